@@ -0,0 +1,252 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>   // for atomic
+
+#include "AllocTracker.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace AllocTracker
+  {
+    namespace
+    {
+      // one cache line per tag so that threads working
+      // in different subsystems don't contend
+      struct alignas(64) TagCounters
+      {
+        atomic<uint64_t> nAllocs{0};
+        atomic<uint64_t> nFrees{0};
+        atomic<uint64_t> bytesAllocated{0};
+        atomic<uint64_t> bytesFreed{0};
+        atomic<int64_t> currentBytes{0};
+        atomic<int64_t> peakBytes{0};
+      };
+
+      // all state has constant initialization because the
+      // allocation hooks may be called before dynamic initialization
+      TagCounters counters[MemTagCount];
+      atomic<bool> enabled{false};
+      atomic<bool> hooksSeen{false};
+      atomic<uint64_t> nHookedAllocs{0};
+      thread_local MemTag threadTag{MemTag::Untagged};
+
+      TagCounters& countersFor(MemTag tag)
+      {
+        return counters[static_cast<size_t>(tag)];
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    void setEnabled(bool isEnabled)
+    {
+      enabled.store(isEnabled, memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    bool isEnabled()
+    {
+      return enabled.load(memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    bool hooksInstalled()
+    {
+      return hooksSeen.load(memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    MemTag currentTag()
+    {
+      return threadTag;
+    }
+
+    //----------------------------------------------------------------------------
+
+    void recordAlloc(MemTag tag, size_t nBytes)
+    {
+      auto& c = countersFor(tag);
+      c.nAllocs.fetch_add(1, memory_order_relaxed);
+      c.bytesAllocated.fetch_add(nBytes, memory_order_relaxed);
+
+      const int64_t cur = c.currentBytes.fetch_add(static_cast<int64_t>(nBytes), memory_order_relaxed) + static_cast<int64_t>(nBytes);
+      int64_t peak = c.peakBytes.load(memory_order_relaxed);
+      while ((cur > peak) && !c.peakBytes.compare_exchange_weak(peak, cur, memory_order_relaxed)) {}
+    }
+
+    //----------------------------------------------------------------------------
+
+    void recordFree(MemTag tag, size_t nBytes)
+    {
+      auto& c = countersFor(tag);
+      c.nFrees.fetch_add(1, memory_order_relaxed);
+      c.bytesFreed.fetch_add(nBytes, memory_order_relaxed);
+      c.currentBytes.fetch_sub(static_cast<int64_t>(nBytes), memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    MemTagStats stats(MemTag tag)
+    {
+      const auto& c = countersFor(tag);
+
+      MemTagStats result;
+      result.nAllocs = c.nAllocs.load(memory_order_relaxed);
+      result.nFrees = c.nFrees.load(memory_order_relaxed);
+      result.bytesAllocated = c.bytesAllocated.load(memory_order_relaxed);
+      result.bytesFreed = c.bytesFreed.load(memory_order_relaxed);
+      result.currentBytes = c.currentBytes.load(memory_order_relaxed);
+      result.peakBytes = c.peakBytes.load(memory_order_relaxed);
+
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+
+    array<MemTagStats, MemTagCount> allStats()
+    {
+      array<MemTagStats, MemTagCount> result;
+      for (size_t i = 0; i < MemTagCount; ++i)
+      {
+        result[i] = stats(static_cast<MemTag>(i));
+      }
+
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+
+    MemTagStats totalStats()
+    {
+      MemTagStats total;
+      for (const auto& s : allStats())
+      {
+        total.nAllocs += s.nAllocs;
+        total.nFrees += s.nFrees;
+        total.bytesAllocated += s.bytesAllocated;
+        total.bytesFreed += s.bytesFreed;
+        total.currentBytes += s.currentBytes;
+        total.peakBytes += s.peakBytes;
+      }
+
+      return total;
+    }
+
+    //----------------------------------------------------------------------------
+
+    void resetPeaks()
+    {
+      for (auto& c : counters)
+      {
+        c.peakBytes.store(c.currentBytes.load(memory_order_relaxed), memory_order_relaxed);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    void reset()
+    {
+      for (auto& c : counters)
+      {
+        c.nAllocs.store(0, memory_order_relaxed);
+        c.nFrees.store(0, memory_order_relaxed);
+        c.bytesAllocated.store(0, memory_order_relaxed);
+        c.bytesFreed.store(0, memory_order_relaxed);
+        c.currentBytes.store(0, memory_order_relaxed);
+        c.peakBytes.store(0, memory_order_relaxed);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    const char* tagName(MemTag tag)
+    {
+      switch (tag)
+      {
+      case MemTag::Untagged:
+        return "untagged";
+      case MemTag::Memory:
+        return "memory";
+      case MemTag::CSV:
+        return "csv";
+      case MemTag::Template:
+        return "template";
+      case MemTag::Net:
+        return "net";
+      case MemTag::Crypto:
+        return "crypto";
+      case MemTag::Logger:
+        return "logger";
+      }
+
+      return "unknown";
+    }
+
+    //----------------------------------------------------------------------------
+
+    uint8_t onHookedAlloc(size_t nBytes)
+    {
+      nHookedAllocs.fetch_add(1, memory_order_relaxed);
+      if (!hooksSeen.load(memory_order_relaxed)) hooksSeen.store(true, memory_order_relaxed);
+
+      if (!isEnabled()) return NotTracked;
+
+      const MemTag tag = threadTag;
+      recordAlloc(tag, nBytes);
+      return static_cast<uint8_t>(tag);
+    }
+
+    //----------------------------------------------------------------------------
+
+    void onHookedFree(uint8_t tagOrNotTracked, size_t nBytes)
+    {
+      if (tagOrNotTracked >= MemTagCount) return;
+
+      recordFree(static_cast<MemTag>(tagOrNotTracked), nBytes);
+    }
+
+    //----------------------------------------------------------------------------
+
+    uint64_t hookedAllocationCount()
+    {
+      return nHookedAllocs.load(memory_order_relaxed);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  ScopedAllocTag::ScopedAllocTag(MemTag tag)
+    :prevTag{AllocTracker::threadTag}
+  {
+    AllocTracker::threadTag = tag;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ScopedAllocTag::~ScopedAllocTag()
+  {
+    AllocTracker::threadTag = prevTag;
+  }
+
+}
@@ -0,0 +1,177 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_ALLOC_TRACKER_H
+#define __LIBSLOPPY_ALLOC_TRACKER_H
+
+#include <array>    // for array
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t, int64_t, uint8_t
+
+namespace Sloppy
+{
+  /** \brief The subsystems that heap allocations can be attributed to
+   */
+  enum class MemTag : uint8_t
+  {
+    Untagged = 0,   ///< allocations outside of any tagged scope
+    Memory,   ///< ManagedArray / MemArray buffers
+    CSV,
+    Template,
+    Net,
+    Crypto,
+    Logger,
+  };
+
+  /** \brief The number of entries in `MemTag`
+   */
+  static constexpr size_t MemTagCount = static_cast<size_t>(MemTag::Logger) + 1;
+
+  /** \brief Allocation statistics for one subsystem tag
+   */
+  struct MemTagStats
+  {
+    uint64_t nAllocs{0};   ///< number of allocations
+    uint64_t nFrees{0};   ///< number of deallocations
+    uint64_t bytesAllocated{0};   ///< sum of all allocated bytes
+    uint64_t bytesFreed{0};   ///< sum of all released bytes
+    int64_t currentBytes{0};   ///< currently allocated bytes
+    int64_t peakBytes{0};   ///< maximum of `currentBytes` since start or the last `resetPeaks()`
+  };
+
+  /** \brief Accounting of heap allocations per subsystem tag
+   *
+   * Allocations are attributed to the tag of the innermost `ScopedAllocTag`
+   * of the allocating thread. They are recorded from two sources:
+   *   * `ManagedArray` (and thus `MemArray`) records its buffers under the
+   *     current tag or, if there is none, under `MemTag::Memory`;
+   *   * the replacement `operator new` / `operator delete` in `AllocTrackerHooks.cpp`
+   *     record every heap allocation of the program. That file is NOT part of the
+   *     library; it is only linked into binaries that want full accounting
+   *     (e.g., the test and benchmark binaries). If the hooks are installed,
+   *     `ManagedArray` leaves the accounting to them so that nothing is counted twice.
+   *
+   * Tracking is off by default. Allocations are only accounted for
+   * if tracking was enabled at the time of the allocation; a release is only
+   * accounted for if its allocation was. Thus tracking can be switched on
+   * and off at any time without unbalancing the counters.
+   *
+   * All counters are lock-free atomics and can be queried from any thread.
+   */
+  namespace AllocTracker
+  {
+    /** \brief Globally enables or disables the tracking of allocations; the default is `off`
+     */
+    void setEnabled(bool isEnabled);
+
+    /** \returns `true` if allocations are currently being tracked
+     */
+    bool isEnabled();
+
+    /** \returns `true` if the replacement `operator new` / `operator delete`
+     * have been linked into the program and have seen at least one allocation
+     */
+    bool hooksInstalled();
+
+    /** \returns the tag of the current thread's innermost `ScopedAllocTag`
+     * or `MemTag::Untagged` if there is none
+     */
+    MemTag currentTag();
+
+    /** \brief Records an allocation; does NOT check whether tracking is enabled
+     */
+    void recordAlloc(MemTag tag, size_t nBytes);
+
+    /** \brief Records a deallocation; does NOT check whether tracking is enabled
+     */
+    void recordFree(MemTag tag, size_t nBytes);
+
+    /** \returns the statistics for a single tag
+     */
+    MemTagStats stats(MemTag tag);
+
+    /** \returns the statistics for all tags, indexed by the tag's numeric value
+     */
+    std::array<MemTagStats, MemTagCount> allStats();
+
+    /** \returns the sum of the statistics of all tags; the peak value is the sum of the per-tag peaks
+     */
+    MemTagStats totalStats();
+
+    /** \brief Sets all peak values to the current values
+     */
+    void resetPeaks();
+
+    /** \brief Sets all counters to zero
+     *
+     * \warning If tracked allocations are still alive, their later release
+     * will cause negative `currentBytes` values.
+     */
+    void reset();
+
+    /** \returns a lower-case name for a tag, e.g. "csv"
+     */
+    const char* tagName(MemTag tag);
+
+    /** \brief Entry point for the replacement `operator new`.
+     *
+     * Marks the hooks as installed and records the allocation
+     * under the current tag if tracking is enabled.
+     *
+     * \returns the tag that the allocation has been recorded under
+     * or `NotTracked`; has to be passed to `onHookedFree()` upon release.
+     */
+    uint8_t onHookedAlloc(size_t nBytes);
+
+    /** \brief Entry point for the replacement `operator delete`
+     */
+    void onHookedFree(
+        uint8_t tagOrNotTracked,   ///< the value that `onHookedAlloc()` returned for this block
+        size_t nBytes   ///< the number of requested bytes as passed to `onHookedAlloc()`
+        );
+
+    /** \brief Marker for blocks that have been allocated while tracking was disabled
+     */
+    static constexpr uint8_t NotTracked = 0xff;
+
+    /** \returns the total number of allocations seen by the replacement `operator new`,
+     * regardless of whether tracking is enabled; zero if the hooks are not installed
+     */
+    uint64_t hookedAllocationCount();
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Attributes all allocations of the current thread to a tag as
+   * long as the object is alive; scopes can be nested.
+   */
+  class ScopedAllocTag
+  {
+  public:
+    explicit ScopedAllocTag(MemTag tag);
+    ~ScopedAllocTag();
+
+    ScopedAllocTag(const ScopedAllocTag&) = delete;
+    ScopedAllocTag& operator=(const ScopedAllocTag&) = delete;
+
+  private:
+    MemTag prevTag;
+  };
+}
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replacement allocation functions that feed every heap allocation
+// of the program into the AllocTracker.
+//
+// This file is NOT part of the library. Link it into an executable
+// (as done for the test and benchmark binaries) to get full accounting.
+//
+// Each block is prefixed with a small header that stores the requested
+// size and the tag the block has been recorded under, so that the release
+// can be attributed correctly even if it happens in a different thread
+// or in a different tag scope.
+
+#include <cstdint>  // for uint64_t, uint32_t, uint8_t
+#include <cstdlib>  // for malloc, free, aligned_alloc
+#include <new>      // for bad_alloc, align_val_t, nothrow_t
+
+#include "AllocTracker.h"
+
+using namespace Sloppy;
+
+namespace
+{
+  struct BlockHeader
+  {
+    uint64_t nBytes;   // the size requested by the caller
+    uint32_t offset;   // distance between the start of the raw block and the user pointer
+    uint8_t tag;   // the tag or AllocTracker::NotTracked
+    uint8_t padding[3];
+  };
+
+  // the header size keeps the user pointer aligned to
+  // the default new alignment (16 bytes on x86-64)
+  constexpr std::size_t HeaderSize = (sizeof(BlockHeader) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) ? sizeof(BlockHeader) : __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+  BlockHeader* headerOf(void* userPtr)
+  {
+    return reinterpret_cast<BlockHeader*>(static_cast<char*>(userPtr) - sizeof(BlockHeader));
+  }
+
+  void* finishBlock(void* raw, std::size_t offset, std::size_t n)
+  {
+    if (raw == nullptr) return nullptr;
+
+    void* userPtr = static_cast<char*>(raw) + offset;
+    BlockHeader* hdr = headerOf(userPtr);
+    hdr->nBytes = n;
+    hdr->offset = static_cast<uint32_t>(offset);
+    hdr->tag = AllocTracker::onHookedAlloc(n);
+
+    return userPtr;
+  }
+
+  void* hookedAlloc(std::size_t n)
+  {
+    return finishBlock(std::malloc(HeaderSize + n), HeaderSize, n);
+  }
+
+  void* hookedAlignedAlloc(std::size_t n, std::size_t align)
+  {
+    const std::size_t offset = (align > HeaderSize) ? align : HeaderSize;
+
+    // aligned_alloc requires a size that is a multiple of the alignment
+    std::size_t total = offset + n;
+    total = ((total + align - 1) / align) * align;
+
+    return finishBlock(std::aligned_alloc(align, total), offset, n);
+  }
+
+  void hookedFree(void* userPtr)
+  {
+    if (userPtr == nullptr) return;
+
+    const BlockHeader* hdr = headerOf(userPtr);
+    AllocTracker::onHookedFree(hdr->tag, hdr->nBytes);
+    std::free(static_cast<char*>(userPtr) - hdr->offset);
+  }
+}
+
+//----------------------------------------------------------------------------
+
+void* operator new(std::size_t n)
+{
+  void* p = hookedAlloc(n);
+  if (p == nullptr) throw std::bad_alloc{};
+  return p;
+}
+
+void* operator new[](std::size_t n)
+{
+  void* p = hookedAlloc(n);
+  if (p == nullptr) throw std::bad_alloc{};
+  return p;
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+  return hookedAlloc(n);
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept
+{
+  return hookedAlloc(n);
+}
+
+void* operator new(std::size_t n, std::align_val_t al)
+{
+  void* p = hookedAlignedAlloc(n, static_cast<std::size_t>(al));
+  if (p == nullptr) throw std::bad_alloc{};
+  return p;
+}
+
+void* operator new[](std::size_t n, std::align_val_t al)
+{
+  void* p = hookedAlignedAlloc(n, static_cast<std::size_t>(al));
+  if (p == nullptr) throw std::bad_alloc{};
+  return p;
+}
+
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+  return hookedAlignedAlloc(n, static_cast<std::size_t>(al));
+}
+
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+  return hookedAlignedAlloc(n, static_cast<std::size_t>(al));
+}
+
+//----------------------------------------------------------------------------
+
+void operator delete(void* p) noexcept { hookedFree(p); }
+void operator delete[](void* p) noexcept { hookedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { hookedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { hookedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { hookedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { hookedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { hookedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { hookedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { hookedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { hookedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { hookedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { hookedFree(p); }
@@ -39,10 +39,13 @@
 
 #include <atomic>         // for atomic_bool
 #include <chrono>         // for milliseconds
-#include <mutex>          // for mutex, lock_guard
+#include <string>         // for string
 #include <thread>         // for thread, sleep_for
 #include <type_traits>    // for is_copy_assignable, is_default_constructible
 
+#include "ConcurrentStats.h" // for ConcurrentWorkerStats
+#include "Metrics.h"      // for MetricsRegistry, MetricHandleList
+#include "ThreadConfig.h" // for ThreadConfig, ConfiguredThread
 #include "ThreadStats.h"  // for AsyncWorkerStats
 #include "Timer.h"        // for Timer
 
@@ -73,11 +76,14 @@ namespace Sloppy
   {
   public:
     /** \brief Default ctor; creates the worker thread
+     *
+     * \throws std::invalid_argument if the provided thread config is invalid
      */
     AsyncWorker(
         ThreadSafeQueue<InputDataType>* inQueuePtr,   ///< pointer to the queue that we'll take our input data from
         ThreadSafeQueue<OutputDataType>* outQueuePtr,   ///< pointer to the queue to which we'll write our result; if `nullptr`, worker results will be discarded
-        int preemptionTime_ms_ = 200   ///< time after which we check for pause / run / join requests, if our input queue is empty
+        int preemptionTime_ms_ = 200,   ///< time after which we check for pause / run / join requests, if our input queue is empty
+        const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker thread
         )
       :inPtr{inQueuePtr}, outPtr{outQueuePtr}, preemptionTime_ms{preemptionTime_ms_}
     {
@@ -88,7 +94,7 @@ namespace Sloppy
       static_assert (std::is_copy_assignable<OutputDataType>::value,
                      "The output data type for the AsyncWorkerWithOutput has to be copy assignable!");
 
-      workerThread = std::thread([&]{mainLoop();});
+      workerThread = ConfiguredThread{thCfg, [this]{mainLoop();}};
     }
 
     /** \brief Dtor; stops the worker loop at the next occastion and `join`s
@@ -153,12 +159,32 @@ namespace Sloppy
     }
 
     /** \returns Some execution statistics about the worker function
+     *
+     * The stats are aggregated on demand and never block the worker.
+     */
+    AsyncWorkerStats stats() const
+    {
+      return statData.snapshot();
+    }
+
+    /** \brief Publishes the worker's runtime histogram and running state
+     * in a metrics registry.
+     *
+     * Any previous registration is removed. The registration is
+     * removed automatically when the worker is destroyed.
      */
-    AsyncWorkerStats stats()
+    void registerMetrics(
+        const std::string& instanceName,   ///< the value of the `worker` label
+        MetricsRegistry& reg = MetricsRegistry::global()   ///< the registry to publish the metrics in
+        )
     {
-      std::lock_guard<std::mutex> lg{statsMutex};
+      metricHandles.clear();
 
-      return statData;
+      const MetricLabels lbl{{"worker", instanceName}};
+      metricHandles.push_back(reg.addHistogram("sloppy_async_worker_runtime_seconds", "Execution time of the worker function", lbl,
+                                               [this]() { return statData.snapshot().runtimeHistogram; }));
+      metricHandles.push_back(reg.addGauge("sloppy_async_worker_running", "1 if the worker is active, 0 if suspended", lbl,
+                                           [this]() { return isRunning ? 1.0 : 0.0; }));
     }
 
   protected:
@@ -189,24 +215,23 @@ namespace Sloppy
         {
           Sloppy::Timer t;
           OutputDataType outData = worker(*optData);
-          int execTime = t.getTime__ms();
+          const int64_t execTime = t.getTime__ns();
           if (outPtr != nullptr) outPtr->put(outData);
 
-          std::lock_guard<std::mutex> lgStats{statsMutex};
-          statData.update(execTime);
+          statData.update__ns(execTime);
         }
       }
     }
 
     int preemptionTime_ms;
-    std::thread workerThread;
+    ConfiguredThread workerThread;
     ThreadSafeQueue<InputDataType>* inPtr{nullptr};
     ThreadSafeQueue<OutputDataType>* outPtr{nullptr};
     std::atomic_bool isRunning{true};
     std::atomic_bool joinRequested{false};
     std::atomic_bool suspendRequested{false};
-    std::mutex statsMutex;
-    AsyncWorkerStats statData;
+    ConcurrentWorkerStats statData;
+    MetricHandleList metricHandles;   // must be last so that it's destroyed first
   };
 }
 
@@ -18,15 +18,21 @@
 
 #include <stddef.h>                              // for size_t
 #include <stdint.h>                              // for int64_t
-#include <algorithm>                             // for max, find_first_of
+#include <algorithm>                             // for max, min, find_first_of
+#include <bit>                                   // for countr_zero
+#include <charconv>                              // for from_chars
+#include <cstring>                               // for memchr
 #include <initializer_list>                      // for initializer_list
 #include <iterator>                              // for end, advance, begin
 #include <memory>                                // for allocator_traits<>::...
-#include <regex>                                 // for regex_replace, match...
 #include <sstream>                               // for basic_stringbuf<>::i...
-#include <stdexcept>                             // for invalid_argument
+#include <stdexcept>                             // for invalid_argument, out_of_range
+#include <system_error>                          // for errc
 
-#include "ConfigFileParser/ConstraintChecker.h"  // for checkConstraint, Val...
+#include "AllocTracker.h"                       // for ScopedAllocTag
+#include "CSV_Scanner.h"                         // for CSV_StructuralScanner
+#include "MultiPatternReplacer.h"                // for MultiPatternReplacer
+#include "Tracing.h"                             // for SLOPPY_TRACE_SPAN
 
 #include "CSV.h"
 
@@ -36,25 +42,63 @@ using namespace std;
 namespace Sloppy
 {
 
-  string escapeStringForCSV(const string& rawInput, bool addQuotes)
+  namespace
   {
-    // replace all backslashes with a double backslash
-    static const regex reBackslash{"\\\\"};  // matches a single backslash
-    string result = regex_replace(rawInput, reBackslash, "\\\\");  // insert double backslash
+    // backslashes, quotes, commas and newlines are
+    // escaped with a backslash, all in one pass
+    const MultiPatternReplacer& csvEscaper()
+    {
+      static const MultiPatternReplacer escaper{{
+          {"\\", "\\\\"},
+          {"\"", "\\\""},
+          {",", "\\,"},
+          {"\n", "\\n"},
+        }};
+
+      return escaper;
+    }
+
+    // trimmed headers have to be non-empty and unique
+    // and may not contain commas or quotation marks
+    bool areValidTrimmedHeaders(const std::vector<string>& headers)
+    {
+      for (auto it = headers.cbegin(); it != headers.cend(); ++it)
+      {
+        const string& hdr = *it;
+
+        // all headers must be non-empty
+        if (hdr.empty()) return false;
+
+        // all headers must be unique
+        // ==> since we already iterate over the headers it means
+        // that the same header may not occur AFTER the
+        // the current element
+        auto itOther = std::find(it + 1, headers.cend(), hdr);
+        if (itOther != headers.cend()) return false;
+
+        // headers may not contain baaad characters
+        const string invalidChars{",\""};
+        auto itDummy = std::find_first_of(
+              hdr.cbegin(), hdr.cend(),
+              invalidChars.cbegin(), invalidChars.cend()
+              );
+        if (itDummy != hdr.cend()) return false;
+      }
 
-    // replace " with \"
-    static const regex reQuote{"\""}; // matches a single "
-    result = regex_replace(result, reQuote, "\\\"");  // inserts \"
+      return true;
+    }
+  }
 
-    // replace , with \,
-    static const regex reComma{","}; // matches a single ','
-    result = regex_replace(result, reComma, "\\,");  // inserts \,
+  //----------------------------------------------------------------------------
 
-    // replace newlines with a literal "\n"
-    static const regex reNewline{"\n"}; // matches a single \n
-    result = regex_replace(result, reNewline, "\\n");  // inserts a literal "\n"
+  string escapeStringForCSV(const string& rawInput, bool addQuotes)
+  {
+    string result;
+    if (addQuotes) result += '"';
+    csvEscaper().appendTo(rawInput, result);
+    if (addQuotes) result += '"';
 
-    return (addQuotes ? "\"" + result + "\"" : result);
+    return result;
   }
 
   //----------------------------------------------------------------------------
@@ -63,57 +107,62 @@ namespace Sloppy
   {
     if (escapedInput.empty()) return string{};
 
-    Sloppy::estring s{escapedInput};
+    // the inverse of escapeStringForCSV()
+    static const MultiPatternReplacer unescaper{{
+        {"\\n", "\n"},
+        {"\\,", ","},
+        {"\\\"", "\""},
+        {"\\\\", "\\"},
+      }};
 
-    /*
-    // remove literal, un-escaped quotation marks
-    if (s[0] == '"') s = s.substr(1);
-    if (s.empty()) return string{};
-    if (s.size() >= 2)
+    if (!isValidEscapedCSVString(escapedInput))
     {
-      auto lastIdx = s.size() - 1;
-      if ((s[lastIdx] == '"') && (s[lastIdx-1] != '\\'))
-      {
-        s.chopRight(1);
-      }
+      throw std::invalid_argument("unescapeStringForCSV(): invalid input string");
     }
-    */
 
-    // make sure there no un-escaped commas and backslashes in the string
-    for (char c : {',', '\\'})
-    {
-      size_t idx = s.find(c);
-      while (idx != string::npos)
-      {
-        if ((idx == 0) && (c != '\\')) throw std::invalid_argument("unescapeStringForCSV(): invalid input string");
-        if ((c != '\\') && (idx > 0) && (s[idx - 1] != '\\')) throw std::invalid_argument("unescapeStringForCSV(): invalid input string");
-
-        idx = s.find(c, idx+1);
-      }
-    }
+    // unescape everything in one pass; this also ensures that
+    // escaped backslashes can't be combined with the following
+    // character into another escape sequence
+    return unescaper.apply(escapedInput);
+  }
 
-    // unescape newlines
-    static const regex reNewline{"\\\\n"};
-    s = regex_replace(s, reNewline, "\n");
+  //----------------------------------------------------------------------------
 
-    // unescape commas
-    static const regex reComma{"\\\\,"};
-    s = regex_replace(s, reComma, ",");
+  bool isValidEscapedCSVString(string_view s)
+  {
+    // only commas and backslashes are relevant; everything in between
+    // can be skipped. Like in previous versions, un-escaped quotation
+    // marks are accepted for compatibility with existing data.
+    size_t idx = s.find_first_of(",\\");
+    while (idx != string_view::npos)
+    {
+      // un-escaped comma
+      if (s[idx] != '\\') return false;
 
-    // unescape quotes
-    static const regex reQuote{"\\\\\""};
-    s = regex_replace(s, reQuote, "\"");
+      // a backslash must start one of the escape
+      // sequences generated by escapeStringForCSV()
+      if (idx + 1 >= s.size()) return false;
+      const char c = s[idx + 1];
+      if ((c != '\\') && (c != '"') && (c != ',') && (c != 'n')) return false;
 
-    // unescape backslashes
-    static const regex reBackslash{"\\\\\\\\"};
-    s = regex_replace(s, reBackslash, "\\");
+      idx = s.find_first_of(",\\", idx + 2);
+    }
 
-    return s;
+    return true;
   }
 
   //----------------------------------------------------------------------------
 
   string CSV_Value::asString(CSV_StringRepresentation rep) const
+  {
+    string result;
+    appendTo(result, rep);
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Value::appendTo(string& dst, CSV_StringRepresentation rep) const
   {
     const auto valType = valueType();
 
@@ -129,58 +178,191 @@ namespace Sloppy
 
     switch (valType) {
     case Type::Null:
-      return string{};
+      return;
 
     case Type::Long:
-      return to_string(std::get<int64_t>(value()));
+    {
+      char buf[24];
+      const auto res = std::to_chars(buf, buf + sizeof(buf), std::get<int64_t>(value()));
+      dst.append(buf, res.ptr);
+      return;
+    }
 
     case Type::Double:
-      return to_string(std::get<double>(value()));
-      break;
+    {
+      // six decimals, just like std::to_string(); the buffer
+      // is large enough for the max. double value in this format
+      char buf[400];
+      const auto res = std::to_chars(buf, buf + sizeof(buf), std::get<double>(value()), std::chars_format::fixed, 6);
+      if (res.ec != std::errc{})
+      {
+        dst += to_string(std::get<double>(value()));
+        return;
+      }
+      dst.append(buf, res.ptr);
+      return;
+    }
 
     case Type::String:
-      string s = std::get<std::string>(value());
-      if (usesEscaping) s = escapeStringForCSV(s, false);
-      if (usesQuotes) s = "\"" + s + "\"";
-      return s;
+      const string& s = std::get<std::string>(value());
+      if (usesQuotes) dst += '"';
+      if (usesEscaping)
+      {
+        csvEscaper().appendTo(s, dst);
+      } else {
+        dst += s;
+      }
+      if (usesQuotes) dst += '"';
+      return;
     }
 
     // we should never reach this point
-    throw std::runtime_error("CSV_Value::asString(): conversion logic error!");
+    throw std::runtime_error("CSV_Value::appendTo(): conversion logic error!");
   }
 
-  //----------------------------------------------------------------------------
-  //----------------------------------------------------------------------------
   //----------------------------------------------------------------------------
 
-  CSV_Row::CSV_Row(const Sloppy::estring& rowData, CSV_StringRepresentation rep)
+  CSV_Value parseNumericCSVField(string_view field)
   {
-    const bool usesEscaping = ((rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
-    const bool usesQuotes = ((rep == CSV_StringRepresentation::Quoted) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
+    if (field.empty()) return CSV_Value{};
 
-    const auto optStringChunks = splitInputInChunks(rowData, rep);
+    // an optional minus sign followed by at least one
+    // digit or a decimal point
+    size_t idx = (field[0] == '-') ? 1 : 0;
+    if (idx == field.size()) return CSV_Value{};
 
-    for (const auto& optChunk : optStringChunks)
+    // the remaining characters must be digits with at most one decimal point
+    size_t dotPos{string_view::npos};
+    for (; idx < field.size(); ++idx)
     {
-      if (!optChunk.has_value())
+      const char c = field[idx];
+      if ((c >= '0') && (c <= '9')) continue;
+      if ((c == '.') && (dotPos == string_view::npos))
       {
-        cols.push_back(CSV_Value{});
+        dotPos = idx;
         continue;
       }
 
-      const estring& trimmed = optChunk->trim_copy();
+      return CSV_Value{};
+    }
+
+    const char* first = field.data();
+    const char* last = field.data() + field.size();
 
-      if (Sloppy::checkConstraint(trimmed, Sloppy::ValueConstraint::Integer))
+    if (dotPos == string_view::npos)
+    {
+      int64_t l{0};
+      if (from_chars(first, last, l).ec == errc::result_out_of_range)
       {
-        int64_t l = stol(trimmed);
-        cols.push_back(CSV_Value{l});
+        throw std::out_of_range("parseNumericCSVField(): integer value out of range");
+      }
+
+      return CSV_Value{l};
+    }
+
+    // a decimal point alone is not a number
+    if (field.size() == ((field[0] == '-') ? 2 : 1)) return CSV_Value{};
+
+    double d{0};
+    if (from_chars(first, last, d).ec == errc::result_out_of_range)
+    {
+      throw std::out_of_range("parseNumericCSVField(): floating point value out of range");
+    }
+
+    return CSV_Value{d};
+  }
+
+  //----------------------------------------------------------------------------
+
+  string_view stripCSVQuotes(string_view field, CSV_StringRepresentation rep)
+  {
+    const bool usesQuotes = ((rep == CSV_StringRepresentation::Quoted) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
+    if (!usesQuotes) return field;
+
+    // in a quoted string, the first and last
+    // character must be pure, unescaped quotation marks
+    if ((field.size() < 2) || (field.front() != '"') || (field.back() != '"'))
+    {
+      throw std::invalid_argument("CSV_Row::ctor(): received invalid input string (missing quotation marks)");
+    }
+    if ((rep == CSV_StringRepresentation::QuotedAndEscaped) && (field.size() > 2) && (field[field.size() - 2] == '\\'))
+    {
+      throw std::invalid_argument("CSV_Row::ctor(): received invalid input string (escaped quotation mark instead of raw quotation mark)");
+    }
+
+    return field.substr(1, field.size() - 2);
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool prepareCSVLine(string_view& line)
+  {
+    // only completely empty lines are skipped; a line that
+    // consists of a single "\r" becomes an empty row
+    if (line.empty()) return false;
+
+    if (line.back() == '\r') line.remove_suffix(1);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool nextCSVLine(string_view& data, string_view& line)
+  {
+    while (!data.empty())
+    {
+      const char* lineEnd = static_cast<const char*>(memchr(data.data(), '\n', data.size()));
+      const size_t lineLen = (lineEnd == nullptr) ? data.size() : lineEnd - data.data();
+      line = data.substr(0, lineLen);
+      data.remove_prefix((lineEnd == nullptr) ? lineLen : lineLen + 1);
+
+      if (prepareCSVLine(line)) return true;
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  CSV_Row::CSV_Row(string_view rowData, CSV_StringRepresentation rep)
+  {
+    assign(rowData, rep);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Row::assign(string_view rowData, CSV_StringRepresentation rep)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    const bool usesEscaping = ((rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
+
+    // the chunk list only holds views into `rowData`, so we can
+    // keep its storage around for the next row parsed by this thread
+    thread_local std::vector<std::optional<string_view>> optStringChunks;
+    splitInputInChunks(rowData, rep, optStringChunks);
+
+    // existing columns (and their string buffers) are overwritten
+    // in place; surplus columns are dropped
+    cols.resize(optStringChunks.size());
+
+    for (size_t idx = 0; idx < optStringChunks.size(); ++idx)
+    {
+      const auto& optChunk = optStringChunks[idx];
+      CSV_Value& val = cols[idx];
+
+      if (!optChunk.has_value())
+      {
+        val.reset();
         continue;
       }
 
-      if (Sloppy::checkConstraint(trimmed, Sloppy::ValueConstraint::Numeric))
+      CSV_Value num = parseNumericCSVField(trimView(*optChunk));
+      if (num.has_value())
       {
-        double d = stod(trimmed);
-        cols.push_back(CSV_Value{d});
+        val = std::move(num);
         continue;
       }
 
@@ -188,34 +370,23 @@ namespace Sloppy
       // so we have a string as last option.
       //
 
-      // in a quoted string, the first and last
-      // character must be pure, unescaped quotation marks
-      const estring& s = *optChunk;
-      if (usesQuotes && (s.size() < 2))
-      {
-        throw std::invalid_argument("CSV_Row::ctor(): received invalid input string (missing quotation marks)");
-      }
-      if (usesQuotes && ((s.front() != '"') || (s.back() != '"')))
-      {
-        throw std::invalid_argument("CSV_Row::ctor(): received invalid input string (missing quotation marks)");
-      }
-      if ((rep == CSV_StringRepresentation::QuotedAndEscaped) && (s.size() > 2) && (s[s.size() - 2] == '\\'))
-      {
-        throw std::invalid_argument("CSV_Row::ctor(): received invalid input string (escaped quotation mark instead of raw quotation mark)");
-      }
-
-      Sloppy::estring raw = usesEscaping ? Sloppy::estring{unescapeStringForCSV(s)} : s;
+      // strip the quotation marks before unescaping; stripCSVQuotes()
+      // guarantees that they are not part of an escape sequence
+      const string_view content = stripCSVQuotes(*optChunk, rep);
 
-      if (usesQuotes)
+      if (usesEscaping)
       {
-        raw = raw.substr(1);
-        raw.chopRight(1);
+        val.set(unescapeStringForCSV(string{content}));
+      } else if (val.valueType() == CSV_Value::Type::String) {
+        std::get<string>(val.value()).assign(content);
+      } else {
+        val.set(string{content});
       }
-
-      cols.push_back(CSV_Value{raw});
     }
   }
 
+  //----------------------------------------------------------------------------
+
   CSV_Row::ColumnConstRef CSV_Row::operator[](CSV_Row::IndexType idx) const
   {
     return cols.at(idx);
@@ -232,44 +403,67 @@ namespace Sloppy
 
   string CSV_Row::asString(CSV_StringRepresentation rep) const
   {
-    if (cols.empty()) return std::string{};
+    std::string result;
+    appendTo(result, rep);
+    return result;
+  }
 
-    auto it = cols.cbegin();
-    std::string result = it->asString(rep);
-    ++it;
-    for (; it != cols.cend(); ++it)
+  //----------------------------------------------------------------------------
+
+  void CSV_Row::appendTo(string& dst, CSV_StringRepresentation rep) const
+  {
+    for (auto it = cols.cbegin(); it != cols.cend(); ++it)
     {
-      result += ',';
-      result += it->asString(rep);
+      if (it != cols.cbegin()) dst += ',';
+      it->appendTo(dst, rep);
     }
-
-    return result;
   }
 
   //----------------------------------------------------------------------------
 
-  std::vector<std::optional<estring> > CSV_Row::splitInputInChunks(const estring& ctorInput, CSV_StringRepresentation rep)
+  void CSV_Row::splitInputInChunks(string_view ctorInput, CSV_StringRepresentation rep, std::vector<std::optional<string_view>>& result)
   {
-    const bool usesEscaping = ((rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
     const bool usesQuotes = ((rep == CSV_StringRepresentation::Quoted) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
 
-    std::vector<std::optional<estring> > result;
-    if (ctorInput.empty()) return result;
+    result.clear();
+    if (ctorInput.empty()) return;
+
+    // stores the field between `idxStart` and a separator (or the end of the input)
+    auto pushChunk = [&](size_t idxStart, size_t idxEnd)
+    {
+      // row starts with a NULL value or
+      // intermediate NULL value like "xxxx,,xxxx"
+      if (idxEnd == idxStart)
+      {
+        result.push_back(std::optional<string_view>{});
+        return;
+      }
+
+      // regular content field
+      string_view sVal = ctorInput.substr(idxStart, idxEnd - idxStart);
+      if (usesQuotes) sVal = trimView(sVal);
+      result.push_back(sVal.empty() ? std::optional<string_view>{} : sVal);
+    };
 
-    // find all valid comma separator positions
-    vector<size_t> commaPos;
-    char prevChar{0};
+    // find all valid comma separator positions and slice
+    // the input at these positions
+    CSV_StructuralScanner scanner{rep};
+    size_t idxStart = 0;
     int quoteCount{0};
-    for (size_t idx=0; idx < ctorInput.size(); ++idx)
+    for (size_t blockStart = 0; blockStart < ctorInput.size(); blockStart += CSV_StructuralScanner::BlockSize)
     {
-      const char c = ctorInput[idx];
+      const size_t len = std::min(CSV_StructuralScanner::BlockSize, ctorInput.size() - blockStart);
+      const auto masks = scanner.scanBlock(ctorInput.data() + blockStart, len);
 
-      // track if we're inside a quoted string section or not
-      if (usesQuotes && (c == '"'))
+      // visit all effective quotation marks and separators in
+      // their order of appearance
+      uint64_t events = masks.separators | masks.quotes;
+      while (events != 0)
       {
-        // is this an "effective" quotation marks or is it an
-        // escaped, literal quotation mark that doesn't have any effect?
-        if ((usesEscaping && (prevChar != '\\')) || !usesEscaping)
+        const int bit = std::countr_zero(events);
+        events &= events - 1;
+
+        if ((masks.quotes >> bit) & 1)
         {
           ++quoteCount;
 
@@ -277,56 +471,42 @@ namespace Sloppy
           {
             throw std::invalid_argument("Inconsistent number of quotation marks in CSV input string");
           }
-        }
-      }
 
-      if ((c == ',') && (quoteCount != 1))
-      {
-        if (!usesEscaping || (usesEscaping && (prevChar != '\\')))
-        {
-          // valid, field separating comma
-          commaPos.push_back(idx);
-          quoteCount = 0;
+          continue;
         }
-      }
 
-      prevChar = c;
-    }
+        // valid, field separating comma
+        const size_t idx = blockStart + bit;
+        pushChunk(idxStart, idx);
+        quoteCount = 0;
 
-    // initialize column values from comma-delimited data
-    size_t idxStart = 0;
-    for (size_t idx : commaPos)
-    {
-      // row starts with a NULL value or
-      // intermediate NULL value like "xxxx,,xxxx"
-      if (idx == idxStart)
-      {
-        result.push_back(std::optional<estring>{});
-      } else {
-        // regular content field
-        Sloppy::estring sVal = ctorInput.slice(idxStart, idx - 1);
-        if (usesQuotes) sVal.trim();
-        result.push_back(sVal.empty() ? std::optional<estring>{} : sVal);
+        // start position for next slice is one behind the comma
+        idxStart = idx + 1;
       }
+    }
 
-      // start position for next slice is one behind the comma
-      idxStart = idx + 1;
+    // don't forget everything after the last comma; if the row
+    // ended with a comma, this pushes another NULL value
+    pushChunk(idxStart, ctorInput.size());
+  }
 
-    }
+  //----------------------------------------------------------------------------
 
-    // don't forget everything after the last comma
-    if (idxStart < ctorInput.size())
-    {
-      Sloppy::estring sVal = ctorInput.slice(idxStart, ctorInput.size() - 1);
-      if (usesQuotes) sVal.trim();
-      result.push_back(sVal.empty() ? std::optional<estring>{} : sVal);
-    }
+  std::vector<std::optional<estring>> CSV_Row::splitInputInChunks(const estring& ctorInput, CSV_StringRepresentation rep)
+  {
+    std::vector<std::optional<string_view>> chunks;
+    splitInputInChunks(ctorInput.toStringView(), rep, chunks);
 
-    // if the row ended with a comma, we have to push
-    // another NULL value
-    if (idxStart == ctorInput.size())
+    std::vector<std::optional<estring>> result;
+    result.reserve(chunks.size());
+    for (const auto& optChunk : chunks)
     {
-      result.push_back(std::optional<estring>{});
+      if (optChunk.has_value())
+      {
+        result.push_back(estring{optChunk->data(), optChunk->size()});
+      } else {
+        result.push_back(std::optional<estring>{});
+      }
     }
 
     return result;
@@ -343,15 +523,15 @@ namespace Sloppy
 
   CSV_Table::CSV_Table(const estring& tableData, bool firstRowContainsHeaders, CSV_StringRepresentation rep)
   {
-    if (tableData.empty()) return;
+    SLOPPY_TRACE_SPAN("CSV_Table::ctor");
+    ScopedAllocTag allocTag{MemTag::CSV};
 
-    auto lines = tableData.split("\n", false, false);
+    if (tableData.empty()) return;
 
-    for (auto& line : lines)
+    string_view data = tableData.toStringView();
+    string_view line;
+    while (nextCSVLine(data, line))
     {
-      // remove trailing "\r" characters
-      if (line.back() == '\r') line.chopRight(1);
-
       // don't catch exceptions here; leave it to
       // the caller to deal with invalid row data
       CSV_Row r{line, rep};
@@ -451,15 +631,8 @@ namespace Sloppy
 
   bool CSV_Table::setHeader(const std::vector<string>& headers)
   {
-    std::vector<std::string> v;
-    for (const auto& h : headers)
-    {
-      estring e{h};
-      e.trim();
-      v.push_back(e);
-    }
-
-    return setHeader_trimmed(v);
+    const auto v = validateCSVHeaders(headers);
+    return v.has_value() && setHeader_trimmed(*v);
   }
 
   //----------------------------------------------------------------------------
@@ -476,17 +649,8 @@ namespace Sloppy
 
   bool CSV_Table::setHeader(const CSV_Row& headers)
   {
-    std::vector<std::string> v;
-
-    for (auto it = headers.cbegin(); it != headers.cend(); ++it)
-    {
-      if (it->valueType() == CSV_Value::Type::Null) return false;
-      estring s = it->asString(CSV_StringRepresentation::Plain);
-      s.trim();
-      v.push_back(s);
-    }
-
-    return setHeader_trimmed(v);
+    const auto v = validateCSVHeaders(headers);
+    return v.has_value() && setHeader_trimmed(*v);
   }
 
   //----------------------------------------------------------------------------
@@ -522,29 +686,27 @@ namespace Sloppy
 
   string CSV_Table::asString(bool includeHeaders, CSV_StringRepresentation rep) const
   {
-    const bool usesEscaping = ((rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
-    const bool usesQuotes = ((rep == CSV_StringRepresentation::Quoted) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
+    ScopedAllocTag allocTag{MemTag::CSV};
 
     string result;
 
+    // the headers are written like a row of string values
     if (includeHeaders && !header2columnIndex.empty())
     {
+      CSV_Row hdr;
       for (ColumnIndexType colIdx = 0; colIdx < header2columnIndex.size(); ++colIdx)
       {
-        string hdr = getHeader(colIdx);
-        if (usesEscaping) hdr = escapeStringForCSV(hdr, usesQuotes);
-
-        if (!result.empty()) result += ",";
-        result += hdr;
+        hdr.append(getHeader(colIdx));
       }
 
-      result += "\n";
+      hdr.appendTo(result, rep);
+      result += '\n';
     }
 
     for (const auto& row : rows)
     {
-      result += row.asString(rep);
-      result += "\n";
+      row.appendTo(result, rep);
+      result += '\n';
     }
 
     return result;
@@ -647,28 +809,7 @@ namespace Sloppy
       return false;
     }
 
-    for (auto it = headers.cbegin(); it != headers.cend(); ++it)
-    {
-      const string& hdr = *it;
-
-      // all headers must be non-empty
-      if (hdr.empty()) return false;
-
-      // all headers must be unique
-      // ==> since we already iterate over the headers it means
-      // that the same header may not occur AFTER the
-      // the current element
-      auto itOther = std::find(it + 1, headers.cend(), hdr);
-      if (itOther != headers.cend()) return false;
-
-      // headers may not contain baaad characters
-      const string invalidChars{",\""};
-      auto itDummy = std::find_first_of(
-            hdr.cbegin(), hdr.cend(),
-            invalidChars.cbegin(), invalidChars.cend()
-            );
-      if (itDummy != hdr.cend()) return false;
-    }
+    if (!areValidTrimmedHeaders(headers)) return false;
 
     // everything is okay. copy the headers over
     header2columnIndex.clear();
@@ -694,9 +835,58 @@ namespace Sloppy
     });
   }
 
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
   //----------------------------------------------------------------------------
 
+  optional<vector<string>> validateCSVHeaders(const CSV_Row& headers)
+  {
+    vector<string> v;
+    v.reserve(headers.size());
 
+    for (auto it = headers.cbegin(); it != headers.cend(); ++it)
+    {
+      if (it->valueType() == CSV_Value::Type::Null) return std::nullopt;
+      estring s = it->asString(CSV_StringRepresentation::Plain);
+      s.trim();
+      v.push_back(std::move(s));
+    }
+
+    if (!areValidTrimmedHeaders(v)) return std::nullopt;
+
+    return v;
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<vector<string>> validateCSVHeaders(const vector<string>& headers)
+  {
+    vector<string> v;
+    v.reserve(headers.size());
+
+    for (const auto& h : headers)
+    {
+      estring e{h};
+      e.trim();
+      v.push_back(std::move(e));
+    }
+
+    if (!areValidTrimmedHeaders(v)) return std::nullopt;
+
+    return v;
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_Row::IndexType> findCSVColumn(const vector<string>& headers, const string& colName)
+  {
+    for (CSV_Row::IndexType idx = 0; idx < headers.size(); ++idx)
+    {
+      if (headers[idx] == colName) return idx;
+    }
+
+    return std::nullopt;
+  }
 
   //----------------------------------------------------------------------------
 
@@ -23,6 +23,7 @@
 #include <cstdint>        // for int64_t
 #include <optional>       // for optional
 #include <string>         // for string, basic_string, allocator, hash
+#include <string_view>    // for string_view
 #include <type_traits>    // for remove_reference<>::type
 #include <unordered_map>  // for unordered_map
 #include <utility>        // for move
@@ -62,6 +63,22 @@ namespace Sloppy
 
   //----------------------------------------------------------------------------
 
+  /** \brief Checks whether a string (without surrounding quotation marks) could
+   * have been produced by `escapeStringForCSV()`
+   *
+   * This is the validation that is performed by `unescapeStringForCSV()`; it
+   * can be used to validate escaped input without actually unescaping it.
+   *
+   * \returns `false` if the string contains un-escaped commas or if it contains
+   * backslashes that are not part of a valid escape sequence; un-escaped
+   * quotation marks are tolerated
+   */
+  bool isValidEscapedCSVString(
+      std::string_view s   ///< the escaped string
+      );
+
+  //----------------------------------------------------------------------------
+
   /** \brief An enum that defines how string data is represented
    * in CSV texts.
    */
@@ -222,11 +239,88 @@ namespace Sloppy
      */
     std::string asString(CSV_StringRepresentation rep) const;
 
+    /** \brief Appends the string representation of the contained value
+     * (see `asString()`) to an existing string
+     *
+     * Numbers are converted with `std::to_chars()` and strings are escaped
+     * directly into the target string, so no temporary strings are created.
+     *
+     * \throws bad_optional_access if the contained value is NULL and
+     * no string quoting is requested.
+     */
+    void appendTo(
+        std::string& dst,   ///< the string that receives the value
+        CSV_StringRepresentation rep   ///< defines how string data is represented in the output string
+        ) const;
+
   private:
   };
 
   //----------------------------------------------------------------------------
 
+  /** \brief Checks whether a (trimmed) CSV field contains a number and converts it
+   *
+   * The field is classified and converted in a single pass using `std::from_chars()`
+   * without creating any intermediate strings.
+   *
+   * The accepted syntax is the same as for `estring::isInt()` and `estring::isDouble()`:
+   * an optional leading minus sign followed by digits with at most one decimal point.
+   * Fields without a decimal point become `int64_t` values, all others become `double`.
+   *
+   * \throws std::out_of_range if the field is numeric but its value exceeds the range of
+   * the respective type
+   *
+   * \returns a CSV_Value with the number or an empty (NULL) CSV_Value if the field is not numeric
+   */
+  CSV_Value parseNumericCSVField(
+      std::string_view field   ///< the field content without leading or trailing white spaces
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Validates and removes the quotation marks around a raw (non-numeric) CSV field
+   *
+   * If the string representation doesn't use quotes, the field is returned unmodified.
+   * The returned content is still escaped if the representation uses escaping.
+   *
+   * \throws std::invalid_argument if quotes are required but missing or if the closing
+   * quotation mark is escaped
+   *
+   * \returns a view of the field content without quotation marks
+   */
+  std::string_view stripCSVQuotes(
+      std::string_view field,   ///< the raw field as it appears in the CSV text
+      CSV_StringRepresentation rep   ///< defines how string data is represented in the CSV text
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Applies the line rules of the `CSV_Table` ctor to a single line
+   * that has already been split off the CSV text (without its "\n")
+   *
+   * Empty lines are skipped. Otherwise a trailing "\r" is removed; thus a line
+   * that only consists of "\r" is NOT skipped but treated as an empty row.
+   *
+   * \returns `false` if the line is empty and has to be skipped
+   */
+  bool prepareCSVLine(
+      std::string_view& line   ///< the raw line; a trailing "\r" is removed from it
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Removes the next line from the beginning of CSV text, using the
+   * same line rules as the `CSV_Table` ctor (see `prepareCSVLine()`)
+   *
+   * \returns `false` if the text didn't contain any further lines
+   */
+  bool nextCSVLine(
+      std::string_view& data,   ///< the remaining CSV text; the line and its line break are removed from it
+      std::string_view& line   ///< receives the next line without "\n" and "\r"
+      );
+
+  //----------------------------------------------------------------------------
+
   /** \brief A vector of CSV_Value elements, representing a row in a CSV table
    */
   class CSV_Row
@@ -256,7 +350,24 @@ namespace Sloppy
      *
      */
     explicit CSV_Row(
-        const Sloppy::estring& rowData,
+        std::string_view rowData,
+        CSV_StringRepresentation rep   ///< defines how string data is represented in the input string
+        );
+
+    /** \brief Replaces the row content with the values parsed from
+     * a string of comma-separated values.
+     *
+     * The parsing rules are identical to the string-based ctor. In contrast to
+     * the ctor, the existing column storage (including the buffers of string
+     * values) is reused which avoids most heap allocations when parsing
+     * many rows of similar shape one after another.
+     *
+     * \throws std::invalid_argument if the input string was malformed (e.g.,
+     * because of inconsistent use of quotation marks). The row content is undefined
+     * in this case.
+     */
+    void assign(
+        std::string_view rowData,
         CSV_StringRepresentation rep   ///< defines how string data is represented in the input string
         );
 
@@ -299,6 +410,22 @@ namespace Sloppy
       cols.push_back(CSV_Value{std::move(v)});
     }
 
+    /** \brief Appends a new column to the row (moves the value)
+     */
+    void append(CSV_Value&& v)
+    {
+      cols.push_back(std::move(v));
+    }
+
+    /** \brief Pre-allocates storage for a given number of columns
+     */
+    void reserve(
+        IndexType n   ///< the expected number of columns
+        )
+    {
+      cols.reserve(n);
+    }
+
     /** \brief Appends a new column with a NULL value
      */
     void append()
@@ -318,6 +445,17 @@ namespace Sloppy
         CSV_StringRepresentation rep   ///< defines how string data is represented in the output string
         ) const;
 
+    /** \brief Appends the CSV representation of the row (see `asString()`)
+     * to an existing string
+     *
+     * \throws bad_optional_access if the contained value is NULL and
+     * no string quoting is requested.
+     */
+    void appendTo(
+        std::string& dst,   ///< the string that receives the row data
+        CSV_StringRepresentation rep   ///< defines how string data is represented in the output string
+        ) const;
+
     ContainerType::const_iterator cbegin() const { return cols.cbegin(); }
     ContainerType::const_iterator cend() const { return cols.cend(); }
 
@@ -338,6 +476,25 @@ namespace Sloppy
         )
     { return cols.erase(first, last); }
 
+    /** \brief Splits a row string in chunks of raw (still quoted and escaped)
+     * field data; used by the ctor and by parsers that work directly on the raw fields
+     *
+     * Subsequent commas (",,") will be treated as NULL value.
+     *
+     * If string data is quoted, all data chunks will be trimmed and empty
+     * strings will be treated as NULL, too. Example: the input row "42,  ,66" will
+     * be converted into NULL value for the second column if strings are quoted. It
+     * will be converted into the string "   " for the second column if string
+     * columns are not quoted.
+     *
+     * The result vector is cleared before the chunks are stored in it.
+     */
+    static void splitInputInChunks(
+        std::string_view ctorInput,
+        CSV_StringRepresentation rep,   ///< defines how string data is represented in the input string
+        std::vector<std::optional<std::string_view>>& result   ///< receives the optional views into the input string; empty optionals represent NULL
+        );
+
   protected:
     /** \brief Used internally by the ctor to split the input string in
      * chunks of data
@@ -350,6 +507,9 @@ namespace Sloppy
      * will be converted into the string "   " for the second column if string
      * columns are not quoted.
      *
+     * \note Kept for compatibility only; it copies all chunks. New code should use
+     * the static, non-copying overload.
+     *
      * \return a vector of optional strings; empty optionals represent NULL.
      */
     std::vector<std::optional<Sloppy::estring>> splitInputInChunks(
@@ -440,6 +600,15 @@ namespace Sloppy
         CSV_Row&& row   ///< the row that shall be appended (moved) to the table
         );
 
+    /** \brief Pre-allocates storage for a given number of data rows
+     */
+    void reserve(
+        RowIndexType n   ///< the expected number of data rows
+        )
+    {
+      rows.reserve(n);
+    }
+
     /** \returns the number of columns in the table (0 if the table
      * is still empty)
      */
@@ -662,6 +831,38 @@ namespace Sloppy
     ContainerType rows;
     std::unordered_map<std::string, ColumnIndexType> header2columnIndex;
   };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Validates a header row using the same rules as `CSV_Table::setHeader()`
+   *
+   * \returns the trimmed header names or an empty optional if the headers are invalid
+   */
+  std::optional<std::vector<std::string>> validateCSVHeaders(
+      const CSV_Row& headers   ///< the row with the column headers
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Validates column headers using the same rules as `CSV_Table::setHeader()`
+   *
+   * \returns the trimmed header names or an empty optional if the headers are invalid
+   */
+  std::optional<std::vector<std::string>> validateCSVHeaders(
+      const std::vector<std::string>& headers   ///< the column headers
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Looks up a column name in a list of (validated) column headers
+   *
+   * \returns the zero-based index of the column or an empty optional
+   * if there is no column with the given name
+   */
+  std::optional<CSV_Row::IndexType> findCSVColumn(
+      const std::vector<std::string>& headers,   ///< the column headers
+      const std::string& colName   ///< name of the column (case-sensitive)
+      );
 }
 
 #endif
@@ -0,0 +1,457 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>  // for invalid_argument, length_error, out_of_range
+#include <utility>    // for move
+#include <variant>    // for get
+
+#include "AllocTracker.h"  // for ScopedAllocTag, MemTag
+#include "CSV_Reader.h"    // for CSV_Reader
+
+#include "CSV_Columnar.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  CSV_Column::CSV_Column(const CSV_Column& other)
+    :colType{other.colType}, nElem{other.nElem}, nNull{other.nNull}, validBits{other.validBits},
+      longs{other.longs}, doubles{other.doubles}, codes{other.codes}, dict{other.dict}, mixed{other.mixed}
+  {
+    rebuildDictIndex();
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Column& CSV_Column::operator=(const CSV_Column& other)
+  {
+    if (this == &other) return *this;
+
+    colType = other.colType;
+    nElem = other.nElem;
+    nNull = other.nNull;
+    validBits = other.validBits;
+    longs = other.longs;
+    doubles = other.doubles;
+    codes = other.codes;
+    dict = other.dict;
+    mixed = other.mixed;
+    rebuildDictIndex();
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_Column::isNull(size_t idx) const
+  {
+    if (idx >= nElem)
+    {
+      throw std::out_of_range("CSV_Column::isNull(): invalid index");
+    }
+
+    return ((validBits[idx / 64] >> (idx % 64)) & 1) == 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Column::append(const CSV_Value& v)
+  {
+    if (isDictionaryFullFor(v))
+    {
+      throw std::length_error("CSV_Column::append(): too many distinct strings in column");
+    }
+
+    const auto vt = v.valueType();
+
+    // map the value type to the required column type
+    Type requiredType{Type::Empty};
+    switch (vt)
+    {
+    case CSV_Value::Type::Long:
+      requiredType = Type::Long;
+      break;
+    case CSV_Value::Type::Double:
+      requiredType = Type::Double;
+      break;
+    case CSV_Value::Type::String:
+      requiredType = Type::String;
+      break;
+    default:
+      break;
+    }
+
+    // the first non-NULL value determines the column type; all
+    // previous (NULL) values get a placeholder in the typed array
+    if ((requiredType != Type::Empty) && (colType == Type::Empty))
+    {
+      colType = requiredType;
+      switch (colType)
+      {
+      case Type::Long:
+        longs.resize(nElem, 0);
+        break;
+      case Type::Double:
+        doubles.resize(nElem, 0);
+        break;
+      default:
+        codes.resize(nElem, 0);
+      }
+    }
+
+    if ((requiredType != Type::Empty) && (colType != Type::Mixed) && (requiredType != colType))
+    {
+      convertToMixed();
+    }
+
+    // update the validity bitmap
+    if ((nElem % 64) == 0) validBits.push_back(0);
+    if (vt == CSV_Value::Type::Null)
+    {
+      ++nNull;
+    } else {
+      validBits.back() |= (uint64_t{1} << (nElem % 64));
+    }
+    ++nElem;
+
+    switch (colType)
+    {
+    case Type::Long:
+      longs.push_back((vt == CSV_Value::Type::Null) ? 0 : v.get<int64_t>());
+      break;
+
+    case Type::Double:
+      doubles.push_back((vt == CSV_Value::Type::Null) ? 0 : v.get<double>());
+      break;
+
+    case Type::String:
+    {
+      if (vt == CSV_Value::Type::Null)
+      {
+        codes.push_back(0);
+        break;
+      }
+
+      const string& s = v.get<string>();
+      auto it = dictIndex.find(s);
+      if (it != dictIndex.end())
+      {
+        codes.push_back(it->second);
+        break;
+      }
+
+      const auto code = static_cast<StringCode>(dict.size());
+      dict.push_back(s);
+      dictIndex.emplace(dict.back(), code);
+      codes.push_back(code);
+      break;
+    }
+
+    case Type::Mixed:
+      mixed.push_back(v);
+      break;
+
+    default:
+      break;   // all values so far are NULL; nothing to store
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_Column::isDictionaryFullFor(const CSV_Value& v) const
+  {
+    // only new strings in a pure string column need a new code
+    if ((colType != Type::String) || (dict.size() < MaxDictionarySize)) return false;
+    if (v.valueType() != CSV_Value::Type::String) return false;
+
+    return (dictIndex.find(v.get<string>()) == dictIndex.end());
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Value CSV_Column::get(size_t idx) const
+  {
+    if (isNull(idx)) return CSV_Value{};
+
+    switch (colType)
+    {
+    case Type::Long:
+      return CSV_Value{longs[idx]};
+
+    case Type::Double:
+      return CSV_Value{doubles[idx]};
+
+    case Type::String:
+      return CSV_Value{dict[codes[idx]]};
+
+    case Type::Mixed:
+      return mixed[idx];
+
+    default:
+      return CSV_Value{};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  const string& CSV_Column::dictionaryEntry(StringCode code) const
+  {
+    return dict.at(code);
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_Column::StringCode> CSV_Column::findString(string_view s) const
+  {
+    auto it = dictIndex.find(s);
+    if (it == dictIndex.end()) return std::nullopt;
+    return it->second;
+  }
+
+  //----------------------------------------------------------------------------
+
+  double CSV_Column::sum() const
+  {
+    double result{0};
+
+    switch (colType)
+    {
+    case Type::Long:
+      // NULLs are stored as zero, so we don't need to check the bitmap
+      for (int64_t l : longs) result += static_cast<double>(l);
+      break;
+
+    case Type::Double:
+      for (double d : doubles) result += d;
+      break;
+
+    case Type::String:
+      throw std::invalid_argument("CSV_Column::sum(): column contains strings");
+
+    case Type::Mixed:
+      for (const CSV_Value& v : mixed)
+      {
+        if (v.valueType() == CSV_Value::Type::Long) result += static_cast<double>(v.get<int64_t>());
+        if (v.valueType() == CSV_Value::Type::Double) result += v.get<double>();
+      }
+      break;
+
+    default:
+      break;
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Column::convertToMixed()
+  {
+    vector<CSV_Value> tmp;
+    tmp.reserve(nElem + 1);
+    for (size_t idx = 0; idx < nElem; ++idx) tmp.push_back(get(idx));
+
+    colType = Type::Mixed;
+    mixed = std::move(tmp);
+
+    longs = vector<int64_t>{};
+    doubles = vector<double>{};
+    codes = vector<StringCode>{};
+    dictIndex.clear();
+    dict.clear();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Column::rebuildDictIndex()
+  {
+    dictIndex.clear();
+    for (size_t code = 0; code < dict.size(); ++code)
+    {
+      dictIndex.emplace(dict[code], static_cast<StringCode>(code));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  CSV_ColumnarTable::CSV_ColumnarTable(const CSV_Table& tab)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (tab.hasHeaders())
+    {
+      vector<string> hdr;
+      for (ColumnIndexType colIdx = 0; colIdx < tab.nCols(); ++colIdx)
+      {
+        hdr.push_back(tab.getHeader(colIdx));
+      }
+      setHeader(hdr);
+    }
+
+    for (auto it = tab.cbegin(); it != tab.cend(); ++it)
+    {
+      append(*it);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_ColumnarTable::CSV_ColumnarTable(CSV_Reader& reader)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (reader.hasHeaders()) setHeader(reader.headers());
+
+    // the reader guarantees a consistent column count
+    while (reader.next())
+    {
+      append(reader.row());
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_ColumnarTable::append(const CSV_Row& row)
+  {
+    // a row without columns can't be stored column-wise
+    if (row.size() == 0) return false;
+
+    // is this the first row in an empty table?
+    if (cols.empty())
+    {
+      cols.resize(row.size());
+    }
+
+    // is the number of columns correct?
+    if (row.size() != cols.size()) return false;
+
+    // check all columns before modifying any of them
+    // so that we don't end up with a partial row
+    ColumnIndexType colIdx{0};
+    for (auto it = row.cbegin(); it != row.cend(); ++it)
+    {
+      if (cols[colIdx].isDictionaryFullFor(*it))
+      {
+        throw std::length_error("CSV_ColumnarTable::append(): too many distinct strings in column " + to_string(colIdx));
+      }
+      ++colIdx;
+    }
+
+    colIdx = 0;
+    for (auto it = row.cbegin(); it != row.cend(); ++it)
+    {
+      cols[colIdx].append(*it);
+      ++colIdx;
+    }
+    ++nRows;
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_ColumnarTable::setHeader(const vector<string>& headers)
+  {
+    if (!cols.empty() && (headers.size() != cols.size()))
+    {
+      return false;
+    }
+
+    auto validHeaders = validateCSVHeaders(headers);
+    if (!validHeaders) return false;
+
+    headerNames = std::move(*validHeaders);
+
+    if (cols.empty()) cols.resize(headerNames.size());
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_ColumnarTable::ColumnIndexType> CSV_ColumnarTable::columnIndex(const string& colName) const
+  {
+    return findCSVColumn(headerNames, colName);
+  }
+
+  //----------------------------------------------------------------------------
+
+  const CSV_Column& CSV_ColumnarTable::column(ColumnIndexType colIdx) const
+  {
+    return cols.at(colIdx);
+  }
+
+  //----------------------------------------------------------------------------
+
+  const CSV_Column& CSV_ColumnarTable::column(const string& colName) const
+  {
+    const auto colIdx = columnIndex(colName);
+    if (!colIdx)
+    {
+      throw std::invalid_argument("CSV_ColumnarTable::column(): unknown column name");
+    }
+
+    return cols[*colIdx];
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Value CSV_ColumnarTable::get(RowIndexType rowIdx, ColumnIndexType colIdx) const
+  {
+    return cols.at(colIdx).get(rowIdx);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Row CSV_ColumnarTable::getRow(RowIndexType rowIdx) const
+  {
+    if (rowIdx >= nRows)
+    {
+      throw std::out_of_range("CSV_ColumnarTable::getRow(): invalid row index");
+    }
+
+    CSV_Row r;
+    for (const CSV_Column& col : cols)
+    {
+      r.append(col.get(rowIdx));
+    }
+
+    return r;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Table CSV_ColumnarTable::toTable() const
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    CSV_Table result;
+    if (hasHeaders()) result.setHeader(headerNames);
+
+    for (RowIndexType rowIdx = 0; rowIdx < nRows; ++rowIdx)
+    {
+      result.append(getRow(rowIdx));
+    }
+
+    return result;
+  }
+
+}
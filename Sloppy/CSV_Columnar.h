@@ -0,0 +1,352 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_COLUMNAR_H
+#define __LIBSLOPPY_CSV_COLUMNAR_H
+
+#include <cstddef>        // for size_t
+#include <cstdint>        // for int64_t, uint32_t, uint64_t
+#include <deque>          // for deque
+#include <limits>         // for numeric_limits
+#include <optional>       // for optional
+#include <string>         // for string
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "CSV.h"          // for CSV_Value, CSV_Row, CSV_Table
+
+namespace Sloppy
+{
+  class CSV_Reader;
+
+  /** \brief A single column of a `CSV_ColumnarTable` that stores
+   * its values in a typed, contiguous array
+   *
+   * The column type is determined by the first non-NULL value:
+   *   * integers are stored in a `vector<int64_t>`;
+   *   * doubles are stored in a `vector<double>`;
+   *   * strings are dictionary-encoded: each distinct string is stored only once
+   *     and the column holds a `vector<uint32_t>` of dictionary codes.
+   *
+   * NULL values are tracked in a separate validity bitmap. The typed array
+   * contains a placeholder (zero) at the position of a NULL value.
+   *
+   * If a value doesn't match the column type (e.g., a string in an integer
+   * column), the column falls back to type `Mixed` and stores a plain `CSV_Value`
+   * for each row. No information is lost in this case but the column
+   * loses its compact representation.
+   */
+  class CSV_Column
+  {
+  public:
+    using StringCode = uint32_t;
+
+    /** \brief The storage type of a column
+     */
+    enum class Type
+    {
+      Empty,   ///< no non-NULL values so far
+      Long,
+      Double,
+      String,   ///< dictionary-encoded strings
+      Mixed   ///< fallback for columns with different value types
+    };
+
+    /** \brief Default ctor for an empty column
+     */
+    CSV_Column() {}
+
+    /** \brief Copy ctor; rebuilds the dictionary index so that it refers to our own dictionary
+     */
+    CSV_Column(const CSV_Column& other);
+
+    /** \brief Copy assignment; rebuilds the dictionary index so that it refers to our own dictionary
+     */
+    CSV_Column& operator=(const CSV_Column& other);
+
+    CSV_Column(CSV_Column&& other) = default;
+    CSV_Column& operator=(CSV_Column&& other) = default;
+
+    /** \returns the storage type of the column
+     */
+    Type type() const { return colType; }
+
+    /** \returns the number of values (including NULLs) in the column
+     */
+    size_t size() const { return nElem; }
+
+    /** \returns the number of NULL values in the column
+     */
+    size_t nullCount() const { return nNull; }
+
+    /** \returns the validity bitmap of the column; bit `idx % 64` of
+     * element `idx / 64` is set if the value at row `idx` is not NULL
+     */
+    const std::vector<uint64_t>& validityBits() const { return validBits; }
+
+    /** \returns `true` if the value at the given index is NULL
+     *
+     * \throws std::out_of_range if the index is invalid
+     */
+    bool isNull(
+        size_t idx   ///< zero-based row index
+        ) const;
+
+    /** \brief The maximum number of distinct strings in a `String` column
+     */
+    static constexpr size_t MaxDictionarySize = size_t{std::numeric_limits<StringCode>::max()} + 1;
+
+    /** \brief Appends a value to the column; converts the
+     * column to `Mixed` if the value type doesn't match the column type
+     *
+     * \throws std::length_error if the value would be the
+     * `MaxDictionarySize + 1`-th distinct string of the column; the
+     * column is not modified in this case
+     */
+    void append(
+        const CSV_Value& v   ///< the value to append
+        );
+
+    /** \returns `true` if appending the value would require a new
+     * dictionary code although the dictionary is already full
+     */
+    bool isDictionaryFullFor(
+        const CSV_Value& v   ///< the value to check
+        ) const;
+
+    /** \returns a copy of the value at a given index
+     *
+     * \throws std::out_of_range if the index is invalid
+     */
+    CSV_Value get(
+        size_t idx   ///< zero-based row index
+        ) const;
+
+    /** \returns the raw data of a `Long` column (empty for all other types);
+     * NULL values are represented by zero
+     */
+    const std::vector<int64_t>& longData() const { return longs; }
+
+    /** \returns the raw data of a `Double` column (empty for all other types);
+     * NULL values are represented by zero
+     */
+    const std::vector<double>& doubleData() const { return doubles; }
+
+    /** \returns the dictionary codes of a `String` column (empty for all other types);
+     * NULL values are represented by zero
+     */
+    const std::vector<StringCode>& stringCodes() const { return codes; }
+
+    /** \returns the number of distinct strings in the dictionary of a `String` column
+     */
+    size_t dictionarySize() const { return dict.size(); }
+
+    /** \returns the dictionary entry for a given code
+     *
+     * \throws std::out_of_range if the code is invalid
+     */
+    const std::string& dictionaryEntry(
+        StringCode code   ///< a code from `stringCodes()`
+        ) const;
+
+    /** \returns the dictionary code of a string or an empty optional if the
+     * string doesn't occur in the column
+     *
+     * This can be used to compare a whole column against a string by simply
+     * comparing integer codes.
+     */
+    std::optional<StringCode> findString(
+        std::string_view s   ///< the string to search for
+        ) const;
+
+    /** \returns the sum of all non-NULL numeric values in the column
+     *
+     * For `Mixed` columns, string values are ignored.
+     *
+     * \throws std::invalid_argument if the column contains strings
+     */
+    double sum() const;
+
+  protected:
+    /** \brief Converts the column to type `Mixed`
+     */
+    void convertToMixed();
+
+    /** \brief Re-creates the lookup index for the string dictionary
+     */
+    void rebuildDictIndex();
+
+  private:
+    Type colType{Type::Empty};
+    size_t nElem{0};
+    size_t nNull{0};
+    std::vector<uint64_t> validBits;
+
+    std::vector<int64_t> longs;
+    std::vector<double> doubles;
+    std::vector<StringCode> codes;
+    std::deque<std::string> dict;   ///< a deque because `dictIndex` refers to the elements
+    std::unordered_map<std::string_view, StringCode> dictIndex;
+    std::vector<CSV_Value> mixed;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A CSV table with column-wise storage
+   *
+   * In contrast to `CSV_Table` which stores one `CSV_Value` per cell, this
+   * class stores each column in a typed array (see `CSV_Column`). This
+   * reduces the memory footprint of numeric columns and columns with
+   * repeating strings significantly and makes scans over a column cache-friendly.
+   *
+   * Rows can be added and retrieved using the row API (`CSV_Row`) and
+   * the table can be converted from and to a `CSV_Table`.
+   *
+   * As with `CSV_Table`, all rows must have the same number of columns.
+   */
+  class CSV_ColumnarTable
+  {
+  public:
+    using ColumnIndexType = CSV_Row::IndexType;
+    using RowIndexType = size_t;
+
+    /** \brief Default ctor, constructs an empty table without headers or data.
+     *
+     * The first appended row determins the number of columns for the table
+     */
+    CSV_ColumnarTable() {}
+
+    /** \brief Ctor that converts a row-based table into a columnar table
+     */
+    explicit CSV_ColumnarTable(
+        const CSV_Table& tab   ///< the table to convert
+        );
+
+    /** \brief Ctor that consumes all (remaining) rows of a CSV_Reader
+     *
+     * This creates a columnar table without ever holding the whole
+     * input as text or as `CSV_Row`s in memory.
+     *
+     * \throws any exception thrown by `CSV_Reader::next()`
+     */
+    explicit CSV_ColumnarTable(
+        CSV_Reader& reader   ///< the reader that provides headers and data rows
+        );
+
+    /** \brief Appends a new row to the table
+     *
+     * If you're appending a new row to an empty table, this first row
+     * determines required the number of columns for all subsequent rows
+     *
+     * \returns `true` if the row was appended successfully, `false`
+     * otherwise (i.e., because the row is empty or because the
+     * number of columns didn't match).
+     *
+     * \throws std::length_error if a string column would exceed `CSV_Column::MaxDictionarySize`
+     * distinct strings; the table is not modified in this case
+     */
+    bool append(
+        const CSV_Row& row   ///< the row that shall be appended to the table
+        );
+
+    /** \returns the number of columns in the table (0 if the table
+     * is still empty)
+     */
+    ColumnIndexType nCols() const { return cols.size(); }
+
+    /** \returns the number of data rows in the table
+     */
+    RowIndexType size() const { return nRows; }
+
+    /** \returns `true' if the table does not contain any DATA rows
+     */
+    bool empty() const { return (nRows == 0); }
+
+    /** \returns `true` if the table contains column headers
+     */
+    bool hasHeaders() const { return !headerNames.empty(); }
+
+    /** \returns all column headers (empty if the table has no headers)
+     */
+    const std::vector<std::string>& headers() const { return headerNames; }
+
+    /** \brief Sets all headers at once.
+     *
+     * The same rules as for `CSV_Table::setHeader()` apply.
+     *
+     * \returns `true` on success or `false` if any of the header conditions
+     * were not fulfilled.
+     */
+    bool setHeader(
+        const std::vector<std::string>& headers   ///< the new column headers
+        );
+
+    /** \returns the index of the column with a given header name (case-sensitive) or
+     * an empty optional if there is no such column
+     */
+    std::optional<ColumnIndexType> columnIndex(
+        const std::string& colName   ///< name of the column
+        ) const;
+
+    /** \returns a reference to a column
+     *
+     * \throws std::out_of_range if the column index was invalid
+     */
+    const CSV_Column& column(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a reference to a column
+     *
+     * \throws std::invalid_argument if the provided column name (header)
+     * could not be found
+     */
+    const CSV_Column& column(
+        const std::string& colName   ///< name of the column (case-sensitive)
+        ) const;
+
+    /** \returns a copy of the value in a given row and column
+     *
+     * \throws std::out_of_range if the column index or row index was invalid
+     */
+    CSV_Value get(
+        RowIndexType rowIdx,   ///< zero-based index of the row
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a full data row, assembled from all columns
+     *
+     * \throws std::out_of_range if the row index was invalid
+     */
+    CSV_Row getRow(
+        RowIndexType rowIdx   ///< zero-based index of the row
+        ) const;
+
+    /** \returns a row-based copy of this table, including the headers
+     */
+    CSV_Table toTable() const;
+
+  private:
+    std::vector<CSV_Column> cols;
+    std::vector<std::string> headerNames;
+    RowIndexType nRows{0};
+  };
+}
+
+#endif
@@ -0,0 +1,354 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIN32
+
+#include <algorithm>  // for sort
+#include <cstring>    // for memchr, memcpy
+#include <fstream>    // for ofstream
+#include <stdexcept>  // for invalid_argument, out_of_range, runtime_error
+
+#include "AllocTracker.h"  // for ScopedAllocTag, MemTag
+#include "Memory.h"        // for MemFile, MemView
+#include "String.h"        // for trimView
+
+#include "CSV_Index.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace
+  {
+    // layout of the index file; all values are uint64_t in host byte order:
+    //
+    //   header:      magic, CSV file size, stride, number of rows,
+    //                number of keys, flags, key column
+    //   offsets:     byte offset of every stride-th data row
+    //   key table:   (key offset in blob, key length, row index) for each
+    //                key, sorted by key
+    //   key blob:    the concatenated key strings
+    constexpr uint64_t IndexMagic = 0x31584449'56534353;   // "SCSVIDX1"
+    constexpr size_t HeaderFieldCount = 7;
+    constexpr size_t HeaderSize = HeaderFieldCount * sizeof(uint64_t);
+    constexpr size_t KeyEntrySize = 3 * sizeof(uint64_t);
+
+    constexpr uint64_t FlagHasHeaders = 0x100;
+    constexpr uint64_t FlagHasKeyColumn = 0x200;
+    constexpr uint64_t RepMask = 0xff;
+
+    // the textual key representation of a raw field
+    optional<string> keyFromField(const optional<string_view>& optChunk, CSV_StringRepresentation rep)
+    {
+      if (!optChunk.has_value()) return std::nullopt;
+
+      const string_view trimmed = trimView(*optChunk);
+      if (parseNumericCSVField(trimmed).has_value()) return string{trimmed};
+
+      const string_view content = stripCSVQuotes(*optChunk, rep);
+      const bool usesEscaping = ((rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
+      if (!usesEscaping) return string{content};
+
+      // same validation as in CSV_Row, even if there's nothing to unescape
+      if (!isValidEscapedCSVString(content))
+      {
+        throw std::invalid_argument("writeCSVRowIndex(): invalid escaped string in key column");
+      }
+      if (memchr(content.data(), '\\', content.size()) != nullptr)
+      {
+        return unescapeStringForCSV(string{content});
+      }
+
+      return string{content};
+    }
+
+    string_view memFileText(const MemFile& mf, const char* errMsg)
+    {
+      if (mf.size() < 0)
+      {
+        throw std::invalid_argument(errMsg);
+      }
+      if (mf.size() == 0) return string_view{};
+
+      const MemView v = mf.view();
+      return string_view{v.to_charPtr(), v.size()};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t writeCSVRowIndex(const MemFile& csvFile, const string& indexFileName, bool firstRowContainsHeaders,
+                          CSV_StringRepresentation rep, size_t stride, optional<CSV_Row::IndexType> keyColumn)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (stride == 0)
+    {
+      throw std::invalid_argument("writeCSVRowIndex(): stride must be larger than zero");
+    }
+
+    const string_view csvText = memFileText(csvFile, "writeCSVRowIndex(): MemFile is not associated with a file");
+    string_view data = csvText;
+
+    vector<uint64_t> offsets;
+    string keyBlob;
+    vector<uint64_t> keyEntries;   // triplets of (blob offset, length, row index)
+
+    vector<optional<string_view>> chunks;
+    string_view line;
+    size_t nRows{0};
+    bool hasHeaders{false};
+
+    if (firstRowContainsHeaders && nextCSVLine(data, line))
+    {
+      const auto hdr = validateCSVHeaders(CSV_Row{line, rep});
+      if (!hdr)
+      {
+        throw std::invalid_argument("writeCSVRowIndex(): invalid header data");
+      }
+      if (keyColumn && (*keyColumn >= hdr->size()))
+      {
+        throw std::invalid_argument("writeCSVRowIndex(): invalid key column");
+      }
+      hasHeaders = true;
+    }
+
+    while (nextCSVLine(data, line))
+    {
+      // prepareCSVLine() only removes characters from the end of
+      // the line, so the view still starts at the beginning of the line
+      if ((nRows % stride) == 0) offsets.push_back(line.data() - csvText.data());
+
+      if (keyColumn)
+      {
+        CSV_Row::splitInputInChunks(line, rep, chunks);
+        if (*keyColumn >= chunks.size())
+        {
+          throw std::invalid_argument("writeCSVRowIndex(): key column missing in data row " + to_string(nRows));
+        }
+
+        const auto key = keyFromField(chunks[*keyColumn], rep);
+        if (key)
+        {
+          keyEntries.push_back(keyBlob.size());
+          keyEntries.push_back(key->size());
+          keyEntries.push_back(nRows);
+          keyBlob += *key;
+        }
+      }
+
+      ++nRows;
+    }
+
+    // sort the keys; the stable sort keeps rows with
+    // identical keys in their original order
+    const size_t nKeys = keyEntries.size() / 3;
+    vector<size_t> order(nKeys);
+    for (size_t idx = 0; idx < nKeys; ++idx) order[idx] = idx;
+    const string_view blob{keyBlob};
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+      return blob.substr(keyEntries[3 * a], keyEntries[3 * a + 1]) < blob.substr(keyEntries[3 * b], keyEntries[3 * b + 1]);
+    });
+
+    vector<uint64_t> out;
+    out.reserve(HeaderFieldCount + offsets.size() + keyEntries.size());
+    out.push_back(IndexMagic);
+    out.push_back(csvFile.size());
+    out.push_back(stride);
+    out.push_back(nRows);
+    out.push_back(nKeys);
+    out.push_back(static_cast<uint64_t>(rep) | (hasHeaders ? FlagHasHeaders : 0) | (keyColumn ? FlagHasKeyColumn : 0));
+    out.push_back(keyColumn.value_or(0));
+    out.insert(out.end(), offsets.begin(), offsets.end());
+    for (size_t idx : order)
+    {
+      out.insert(out.end(), keyEntries.begin() + 3 * idx, keyEntries.begin() + 3 * idx + 3);
+    }
+
+    ofstream f{indexFileName, ios::binary | ios::trunc};
+    if (!f)
+    {
+      throw std::runtime_error("writeCSVRowIndex(): could not open index file for writing");
+    }
+    f.write(reinterpret_cast<const char*>(out.data()), out.size() * sizeof(uint64_t));
+    f.write(keyBlob.data(), keyBlob.size());
+    f.close();
+    if (f.fail())
+    {
+      throw std::runtime_error("writeCSVRowIndex(): could not write index file");
+    }
+
+    return nRows;
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  CSV_IndexedReader::CSV_IndexedReader(const MemFile& _csvFile, const MemFile& _indexFile)
+    :indexFile{_indexFile}
+  {
+    csvData = memFileText(_csvFile, "CSV_IndexedReader: MemFile is not associated with a file");
+
+    if ((indexFile.size() < static_cast<int64_t>(HeaderSize)) || (indexFile.getUI64(0) != IndexMagic))
+    {
+      throw std::invalid_argument("CSV_IndexedReader: invalid index file");
+    }
+    if (indexFile.getUI64(8) != static_cast<uint64_t>(_csvFile.size()))
+    {
+      throw std::invalid_argument("CSV_IndexedReader: index doesn't match the CSV file");
+    }
+
+    stride = indexFile.getUI64(16);
+    nRows = indexFile.getUI64(24);
+    nKeys = indexFile.getUI64(32);
+    const uint64_t flags = indexFile.getUI64(40);
+    const uint64_t repValue = flags & RepMask;
+    if ((stride == 0) || (repValue > static_cast<uint64_t>(CSV_StringRepresentation::QuotedAndEscaped)))
+    {
+      throw std::invalid_argument("CSV_IndexedReader: invalid index file");
+    }
+    rep = static_cast<CSV_StringRepresentation>(repValue);
+    if (flags & FlagHasKeyColumn) keyCol = indexFile.getUI64(48);
+
+    // the offset table and the key table must fit into the file; the
+    // values come from the file, so avoid overflows in the computation
+    const uint64_t fileSize = indexFile.size();
+    const uint64_t nOffsets = nRows / stride + (((nRows % stride) != 0) ? 1 : 0);
+    if (nOffsets > (fileSize - HeaderSize) / sizeof(uint64_t))
+    {
+      throw std::invalid_argument("CSV_IndexedReader: invalid index file");
+    }
+    keyTableOffset = HeaderSize + nOffsets * sizeof(uint64_t);
+    if (nKeys > (fileSize - keyTableOffset) / KeyEntrySize)
+    {
+      throw std::invalid_argument("CSV_IndexedReader: invalid index file");
+    }
+    keyBlobOffset = keyTableOffset + nKeys * KeyEntrySize;
+
+    if (flags & FlagHasHeaders)
+    {
+      string_view data = csvData;
+      string_view line;
+      nextCSVLine(data, line);
+
+      auto hdr = validateCSVHeaders(CSV_Row{line, rep});
+      if (!hdr)
+      {
+        throw std::invalid_argument("CSV_IndexedReader: invalid header data");
+      }
+      headerNames = std::move(*hdr);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  string_view CSV_IndexedReader::rawRow(RowIndexType rowIdx) const
+  {
+    if (rowIdx >= nRows)
+    {
+      throw std::out_of_range("CSV_IndexedReader::rawRow(): invalid row index");
+    }
+
+    // jump to the closest recorded row ...
+    size_t pos = indexFile.getUI64(HeaderSize + (rowIdx / stride) * sizeof(uint64_t));
+    if (pos > csvData.size())
+    {
+      throw std::invalid_argument("CSV_IndexedReader::rawRow(): invalid row offset in index");
+    }
+    string_view data = csvData.substr(pos);
+
+    // ... and skip the remaining lines
+    string_view line;
+    for (size_t n = rowIdx % stride; n > 0; --n)
+    {
+      nextCSVLine(data, line);
+    }
+    if (!nextCSVLine(data, line))
+    {
+      throw std::invalid_argument("CSV_IndexedReader::rawRow(): index doesn't match the CSV file");
+    }
+
+    return line;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Row CSV_IndexedReader::getRow(RowIndexType rowIdx) const
+  {
+    CSV_Row result{rawRow(rowIdx), rep};
+    if (hasHeaders() && (result.size() != headerNames.size()))
+    {
+      throw std::invalid_argument("CSV_IndexedReader::getRow(): inconsistent column count in data row " + to_string(rowIdx));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_IndexedReader::RowIndexType> CSV_IndexedReader::findKey(string_view key) const
+  {
+    if (!keyCol)
+    {
+      throw std::runtime_error("CSV_IndexedReader::findKey(): the index doesn't contain key values");
+    }
+
+    const MemView v = indexFile.view();
+    const string_view blob{v.to_charPtr() + keyBlobOffset, v.size() - keyBlobOffset};
+    auto keyAt = [&](size_t idx)
+    {
+      const size_t entry = keyTableOffset + idx * KeyEntrySize;
+      const size_t offset = indexFile.getUI64(entry);
+      const size_t len = indexFile.getUI64(entry + sizeof(uint64_t));
+      if ((offset > blob.size()) || (len > blob.size() - offset))
+      {
+        throw std::invalid_argument("CSV_IndexedReader::findKey(): invalid key entry in index");
+      }
+      return blob.substr(offset, len);
+    };
+
+    // lower bound => first match for duplicate keys
+    size_t lo{0};
+    size_t hi{nKeys};
+    while (lo < hi)
+    {
+      const size_t mid = lo + (hi - lo) / 2;
+      if (keyAt(mid) < key) lo = mid + 1;
+      else hi = mid;
+    }
+
+    if ((lo == nKeys) || (keyAt(lo) != key)) return std::nullopt;
+
+    return indexFile.getUI64(keyTableOffset + lo * KeyEntrySize + 2 * sizeof(uint64_t));
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_Row> CSV_IndexedReader::getRowByKey(string_view key) const
+  {
+    const auto rowIdx = findKey(key);
+    if (!rowIdx) return std::nullopt;
+
+    return getRow(*rowIdx);
+  }
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_INDEX_H
+#define __LIBSLOPPY_CSV_INDEX_H
+
+#ifndef WIN32
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <optional>     // for optional
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "CSV.h"        // for CSV_Row, CSV_StringRepresentation
+
+namespace Sloppy
+{
+  class MemFile;
+
+  /** \brief The default number of data rows between two recorded row offsets
+   */
+  static constexpr size_t DefaultCSVIndexStride = 256;
+
+  /** \brief Creates an index file for random row access into a CSV file
+   *
+   * The index records the byte offset of every n-th data row. Optionally, the values of
+   * a key column are stored as well, together with their row numbers and sorted
+   * for binary search. The index is read by `CSV_IndexedReader`.
+   *
+   * Key values are stored as text: strings are unquoted and unescaped, numbers are stored
+   * exactly as they appear in the CSV file (without surrounding white spaces). NULL values
+   * are not indexed.
+   *
+   * The CSV file is parsed with the same line rules as `CSV_Table` (see `nextCSVLine()`): rows
+   * are terminated by "\n", a trailing "\r" is removed and empty lines are ignored. Without a key
+   * column, the row content is not validated at all which makes building the index very fast.
+   *
+   * The index file uses the host's byte order and is thus not portable between
+   * platforms with different endianness.
+   *
+   * \throws std::invalid_argument if the CSV file is invalid or if the key column doesn't
+   * exist in a row
+   *
+   * \throws std::runtime_error if the index file could not be written
+   *
+   * \returns the number of data rows in the CSV file
+   */
+  size_t writeCSVRowIndex(
+      const MemFile& csvFile,   ///< the CSV file that shall be indexed
+      const std::string& indexFileName,   ///< name of the index file that shall be created (or overwritten)
+      bool firstRowContainsHeaders,   ///< if `true`, the first row contains column headers
+      CSV_StringRepresentation rep,   ///< defines how string data is represented in the CSV file
+      size_t stride = DefaultCSVIndexStride,   ///< record the offset of every n-th data row
+      std::optional<CSV_Row::IndexType> keyColumn = std::nullopt   ///< zero-based index of the column whose values shall be indexed
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Provides random access to the rows of a large CSV file
+   * with the help of an index file created by `writeCSVRowIndex()`
+   *
+   * Accessing row k only requires jumping to the closest recorded row offset
+   * and skipping at most `stride - 1` lines; no other rows are parsed.
+   * Key lookups are a binary search directly in the (memory-mapped) index file.
+   *
+   * The reader keeps references to both files; they must outlive the reader.
+   */
+  class CSV_IndexedReader
+  {
+  public:
+    using RowIndexType = size_t;
+
+    /** \brief Ctor that validates the index file and reads the headers (if any)
+     *
+     * \throws std::invalid_argument if the index file is malformed or if it doesn't
+     * match the size of the CSV file (e.g., because the CSV file has changed after
+     * the index had been created)
+     */
+    CSV_IndexedReader(
+        const MemFile& _csvFile,   ///< the CSV file
+        const MemFile& _indexFile   ///< the index file for the CSV file
+        );
+
+    /** \returns the number of data rows in the CSV file
+     */
+    RowIndexType size() const { return nRows; }
+
+    /** \returns `true` if the CSV file contains column headers
+     */
+    bool hasHeaders() const { return !headerNames.empty(); }
+
+    /** \returns all column headers (empty if the file has no headers)
+     */
+    const std::vector<std::string>& headers() const { return headerNames; }
+
+    /** \returns `true` if the index contains key values
+     */
+    bool hasKeyIndex() const { return keyCol.has_value(); }
+
+    /** \returns the raw text of a data row (without line break) as a view into the CSV file
+     *
+     * \throws std::out_of_range if the row index is invalid
+     */
+    std::string_view rawRow(
+        RowIndexType rowIdx   ///< zero-based index of the data row
+        ) const;
+
+    /** \returns a parsed data row
+     *
+     * \throws std::out_of_range if the row index is invalid
+     *
+     * \throws std::invalid_argument if the row is malformed or has the wrong number of columns
+     */
+    CSV_Row getRow(
+        RowIndexType rowIdx   ///< zero-based index of the data row
+        ) const;
+
+    /** \returns the index of the first data row whose key column contains a given
+     * value or an empty optional if there is no such row
+     *
+     * \throws std::runtime_error if the index doesn't contain key values
+     */
+    std::optional<RowIndexType> findKey(
+        std::string_view key   ///< the key as text (see `writeCSVRowIndex()`)
+        ) const;
+
+    /** \returns the first data row whose key column contains a given value
+     * or an empty optional if there is no such row
+     *
+     * \throws any exception of `findKey()` and `getRow()`
+     */
+    std::optional<CSV_Row> getRowByKey(
+        std::string_view key   ///< the key as text (see `writeCSVRowIndex()`)
+        ) const;
+
+  private:
+    const MemFile& indexFile;
+    std::string_view csvData;
+    CSV_StringRepresentation rep;
+    size_t stride;
+    RowIndexType nRows;
+    std::optional<CSV_Row::IndexType> keyCol;
+    size_t nKeys;
+    size_t keyTableOffset;
+    size_t keyBlobOffset;
+    std::vector<std::string> headerNames;
+  };
+}
+
+#endif
+
+#endif
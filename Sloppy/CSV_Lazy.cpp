@@ -0,0 +1,285 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for count
+#include <cstring>    // for memchr
+#include <stdexcept>  // for invalid_argument, out_of_range
+
+#include "AllocTracker.h"  // for ScopedAllocTag, MemTag
+#include "String.h"        // for trimView
+
+#ifndef WIN32
+#include "Memory.h"        // for MemFile, MemView
+#endif
+
+#include "CSV_Lazy.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace
+  {
+    // converts a single raw field into a lazy value,
+    // using the same rules as CSV_Row::assign()
+    CSV_LazyValue makeLazyValue(const optional<string_view>& optChunk, CSV_StringRepresentation rep, bool usesEscaping)
+    {
+      if (!optChunk.has_value()) return CSV_LazyValue{};
+
+      const CSV_Value num = parseNumericCSVField(trimView(*optChunk));
+      if (num.valueType() == CSV_Value::Type::Long) return CSV_LazyValue{num.get<int64_t>()};
+      if (num.valueType() == CSV_Value::Type::Double) return CSV_LazyValue{num.get<double>()};
+
+      const string_view content = stripCSVQuotes(*optChunk, rep);
+      if (!usesEscaping) return CSV_LazyValue{content, false};
+
+      // reject invalid input now, like CSV_Row does; only the
+      // allocation of the unescaped string is deferred
+      if (!isValidEscapedCSVString(content))
+      {
+        throw std::invalid_argument("CSV_LazyTable ctor: invalid escaped string in input");
+      }
+
+      // all escape sequences start with a backslash, so a
+      // quick search tells us whether we'll need to unescape later
+      const bool hasEscapes = (memchr(content.data(), '\\', content.size()) != nullptr);
+
+      return CSV_LazyValue{content, hasEscapes};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_LazyValue::CSV_LazyValue(const CSV_LazyValue& other)
+    :val{other.val}, hasEscapes{other.hasEscapes},
+      unescaped{other.unescaped ? make_unique<string>(*other.unescaped) : nullptr}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_LazyValue& CSV_LazyValue::operator=(const CSV_LazyValue& other)
+  {
+    if (this == &other) return *this;
+
+    val = other.val;
+    hasEscapes = other.hasEscapes;
+    unescaped = other.unescaped ? make_unique<string>(*other.unescaped) : nullptr;
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Value CSV_LazyValue::toValue() const
+  {
+    switch (valueType())
+    {
+    case Type::Long:
+      return CSV_Value{std::get<int64_t>(*val)};
+
+    case Type::Double:
+      return CSV_Value{std::get<double>(*val)};
+
+    case Type::String:
+      return CSV_Value{string{stringView()}};
+
+    default:
+      return CSV_Value{};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  string_view CSV_LazyValue::stringView() const
+  {
+    const string_view raw = std::get<string_view>(val.value());
+    if (!hasEscapes) return raw;
+
+    if (!unescaped)
+    {
+      ScopedAllocTag allocTag{MemTag::CSV};
+
+      // the field has been validated during parsing,
+      // so the unescaping itself can't fail here
+      unescaped = make_unique<string>(unescapeStringForCSV(string{raw}));
+    }
+
+    return *unescaped;
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  CSV_LazyTable::CSV_LazyTable(string_view tableData, bool firstRowContainsHeaders, CSV_StringRepresentation _rep)
+    :rep{_rep}
+  {
+    parse(tableData, firstRowContainsHeaders);
+  }
+
+  //----------------------------------------------------------------------------
+
+#ifndef WIN32
+  CSV_LazyTable::CSV_LazyTable(const MemFile& mf, bool firstRowContainsHeaders, CSV_StringRepresentation _rep)
+    :rep{_rep}
+  {
+    if (mf.size() < 0)
+    {
+      throw std::invalid_argument("CSV_LazyTable: MemFile is not associated with a file");
+    }
+
+    if (mf.size() > 0)
+    {
+      const MemView v = mf.view();
+      parse(string_view{v.to_charPtr(), v.size()}, firstRowContainsHeaders);
+    }
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_LazyTable::ColumnIndexType> CSV_LazyTable::columnIndex(const string& colName) const
+  {
+    return findCSVColumn(headerNames, colName);
+  }
+
+  //----------------------------------------------------------------------------
+
+  const CSV_LazyValue& CSV_LazyTable::get(RowIndexType rowIdx, ColumnIndexType colIdx) const
+  {
+    if ((rowIdx >= nRows) || (colIdx >= colCount))
+    {
+      throw std::out_of_range("CSV_LazyTable::get(): invalid row or column index");
+    }
+
+    return values[rowIdx * colCount + colIdx];
+  }
+
+  //----------------------------------------------------------------------------
+
+  const CSV_LazyValue& CSV_LazyTable::get(RowIndexType rowIdx, const string& colName) const
+  {
+    const auto colIdx = columnIndex(colName);
+    if (!colIdx)
+    {
+      throw std::invalid_argument("CSV_LazyTable::get(): unknown column name");
+    }
+
+    return get(rowIdx, *colIdx);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Row CSV_LazyTable::getRow(RowIndexType rowIdx) const
+  {
+    if (rowIdx >= nRows)
+    {
+      throw std::out_of_range("CSV_LazyTable::getRow(): invalid row index");
+    }
+
+    CSV_Row result;
+    for (ColumnIndexType colIdx = 0; colIdx < colCount; ++colIdx)
+    {
+      result.append(values[rowIdx * colCount + colIdx].toValue());
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Table CSV_LazyTable::toTable() const
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    CSV_Table result;
+    if (hasHeaders()) result.setHeader(headerNames);
+
+    for (RowIndexType rowIdx = 0; rowIdx < nRows; ++rowIdx)
+    {
+      result.append(getRow(rowIdx));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_LazyTable::parse(string_view tableData, bool firstRowContainsHeaders)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    const bool usesEscaping = ((rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped));
+
+    // the chunk list only holds views into the input
+    // and is re-used for all rows
+    vector<optional<string_view>> chunks;
+
+    bool expectHeader = firstRowContainsHeaders;
+    string_view line;
+    while (nextCSVLine(tableData, line))
+    {
+      if (expectHeader)
+      {
+        setHeader(line);
+        expectHeader = false;
+        continue;
+      }
+
+      CSV_Row::splitInputInChunks(line, rep, chunks);
+
+      // the first row determines the number
+      // of columns if we don't have headers
+      if (colCount == 0)
+      {
+        colCount = chunks.size();
+
+        // the number of remaining line breaks is an upper limit
+        // for the number of remaining rows
+        values.reserve(colCount * (1 + std::count(tableData.begin(), tableData.end(), '\n')));
+      }
+
+      if (chunks.size() != colCount)
+      {
+        throw std::invalid_argument("CSV_LazyTable ctor: inconsistent column count across data rows");
+      }
+
+      for (const auto& optChunk : chunks)
+      {
+        values.push_back(makeLazyValue(optChunk, rep, usesEscaping));
+      }
+      ++nRows;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_LazyTable::setHeader(string_view headerLine)
+  {
+    auto hdr = validateCSVHeaders(CSV_Row{headerLine, rep});
+    if (!hdr)
+    {
+      throw std::invalid_argument("CSV_LazyTable ctor: invalid header data");
+    }
+
+    headerNames = std::move(*hdr);
+    colCount = headerNames.size();
+  }
+
+}
@@ -0,0 +1,312 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_LAZY_H
+#define __LIBSLOPPY_CSV_LAZY_H
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int64_t
+#include <memory>       // for unique_ptr
+#include <optional>     // for optional
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <type_traits>  // for is_same_v
+#include <variant>      // for variant, get
+#include <vector>       // for vector
+
+#include "CSV.h"        // for CSV_Value, CSV_Row, CSV_Table, CSV_StringRepresentation
+
+namespace Sloppy
+{
+#ifndef WIN32
+  class MemFile;
+#endif
+
+  /** \brief A read-only CSV value that doesn't own its string data
+   *
+   * Numbers are stored directly. Strings are stored as a view into an
+   * external buffer (e.g., a memory-mapped file) that contains the raw,
+   * still escaped field content without quotation marks.
+   *
+   * If the field contains escape sequences, it is unescaped on the first
+   * access and the result is cached in the value. Fields without escape
+   * sequences never allocate memory.
+   *
+   * \warning The external buffer must outlive the value.
+   *
+   * \warning The lazy unescaping modifies the internal state of a `const` value.
+   * Concurrent reads of the same value from different threads are thus not safe
+   * unless the string has been accessed once before.
+   */
+  class CSV_LazyValue
+  {
+  public:
+    using Type = CSV_Value::Type;
+
+    /** \brief Ctor for an empty NULL value
+     */
+    CSV_LazyValue() noexcept {}
+
+    /** \brief Ctor for a 64-bit int value
+     */
+    explicit CSV_LazyValue(const int64_t& l) noexcept
+      :val{l} {}
+
+    /** \brief Ctor for a double value
+     */
+    explicit CSV_LazyValue(const double& d) noexcept
+      :val{d} {}
+
+    /** \brief Ctor for a string value that references external memory
+     */
+    CSV_LazyValue(
+        std::string_view rawContent,   ///< the field content without quotation marks, still escaped if `_hasEscapes` is set
+        bool _hasEscapes   ///< `true` if the content contains escape sequences that have to be resolved on access
+        ) noexcept
+      :val{rawContent}, hasEscapes{_hasEscapes} {}
+
+    /** \brief Copy ctor; copies the cached, unescaped string (if any)
+     */
+    CSV_LazyValue(const CSV_LazyValue& other);
+
+    /** \brief Copy assignment; copies the cached, unescaped string (if any)
+     */
+    CSV_LazyValue& operator=(const CSV_LazyValue& other);
+
+    CSV_LazyValue(CSV_LazyValue&& other) noexcept = default;
+    CSV_LazyValue& operator=(CSV_LazyValue&& other) noexcept = default;
+
+    /** \returns `true` if the value is not NULL
+     */
+    bool has_value() const { return val.has_value(); }
+
+    /** \returns the currently stored value type
+     */
+    Type valueType() const
+    {
+      if (val.has_value())
+      {
+        return static_cast<Type>(val->index());
+      }
+
+      return Type::Null;
+    }
+
+    /** \brief Direct access to the underlying value
+     *
+     * Supported types are `int64_t`, `double` and `std::string_view`. A string view
+     * refers to the unescaped string and remains valid as long as this
+     * value and the external buffer are alive.
+     *
+     * \warning We do not perform any type conversion here!
+     *
+     * \throws bad_optional_access if the contained value is empty (NULL)
+     *
+     * \throws bad_variant_access if the contained value is not of type T
+     */
+    template<typename T>
+    T get() const
+    {
+      static_assert(std::is_same_v<T, int64_t> || std::is_same_v<T, double> || std::is_same_v<T, std::string_view>,
+                    "CSV_LazyValue::get(): unsupported type");
+
+      if constexpr (std::is_same_v<T, std::string_view>)
+      {
+        return stringView();
+      } else {
+        return std::get<T>(val.value());
+      }
+    }
+
+    /** \returns the raw, still escaped string content as it appears in the CSV text
+     *
+     * \throws bad_optional_access if the contained value is empty (NULL)
+     *
+     * \throws bad_variant_access if the contained value is not a string
+     */
+    std::string_view rawView() const { return std::get<std::string_view>(val.value()); }
+
+    /** \returns `true` if the value is a string that contains escape sequences
+     * and thus requires a memory allocation on the first access
+     */
+    bool needsUnescaping() const { return hasEscapes; }
+
+    /** \returns a self-contained copy of the value as a regular `CSV_Value`
+     */
+    CSV_Value toValue() const;
+
+  protected:
+    /** \returns the unescaped string; performs the unescaping on the first call
+     */
+    std::string_view stringView() const;
+
+  private:
+    std::optional<std::variant<int64_t, double, std::string_view>> val;
+    bool hasEscapes{false};
+    mutable std::unique_ptr<std::string> unescaped;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A read-only CSV table whose string values are views into
+   * the original CSV text
+   *
+   * The table is parsed with the same rules as `CSV_Table` but instead of copying
+   * (and unescaping) every string field into a `CSV_Value`, each string field is stored
+   * as a `CSV_LazyValue` that references the input buffer. Escaped fields
+   * are validated during parsing but only resolved on first access (see `CSV_LazyValue`).
+   *
+   * All values are stored in a single, row-major array. Thus, parsing requires no
+   * allocations per row or per field which makes the table well-suited for read-mostly
+   * analytics on large (memory-mapped) files.
+   *
+   * \warning The input buffer (or `MemFile`) must outlive the table.
+   */
+  class CSV_LazyTable
+  {
+  public:
+    using ColumnIndexType = CSV_Row::IndexType;
+    using RowIndexType = size_t;
+
+    /** \brief Ctor that parses a CSV text in a buffer that is owned by the caller
+     *
+     * \throws std::invalid_argument if the input is malformed, if the headers are
+     * invalid or if the rows have different numbers of columns
+     */
+    CSV_LazyTable(
+        std::string_view tableData,   ///< the CSV text; must outlive the table
+        bool firstRowContainsHeaders,   ///< if `true`, the first row contains column headers
+        CSV_StringRepresentation _rep   ///< defines how string data is represented in the input
+        );
+
+    /** \brief Ctor that parses a CSV text in a string that is owned by the caller
+     *
+     * Only required for disambiguation because a `std::string` converts
+     * to a `std::string_view` as well as to a `MemFile`.
+     */
+    CSV_LazyTable(
+        const std::string& tableData,   ///< the CSV text; must outlive the table
+        bool firstRowContainsHeaders,   ///< if `true`, the first row contains column headers
+        CSV_StringRepresentation _rep   ///< defines how string data is represented in the input
+        )
+      :CSV_LazyTable{std::string_view{tableData}, firstRowContainsHeaders, _rep} {}
+
+    /** \brief Disabled ctor for temporary strings because the table would
+     * reference destroyed data
+     */
+    CSV_LazyTable(std::string&& tableData, bool firstRowContainsHeaders, CSV_StringRepresentation _rep) = delete;
+
+#ifndef WIN32
+    /** \brief Ctor that parses a memory-mapped file without copying its content
+     *
+     * \throws std::invalid_argument if the `MemFile` is not associated with a file
+     *
+     * \throws any exception of the string-based ctor
+     */
+    CSV_LazyTable(
+        const MemFile& mf,   ///< the file with the CSV text; must outlive the table
+        bool firstRowContainsHeaders,   ///< if `true`, the first row contains column headers
+        CSV_StringRepresentation _rep   ///< defines how string data is represented in the input
+        );
+#endif
+
+    /** \returns the number of columns in the table (0 if the table
+     * is empty)
+     */
+    ColumnIndexType nCols() const { return colCount; }
+
+    /** \returns the number of data rows in the table
+     */
+    RowIndexType size() const { return nRows; }
+
+    /** \returns `true' if the table does not contain any DATA rows
+     */
+    bool empty() const { return (nRows == 0); }
+
+    /** \returns `true` if the table contains column headers
+     */
+    bool hasHeaders() const { return !headerNames.empty(); }
+
+    /** \returns all column headers (empty if the table has no headers)
+     */
+    const std::vector<std::string>& headers() const { return headerNames; }
+
+    /** \returns the index of the column with a given header name (case-sensitive) or
+     * an empty optional if there is no such column
+     */
+    std::optional<ColumnIndexType> columnIndex(
+        const std::string& colName   ///< name of the column
+        ) const;
+
+    /** \returns a reference to the value in a given row and column
+     *
+     * \throws std::out_of_range if the column index or row index was invalid
+     */
+    const CSV_LazyValue& get(
+        RowIndexType rowIdx,   ///< zero-based index of the row
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a reference to the value in a given row and column
+     *
+     * \throws std::out_of_range if the row index was invalid
+     *
+     * \throws std::invalid_argument if the provided column name (header)
+     * could not be found
+     */
+    const CSV_LazyValue& get(
+        RowIndexType rowIdx,   ///< zero-based index of the row
+        const std::string& colName   ///< name of the column (case-sensitive)
+        ) const;
+
+    /** \returns a self-contained copy of a data row
+     *
+     * \throws std::out_of_range if the row index was invalid
+     */
+    CSV_Row getRow(
+        RowIndexType rowIdx   ///< zero-based index of the row
+        ) const;
+
+    /** \returns a self-contained, row-based copy of this table, including the headers
+     */
+    CSV_Table toTable() const;
+
+  protected:
+    /** \brief Parses the CSV text and fills the value array
+     */
+    void parse(
+        std::string_view tableData,
+        bool firstRowContainsHeaders
+        );
+
+    /** \brief Validates and stores the column headers
+     */
+    void setHeader(
+        std::string_view headerLine
+        );
+
+  private:
+    CSV_StringRepresentation rep;
+    std::vector<CSV_LazyValue> values;
+    std::vector<std::string> headerNames;
+    ColumnIndexType colCount{0};
+    RowIndexType nRows{0};
+  };
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for min, max
+#include <atomic>     // for atomic
+#include <exception>  // for exception_ptr, current_exception, rethrow_exception
+#include <stdexcept>  // for invalid_argument
+#include <thread>     // for hardware_concurrency
+#include <utility>    // for move
+
+#ifndef WIN32
+#include "Memory.h"   // for MemFile
+#endif
+#include "Tracing.h"  // for SLOPPY_TRACE_SPAN
+
+#include "CSV_Parallel.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace
+  {
+    struct ChunkResult
+    {
+      vector<CSV_Row> rows;
+      exception_ptr err;
+    };
+
+    // parses all rows in a chunk; stops at the first error
+    void parseChunk(string_view chunk, CSV_StringRepresentation rep, ChunkResult& res)
+    {
+      try
+      {
+        string_view line;
+        while (nextCSVLine(chunk, line))
+        {
+          res.rows.emplace_back(line, rep);
+        }
+      }
+      catch (...)
+      {
+        res.err = current_exception();
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void runParallelCSVTasks(size_t nTasks, size_t nThreads, const ThreadConfig& thCfg, const function<void(size_t)>& task)
+  {
+    if (nTasks == 0) return;
+    if (nTasks == 1)
+    {
+      task(0);
+      return;
+    }
+
+    vector<exception_ptr> errors(nTasks);
+    atomic<size_t> nextTask{0};
+    auto worker = [&]()
+    {
+      for (size_t idx = nextTask++; idx < nTasks; idx = nextTask++)
+      {
+        try
+        {
+          task(idx);
+        }
+        catch (...)
+        {
+          errors[idx] = current_exception();
+        }
+      }
+    };
+
+    // start the worker threads; the calling
+    // thread is one of the workers
+    nThreads = std::max<size_t>(1, std::min(nThreads, nTasks));
+    vector<ConfiguredThread> threads;
+    threads.reserve(nThreads - 1);
+    try
+    {
+      for (size_t i = 1; i < nThreads; ++i)
+      {
+        threads.emplace_back(thCfg, worker);
+      }
+    }
+    catch (...)
+    {
+      // stop the threads that have already been started
+      nextTask = nTasks;
+      for (auto& th : threads) th.join();
+      throw;
+    }
+    worker();
+    for (auto& th : threads) th.join();
+
+    for (const auto& err : errors)
+    {
+      if (err) rethrow_exception(err);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  vector<string_view> splitCSVAtRowBoundaries(string_view data, size_t nChunks)
+  {
+    vector<string_view> result;
+    if (data.empty()) return result;
+    if (nChunks == 0) nChunks = 1;
+
+    const size_t targetSize = std::max<size_t>(1, data.size() / nChunks);
+    size_t idxStart{0};
+    while (idxStart < data.size())
+    {
+      // extend each chunk up to and including the next
+      // newline after its target size
+      size_t idxEnd = data.size();
+      if ((data.size() - idxStart) > targetSize)
+      {
+        const size_t nlPos = data.find('\n', idxStart + targetSize - 1);
+        if (nlPos != string_view::npos) idxEnd = nlPos + 1;
+      }
+
+      result.push_back(data.substr(idxStart, idxEnd - idxStart));
+      idxStart = idxEnd;
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Table parseCSVTableParallel(string_view tableData, bool firstRowContainsHeaders, CSV_StringRepresentation rep, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("parseCSVTableParallel");
+
+    CSV_Table result;
+
+    // the header row is parsed upfront
+    string_view line;
+    if (firstRowContainsHeaders && nextCSVLine(tableData, line))
+    {
+      if (!result.setHeader(CSV_Row{line, rep}))
+      {
+        throw std::invalid_argument("parseCSVTableParallel(): invalid header data");
+      }
+    }
+
+    if (tableData.empty()) return result;
+
+    if (nThreads == 0) nThreads = std::max(1u, thread::hardware_concurrency());
+
+    // use a few more chunks than threads to compensate
+    // for chunks that take longer than others
+    const size_t maxChunks = std::max<size_t>(1, tableData.size() / MinParallelCSVChunkSize);
+    const auto chunks = splitCSVAtRowBoundaries(tableData, std::min(maxChunks, nThreads * 4));
+
+    // parseChunk() doesn't throw but stores the errors
+    // so that we can report the first error of the table
+    vector<ChunkResult> chunkResults(chunks.size());
+    runParallelCSVTasks(chunks.size(), nThreads, thCfg, [&](size_t idx)
+    {
+      parseChunk(chunks[idx], rep, chunkResults[idx]);
+    });
+
+    // stitch the results together in the original order
+    for (auto& res : chunkResults)
+    {
+      for (auto& r : res.rows)
+      {
+        if (!result.append(std::move(r)))
+        {
+          throw std::invalid_argument("parseCSVTableParallel(): inconsistent column count across data rows");
+        }
+      }
+
+      // the rows before the first error in this chunk
+      // are valid, so this is the first error in the table
+      if (res.err) rethrow_exception(res.err);
+
+      res.rows = vector<CSV_Row>{};
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+#ifndef WIN32
+  CSV_Table parseCSVTableParallel(const MemFile& mf, bool firstRowContainsHeaders, CSV_StringRepresentation rep, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    if (mf.size() < 0)
+    {
+      throw std::invalid_argument("parseCSVTableParallel(): MemFile is not associated with a file");
+    }
+    if (mf.size() == 0) return CSV_Table{};
+
+    const MemView v = mf.view();
+    return parseCSVTableParallel(string_view{v.to_charPtr(), v.size()}, firstRowContainsHeaders, rep, nThreads, thCfg);
+  }
+#endif
+
+}
@@ -0,0 +1,145 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_PARALLEL_H
+#define __LIBSLOPPY_CSV_PARALLEL_H
+
+#include <cstddef>       // for size_t
+#include <functional>    // for function
+#include <string>        // for string
+#include <string_view>   // for string_view
+#include <vector>        // for vector
+
+#include "CSV.h"           // for CSV_Table, CSV_StringRepresentation
+#include "ThreadConfig.h"  // for ThreadConfig
+
+namespace Sloppy
+{
+#ifndef WIN32
+  class MemFile;
+#endif
+
+  /** \brief Inputs smaller than this are never split into more than one chunk
+   */
+  constexpr size_t MinParallelCSVChunkSize = 256 * 1024;
+
+  /** \brief Splits CSV data into (roughly) equally sized chunks that
+   * start and end at row boundaries
+   *
+   * Our CSV dialect doesn't allow raw newlines inside of values (strings with
+   * newlines have to be escaped), so every "\n" is a row boundary, no matter
+   * if it appears inside a quoted value or not. Each chunk except for the last one
+   * ends with a "\n".
+   *
+   * \returns a list of views into `data` that cover the whole input without gaps
+   */
+  std::vector<std::string_view> splitCSVAtRowBoundaries(
+      std::string_view data,   ///< the CSV data
+      size_t nChunks   ///< the desired number of chunks; the result may contain fewer chunks
+      );
+
+  /** \brief Executes a task for all indices in [0, nTasks) on a set of worker threads;
+   * used by all parallel CSV functions
+   *
+   * The calling thread is one of the workers. The tasks are handed out to the workers
+   * in the order of their indices. A single task is executed directly by the calling thread.
+   *
+   * \throws the exception of the failed task with the lowest index after all tasks
+   * have been executed
+   *
+   * \throws std::invalid_argument if the thread config is invalid
+   */
+  void runParallelCSVTasks(
+      size_t nTasks,   ///< the number of tasks
+      size_t nThreads,   ///< the max. number of threads, including the calling thread
+      const ThreadConfig& thCfg,   ///< placement / scheduling parameters for the worker threads
+      const std::function<void(size_t)>& task   ///< the task; called with the task index
+      );
+
+  /** \brief Parses a CSV table using several threads
+   *
+   * The input is split at row boundaries into chunks (see `splitCSVAtRowBoundaries()`)
+   * which are parsed independently by a set of worker threads. The calling thread
+   * participates in the parsing. The parsed rows are finally appended to the
+   * result table in their original order.
+   *
+   * The parsing rules, the result and the error handling are identical to
+   * the string-based ctor of `CSV_Table`. If several rows contain errors, the
+   * exception for the first of these rows is thrown.
+   *
+   * \throws std::invalid_argument if the input string was malformed (e.g.,
+   * because of inconsistent use of quotation marks).
+   *
+   * \throws std::invalid_argument if the number of columns is inconsistent
+   * between rows.
+   *
+   * \throws std::invalid_argument if any of the header naming conditions
+   * is violated by the input data or if the thread config is invalid.
+   */
+  CSV_Table parseCSVTableParallel(
+      std::string_view tableData,   ///< the string that shall be parsed
+      bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+      CSV_StringRepresentation rep,   ///< defines how string data is represented in the input string
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+
+  /** \brief Convenience overload for strings; only required for disambiguation
+   * because a `std::string` converts to a `std::string_view` as well as to a `MemFile`
+   */
+  inline CSV_Table parseCSVTableParallel(
+      const std::string& tableData,   ///< the string that shall be parsed
+      bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+      CSV_StringRepresentation rep,   ///< defines how string data is represented in the input string
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      )
+  {
+    return parseCSVTableParallel(std::string_view{tableData}, firstRowContainsHeaders, rep, nThreads, thCfg);
+  }
+
+  /** \brief Convenience overload for C strings; only required for disambiguation
+   */
+  inline CSV_Table parseCSVTableParallel(
+      const char* tableData,   ///< the string that shall be parsed
+      bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+      CSV_StringRepresentation rep,   ///< defines how string data is represented in the input string
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      )
+  {
+    return parseCSVTableParallel(std::string_view{tableData}, firstRowContainsHeaders, rep, nThreads, thCfg);
+  }
+
+#ifndef WIN32
+  /** \brief Parses a memory-mapped CSV file using several threads;
+   * convenience wrapper for the string-based `parseCSVTableParallel()`
+   *
+   * \throws std::invalid_argument if the MemFile is not associated with a file
+   */
+  CSV_Table parseCSVTableParallel(
+      const MemFile& mf,   ///< the mapped file that contains the CSV data
+      bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+      CSV_StringRepresentation rep,   ///< defines how string data is represented in the input
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+#endif
+}
+
+#endif
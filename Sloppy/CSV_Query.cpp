@@ -0,0 +1,1171 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>      // for stable_sort, inplace_merge, sort, min, max
+#include <bit>            // for countr_zero
+#include <cstring>        // for memcpy
+#include <functional>     // for equal_to, less, ...
+#include <numeric>        // for iota
+#include <stdexcept>      // for invalid_argument, out_of_range
+#include <string>         // for string
+#include <string_view>    // for string_view
+#include <thread>         // for hardware_concurrency
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for pair
+
+#include "AllocTracker.h"  // for ScopedAllocTag, MemTag
+#include "CSV_Parallel.h"  // for runParallelCSVTasks
+#include "Tracing.h"       // for SLOPPY_TRACE_SPAN
+
+#include "CSV_Query.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace
+  {
+    using RowIndexType = CSV_ColumnarTable::RowIndexType;
+    using ColumnIndexType = CSV_ColumnarTable::ColumnIndexType;
+    using RowRange = pair<size_t, size_t>;
+
+    constexpr size_t NoRow = static_cast<size_t>(-1);
+
+    //--------------------------------------------------------------------------
+    // threading
+
+    size_t effectiveThreadCount(size_t nThreads, size_t nRows)
+    {
+      const size_t maxByRows = std::max<size_t>(1, nRows / MinParallelQueryRows);
+      if (maxByRows == 1) return 1;   // don't query the hardware for small tables, it's a syscall
+
+      if (nThreads == 0) nThreads = std::max(1u, thread::hardware_concurrency());
+      return std::min(nThreads, maxByRows);
+    }
+
+    // splits [0, n) into at most `nParts` consecutive ranges whose
+    // boundaries are multiples of 64 so that each range starts at
+    // a new word of the validity bitmaps
+    vector<RowRange> splitRows(size_t n, size_t nParts)
+    {
+      vector<RowRange> result;
+      const size_t partSize = std::max<size_t>(64, ((n / nParts + 63) / 64) * 64);
+      for (size_t start = 0; start < n; start += partSize)
+      {
+        result.emplace_back(start, std::min(n, start + partSize));
+      }
+      if (result.empty()) result.emplace_back(0, 0);
+
+      return result;
+    }
+
+    CSV_Selection concatSelections(const vector<CSV_Selection>& parts)
+    {
+      size_t total{0};
+      for (const auto& p : parts) total += p.size();
+
+      CSV_Selection result;
+      result.reserve(total);
+      for (const auto& p : parts) result.insert(result.end(), p.begin(), p.end());
+
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    // value encoding
+
+    inline bool isValid(const vector<uint64_t>& validBits, size_t idx)
+    {
+      return ((validBits[idx / 64] >> (idx % 64)) & 1) != 0;
+    }
+
+    int compareNumbers(const CSV_Value& a, const CSV_Value& b)
+    {
+      if ((a.valueType() == CSV_Value::Type::Long) && (b.valueType() == CSV_Value::Type::Long))
+      {
+        const int64_t la = a.get<int64_t>();
+        const int64_t lb = b.get<int64_t>();
+        return (la < lb) ? -1 : ((la > lb) ? 1 : 0);
+      }
+
+      const double da = (a.valueType() == CSV_Value::Type::Long) ? static_cast<double>(a.get<int64_t>()) : a.get<double>();
+      const double db = (b.valueType() == CSV_Value::Type::Long) ? static_cast<double>(b.get<int64_t>()) : b.get<double>();
+      return (da < db) ? -1 : ((da > db) ? 1 : 0);
+    }
+
+    // the rank of a value type in the order of compareCSVValues()
+    int typeRank(CSV_Value::Type t)
+    {
+      switch (t)
+      {
+      case CSV_Value::Type::Null:
+        return 0;
+      case CSV_Value::Type::String:
+        return 2;
+      default:
+        return 1;
+      }
+    }
+
+    // bits of a double that are identical for equal values
+    uint64_t doubleKeyBits(double d)
+    {
+      if (d == 0) d = 0;   // -0.0 == +0.0
+
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(d));
+      return bits;
+    }
+
+    // maps numbers to unsigned integers with the same order
+    uint64_t orderedBits(int64_t l)
+    {
+      return static_cast<uint64_t>(l) ^ (uint64_t{1} << 63);
+    }
+    uint64_t orderedBits(double d)
+    {
+      const uint64_t bits = doubleKeyBits(d);
+      return (bits & (uint64_t{1} << 63)) ? ~bits : (bits | (uint64_t{1} << 63));
+    }
+
+    // a unique string for each value of a mixed column
+    string mixedKeyString(const CSV_Value& v)
+    {
+      string result;
+      switch (v.valueType())
+      {
+      case CSV_Value::Type::Long:
+      {
+        const int64_t l = v.get<int64_t>();
+        result = "L";
+        result.append(reinterpret_cast<const char*>(&l), sizeof(l));
+        break;
+      }
+
+      case CSV_Value::Type::Double:
+      {
+        const uint64_t bits = doubleKeyBits(v.get<double>());
+        result = "D";
+        result.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        break;
+      }
+
+      default:
+        result = "S" + v.get<string>();
+      }
+
+      return result;
+    }
+
+    // the codes for the values of a key column (group-by or join);
+    // non-NULL values have identical codes if and only if they are equal
+    struct KeyColumn
+    {
+      const CSV_Column* col;
+      vector<uint64_t> codes;
+      unordered_map<string, uint64_t> mixedIds;   ///< only used for mixed columns
+    };
+
+    KeyColumn makeKeyColumn(const CSV_Column& col)
+    {
+      KeyColumn kc;
+      kc.col = &col;
+      kc.codes.resize(col.size());
+
+      const size_t n = col.size();
+      switch (col.type())
+      {
+      case CSV_Column::Type::Long:
+        for (size_t i = 0; i < n; ++i) kc.codes[i] = static_cast<uint64_t>(col.longData()[i]);
+        break;
+
+      case CSV_Column::Type::Double:
+        for (size_t i = 0; i < n; ++i) kc.codes[i] = doubleKeyBits(col.doubleData()[i]);
+        break;
+
+      case CSV_Column::Type::String:
+        for (size_t i = 0; i < n; ++i) kc.codes[i] = col.stringCodes()[i];
+        break;
+
+      case CSV_Column::Type::Mixed:
+        for (size_t i = 0; i < n; ++i)
+        {
+          if (col.isNull(i)) continue;
+          auto it = kc.mixedIds.try_emplace(mixedKeyString(col.get(i)), kc.mixedIds.size()).first;
+          kc.codes[i] = it->second;
+        }
+        break;
+
+      default:
+        break;   // only NULL values
+      }
+
+      return kc;
+    }
+
+    // encodes the values of a column with the codes of a key column in another table;
+    // `usable` is cleared for NULL values and for values that don't occur in the key column
+    void encodeProbeColumn(const CSV_Column& probe, const KeyColumn& kc, vector<uint64_t>& codes, vector<uint8_t>& usable)
+    {
+      const size_t n = probe.size();
+      codes.assign(n, 0);
+      usable.assign(n, 0);
+
+      const CSV_Column& build = *kc.col;
+      const auto& validBits = probe.validityBits();
+
+      // fast paths for identical column types
+      if ((probe.type() == CSV_Column::Type::Long) && (build.type() == CSV_Column::Type::Long))
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          codes[i] = static_cast<uint64_t>(probe.longData()[i]);
+          usable[i] = isValid(validBits, i);
+        }
+        return;
+      }
+      if ((probe.type() == CSV_Column::Type::Double) && (build.type() == CSV_Column::Type::Double))
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          codes[i] = doubleKeyBits(probe.doubleData()[i]);
+          usable[i] = isValid(validBits, i);
+        }
+        return;
+      }
+      if ((probe.type() == CSV_Column::Type::String) && (build.type() == CSV_Column::Type::String))
+      {
+        // translate the dictionary codes once per dictionary entry
+        vector<optional<CSV_Column::StringCode>> translation(probe.dictionarySize());
+        for (size_t code = 0; code < translation.size(); ++code)
+        {
+          translation[code] = build.findString(probe.dictionaryEntry(code));
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+          const auto& tr = translation[probe.stringCodes()[i]];
+          if (!isValid(validBits, i) || !tr) continue;
+          codes[i] = *tr;
+          usable[i] = 1;
+        }
+        return;
+      }
+
+      // generic path for all other combinations
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (!isValid(validBits, i)) continue;
+        const CSV_Value v = probe.get(i);
+
+        switch (build.type())
+        {
+        case CSV_Column::Type::Long:
+          if (v.valueType() != CSV_Value::Type::Long) continue;
+          codes[i] = static_cast<uint64_t>(v.get<int64_t>());
+          break;
+
+        case CSV_Column::Type::Double:
+          if (v.valueType() != CSV_Value::Type::Double) continue;
+          codes[i] = doubleKeyBits(v.get<double>());
+          break;
+
+        case CSV_Column::Type::String:
+        {
+          if (v.valueType() != CSV_Value::Type::String) continue;
+          const auto code = build.findString(v.get<string>());
+          if (!code) continue;
+          codes[i] = *code;
+          break;
+        }
+
+        case CSV_Column::Type::Mixed:
+        {
+          auto it = kc.mixedIds.find(mixedKeyString(v));
+          if (it == kc.mixedIds.end()) continue;
+          codes[i] = it->second;
+          break;
+        }
+
+        default:
+          continue;
+        }
+
+        usable[i] = 1;
+      }
+    }
+
+    inline uint64_t mix64(uint64_t x)
+    {
+      // the finalizer of splitmix64
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+      return x ^ (x >> 31);
+    }
+
+    constexpr uint64_t HashSeed = 0x9e3779b97f4a7c15;
+    constexpr uint64_t NullHashMarker = 0x5bd1e9955bd1e995;
+
+    //--------------------------------------------------------------------------
+    // filtering
+
+    bool matchesOrder(int c, CSV_CompareOp op)
+    {
+      switch (op)
+      {
+      case CSV_CompareOp::Equal:
+        return (c == 0);
+      case CSV_CompareOp::NotEqual:
+        return (c != 0);
+      case CSV_CompareOp::Less:
+        return (c < 0);
+      case CSV_CompareOp::LessOrEqual:
+        return (c <= 0);
+      case CSV_CompareOp::Greater:
+        return (c > 0);
+      default:
+        return (c >= 0);
+      }
+    }
+
+    // calls `f` with a comparison functor for the operator
+    template<typename F>
+    void withComparator(CSV_CompareOp op, F&& f)
+    {
+      switch (op)
+      {
+      case CSV_CompareOp::Equal:
+        f(std::equal_to<>{});
+        break;
+      case CSV_CompareOp::NotEqual:
+        f(std::not_equal_to<>{});
+        break;
+      case CSV_CompareOp::Less:
+        f(std::less<>{});
+        break;
+      case CSV_CompareOp::LessOrEqual:
+        f(std::less_equal<>{});
+        break;
+      case CSV_CompareOp::Greater:
+        f(std::greater<>{});
+        break;
+      default:
+        f(std::greater_equal<>{});
+      }
+    }
+
+    // builds the row predicate "column value <op> operand" for a column
+    // and calls `f` with it; the predicate ignores the validity bitmap
+    template<typename F>
+    void withRowPredicate(const CSV_Column& col, CSV_CompareOp op, const CSV_Value& operand, F&& f)
+    {
+      const auto ot = operand.valueType();
+      const bool numericOperand = (ot != CSV_Value::Type::String);
+
+      switch (col.type())
+      {
+      case CSV_Column::Type::Long:
+      {
+        if (!numericOperand) break;
+
+        const int64_t* data = col.longData().data();
+        if (ot == CSV_Value::Type::Long)
+        {
+          const int64_t v = operand.get<int64_t>();
+          withComparator(op, [&](auto cmp) { f([=](size_t i) { return cmp(data[i], v); }); });
+        } else {
+          const double v = operand.get<double>();
+          withComparator(op, [&](auto cmp) { f([=](size_t i) { return cmp(static_cast<double>(data[i]), v); }); });
+        }
+        return;
+      }
+
+      case CSV_Column::Type::Double:
+      {
+        if (!numericOperand) break;
+
+        const double* data = col.doubleData().data();
+        const double v = (ot == CSV_Value::Type::Long) ? static_cast<double>(operand.get<int64_t>()) : operand.get<double>();
+        withComparator(op, [&](auto cmp) { f([=](size_t i) { return cmp(data[i], v); }); });
+        return;
+      }
+
+      case CSV_Column::Type::String:
+      {
+        // evaluate the comparison only once per dictionary entry;
+        // strings are always larger than numbers
+        vector<uint8_t> codeMatches(col.dictionarySize());
+        for (size_t code = 0; code < codeMatches.size(); ++code)
+        {
+          int c{1};
+          if (!numericOperand)
+          {
+            c = string_view{col.dictionaryEntry(code)}.compare(operand.get<string>());
+          }
+          codeMatches[code] = matchesOrder(c, op);
+        }
+
+        const CSV_Column::StringCode* codes = col.stringCodes().data();
+        const uint8_t* m = codeMatches.data();
+        f([=](size_t i) { return m[codes[i]] != 0; });
+        return;
+      }
+
+      case CSV_Column::Type::Mixed:
+        f([&col, &operand, op](size_t i) { return matchesOrder(compareCSVValues(col.get(i), operand), op); });
+        return;
+
+      default:
+        f([](size_t) { return false; });   // only NULL values
+        return;
+      }
+
+      // numeric column vs. string operand: numbers
+      // are always smaller than strings
+      const bool result = matchesOrder(-1, op);
+      f([result](size_t) { return result; });
+    }
+
+    // evaluates `pred` for 64 rows at a time and appends all matching non-NULL
+    // rows in [begin, end) to `out`; `begin` must be a multiple of 64
+    template<typename Pred>
+    void selectRange(const vector<uint64_t>& validBits, size_t begin, size_t end, const Pred& pred, CSV_Selection& out)
+    {
+      for (size_t blockStart = begin; blockStart < end; blockStart += 64)
+      {
+        const size_t n = std::min<size_t>(64, end - blockStart);
+
+        uint64_t mask{0};
+        for (size_t i = 0; i < n; ++i)
+        {
+          mask |= static_cast<uint64_t>(pred(blockStart + i)) << i;
+        }
+        mask &= validBits[blockStart / 64];
+
+        while (mask != 0)
+        {
+          out.push_back(blockStart + countr_zero(mask));
+          mask &= mask - 1;
+        }
+      }
+    }
+
+    void assertValidSelection(const CSV_Selection& sel, size_t nRows, const char* errMsg)
+    {
+      for (RowIndexType row : sel)
+      {
+        if (row >= nRows) throw std::out_of_range(errMsg);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    // sorting
+
+    struct SortColumn
+    {
+      vector<uint64_t> codes;   ///< order-preserving codes for all rows
+      const vector<uint64_t>* validBits;
+      bool ascending;
+    };
+
+    vector<uint64_t> makeSortCodes(const CSV_Column& col)
+    {
+      const size_t n = col.size();
+      vector<uint64_t> result(n);
+
+      switch (col.type())
+      {
+      case CSV_Column::Type::Long:
+        for (size_t i = 0; i < n; ++i) result[i] = orderedBits(col.longData()[i]);
+        break;
+
+      case CSV_Column::Type::Double:
+        for (size_t i = 0; i < n; ++i) result[i] = orderedBits(col.doubleData()[i]);
+        break;
+
+      case CSV_Column::Type::String:
+      {
+        // sort the dictionary once and use the
+        // rank of each entry as code
+        vector<CSV_Column::StringCode> byValue(col.dictionarySize());
+        iota(byValue.begin(), byValue.end(), 0);
+        sort(byValue.begin(), byValue.end(), [&col](CSV_Column::StringCode a, CSV_Column::StringCode b)
+        {
+          return col.dictionaryEntry(a) < col.dictionaryEntry(b);
+        });
+
+        vector<uint64_t> rank(byValue.size());
+        for (size_t r = 0; r < byValue.size(); ++r) rank[byValue[r]] = r;
+
+        for (size_t i = 0; i < n; ++i) result[i] = rank[col.stringCodes()[i]];
+        break;
+      }
+
+      case CSV_Column::Type::Mixed:
+      {
+        // dense ranks of all values
+        vector<CSV_Value> vals;
+        vals.reserve(n);
+        for (size_t i = 0; i < n; ++i) vals.push_back(col.get(i));
+
+        vector<size_t> order(n);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&vals](size_t a, size_t b) { return compareCSVValues(vals[a], vals[b]) < 0; });
+
+        uint64_t r{0};
+        for (size_t k = 0; k < n; ++k)
+        {
+          if ((k > 0) && (compareCSVValues(vals[order[k - 1]], vals[order[k]]) != 0)) ++r;
+          result[order[k]] = r;
+        }
+        break;
+      }
+
+      default:
+        break;   // only NULL values
+      }
+
+      return result;
+    }
+
+    struct RowComparator
+    {
+      const vector<SortColumn>& keys;
+
+      bool operator()(size_t a, size_t b) const
+      {
+        for (const auto& k : keys)
+        {
+          const bool va = isValid(*k.validBits, a);
+          const bool vb = isValid(*k.validBits, b);
+
+          int c{0};
+          if (va != vb)
+          {
+            c = va ? 1 : -1;   // NULL first
+          } else if (va) {
+            c = (k.codes[a] < k.codes[b]) ? -1 : ((k.codes[a] > k.codes[b]) ? 1 : 0);
+          }
+
+          if (c != 0) return k.ascending ? (c < 0) : (c > 0);
+        }
+
+        return false;
+      }
+    };
+
+    CSV_Selection sortSelection(const CSV_ColumnarTable& tab, CSV_Selection sel, const vector<CSV_SortKey>& keys, size_t nThreads, const ThreadConfig& thCfg)
+    {
+      ScopedAllocTag allocTag{MemTag::CSV};
+
+      if (keys.empty())
+      {
+        throw std::invalid_argument("sortRows(): no sort keys provided");
+      }
+
+      vector<SortColumn> sortCols;
+      for (const auto& k : keys)
+      {
+        const CSV_Column& col = tab.column(k.colIdx);
+        sortCols.push_back(SortColumn{makeSortCodes(col), &col.validityBits(), k.ascending});
+      }
+      const RowComparator cmp{sortCols};
+
+      // sort chunks in parallel ...
+      const auto ranges = splitRows(sel.size(), effectiveThreadCount(nThreads, sel.size()));
+      runParallelCSVTasks(ranges.size(), ranges.size(), thCfg, [&](size_t idx)
+      {
+        stable_sort(sel.begin() + ranges[idx].first, sel.begin() + ranges[idx].second, cmp);
+      });
+
+      // ... and merge neighbouring chunks until only one chunk is
+      // left; merging neighbours in order keeps the sort stable
+      vector<size_t> bounds;
+      for (const auto& r : ranges) bounds.push_back(r.first);
+      bounds.push_back(sel.size());
+      while (bounds.size() > 2)
+      {
+        const size_t nPairs = (bounds.size() - 1) / 2;
+        runParallelCSVTasks(nPairs, nPairs, thCfg, [&](size_t p)
+        {
+          inplace_merge(sel.begin() + bounds[2 * p], sel.begin() + bounds[2 * p + 1], sel.begin() + bounds[2 * p + 2], cmp);
+        });
+
+        vector<size_t> merged;
+        for (size_t i = 0; i < bounds.size(); i += 2) merged.push_back(bounds[i]);
+        if (merged.back() != sel.size()) merged.push_back(sel.size());
+        bounds = std::move(merged);
+      }
+
+      return sel;
+    }
+
+    //--------------------------------------------------------------------------
+    // grouping
+
+    // hashes and compares the key of a row
+    struct GroupKeys
+    {
+      const vector<KeyColumn>& keyCols;
+      const vector<uint64_t>& hashes;
+
+      size_t operator()(size_t row) const noexcept { return hashes[row]; }
+
+      bool operator()(size_t a, size_t b) const noexcept
+      {
+        for (const auto& kc : keyCols)
+        {
+          const auto& validBits = kc.col->validityBits();
+          const bool va = isValid(validBits, a);
+          if (va != isValid(validBits, b)) return false;
+          if (va && (kc.codes[a] != kc.codes[b])) return false;
+        }
+        return true;
+      }
+    };
+
+    // maps a representative row to a group ID
+    using GroupMap = unordered_map<size_t, uint32_t, GroupKeys, GroupKeys>;
+
+    struct Accumulator
+    {
+      uint64_t count{0};   ///< non-NULL values
+      uint64_t numCount{0};   ///< numeric values
+      int64_t longSum{0};
+      double doubleSum{0};   ///< also takes the part of an integer sum that doesn't fit into `longSum`
+      bool isLongSumOverflow{false};
+      size_t minRow{NoRow};
+      size_t maxRow{NoRow};
+    };
+
+    // adds a value to the exact integer sum; once the integer
+    // sum would overflow, all further values go to `doubleSum`
+    void addToLongSum(int64_t v, Accumulator& acc)
+    {
+      int64_t sum;
+      if (!acc.isLongSumOverflow && !__builtin_add_overflow(acc.longSum, v, &sum))
+      {
+        acc.longSum = sum;
+        return;
+      }
+
+      acc.isLongSumOverflow = true;
+      acc.doubleSum += static_cast<double>(v);
+    }
+
+    bool rowLess(const CSV_Column& col, size_t a, size_t b)
+    {
+      switch (col.type())
+      {
+      case CSV_Column::Type::Long:
+        return col.longData()[a] < col.longData()[b];
+
+      case CSV_Column::Type::Double:
+        return col.doubleData()[a] < col.doubleData()[b];
+
+      case CSV_Column::Type::String:
+        return col.dictionaryEntry(col.stringCodes()[a]) < col.dictionaryEntry(col.stringCodes()[b]);
+
+      default:
+        return compareCSVValues(col.get(a), col.get(b)) < 0;
+      }
+    }
+
+    void accumulate(const CSV_Column& col, size_t row, Accumulator& acc)
+    {
+      ++acc.count;
+
+      switch (col.type())
+      {
+      case CSV_Column::Type::Long:
+        addToLongSum(col.longData()[row], acc);
+        ++acc.numCount;
+        break;
+
+      case CSV_Column::Type::Double:
+        acc.doubleSum += col.doubleData()[row];
+        ++acc.numCount;
+        break;
+
+      case CSV_Column::Type::Mixed:
+      {
+        const CSV_Value v = col.get(row);
+        if (v.valueType() == CSV_Value::Type::Long)
+        {
+          acc.doubleSum += static_cast<double>(v.get<int64_t>());
+          ++acc.numCount;
+        }
+        if (v.valueType() == CSV_Value::Type::Double)
+        {
+          acc.doubleSum += v.get<double>();
+          ++acc.numCount;
+        }
+        break;
+      }
+
+      default:
+        break;
+      }
+
+      if ((acc.minRow == NoRow) || rowLess(col, row, acc.minRow)) acc.minRow = row;
+      if ((acc.maxRow == NoRow) || rowLess(col, acc.maxRow, row)) acc.maxRow = row;
+    }
+
+    // merges the accumulator of a later part of the table into `acc`
+    void mergeAccumulator(const CSV_Column& col, const Accumulator& other, Accumulator& acc)
+    {
+      acc.count += other.count;
+      acc.numCount += other.numCount;
+      addToLongSum(other.longSum, acc);
+      acc.doubleSum += other.doubleSum;
+      if (other.isLongSumOverflow) acc.isLongSumOverflow = true;
+
+      if (other.minRow != NoRow)
+      {
+        if ((acc.minRow == NoRow) || rowLess(col, other.minRow, acc.minRow)) acc.minRow = other.minRow;
+        if ((acc.maxRow == NoRow) || rowLess(col, acc.maxRow, other.maxRow)) acc.maxRow = other.maxRow;
+      }
+    }
+
+    CSV_Value aggregateResult(const CSV_Column& col, CSV_AggregateFunction func, const Accumulator& acc)
+    {
+      switch (func)
+      {
+      case CSV_AggregateFunction::Count:
+        return CSV_Value{static_cast<int64_t>(acc.count)};
+
+      case CSV_AggregateFunction::Sum:
+        if (acc.numCount == 0) return CSV_Value{};
+        if ((col.type() == CSV_Column::Type::Long) && !acc.isLongSumOverflow) return CSV_Value{acc.longSum};
+        return CSV_Value{static_cast<double>(acc.longSum) + acc.doubleSum};
+
+      case CSV_AggregateFunction::Mean:
+        if (acc.numCount == 0) return CSV_Value{};
+        return CSV_Value{(static_cast<double>(acc.longSum) + acc.doubleSum) / acc.numCount};
+
+      case CSV_AggregateFunction::Min:
+        return (acc.minRow == NoRow) ? CSV_Value{} : col.get(acc.minRow);
+
+      default:
+        return (acc.maxRow == NoRow) ? CSV_Value{} : col.get(acc.maxRow);
+      }
+    }
+
+    string aggregateName(CSV_AggregateFunction func)
+    {
+      switch (func)
+      {
+      case CSV_AggregateFunction::Count:
+        return "count";
+      case CSV_AggregateFunction::Sum:
+        return "sum";
+      case CSV_AggregateFunction::Min:
+        return "min";
+      case CSV_AggregateFunction::Max:
+        return "max";
+      default:
+        return "mean";
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  int compareCSVValues(const CSV_Value& a, const CSV_Value& b)
+  {
+    const int ra = typeRank(a.valueType());
+    const int rb = typeRank(b.valueType());
+    if (ra != rb) return (ra < rb) ? -1 : 1;
+
+    switch (ra)
+    {
+    case 0:
+      return 0;   // NULL == NULL
+
+    case 1:
+      return compareNumbers(a, b);
+
+    default:
+      const int c = a.get<string>().compare(b.get<string>());
+      return (c < 0) ? -1 : ((c > 0) ? 1 : 0);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Selection filterRows(const CSV_ColumnarTable& tab, CSV_ColumnarTable::ColumnIndexType colIdx, CSV_CompareOp op, const CSV_Value& operand, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("filterRows");
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (!operand.has_value())
+    {
+      throw std::invalid_argument("filterRows(): the operand is NULL");
+    }
+
+    const CSV_Column& col = tab.column(colIdx);
+    const auto ranges = splitRows(tab.size(), effectiveThreadCount(nThreads, tab.size()));
+    vector<CSV_Selection> partial(ranges.size());
+
+    withRowPredicate(col, op, operand, [&](const auto& pred)
+    {
+      runParallelCSVTasks(ranges.size(), ranges.size(), thCfg, [&](size_t idx)
+      {
+        selectRange(col.validityBits(), ranges[idx].first, ranges[idx].second, pred, partial[idx]);
+      });
+    });
+
+    return concatSelections(partial);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Selection filterRows(const CSV_ColumnarTable& tab, const CSV_Selection& candidates, CSV_ColumnarTable::ColumnIndexType colIdx, CSV_CompareOp op, const CSV_Value& operand, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("filterRows");
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (!operand.has_value())
+    {
+      throw std::invalid_argument("filterRows(): the operand is NULL");
+    }
+
+    const CSV_Column& col = tab.column(colIdx);
+    assertValidSelection(candidates, tab.size(), "filterRows(): invalid row index in selection");
+
+    const auto ranges = splitRows(candidates.size(), effectiveThreadCount(nThreads, candidates.size()));
+    vector<CSV_Selection> partial(ranges.size());
+
+    withRowPredicate(col, op, operand, [&](const auto& pred)
+    {
+      runParallelCSVTasks(ranges.size(), ranges.size(), thCfg, [&](size_t idx)
+      {
+        const auto& validBits = col.validityBits();
+        for (size_t k = ranges[idx].first; k < ranges[idx].second; ++k)
+        {
+          const RowIndexType row = candidates[k];
+          if (isValid(validBits, row) && pred(row)) partial[idx].push_back(row);
+        }
+      });
+    });
+
+    return concatSelections(partial);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_ColumnarTable selectRows(const CSV_ColumnarTable& tab, const CSV_Selection& sel)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    CSV_ColumnarTable result;
+    if (tab.hasHeaders()) result.setHeader(tab.headers());
+
+    for (RowIndexType row : sel)
+    {
+      result.append(tab.getRow(row));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Selection sortRows(const CSV_ColumnarTable& tab, const vector<CSV_SortKey>& keys, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("sortRows");
+
+    CSV_Selection sel(tab.size());
+    iota(sel.begin(), sel.end(), 0);
+
+    return sortSelection(tab, std::move(sel), keys, nThreads, thCfg);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Selection sortRows(const CSV_ColumnarTable& tab, const CSV_Selection& sel, const vector<CSV_SortKey>& keys, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("sortRows");
+
+    assertValidSelection(sel, tab.size(), "sortRows(): invalid row index in selection");
+
+    return sortSelection(tab, sel, keys, nThreads, thCfg);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_ColumnarTable groupBy(const CSV_ColumnarTable& tab, const vector<CSV_ColumnarTable::ColumnIndexType>& keyCols, const vector<CSV_Aggregate>& aggregates, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("groupBy");
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (keyCols.empty())
+    {
+      throw std::invalid_argument("groupBy(): no key columns provided");
+    }
+    for (const auto& agg : aggregates)
+    {
+      const CSV_Column& col = tab.column(agg.colIdx);
+      const bool isNumericFunc = ((agg.func == CSV_AggregateFunction::Sum) || (agg.func == CSV_AggregateFunction::Mean));
+      if (isNumericFunc && (col.type() == CSV_Column::Type::String))
+      {
+        throw std::invalid_argument("groupBy(): sum or mean requested for a string column");
+      }
+    }
+
+    // prepare the result headers first so that
+    // we fail early if they're invalid
+    vector<string> headers;
+    if (tab.hasHeaders())
+    {
+      for (ColumnIndexType colIdx : keyCols)
+      {
+        headers.push_back(tab.headers().at(colIdx));
+      }
+      for (const auto& agg : aggregates)
+      {
+        headers.push_back(aggregateName(agg.func) + "(" + tab.headers()[agg.colIdx] + ")");
+      }
+    }
+    CSV_ColumnarTable result;
+    if (tab.hasHeaders() && !result.setHeader(headers))
+    {
+      throw std::invalid_argument("groupBy(): the result headers are not unique");
+    }
+
+    vector<KeyColumn> keys;
+    for (ColumnIndexType colIdx : keyCols)
+    {
+      keys.push_back(makeKeyColumn(tab.column(colIdx)));
+    }
+
+    const size_t n = tab.size();
+    const auto ranges = splitRows(n, effectiveThreadCount(nThreads, n));
+    const size_t nTasks = ranges.size();
+
+    // step 1: hash the keys of all rows and assign
+    // preliminary, thread-local group IDs
+    vector<uint64_t> hashes(n);
+    vector<uint32_t> rowGroup(n);
+    vector<vector<size_t>> localReps(nTasks);
+    const GroupKeys groupKeys{keys, hashes};
+    runParallelCSVTasks(nTasks, nTasks, thCfg, [&](size_t idx)
+    {
+      const auto [begin, end] = ranges[idx];
+      for (size_t row = begin; row < end; ++row)
+      {
+        uint64_t h = HashSeed;
+        for (const auto& kc : keys)
+        {
+          h = mix64(h ^ (isValid(kc.col->validityBits(), row) ? kc.codes[row] : NullHashMarker));
+        }
+        hashes[row] = h;
+      }
+
+      GroupMap local{0, groupKeys, groupKeys};
+      for (size_t row = begin; row < end; ++row)
+      {
+        auto [it, isNew] = local.try_emplace(row, static_cast<uint32_t>(localReps[idx].size()));
+        if (isNew) localReps[idx].push_back(row);
+        rowGroup[row] = it->second;
+      }
+    });
+
+    // step 2: merge the thread-local groups in the order of the
+    // table rows which gives us the order of first occurrence
+    GroupMap global{0, groupKeys, groupKeys};
+    vector<size_t> groupReps;
+    vector<vector<uint32_t>> localToGlobal(nTasks);
+    for (size_t idx = 0; idx < nTasks; ++idx)
+    {
+      for (size_t rep : localReps[idx])
+      {
+        auto [it, isNew] = global.try_emplace(rep, static_cast<uint32_t>(groupReps.size()));
+        if (isNew) groupReps.push_back(rep);
+        localToGlobal[idx].push_back(it->second);
+      }
+    }
+    const size_t nGroups = groupReps.size();
+
+    // step 3: aggregate each part of the table into thread-local
+    // accumulators; they only cover the groups of their part and
+    // are indexed by the thread-local group IDs
+    const size_t nAggs = aggregates.size();
+    vector<vector<Accumulator>> partialAcc(nTasks);
+    runParallelCSVTasks(nTasks, nTasks, thCfg, [&](size_t idx)
+    {
+      auto& acc = partialAcc[idx];
+      acc.resize(localReps[idx].size() * nAggs);
+
+      const auto [begin, end] = ranges[idx];
+      for (size_t aggIdx = 0; aggIdx < nAggs; ++aggIdx)
+      {
+        const CSV_Column& col = tab.column(aggregates[aggIdx].colIdx);
+        const auto& validBits = col.validityBits();
+        for (size_t row = begin; row < end; ++row)
+        {
+          if (!isValid(validBits, row)) continue;
+          accumulate(col, row, acc[rowGroup[row] * nAggs + aggIdx]);
+        }
+      }
+    });
+
+    // step 4: merge the accumulators in the order of the table
+    // parts and create the result rows
+    vector<Accumulator> totalAcc(nGroups * nAggs);
+    for (size_t idx = 0; idx < nTasks; ++idx)
+    {
+      const auto& part = partialAcc[idx];
+      for (size_t localGroup = 0; localGroup < localToGlobal[idx].size(); ++localGroup)
+      {
+        const size_t g = localToGlobal[idx][localGroup];
+        for (size_t aggIdx = 0; aggIdx < nAggs; ++aggIdx)
+        {
+          const CSV_Column& col = tab.column(aggregates[aggIdx].colIdx);
+          mergeAccumulator(col, part[localGroup * nAggs + aggIdx], totalAcc[g * nAggs + aggIdx]);
+        }
+      }
+    }
+
+    for (size_t g = 0; g < nGroups; ++g)
+    {
+      CSV_Row row;
+      for (ColumnIndexType colIdx : keyCols)
+      {
+        row.append(tab.column(colIdx).get(groupReps[g]));
+      }
+
+      for (size_t aggIdx = 0; aggIdx < nAggs; ++aggIdx)
+      {
+        const CSV_Column& col = tab.column(aggregates[aggIdx].colIdx);
+        row.append(aggregateResult(col, aggregates[aggIdx].func, totalAcc[g * nAggs + aggIdx]));
+      }
+
+      result.append(row);
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_JoinResult hashJoin(const CSV_ColumnarTable& left, const vector<CSV_ColumnarTable::ColumnIndexType>& leftKeys, const CSV_ColumnarTable& right, const vector<CSV_ColumnarTable::ColumnIndexType>& rightKeys, size_t nThreads, const ThreadConfig& thCfg)
+  {
+    SLOPPY_TRACE_SPAN("hashJoin");
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    if (leftKeys.empty() || (leftKeys.size() != rightKeys.size()))
+    {
+      throw std::invalid_argument("hashJoin(): invalid number of key columns");
+    }
+
+    // encode the keys of both tables with the codes of the right table
+    const size_t nKeys = leftKeys.size();
+    vector<KeyColumn> buildKeys;
+    vector<vector<uint64_t>> probeCodes(nKeys);
+    vector<vector<uint8_t>> probeUsable(nKeys);
+    for (size_t k = 0; k < nKeys; ++k)
+    {
+      buildKeys.push_back(makeKeyColumn(right.column(rightKeys[k])));
+      encodeProbeColumn(left.column(leftKeys[k]), buildKeys.back(), probeCodes[k], probeUsable[k]);
+    }
+
+    // build a chained hash table for all right rows without NULL keys; the
+    // rows are inserted in reverse order so that each chain is sorted by row index
+    const size_t nRight = right.size();
+    size_t nBuckets{1};
+    while (nBuckets < 2 * nRight) nBuckets <<= 1;
+    const uint64_t bucketMask = nBuckets - 1;
+
+    vector<uint64_t> rightHashes(nRight);
+    vector<size_t> head(nBuckets, NoRow);
+    vector<size_t> next(nRight, NoRow);
+    for (size_t row = nRight; row-- > 0;)
+    {
+      uint64_t h = HashSeed;
+      bool hasNull{false};
+      for (const auto& kc : buildKeys)
+      {
+        if (!isValid(kc.col->validityBits(), row))
+        {
+          hasNull = true;
+          break;
+        }
+        h = mix64(h ^ kc.codes[row]);
+      }
+      if (hasNull) continue;
+
+      rightHashes[row] = h;
+      next[row] = head[h & bucketMask];
+      head[h & bucketMask] = row;
+    }
+
+    // probe the hash table with all left rows
+    const size_t nLeft = left.size();
+    const auto ranges = splitRows(nLeft, effectiveThreadCount(nThreads, nLeft));
+    vector<CSV_JoinResult> partial(ranges.size());
+    runParallelCSVTasks(ranges.size(), ranges.size(), thCfg, [&](size_t idx)
+    {
+      auto& res = partial[idx];
+      for (size_t row = ranges[idx].first; row < ranges[idx].second; ++row)
+      {
+        uint64_t h = HashSeed;
+        bool usable{true};
+        for (size_t k = 0; k < nKeys; ++k)
+        {
+          if (!probeUsable[k][row])
+          {
+            usable = false;
+            break;
+          }
+          h = mix64(h ^ probeCodes[k][row]);
+        }
+        if (!usable) continue;
+
+        for (size_t rRow = head[h & bucketMask]; rRow != NoRow; rRow = next[rRow])
+        {
+          if (rightHashes[rRow] != h) continue;
+
+          bool isMatch{true};
+          for (size_t k = 0; k < nKeys; ++k)
+          {
+            if (buildKeys[k].codes[rRow] != probeCodes[k][row])
+            {
+              isMatch = false;
+              break;
+            }
+          }
+          if (!isMatch) continue;
+
+          res.leftRows.push_back(row);
+          res.rightRows.push_back(rRow);
+        }
+      }
+    });
+
+    CSV_JoinResult result;
+    for (auto& part : partial)
+    {
+      result.leftRows.insert(result.leftRows.end(), part.leftRows.begin(), part.leftRows.end());
+      result.rightRows.insert(result.rightRows.end(), part.rightRows.begin(), part.rightRows.end());
+    }
+
+    return result;
+  }
+
+}
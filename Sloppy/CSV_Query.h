@@ -0,0 +1,251 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_QUERY_H
+#define __LIBSLOPPY_CSV_QUERY_H
+
+#include <cstddef>        // for size_t
+#include <vector>         // for vector
+
+#include "CSV.h"           // for CSV_Value
+#include "CSV_Columnar.h"  // for CSV_ColumnarTable
+#include "ThreadConfig.h"  // for ThreadConfig
+
+namespace Sloppy
+{
+  /** \brief A list of (zero-based) row indices that refer to the rows of
+   * a `CSV_ColumnarTable`; the result of filtering, sorting and joining
+   */
+  using CSV_Selection = std::vector<CSV_ColumnarTable::RowIndexType>;
+
+  /** \brief The minimum number of rows per thread for the query functions
+   *
+   * Smaller tables are processed by fewer threads (or only by the calling thread)
+   * because the overhead for starting the threads would outweigh the gain.
+   */
+  static constexpr size_t MinParallelQueryRows = 64 * 1024;
+
+  /** \brief Compares two CSV values using a total order
+   *
+   * The order is: NULL < numbers < strings. Numbers (`int64_t` and `double`) are
+   * compared by their numeric value, strings are compared lexicographically
+   * (byte-wise).
+   *
+   * \returns a negative value if `a < b`, zero if `a == b` and a
+   * positive value if `a > b`
+   */
+  int compareCSVValues(
+      const CSV_Value& a,
+      const CSV_Value& b
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The comparison operators for filtering rows
+   */
+  enum class CSV_CompareOp
+  {
+    Equal,
+    NotEqual,
+    Less,
+    LessOrEqual,
+    Greater,
+    GreaterOrEqual
+  };
+
+  /** \brief Selects all rows whose value in a given column fulfills a comparison
+   * with a constant operand
+   *
+   * Values are compared using the order of `compareCSVValues()`. NULL values never
+   * match. For integer, double and string columns the comparison is evaluated for
+   * 64 rows at a time into a bitmask that is combined with the column's validity
+   * bitmap; strings are compared only once per dictionary entry.
+   *
+   * \throws std::out_of_range if the column index is invalid
+   *
+   * \throws std::invalid_argument if the operand is NULL or if the thread config is invalid
+   *
+   * \returns the indices of all matching rows in ascending order
+   */
+  CSV_Selection filterRows(
+      const CSV_ColumnarTable& tab,   ///< the table that shall be filtered
+      CSV_ColumnarTable::ColumnIndexType colIdx,   ///< zero-based index of the column that shall be compared
+      CSV_CompareOp op,   ///< the comparison operator; the column value is the left-hand side
+      const CSV_Value& operand,   ///< the right-hand side of the comparison
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+
+  /** \brief Same as the other `filterRows()` but only tests the rows in an existing
+   * selection; use this for combining several conditions (logical AND)
+   *
+   * \throws std::out_of_range if the column index or a row index in the selection is invalid
+   *
+   * \returns the matching rows in the order of the input selection
+   */
+  CSV_Selection filterRows(
+      const CSV_ColumnarTable& tab,   ///< the table that shall be filtered
+      const CSV_Selection& candidates,   ///< the rows that shall be tested
+      CSV_ColumnarTable::ColumnIndexType colIdx,   ///< zero-based index of the column that shall be compared
+      CSV_CompareOp op,   ///< the comparison operator; the column value is the left-hand side
+      const CSV_Value& operand,   ///< the right-hand side of the comparison
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+
+  /** \brief Creates a new table that contains the selected rows (in the order
+   * of the selection), including the headers of the source table
+   *
+   * \throws std::out_of_range if a row index in the selection is invalid
+   */
+  CSV_ColumnarTable selectRows(
+      const CSV_ColumnarTable& tab,   ///< the source table
+      const CSV_Selection& sel   ///< the rows that shall be copied
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A column that is part of a sort order
+   */
+  struct CSV_SortKey
+  {
+    CSV_ColumnarTable::ColumnIndexType colIdx;   ///< zero-based index of the column
+    bool ascending{true};   ///< ascending: NULL values first; descending: NULL values last
+  };
+
+  /** \brief Sorts the rows of a table by one or more columns
+   *
+   * The sort is stable: rows with identical keys keep their original order. Values
+   * are compared using the order of `compareCSVValues()`. Before sorting, each key column
+   * is converted into an array of order-preserving integers, so the actual sort only
+   * compares integers.
+   *
+   * The rows are sorted in chunks by several threads and the chunks are merged afterwards.
+   *
+   * \throws std::out_of_range if a column index is invalid
+   *
+   * \throws std::invalid_argument if no sort keys have been provided or if the thread config is invalid
+   *
+   * \returns the row indices in sort order; use `selectRows()` to create a sorted table
+   */
+  CSV_Selection sortRows(
+      const CSV_ColumnarTable& tab,   ///< the table that shall be sorted
+      const std::vector<CSV_SortKey>& keys,   ///< the sort keys in descending priority
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+
+  /** \brief Same as the other `sortRows()` but only sorts the rows in an existing selection
+   *
+   * \throws std::out_of_range if a column index or a row index in the selection is invalid
+   */
+  CSV_Selection sortRows(
+      const CSV_ColumnarTable& tab,   ///< the table that shall be sorted
+      const CSV_Selection& sel,   ///< the rows that shall be sorted
+      const std::vector<CSV_SortKey>& keys,   ///< the sort keys in descending priority
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The aggregate functions for `groupBy()`
+   */
+  enum class CSV_AggregateFunction
+  {
+    Count,   ///< number of non-NULL values
+    Sum,   ///< integer columns: `int64_t` sum (`double` if the sum exceeds the range of `int64_t`); all other numeric columns: `double` sum
+    Min,   ///< smallest value according to `compareCSVValues()`
+    Max,   ///< largest value according to `compareCSVValues()`
+    Mean   ///< arithmetic mean as `double`
+  };
+
+  /** \brief An aggregate function applied to a column
+   */
+  struct CSV_Aggregate
+  {
+    CSV_AggregateFunction func;
+    CSV_ColumnarTable::ColumnIndexType colIdx;   ///< zero-based index of the column that shall be aggregated
+  };
+
+  /** \brief Groups the rows of a table by one or more key columns and
+   * calculates aggregates for each group
+   *
+   * The key values are hashed, NULL values form a group of their own. Each thread groups
+   * and aggregates a part of the rows; the partial results are merged afterwards.
+   *
+   * NULL values are ignored by all aggregate functions. If a group doesn't contain
+   * any non-NULL values for an aggregate, the result is NULL (or zero for `Count`).
+   *
+   * The result table contains one row per group (in the order of the first occurrence
+   * of each group in the source table) with the key columns followed by one column
+   * per aggregate. If the source table has headers, the aggregate columns are
+   * named "func(header)", e.g. "sum(amount)".
+   *
+   * \throws std::out_of_range if a column index is invalid
+   *
+   * \throws std::invalid_argument if no key columns are provided, if a sum or mean is
+   * requested for a string column, if the result headers are not unique or
+   * if the thread config is invalid
+   */
+  CSV_ColumnarTable groupBy(
+      const CSV_ColumnarTable& tab,   ///< the source table
+      const std::vector<CSV_ColumnarTable::ColumnIndexType>& keyCols,   ///< zero-based indices of the key columns
+      const std::vector<CSV_Aggregate>& aggregates,   ///< the aggregates that shall be calculated for each group
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The result of a join: two selections of equal length that
+   * contain the indices of matching rows
+   */
+  struct CSV_JoinResult
+  {
+    CSV_Selection leftRows;
+    CSV_Selection rightRows;
+  };
+
+  /** \brief Joins two tables on one or more key columns (inner join)
+   *
+   * A hash table is built for the keys of the right table and is probed with the keys
+   * of the left table by several threads.
+   *
+   * Keys are equal if they have the same type and the same value, so an integer never
+   * matches a double; NULL keys never match.
+   *
+   * \throws std::out_of_range if a column index is invalid
+   *
+   * \throws std::invalid_argument if the number of key columns differs between the tables,
+   * if no key columns have been provided or if the thread config is invalid
+   *
+   * \returns all pairs of matching rows, sorted by the left row index
+   * and then by the right row index
+   */
+  CSV_JoinResult hashJoin(
+      const CSV_ColumnarTable& left,   ///< the left table (probe side)
+      const std::vector<CSV_ColumnarTable::ColumnIndexType>& leftKeys,   ///< zero-based indices of the key columns in the left table
+      const CSV_ColumnarTable& right,   ///< the right table (build side); should be the smaller table
+      const std::vector<CSV_ColumnarTable::ColumnIndexType>& rightKeys,   ///< zero-based indices of the key columns in the right table
+      size_t nThreads = 0,   ///< the max. number of threads, including the calling thread; 0 = number of hardware threads
+      const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker threads
+      );
+}
+
+#endif
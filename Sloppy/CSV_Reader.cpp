@@ -0,0 +1,235 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>    // for memchr, memmove
+#include <istream>    // for istream
+#include <stdexcept>  // for invalid_argument, out_of_range, runtime_error
+#include <utility>    // for move
+
+#ifndef WIN32
+#include "ManagedFileDescriptor.h"  // for ManagedFileDescriptor
+#include "Memory.h"                 // for MemFile
+#endif
+
+#include "CSV_Reader.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  CSV_Reader::CSV_Reader(std::function<size_t (char*, size_t)> readFunc, CSV_StringRepresentation _rep, size_t _chunkSize, size_t _maxLineLength)
+    :readChunk{std::move(readFunc)}, rep{_rep}, chunkSize{_chunkSize}, maxLineLength{_maxLineLength}
+  {
+    if (chunkSize == 0)
+    {
+      throw std::invalid_argument("CSV_Reader: chunk size must be larger than zero");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Reader::CSV_Reader(istream& src, bool firstRowContainsHeaders, CSV_StringRepresentation _rep, size_t _chunkSize, size_t _maxLineLength)
+    :CSV_Reader{
+       [&src](char* dst, size_t n) -> size_t
+       {
+         src.read(dst, n);
+         if (src.bad())
+         {
+           throw std::runtime_error("CSV_Reader: error while reading from input stream");
+         }
+         return static_cast<size_t>(src.gcount());
+       },
+       _rep, _chunkSize, _maxLineLength}
+  {
+    if (firstRowContainsHeaders) readHeader();
+  }
+
+  //----------------------------------------------------------------------------
+
+#ifndef WIN32
+  CSV_Reader::CSV_Reader(ManagedFileDescriptor& fd, bool firstRowContainsHeaders, CSV_StringRepresentation _rep, size_t _chunkSize, size_t _maxLineLength)
+    :CSV_Reader{
+       [&fd](char* dst, size_t n) { return fd.readSome(dst, n, -1); },
+       _rep, _chunkSize, _maxLineLength}
+  {
+    if (firstRowContainsHeaders) readHeader();
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Reader::CSV_Reader(const MemFile& mf, bool firstRowContainsHeaders, CSV_StringRepresentation _rep, size_t _maxLineLength)
+    :rep{_rep}, maxLineLength{_maxLineLength}
+  {
+    if (mf.size() < 0)
+    {
+      throw std::invalid_argument("CSV_Reader: MemFile is not associated with a file");
+    }
+
+    // the whole mapping is "pending" data; no
+    // further reads are necessary
+    if (mf.size() > 0)
+    {
+      const MemView v = mf.view();
+      pending = string_view{v.to_charPtr(), v.size()};
+    }
+    eof = true;
+
+    if (firstRowContainsHeaders) readHeader();
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_Reader::next()
+  {
+    string_view line;
+    while (nextLine(line))
+    {
+      if (!prepareCSVLine(line)) continue;
+
+      // don't catch exceptions here; leave it to
+      // the caller to deal with invalid row data
+      curRow.assign(line, rep);
+
+      // the first row determines the number
+      // of columns if we don't have headers
+      if (colCount == 0) colCount = curRow.size();
+
+      if (curRow.size() != colCount)
+      {
+        throw std::invalid_argument("CSV_Reader: inconsistent column count in line " + to_string(nLines));
+      }
+
+      ++nRows;
+      return true;
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+
+  const string& CSV_Reader::getHeader(ColumnIndexType colIdx) const
+  {
+    if (colIdx >= headerNames.size())
+    {
+      throw std::out_of_range("CSV_Reader::getHeader(): invalid column index");
+    }
+
+    return headerNames[colIdx];
+  }
+
+  //----------------------------------------------------------------------------
+
+  optional<CSV_Reader::ColumnIndexType> CSV_Reader::columnIndex(const string& colName) const
+  {
+    return findCSVColumn(headerNames, colName);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Reader::readHeader()
+  {
+    if (!next()) return;   // empty input, no headers
+
+    auto hdr = validateCSVHeaders(curRow);
+    if (!hdr)
+    {
+      throw std::invalid_argument("CSV_Reader: invalid header data");
+    }
+    headerNames = std::move(*hdr);
+
+    // the header row is not a data row
+    nRows = 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_Reader::nextLine(string_view& line)
+  {
+    while (true)
+    {
+      // search for the end of the line, skipping what has
+      // already been searched before the last refill
+      const char* lineEnd{nullptr};
+      if (nScanned < pending.size())
+      {
+        lineEnd = static_cast<const char*>(memchr(pending.data() + nScanned, '\n', pending.size() - nScanned));
+      }
+
+      if (lineEnd != nullptr)
+      {
+        const size_t len = lineEnd - pending.data();
+        checkLineLength(len);
+        line = pending.substr(0, len);
+        pending.remove_prefix(len + 1);
+        nScanned = 0;
+        ++nLines;
+        return true;
+      }
+
+      // everything after the last "\n" is the last line
+      if (eof)
+      {
+        if (pending.empty()) return false;
+
+        checkLineLength(pending.size());
+        line = pending;
+        pending = string_view{};
+        nScanned = 0;
+        ++nLines;
+        return true;
+      }
+
+      nScanned = pending.size();
+      refill();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Reader::checkLineLength(size_t len) const
+  {
+    if (len > maxLineLength)
+    {
+      throw std::invalid_argument("CSV_Reader: line " + to_string(nLines + 1) + " exceeds the maximum line length");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Reader::refill()
+  {
+    // don't buffer more data if the incomplete
+    // line is already too long
+    checkLineLength(pending.size());
+
+    // move the incomplete line to the front
+    // of the buffer and append a new chunk
+    const size_t nKeep = pending.size();
+    if (nKeep > 0) memmove(buf.data(), pending.data(), nKeep);
+    if (buf.size() < nKeep + chunkSize) buf.resize(nKeep + chunkSize);
+
+    const size_t n = readChunk(buf.data() + nKeep, chunkSize);
+    if (n == 0) eof = true;
+
+    pending = string_view{buf.data(), nKeep + n};
+  }
+
+}
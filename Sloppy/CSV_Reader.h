@@ -0,0 +1,250 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_READER_H
+#define __LIBSLOPPY_CSV_READER_H
+
+#include <cstddef>      // for size_t
+#include <functional>   // for function
+#include <iosfwd>       // for istream
+#include <optional>     // for optional
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "CSV.h"        // for CSV_Row, CSV_StringRepresentation
+
+namespace Sloppy
+{
+#ifndef WIN32
+  class ManagedFileDescriptor;
+  class MemFile;
+#endif
+
+  /** \brief Reads a CSV table row by row from a stream, a file descriptor or
+   * a memory-mapped file.
+   *
+   * In contrast to `CSV_Table` the reader never holds the complete input in memory.
+   * The input is consumed in chunks and each call to `next()` parses the next
+   * line into a row buffer that is reused for all rows. The memory consumption is thus
+   * bounded by the chunk size plus the length of the longest line, independent
+   * of the size of the input.
+   *
+   * The parsing rules are identical to the string-based ctor of `CSV_Table`: rows are
+   * terminated by "\n", a trailing "\r" is removed, empty lines are ignored (see
+   * `prepareCSVLine()`) and all rows must have the same number of columns.
+   *
+   * The reader only keeps a reference to the data source. The source
+   * must thus outlive the reader.
+   */
+  class CSV_Reader
+  {
+  public:
+    using ColumnIndexType = CSV_Row::IndexType;
+
+    /** \brief The default number of bytes that are requested from the source
+     * in a single read operation
+     */
+    static constexpr size_t DefaultChunkSize = 1024 * 1024;
+
+    /** \brief The default upper limit for the length of a single line in bytes
+     */
+    static constexpr size_t DefaultMaxLineLength = 16 * 1024 * 1024;
+
+    /** \brief Ctor for reading from an input stream
+     *
+     * If the first row contains headers, the header row is read immediately.
+     *
+     * \throws std::invalid_argument if the chunk size is zero
+     *
+     * \throws std::invalid_argument if the header row is malformed or violates
+     * the header naming conditions of `CSV_Table`
+     */
+    CSV_Reader(
+        std::istream& src,   ///< the stream that provides the CSV data
+        bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+        CSV_StringRepresentation _rep,   ///< defines how string data is represented in the input
+        size_t _chunkSize = DefaultChunkSize,   ///< the number of bytes to read from the stream at once
+        size_t _maxLineLength = DefaultMaxLineLength   ///< lines longer than this will be rejected
+        );
+
+#ifndef WIN32
+    /** \brief Ctor for reading from a file descriptor (e.g., a file or a pipe)
+     *
+     * The descriptor is read until the end of the input is reached. Reading
+     * blocks until data becomes available.
+     *
+     * If the first row contains headers, the header row is read immediately.
+     *
+     * \throws std::invalid_argument if the chunk size is zero
+     *
+     * \throws std::invalid_argument if the header row is malformed or violates
+     * the header naming conditions of `CSV_Table`
+     *
+     * \throws IOError if an I/O error occurred while reading the header row
+     */
+    CSV_Reader(
+        ManagedFileDescriptor& fd,   ///< the descriptor that provides the CSV data
+        bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+        CSV_StringRepresentation _rep,   ///< defines how string data is represented in the input
+        size_t _chunkSize = DefaultChunkSize,   ///< the number of bytes to read from the descriptor at once
+        size_t _maxLineLength = DefaultMaxLineLength   ///< lines longer than this will be rejected
+        );
+
+    /** \brief Ctor for reading from a memory-mapped file
+     *
+     * The rows are parsed directly from the memory map without copying
+     * the data into an intermediate buffer.
+     *
+     * If the first row contains headers, the header row is read immediately.
+     *
+     * \throws std::invalid_argument if the MemFile is not associated with a file
+     *
+     * \throws std::invalid_argument if the header row is malformed or violates
+     * the header naming conditions of `CSV_Table`
+     */
+    CSV_Reader(
+        const MemFile& mf,   ///< the mapped file that contains the CSV data
+        bool firstRowContainsHeaders,   ///< if true then the first row will be treated as column headers
+        CSV_StringRepresentation _rep,   ///< defines how string data is represented in the input
+        size_t _maxLineLength = DefaultMaxLineLength   ///< lines longer than this will be rejected
+        );
+#endif
+
+    /** \brief Disabled copy ctor because the reader is bound to its source */
+    CSV_Reader(const CSV_Reader& other) = delete;
+
+    /** \brief Disabled copy assignment because the reader is bound to its source */
+    CSV_Reader& operator=(const CSV_Reader& other) = delete;
+
+    /** \brief Parses the next data row into the row buffer
+     *
+     * Errors in the row data are reported as exceptions; use
+     * `lineNumber()` to locate the offending line in the input.
+     *
+     * \throws std::invalid_argument if the row was malformed (e.g.,
+     * because of inconsistent use of quotation marks)
+     *
+     * \throws std::invalid_argument if the number of columns differs from
+     * the header row or from the first data row
+     *
+     * \throws std::invalid_argument if a line exceeds the maximum line length
+     *
+     * \throws std::runtime_error if the input stream failed
+     *
+     * \returns `true` if a new row is available via `row()` or `false` if the
+     * end of the input has been reached
+     */
+    bool next();
+
+    /** \returns a reference to the row buffer with the data of the
+     * row that has been read by the last successful call to `next()`
+     *
+     * \warning The buffer's content is overwritten by each call to `next()`.
+     */
+    const CSV_Row& row() const { return curRow; }
+
+    /** \returns the number of columns in the table (0 if neither headers
+     * nor data rows have been read so far)
+     */
+    ColumnIndexType nCols() const { return colCount; }
+
+    /** \returns `true` if the input contains column headers
+     */
+    bool hasHeaders() const { return !headerNames.empty(); }
+
+    /** \returns all column headers (empty if the input has no headers)
+     */
+    const std::vector<std::string>& headers() const { return headerNames; }
+
+    /** \returns the header for a given column index
+     *
+     * \throws std::out_of_range if the provided column index was invalid or if
+     * the input has no headers
+     */
+    const std::string& getHeader(
+        ColumnIndexType colIdx   ///< the zero-based index of the column
+        ) const;
+
+    /** \returns the index of the column with a given header name (case-sensitive) or
+     * an empty optional if there is no such column
+     */
+    std::optional<ColumnIndexType> columnIndex(
+        const std::string& colName   ///< name of the column
+        ) const;
+
+    /** \returns the number of data rows that have been read so far
+     */
+    size_t rowCount() const { return nRows; }
+
+    /** \returns the one-based number of the input line that has been
+     * processed last, including the header row and empty lines
+     */
+    size_t lineNumber() const { return nLines; }
+
+  protected:
+    /** \brief Common ctor for all chunk-wise read sources
+     */
+    CSV_Reader(
+        std::function<size_t(char*, size_t)> readFunc,   ///< reads up to n bytes into a buffer; returns 0 at the end of the input
+        CSV_StringRepresentation _rep,
+        size_t _chunkSize,
+        size_t _maxLineLength
+        );
+
+    /** \brief Reads and validates the header row
+     */
+    void readHeader();
+
+    /** \brief Fetches the next line from the input without the trailing "\n"
+     *
+     * \returns `false` if the end of the input has been reached
+     */
+    bool nextLine(std::string_view& line);
+
+    /** \brief Moves unprocessed data to the front of the buffer and
+     * appends the next chunk from the source
+     */
+    void refill();
+
+    /** \brief Rejects lines that are longer than the configured maximum
+     *
+     * \throws std::invalid_argument if `len` exceeds the maximum line length
+     */
+    void checkLineLength(size_t len) const;
+
+  private:
+    std::function<size_t(char*, size_t)> readChunk;
+    CSV_StringRepresentation rep;
+    size_t chunkSize{DefaultChunkSize};
+    size_t maxLineLength{DefaultMaxLineLength};
+
+    std::string buf;   ///< the read buffer for chunk-wise sources
+    std::string_view pending;   ///< the not yet processed input data
+    size_t nScanned{0};   ///< the number of bytes at the start of `pending` that are known not to contain "\n"
+    bool eof{false};
+
+    CSV_Row curRow;
+    ColumnIndexType colCount{0};
+    std::vector<std::string> headerNames;
+    size_t nRows{0};
+    size_t nLines{0};
+  };
+}
+
+#endif
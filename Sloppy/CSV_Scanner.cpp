@@ -0,0 +1,153 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>  // for memcpy
+
+#ifdef __SSE2__
+#include <emmintrin.h>  // for _mm_loadu_si128, _mm_cmpeq_epi8, _mm_movemask_epi8, ...
+#endif
+
+#include "CSV_Scanner.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace
+  {
+    struct CharMasks
+    {
+      uint64_t comma{0};
+      uint64_t quote{0};
+      uint64_t backslash{0};
+      uint64_t newline{0};
+    };
+
+    // builds the character bitmaps for exactly 64 bytes
+    inline CharMasks classifyBlock(const char* p)
+    {
+      CharMasks m;
+#ifdef __SSE2__
+      const __m128i comma = _mm_set1_epi8(',');
+      const __m128i quote = _mm_set1_epi8('"');
+      const __m128i backslash = _mm_set1_epi8('\\');
+      const __m128i newline = _mm_set1_epi8('\n');
+
+      for (int i = 0; i < 4; ++i)
+      {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        const int shift = 16 * i;
+        m.comma |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)))) << shift;
+        m.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        m.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        m.newline |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)))) << shift;
+      }
+#else
+      for (size_t i = 0; i < CSV_StructuralScanner::BlockSize; ++i)
+      {
+        const uint64_t bit = uint64_t{1} << i;
+        switch (p[i])
+        {
+        case ',':
+          m.comma |= bit;
+          break;
+        case '"':
+          m.quote |= bit;
+          break;
+        case '\\':
+          m.backslash |= bit;
+          break;
+        case '\n':
+          m.newline |= bit;
+          break;
+        default:
+          break;
+        }
+      }
+#endif
+      return m;
+    }
+
+    // bit i of the result is the XOR of bits 0...i of the input
+    inline uint64_t prefixXor(uint64_t x)
+    {
+      x ^= x << 1;
+      x ^= x << 2;
+      x ^= x << 4;
+      x ^= x << 8;
+      x ^= x << 16;
+      x ^= x << 32;
+      return x;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_StructuralScanner::CSV_StructuralScanner(CSV_StringRepresentation rep)
+    :usesQuotes{(rep == CSV_StringRepresentation::Quoted) || (rep == CSV_StringRepresentation::QuotedAndEscaped)},
+      usesEscaping{(rep == CSV_StringRepresentation::Escaped) || (rep == CSV_StringRepresentation::QuotedAndEscaped)}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_StructuralMasks CSV_StructuralScanner::scanBlock(const char* p, size_t len)
+  {
+    CSV_StructuralMasks result;
+    if (len == 0) return result;
+
+    // incomplete blocks are padded with zeros which
+    // don't match any structural character
+    CharMasks m;
+    if (len >= BlockSize)
+    {
+      len = BlockSize;
+      m = classifyBlock(p);
+    } else {
+      char padded[BlockSize]{};
+      memcpy(padded, p, len);
+      m = classifyBlock(padded);
+    }
+
+    // a character is escaped if its predecessor is a backslash
+    uint64_t notEscaped = ~uint64_t{0};
+    if (usesEscaping)
+    {
+      notEscaped = ~((m.backslash << 1) | prevBackslash);
+      prevBackslash = (m.backslash >> (len - 1)) & 1;
+    }
+
+    if (usesQuotes)
+    {
+      result.quotes = m.quote & notEscaped;
+
+      // a bit is set for all bytes between an opening quotation mark (inclusive)
+      // and a closing quotation mark (exclusive)
+      const uint64_t inside = prefixXor(result.quotes) ^ insideQuotes;
+      insideQuotes = ((inside >> (len - 1)) & 1) ? ~uint64_t{0} : 0;
+
+      result.separators = m.comma & notEscaped & ~inside;
+    } else {
+      result.separators = m.comma & notEscaped;
+    }
+    result.lineEnds = m.newline;
+
+    return result;
+  }
+
+}
@@ -0,0 +1,97 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_SCANNER_H
+#define __LIBSLOPPY_CSV_SCANNER_H
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t
+
+#include "CSV.h"    // for CSV_StringRepresentation
+
+namespace Sloppy
+{
+  /** \brief Bitmaps of the structural characters in a block of
+   * up to 64 bytes of CSV data; bit `i` refers to byte `i` of the block
+   */
+  struct CSV_StructuralMasks
+  {
+    uint64_t separators{0};   ///< field separating commas (not escaped, not inside a quoted section)
+    uint64_t quotes{0};   ///< effective quotation marks (not escaped); always zero if strings are not quoted
+    uint64_t lineEnds{0};   ///< newline characters
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Classifies the structural characters of CSV data in blocks of
+   * 64 bytes without branching on individual characters
+   *
+   * The scanner produces the same separator decisions as the byte-by-byte state
+   * machine that `CSV_Row` used before:
+   *   * a character is escaped if (and only if) it is preceded by a backslash;
+   *   * only unescaped quotation marks open or close a quoted section;
+   *   * a comma separates fields if it is unescaped and not inside a quoted section.
+   *
+   * The quoted sections are derived from a prefix-XOR of the quotation mark bitmap.
+   * With SSE2, the character bitmaps of a block are built 16 bytes at a time.
+   *
+   * Newlines are reported as they are and do not reset the quoting state. In our CSV
+   * dialect every newline terminates a row (see `CSV_Table`), so callers that
+   * process multiple rows should call `reset()` at each row start.
+   *
+   * The scanner carries the escaping and quoting state from one block to the next,
+   * so a row of any length can be scanned by feeding it block by block.
+   */
+  class CSV_StructuralScanner
+  {
+  public:
+    static constexpr size_t BlockSize = 64;
+
+    /** \brief Ctor for a scanner in its initial state (i.e., at the start of a row)
+     */
+    explicit CSV_StructuralScanner(
+        CSV_StringRepresentation rep   ///< defines how string data is represented in the input
+        );
+
+    /** \brief Scans the next block of input data
+     *
+     * \returns the bitmaps for the structural characters in the block; bits
+     * beyond `len` are always zero
+     */
+    CSV_StructuralMasks scanBlock(
+        const char* p,   ///< pointer to the block data
+        size_t len   ///< number of bytes in the block; must not exceed `BlockSize`
+        );
+
+    /** \brief Resets the scanner to its initial state, e.g., at the start of a new row
+     */
+    void reset()
+    {
+      prevBackslash = 0;
+      insideQuotes = 0;
+    }
+
+  private:
+    bool usesQuotes;
+    bool usesEscaping;
+    uint64_t prevBackslash{0};   ///< 1 if the last byte of the previous block was a backslash
+    uint64_t insideQuotes{0};   ///< all ones if the previous block ended inside a quoted section
+  };
+}
+
+#endif
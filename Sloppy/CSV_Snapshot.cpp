@@ -0,0 +1,701 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIN32
+
+#include <bit>            // for endian
+#include <cstring>        // for memcpy
+#include <fstream>        // for ofstream
+#include <stdexcept>      // for invalid_argument, out_of_range, runtime_error
+#include <type_traits>    // for make_unsigned_t
+#include <unordered_map>  // for unordered_map
+
+#include "AllocTracker.h"  // for ScopedAllocTag, MemTag
+#include "Memory.h"        // for MemFile, MemView
+
+#include "CSV_Snapshot.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace
+  {
+    // layout of the snapshot file; all numbers are little-endian and
+    // all blocks start at a multiple of eight bytes:
+    //
+    //   header:      magic, file size, number of rows, number of columns, flags (uint64_t each)
+    //   headers:     a dictionary with the column headers (only if flags & FlagHasHeaders)
+    //   columns:     for each column:
+    //                  - the column type (uint64_t)
+    //                  - the validity bitmap (one uint64_t per 64 rows)
+    //                  - Long:   one int64_t per row
+    //                  - Double: one double per row
+    //                  - String: one uint32_t dictionary code per row; dictionary
+    //                  - Mixed:  one uint8_t type tag per row, one uint64_t value
+    //                            (integer, double bits or dictionary code) per row; dictionary
+    //
+    //   dictionary:  number of entries n (uint64_t), n + 1 string offsets relative
+    //                to the start of the string data (uint64_t), the string data
+    constexpr uint64_t SnapshotMagic = 0x31504e53'56534353;   // "SCSVSNP1"
+    constexpr size_t HeaderFieldCount = 5;
+    constexpr size_t HeaderSize = HeaderFieldCount * sizeof(uint64_t);
+
+    constexpr uint64_t FlagHasHeaders = 0x01;
+
+    constexpr uint64_t TypeCodeEmpty = 0;
+    constexpr uint64_t TypeCodeLong = 1;
+    constexpr uint64_t TypeCodeDouble = 2;
+    constexpr uint64_t TypeCodeString = 3;
+    constexpr uint64_t TypeCodeMixed = 4;
+
+    constexpr uint8_t TagLong = 0;
+    constexpr uint8_t TagDouble = 1;
+    constexpr uint8_t TagString = 2;
+
+    constexpr const char* InvalidFileMsg = "CSV_SnapshotReader: invalid or truncated snapshot file";
+
+    template<typename T>
+    T toLittleEndian(T v)
+    {
+      if constexpr (endian::native == endian::big)
+      {
+        T result{0};
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+          result = static_cast<T>((result << 8) | (v & 0xff));
+          v >>= 8;
+        }
+        return result;
+      }
+
+      return v;
+    }
+
+    // views of the typed blocks are only possible if the host
+    // uses the byte order of the file
+    void assertLittleEndianHost()
+    {
+      if constexpr (endian::native != endian::little)
+      {
+        throw std::runtime_error("CSV_SnapshotReader: typed column access requires a little-endian host");
+      }
+    }
+
+    // all blocks are aligned to eight bytes relative to the start of
+    // the (page-aligned) mapping, so they can be accessed as arrays
+    template<typename T>
+    ArrayView<T> blockView(const uint8_t* p, size_t nElem)
+    {
+      assertLittleEndianHost();
+      if (nElem == 0) return ArrayView<T>{};
+      return ArrayView<T>{reinterpret_cast<const T*>(p), nElem};
+    }
+
+    size_t paddedSize(size_t n)
+    {
+      return (n + 7) & ~size_t{7};
+    }
+
+    size_t bitmapWords(size_t nRows)
+    {
+      return (nRows + 63) / 64;
+    }
+
+    uint64_t typeCode(CSV_Column::Type t)
+    {
+      switch (t)
+      {
+      case CSV_Column::Type::Long:
+        return TypeCodeLong;
+      case CSV_Column::Type::Double:
+        return TypeCodeDouble;
+      case CSV_Column::Type::String:
+        return TypeCodeString;
+      case CSV_Column::Type::Mixed:
+        return TypeCodeMixed;
+      default:
+        return TypeCodeEmpty;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+
+    // a thin wrapper around a file stream that writes
+    // little-endian values and keeps track of the position
+    class SnapshotFile
+    {
+    public:
+      explicit SnapshotFile(const string& fileName)
+        :f{fileName, ios::binary | ios::trunc}
+      {
+        if (!f)
+        {
+          throw std::runtime_error("writeCSVSnapshot(): could not open snapshot file for writing");
+        }
+      }
+
+      template<typename T>
+      void put(T v)
+      {
+        v = toLittleEndian(v);
+        putBytes(&v, sizeof(T));
+      }
+
+      template<typename T>
+      void putArray(const T* src, size_t n)
+      {
+        if constexpr (endian::native == endian::little)
+        {
+          putBytes(src, n * sizeof(T));
+        } else {
+          for (size_t i = 0; i < n; ++i) put(static_cast<make_unsigned_t<T>>(src[i]));
+        }
+      }
+
+      void putBytes(const void* src, size_t n)
+      {
+        f.write(static_cast<const char*>(src), n);
+        pos += n;
+      }
+
+      void pad()
+      {
+        static constexpr char zeros[8]{};
+        putBytes(zeros, paddedSize(pos) - pos);
+      }
+
+      // `entry(idx)` returns the dictionary entry with index `idx` as a string_view
+      template<typename EntryFunc>
+      void putDictionary(size_t n, const EntryFunc& entry)
+      {
+        put<uint64_t>(n);
+
+        uint64_t offset{0};
+        put(offset);
+        for (size_t idx = 0; idx < n; ++idx)
+        {
+          offset += entry(idx).size();
+          put(offset);
+        }
+        for (size_t idx = 0; idx < n; ++idx)
+        {
+          const string_view s = entry(idx);
+          putBytes(s.data(), s.size());
+        }
+        pad();
+      }
+
+      void finish()
+      {
+        // store the final file size in the header
+        const uint64_t fileSize = toLittleEndian<uint64_t>(pos);
+        f.seekp(sizeof(uint64_t));
+        f.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+
+        f.close();
+        if (f.fail())
+        {
+          throw std::runtime_error("writeCSVSnapshot(): could not write snapshot file");
+        }
+      }
+
+    private:
+      ofstream f;
+      size_t pos{0};
+    };
+
+    void writeColumn(SnapshotFile& out, const CSV_Column& col, size_t nRows)
+    {
+      out.put(typeCode(col.type()));
+
+      const auto& validBits = col.validityBits();
+      for (size_t w = 0; w < bitmapWords(nRows); ++w)
+      {
+        out.put<uint64_t>((w < validBits.size()) ? validBits[w] : 0);
+      }
+
+      switch (col.type())
+      {
+      case CSV_Column::Type::Long:
+        out.putArray(col.longData().data(), nRows);
+        break;
+
+      case CSV_Column::Type::Double:
+      {
+        static_assert(sizeof(double) == sizeof(uint64_t));
+        for (double d : col.doubleData())
+        {
+          uint64_t bits;
+          memcpy(&bits, &d, sizeof(bits));
+          out.put(bits);
+        }
+        break;
+      }
+
+      case CSV_Column::Type::String:
+        out.putArray(col.stringCodes().data(), nRows);
+        out.pad();
+        out.putDictionary(col.dictionarySize(), [&col](size_t idx) { return string_view{col.dictionaryEntry(idx)}; });
+        break;
+
+      case CSV_Column::Type::Mixed:
+      {
+        // mixed columns get their own dictionary for the string values
+        vector<string> dict;
+        unordered_map<string, uint64_t> dictIndex;
+        vector<uint64_t> values(nRows, 0);
+        vector<uint8_t> tags(nRows, 0);
+        for (size_t row = 0; row < nRows; ++row)
+        {
+          const CSV_Value v = col.get(row);
+          switch (v.valueType())
+          {
+          case CSV_Value::Type::Long:
+            tags[row] = TagLong;
+            values[row] = static_cast<uint64_t>(v.get<int64_t>());
+            break;
+
+          case CSV_Value::Type::Double:
+          {
+            const double d = v.get<double>();
+            tags[row] = TagDouble;
+            memcpy(&values[row], &d, sizeof(d));
+            break;
+          }
+
+          case CSV_Value::Type::String:
+          {
+            auto [it, isNew] = dictIndex.try_emplace(v.get<string>(), dict.size());
+            if (isNew) dict.push_back(it->first);
+            tags[row] = TagString;
+            values[row] = it->second;
+            break;
+          }
+
+          default:
+            break;   // NULL
+          }
+        }
+
+        out.putBytes(tags.data(), tags.size());
+        out.pad();
+        out.putArray(values.data(), nRows);
+        out.putDictionary(dict.size(), [&dict](size_t idx) { return string_view{dict[idx]}; });
+        break;
+      }
+
+      default:
+        break;   // only NULL values
+      }
+    }
+
+    //--------------------------------------------------------------------------
+
+    template<typename T>
+    T loadLittleEndian(const uint8_t* src)
+    {
+      T v;
+      memcpy(&v, src, sizeof(T));
+      return toLittleEndian(v);   // swapping is symmetric
+    }
+
+    // returns the position after a block of `len` bytes that starts at
+    // `pos`; throws if the block exceeds the size of the file
+    size_t skipBlock(size_t pos, size_t len, size_t fileSize)
+    {
+      if ((pos > fileSize) || (len > fileSize - pos))
+      {
+        throw std::invalid_argument(InvalidFileMsg);
+      }
+      return pos + len;
+    }
+
+    // returns the size of an array with `n` elements of `elemSize` bytes;
+    // throws if the size can't possibly fit into the file
+    size_t arraySize(uint64_t n, size_t elemSize, size_t fileSize)
+    {
+      if (n > fileSize / elemSize)
+      {
+        throw std::invalid_argument(InvalidFileMsg);
+      }
+      return n * elemSize;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void writeCSVSnapshot(const CSV_Table& tab, const string& fileName)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    writeCSVSnapshot(CSV_ColumnarTable{tab}, fileName);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void writeCSVSnapshot(const CSV_ColumnarTable& tab, const string& fileName)
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    SnapshotFile out{fileName};
+    out.put(SnapshotMagic);
+    out.put<uint64_t>(0);   // file size; updated at the end
+    out.put<uint64_t>(tab.size());
+    out.put<uint64_t>(tab.nCols());
+    out.put<uint64_t>(tab.hasHeaders() ? FlagHasHeaders : 0);
+
+    if (tab.hasHeaders())
+    {
+      const auto& hdr = tab.headers();
+      out.putDictionary(hdr.size(), [&hdr](size_t idx) { return string_view{hdr[idx]}; });
+    }
+
+    for (CSV_ColumnarTable::ColumnIndexType colIdx = 0; colIdx < tab.nCols(); ++colIdx)
+    {
+      writeColumn(out, tab.column(colIdx), tab.size());
+    }
+
+    out.finish();
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  CSV_SnapshotReader::CSV_SnapshotReader(const MemFile& _file)
+  {
+    if (_file.size() < static_cast<int64_t>(HeaderSize))
+    {
+      throw std::invalid_argument(InvalidFileMsg);
+    }
+    const MemView v = _file.view();
+    data = v.to_uint8Ptr();
+    fileSize = v.size();
+
+    if ((loadLittleEndian<uint64_t>(data) != SnapshotMagic) || (loadLittleEndian<uint64_t>(data + 8) != fileSize))
+    {
+      throw std::invalid_argument(InvalidFileMsg);
+    }
+    nRows = loadLittleEndian<uint64_t>(data + 16);
+    const uint64_t nColumns = loadLittleEndian<uint64_t>(data + 24);
+    const uint64_t flags = loadLittleEndian<uint64_t>(data + 32);
+
+    // each column needs at least eight bytes for its type
+    arraySize(nColumns, sizeof(uint64_t), fileSize);
+    size_t pos = HeaderSize;
+
+    if (flags & FlagHasHeaders)
+    {
+      ColumnLayout hdrLayout{};
+      pos = readDictionary(pos, hdrLayout.dictSize, hdrLayout.dictOffset, hdrLayout.blobOffset, hdrLayout.blobSize);
+      if (hdrLayout.dictSize != nColumns)
+      {
+        throw std::invalid_argument(InvalidFileMsg);
+      }
+      for (size_t idx = 0; idx < hdrLayout.dictSize; ++idx)
+      {
+        headerNames.emplace_back(dictionaryEntry(hdrLayout, idx));
+      }
+    }
+
+    cols.reserve(nColumns);
+    for (size_t colIdx = 0; colIdx < nColumns; ++colIdx)
+    {
+      ColumnLayout col{};
+
+      skipBlock(pos, sizeof(uint64_t), fileSize);
+      const uint64_t code = loadLittleEndian<uint64_t>(data + pos);
+      pos += sizeof(uint64_t);
+
+      col.validOffset = pos;
+      pos = skipBlock(pos, arraySize(bitmapWords(nRows), sizeof(uint64_t), fileSize), fileSize);
+
+      switch (code)
+      {
+      case TypeCodeEmpty:
+        col.type = CSV_Column::Type::Empty;
+        break;
+
+      case TypeCodeLong:
+      case TypeCodeDouble:
+        col.type = (code == TypeCodeLong) ? CSV_Column::Type::Long : CSV_Column::Type::Double;
+        col.dataOffset = pos;
+        pos = skipBlock(pos, arraySize(nRows, sizeof(uint64_t), fileSize), fileSize);
+        break;
+
+      case TypeCodeString:
+        col.type = CSV_Column::Type::String;
+        col.dataOffset = pos;
+        pos = skipBlock(pos, paddedSize(arraySize(nRows, sizeof(uint32_t), fileSize)), fileSize);
+        pos = readDictionary(pos, col.dictSize, col.dictOffset, col.blobOffset, col.blobSize);
+        break;
+
+      case TypeCodeMixed:
+        col.type = CSV_Column::Type::Mixed;
+        col.tagOffset = pos;
+        pos = skipBlock(pos, paddedSize(arraySize(nRows, sizeof(uint8_t), fileSize)), fileSize);
+        col.dataOffset = pos;
+        pos = skipBlock(pos, arraySize(nRows, sizeof(uint64_t), fileSize), fileSize);
+        pos = readDictionary(pos, col.dictSize, col.dictOffset, col.blobOffset, col.blobSize);
+        break;
+
+      default:
+        throw std::invalid_argument(InvalidFileMsg);
+      }
+
+      cols.push_back(col);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Column::Type CSV_SnapshotReader::columnType(ColumnIndexType colIdx) const
+  {
+    if (colIdx >= cols.size())
+    {
+      throw std::out_of_range("CSV_SnapshotReader::columnType(): invalid column index");
+    }
+
+    return cols[colIdx].type;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CSV_SnapshotReader::isNull(RowIndexType rowIdx, ColumnIndexType colIdx) const
+  {
+    assertIndex(rowIdx, colIdx);
+
+    const uint64_t word = loadLittleEndian<uint64_t>(data + cols[colIdx].validOffset + (rowIdx / 64) * sizeof(uint64_t));
+    return ((word >> (rowIdx % 64)) & 1) == 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Value CSV_SnapshotReader::get(RowIndexType rowIdx, ColumnIndexType colIdx) const
+  {
+    if (isNull(rowIdx, colIdx)) return CSV_Value{};
+
+    const ColumnLayout& col = cols[colIdx];
+    switch (col.type)
+    {
+    case CSV_Column::Type::Long:
+      return CSV_Value{static_cast<int64_t>(loadLittleEndian<uint64_t>(data + col.dataOffset + rowIdx * sizeof(uint64_t)))};
+
+    case CSV_Column::Type::Double:
+    {
+      const uint64_t bits = loadLittleEndian<uint64_t>(data + col.dataOffset + rowIdx * sizeof(uint64_t));
+      double d;
+      memcpy(&d, &bits, sizeof(d));
+      return CSV_Value{d};
+    }
+
+    case CSV_Column::Type::String:
+    {
+      const uint32_t code = loadLittleEndian<uint32_t>(data + col.dataOffset + rowIdx * sizeof(uint32_t));
+      return CSV_Value{string{dictionaryEntry(col, code)}};
+    }
+
+    case CSV_Column::Type::Mixed:
+    {
+      const uint8_t tag = data[col.tagOffset + rowIdx];
+      const uint64_t val = loadLittleEndian<uint64_t>(data + col.dataOffset + rowIdx * sizeof(uint64_t));
+      switch (tag)
+      {
+      case TagLong:
+        return CSV_Value{static_cast<int64_t>(val)};
+
+      case TagDouble:
+      {
+        double d;
+        memcpy(&d, &val, sizeof(d));
+        return CSV_Value{d};
+      }
+
+      case TagString:
+        return CSV_Value{string{dictionaryEntry(col, val)}};
+
+      default:
+        throw std::invalid_argument("CSV_SnapshotReader::get(): invalid value type in snapshot file");
+      }
+    }
+
+    default:
+      throw std::invalid_argument("CSV_SnapshotReader::get(): invalid value in empty column");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Row CSV_SnapshotReader::getRow(RowIndexType rowIdx) const
+  {
+    CSV_Row result;
+    result.reserve(cols.size());
+    for (ColumnIndexType colIdx = 0; colIdx < cols.size(); ++colIdx)
+    {
+      result.append(get(rowIdx, colIdx));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Table CSV_SnapshotReader::toTable() const
+  {
+    ScopedAllocTag allocTag{MemTag::CSV};
+
+    CSV_Table result;
+    if (hasHeaders()) result.setHeader(headerNames);
+    result.reserve(nRows);
+
+    for (RowIndexType rowIdx = 0; rowIdx < nRows; ++rowIdx)
+    {
+      result.append(getRow(rowIdx));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ArrayView<int64_t> CSV_SnapshotReader::longData(ColumnIndexType colIdx) const
+  {
+    const ColumnLayout& col = typedColumn(colIdx, CSV_Column::Type::Long);
+    return blockView<int64_t>(data + col.dataOffset, nRows);
+  }
+
+  //----------------------------------------------------------------------------
+
+  ArrayView<double> CSV_SnapshotReader::doubleData(ColumnIndexType colIdx) const
+  {
+    const ColumnLayout& col = typedColumn(colIdx, CSV_Column::Type::Double);
+    return blockView<double>(data + col.dataOffset, nRows);
+  }
+
+  //----------------------------------------------------------------------------
+
+  ArrayView<CSV_Column::StringCode> CSV_SnapshotReader::stringCodes(ColumnIndexType colIdx) const
+  {
+    const ColumnLayout& col = typedColumn(colIdx, CSV_Column::Type::String);
+    return blockView<CSV_Column::StringCode>(data + col.dataOffset, nRows);
+  }
+
+  //----------------------------------------------------------------------------
+
+  ArrayView<uint64_t> CSV_SnapshotReader::validityBits(ColumnIndexType colIdx) const
+  {
+    if (colIdx >= cols.size())
+    {
+      throw std::out_of_range("CSV_SnapshotReader::validityBits(): invalid column index");
+    }
+
+    return blockView<uint64_t>(data + cols[colIdx].validOffset, bitmapWords(nRows));
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t CSV_SnapshotReader::dictionarySize(ColumnIndexType colIdx) const
+  {
+    if (colIdx >= cols.size())
+    {
+      throw std::out_of_range("CSV_SnapshotReader::dictionarySize(): invalid column index");
+    }
+
+    return cols[colIdx].dictSize;
+  }
+
+  //----------------------------------------------------------------------------
+
+  string_view CSV_SnapshotReader::dictionaryEntry(ColumnIndexType colIdx, CSV_Column::StringCode code) const
+  {
+    if (colIdx >= cols.size())
+    {
+      throw std::out_of_range("CSV_SnapshotReader::dictionaryEntry(): invalid column index");
+    }
+
+    return dictionaryEntry(cols[colIdx], code);
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t CSV_SnapshotReader::readDictionary(size_t pos, size_t& dictSize, size_t& dictOffset, size_t& blobOffset, size_t& blobSize) const
+  {
+    skipBlock(pos, sizeof(uint64_t), fileSize);
+    dictSize = loadLittleEndian<uint64_t>(data + pos);
+    pos += sizeof(uint64_t);
+
+    // the individual string offsets are only checked on access,
+    // so that opening a snapshot doesn't depend on the dictionary size
+    dictOffset = pos;
+    const size_t offsetTableSize = arraySize(dictSize, sizeof(uint64_t), fileSize) + sizeof(uint64_t);
+    pos = skipBlock(pos, offsetTableSize, fileSize);
+
+    blobOffset = pos;
+    blobSize = loadLittleEndian<uint64_t>(data + dictOffset + dictSize * sizeof(uint64_t));
+    return skipBlock(pos, paddedSize(skipBlock(0, blobSize, fileSize)), fileSize);
+  }
+
+  //----------------------------------------------------------------------------
+
+  string_view CSV_SnapshotReader::dictionaryEntry(const ColumnLayout& col, uint64_t code) const
+  {
+    if (code >= col.dictSize)
+    {
+      throw std::invalid_argument("CSV_SnapshotReader: invalid dictionary code in snapshot file");
+    }
+
+    const uint64_t first = loadLittleEndian<uint64_t>(data + col.dictOffset + code * sizeof(uint64_t));
+    const uint64_t last = loadLittleEndian<uint64_t>(data + col.dictOffset + (code + 1) * sizeof(uint64_t));
+    if ((first > last) || (last > col.blobSize))
+    {
+      throw std::invalid_argument("CSV_SnapshotReader: invalid dictionary entry in snapshot file");
+    }
+
+    return string_view{reinterpret_cast<const char*>(data) + col.blobOffset + first, last - first};
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_SnapshotReader::assertIndex(RowIndexType rowIdx, ColumnIndexType colIdx) const
+  {
+    if ((rowIdx >= nRows) || (colIdx >= cols.size()))
+    {
+      throw std::out_of_range("CSV_SnapshotReader: invalid row or column index");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  const CSV_SnapshotReader::ColumnLayout& CSV_SnapshotReader::typedColumn(ColumnIndexType colIdx, CSV_Column::Type t) const
+  {
+    if (colIdx >= cols.size())
+    {
+      throw std::out_of_range("CSV_SnapshotReader: invalid column index");
+    }
+    if (cols[colIdx].type != t)
+    {
+      throw std::invalid_argument("CSV_SnapshotReader: requested column data doesn't match the column type");
+    }
+
+    return cols[colIdx];
+  }
+
+}
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_SNAPSHOT_H
+#define __LIBSLOPPY_CSV_SNAPSHOT_H
+
+#ifndef WIN32
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "CSV.h"           // for CSV_Table, CSV_Row, CSV_Value
+#include "CSV_Columnar.h"  // for CSV_ColumnarTable, CSV_Column
+#include "Memory.h"        // for ArrayView, MemFile
+
+namespace Sloppy
+{
+  /** \brief Writes a table to a binary snapshot file that can be read back
+   * with `CSV_SnapshotReader` without any parsing
+   *
+   * The snapshot stores the table column by column: the column type, a validity
+   * bitmap for the NULL values and a block of fixed-size values (`int64_t`, `double`
+   * or dictionary codes). Strings are stored once per column in a dictionary.
+   * All numbers are stored in little-endian byte order and all blocks are
+   * aligned to eight bytes, so the file is portable between platforms.
+   *
+   * \throws std::runtime_error if the file could not be written
+   */
+  void writeCSVSnapshot(
+      const CSV_Table& tab,   ///< the table that shall be written
+      const std::string& fileName   ///< name of the snapshot file that shall be created (or overwritten)
+      );
+
+  /** \brief Same as the other `writeCSVSnapshot()`, but for a columnar table
+   *
+   * This is the faster version because the table is already organized in columns.
+   */
+  void writeCSVSnapshot(
+      const CSV_ColumnarTable& tab,   ///< the table that shall be written
+      const std::string& fileName   ///< name of the snapshot file that shall be created (or overwritten)
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Provides access to the contents of a snapshot file created by `writeCSVSnapshot()`
+   *
+   * Opening a snapshot only validates the file layout (the size of all column blocks
+   * and dictionaries). All values are read on demand directly from the memory-mapped
+   * file; nothing is parsed or copied in advance.
+   *
+   * Besides the per-cell access with `get()`, the typed columns can be scanned
+   * without any copies: `longData()`, `doubleData()`, `stringCodes()` and
+   * `validityBits()` return views into the mapped file with the same layout
+   * as the respective `CSV_Column` accessors and `dictionaryEntry()` returns
+   * a view of a dictionary string.
+   *
+   * The reader keeps a reference to the file; it must outlive the reader.
+   */
+  class CSV_SnapshotReader
+  {
+  public:
+    using RowIndexType = size_t;
+    using ColumnIndexType = CSV_Row::IndexType;
+
+    /** \brief Ctor that validates the snapshot file and reads the headers (if any)
+     *
+     * \throws std::invalid_argument if the file is not a valid snapshot file
+     * or if it has been truncated
+     */
+    explicit CSV_SnapshotReader(
+        const MemFile& _file   ///< the snapshot file
+        );
+
+    /** \returns the number of data rows
+     */
+    RowIndexType size() const { return nRows; }
+
+    /** \returns the number of columns
+     */
+    ColumnIndexType nCols() const { return cols.size(); }
+
+    /** \returns `true` if the table has column headers
+     */
+    bool hasHeaders() const { return !headerNames.empty(); }
+
+    /** \returns all column headers (empty if the table has no headers)
+     */
+    const std::vector<std::string>& headers() const { return headerNames; }
+
+    /** \returns the type of a column
+     *
+     * \throws std::out_of_range if the column index is invalid
+     */
+    CSV_Column::Type columnType(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns `true` if a cell contains a NULL value
+     *
+     * \throws std::out_of_range if the row or column index is invalid
+     */
+    bool isNull(
+        RowIndexType rowIdx,   ///< zero-based index of the row
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns the value of a cell
+     *
+     * \throws std::out_of_range if the row or column index is invalid
+     *
+     * \throws std::invalid_argument if the cell refers to an invalid dictionary entry
+     */
+    CSV_Value get(
+        RowIndexType rowIdx,   ///< zero-based index of the row
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a complete data row
+     *
+     * \throws any exception of `get()`
+     */
+    CSV_Row getRow(
+        RowIndexType rowIdx   ///< zero-based index of the row
+        ) const;
+
+    /** \returns a (row-based) copy of the complete table
+     *
+     * \throws any exception of `get()`
+     */
+    CSV_Table toTable() const;
+
+    /** \returns a view of the values of a `Long` column in the mapped file;
+     * NULL values are represented by zero
+     *
+     * \throws std::out_of_range if the column index is invalid
+     *
+     * \throws std::invalid_argument if the column is not a `Long` column
+     *
+     * \throws std::runtime_error on big-endian hosts because the values are stored in little-endian byte order
+     */
+    ArrayView<int64_t> longData(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a view of the values of a `Double` column in the mapped file;
+     * NULL values are represented by zero
+     *
+     * \throws the same exceptions as `longData()`, for `Double` columns
+     */
+    ArrayView<double> doubleData(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a view of the dictionary codes of a `String` column in the
+     * mapped file; NULL values are represented by zero
+     *
+     * \throws the same exceptions as `longData()`, for `String` columns
+     */
+    ArrayView<CSV_Column::StringCode> stringCodes(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a view of the validity bitmap of a column in the mapped file; bit
+     * `idx % 64` of element `idx / 64` is set if the value at row `idx` is not NULL
+     *
+     * \throws std::out_of_range if the column index is invalid
+     *
+     * \throws std::runtime_error on big-endian hosts
+     */
+    ArrayView<uint64_t> validityBits(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns the number of entries in the dictionary of a `String`
+     * or `Mixed` column (zero for all other columns)
+     *
+     * \throws std::out_of_range if the column index is invalid
+     */
+    size_t dictionarySize(
+        ColumnIndexType colIdx   ///< zero-based index of the column
+        ) const;
+
+    /** \returns a view of a dictionary entry in the mapped file
+     *
+     * \throws std::out_of_range if the column index is invalid
+     *
+     * \throws std::invalid_argument if the code or the dictionary entry is invalid
+     */
+    std::string_view dictionaryEntry(
+        ColumnIndexType colIdx,   ///< zero-based index of the column
+        CSV_Column::StringCode code   ///< a code from `stringCodes()`
+        ) const;
+
+  private:
+    // the positions of the blocks of a column in the file
+    struct ColumnLayout
+    {
+      CSV_Column::Type type;
+      size_t validOffset;   ///< validity bitmap
+      size_t tagOffset;   ///< value types (mixed columns only)
+      size_t dataOffset;   ///< values or dictionary codes
+      size_t dictSize;   ///< number of dictionary entries
+      size_t dictOffset;   ///< dictionary entry offsets
+      size_t blobOffset;   ///< dictionary strings
+      size_t blobSize;
+    };
+
+    size_t readDictionary(size_t pos, size_t& dictSize, size_t& dictOffset, size_t& blobOffset, size_t& blobSize) const;
+    std::string_view dictionaryEntry(const ColumnLayout& col, uint64_t code) const;
+    void assertIndex(RowIndexType rowIdx, ColumnIndexType colIdx) const;
+    const ColumnLayout& typedColumn(ColumnIndexType colIdx, CSV_Column::Type t) const;
+
+    const uint8_t* data;
+    size_t fileSize;
+    RowIndexType nRows;
+    std::vector<ColumnLayout> cols;
+    std::vector<std::string> headerNames;
+  };
+}
+
+#endif
+
+#endif
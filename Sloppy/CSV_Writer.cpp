@@ -0,0 +1,198 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ostream>    // for ostream
+#include <stdexcept>  // for invalid_argument, runtime_error
+#include <utility>    // for move
+
+#ifndef WIN32
+#include "ManagedFileDescriptor.h"  // for ManagedFileDescriptor
+#endif
+
+#include "CSV_Writer.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  CSV_Writer::CSV_Writer(std::function<void (string_view)> writeFunc, std::function<void ()> syncFunc, CSV_StringRepresentation _rep, size_t _flushThreshold, size_t _syncInterval)
+    :writeChunk{std::move(writeFunc)}, syncDestination{std::move(syncFunc)}, rep{_rep},
+      flushThreshold{_flushThreshold}, syncInterval{_syncInterval}
+  {
+    // leave some room for the row that exceeds the threshold
+    buf.reserve(flushThreshold + flushThreshold / 4);
+  }
+
+  //----------------------------------------------------------------------------
+
+  CSV_Writer::CSV_Writer(ostream& dst, CSV_StringRepresentation _rep, size_t _flushThreshold, size_t _syncInterval)
+    :CSV_Writer{
+       [&dst](string_view data)
+       {
+         dst.write(data.data(), data.size());
+         if (!dst)
+         {
+           throw std::runtime_error("CSV_Writer: error while writing to output stream");
+         }
+       },
+       [&dst]() { dst.flush(); },
+       _rep, _flushThreshold, _syncInterval}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+#ifndef WIN32
+  CSV_Writer::CSV_Writer(ManagedFileDescriptor& fd, CSV_StringRepresentation _rep, size_t _flushThreshold, size_t _syncInterval)
+    :CSV_Writer{
+       [&fd](string_view data)
+       {
+         if (!fd.blockingWrite(data.data(), data.size()))
+         {
+           throw std::runtime_error("CSV_Writer: incomplete write to file descriptor");
+         }
+       },
+       [&fd]() { fd.sync(); },
+       _rep, _flushThreshold, _syncInterval}
+  {
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+
+  CSV_Writer::~CSV_Writer()
+  {
+    try
+    {
+      flush();
+    }
+    catch (...) {}
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::writeHeader(const vector<string>& headers)
+  {
+    assertColumnCount(headers.size());
+
+    for (size_t idx = 0; idx < headers.size(); ++idx)
+    {
+      if (idx > 0) buf += ',';
+      CSV_Value{headers[idx]}.appendTo(buf, rep);
+    }
+    finishRow(false);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::writeRow(const CSV_Row& row)
+  {
+    assertColumnCount(row.size());
+
+    // don't leave a partial row in the buffer if a value
+    // can't be serialized
+    const size_t oldSize = buf.size();
+    try
+    {
+      row.appendTo(buf, rep);
+    }
+    catch (...)
+    {
+      buf.resize(oldSize);
+      throw;
+    }
+    finishRow(true);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::writeTable(const CSV_Table& tab, bool includeHeaders)
+  {
+    if (includeHeaders && tab.hasHeaders())
+    {
+      vector<string> hdr;
+      for (CSV_Table::ColumnIndexType colIdx = 0; colIdx < tab.nCols(); ++colIdx)
+      {
+        hdr.push_back(tab.getHeader(colIdx));
+      }
+      writeHeader(hdr);
+    }
+
+    for (auto it = tab.cbegin(); it != tab.cend(); ++it)
+    {
+      writeRow(*it);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::flush()
+  {
+    if (buf.empty()) return;
+
+    writeChunk(buf);
+    nBytes += buf.size();
+    buf.clear();   // keeps the capacity
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::sync()
+  {
+    flush();
+    syncDestination();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::assertColumnCount(size_t n)
+  {
+    if (!hasColCount)
+    {
+      colCount = n;
+      hasColCount = true;
+      return;
+    }
+
+    if (n != colCount)
+    {
+      throw std::invalid_argument("CSV_Writer: inconsistent column count");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CSV_Writer::finishRow(bool isDataRow)
+  {
+    buf += '\n';
+
+    if (isDataRow)
+    {
+      ++nRows;
+      if ((syncInterval > 0) && ((nRows % syncInterval) == 0))
+      {
+        sync();
+        return;
+      }
+    }
+
+    if (buf.size() >= flushThreshold) flush();
+  }
+
+}
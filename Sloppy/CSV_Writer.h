@@ -0,0 +1,187 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CSV_WRITER_H
+#define __LIBSLOPPY_CSV_WRITER_H
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <functional>   // for function
+#include <iosfwd>       // for ostream
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "CSV.h"        // for CSV_Row, CSV_Table, CSV_StringRepresentation
+
+namespace Sloppy
+{
+#ifndef WIN32
+  class ManagedFileDescriptor;
+#endif
+
+  /** \brief Writes CSV data row by row to an output stream or a file descriptor
+   *
+   * Rows are serialized directly into an output buffer that is reused for the whole
+   * lifetime of the writer. The buffer is passed on to the destination whenever it
+   * exceeds a configurable size. Thus, large tables can be exported without holding
+   * the full CSV document in memory.
+   *
+   * The output format is identical to `CSV_Table::asString()`. All rows must
+   * have the same number of columns; the header row or the first data row
+   * determines the number of columns.
+   *
+   * Optionally, the writer can synchronize the output after every n rows
+   * (e.g., for append-only logs). For file descriptors this includes `fdatasync()`.
+   *
+   * The writer only keeps a reference to the destination. The destination
+   * must thus outlive the writer.
+   */
+  class CSV_Writer
+  {
+  public:
+    /** \brief The default size threshold for flushing the output buffer
+     */
+    static constexpr size_t DefaultFlushThreshold = 1024 * 1024;
+
+    /** \brief Ctor for writing to an output stream
+     */
+    CSV_Writer(
+        std::ostream& dst,   ///< the stream that receives the CSV data
+        CSV_StringRepresentation _rep,   ///< defines how string data is represented in the output
+        size_t _flushThreshold = DefaultFlushThreshold,   ///< the buffer is flushed as soon as it contains at least this many bytes
+        size_t _syncInterval = 0   ///< if not zero, `sync()` (flush + `ostream::flush()`) is called after every n rows
+        );
+
+#ifndef WIN32
+    /** \brief Ctor for writing to a file descriptor
+     */
+    CSV_Writer(
+        ManagedFileDescriptor& fd,   ///< the descriptor that receives the CSV data
+        CSV_StringRepresentation _rep,   ///< defines how string data is represented in the output
+        size_t _flushThreshold = DefaultFlushThreshold,   ///< the buffer is flushed as soon as it contains at least this many bytes
+        size_t _syncInterval = 0   ///< if not zero, `sync()` (flush + `fdatasync()`) is called after every n rows
+        );
+#endif
+
+    /** \brief Dtor; flushes all pending data
+     *
+     * Errors are ignored here. Call `flush()` before destroying
+     * the writer if you need to handle write errors.
+     */
+    ~CSV_Writer();
+
+    /** \brief Disabled copy ctor because the writer is bound to its destination */
+    CSV_Writer(const CSV_Writer& other) = delete;
+
+    /** \brief Disabled copy assignment because the writer is bound to its destination */
+    CSV_Writer& operator=(const CSV_Writer& other) = delete;
+
+    /** \brief Writes a header row; the headers are written like string values
+     *
+     * \throws std::invalid_argument if the number of headers doesn't match the number
+     * of columns of previously written rows
+     *
+     * \throws any exception of `flush()` if the buffer had to be flushed
+     */
+    void writeHeader(
+        const std::vector<std::string>& headers   ///< the column headers
+        );
+
+    /** \brief Writes a single data row
+     *
+     * \throws std::invalid_argument if the number of columns doesn't match the
+     * number of columns of previously written rows
+     *
+     * \throws bad_optional_access if the row contains a NULL value and
+     * no string quoting is used. The output is not modified in this case.
+     *
+     * \throws any exception of `flush()` or `sync()` if the buffer had to be flushed
+     */
+    void writeRow(
+        const CSV_Row& row   ///< the row to write
+        );
+
+    /** \brief Writes all rows of a table, optionally preceded by the table's headers
+     */
+    void writeTable(
+        const CSV_Table& tab,   ///< the table to write
+        bool includeHeaders   ///< write the headers yes/no; ignored if the table doesn't have headers
+        );
+
+    /** \brief Passes all buffered data to the destination
+     *
+     * \throws std::runtime_error if the destination stream failed or if not all
+     * data could be written to the file descriptor
+     *
+     * \throws IOError if an I/O error occurred while writing to the file descriptor
+     */
+    void flush();
+
+    /** \brief Flushes the buffer and synchronizes the destination (`ostream::flush()`
+     * or `fdatasync()`)
+     *
+     * \throws any exception of `flush()`
+     *
+     * \throws IOError if the file descriptor could not be synchronized
+     */
+    void sync();
+
+    /** \returns the number of data rows that have been written so far
+     */
+    size_t rowCount() const { return nRows; }
+
+    /** \returns the number of bytes that have been passed on to the destination so far
+     */
+    uint64_t bytesWritten() const { return nBytes; }
+
+  protected:
+    /** \brief Common ctor for all destinations
+     */
+    CSV_Writer(
+        std::function<void(std::string_view)> writeFunc,   ///< writes all data to the destination
+        std::function<void()> syncFunc,   ///< synchronizes the destination
+        CSV_StringRepresentation _rep,
+        size_t _flushThreshold,
+        size_t _syncInterval
+        );
+
+    /** \brief Checks and sets the number of columns
+     */
+    void assertColumnCount(size_t n);
+
+    /** \brief Terminates the current row in the buffer and flushes / syncs if necessary
+     */
+    void finishRow(bool isDataRow);
+
+  private:
+    std::function<void(std::string_view)> writeChunk;
+    std::function<void()> syncDestination;
+    CSV_StringRepresentation rep;
+    size_t flushThreshold;
+    size_t syncInterval;
+
+    std::string buf;
+    size_t colCount{0};
+    bool hasColCount{false};
+    size_t nRows{0};
+    uint64_t nBytes{0};
+  };
+}
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>    // for array
+#include <cstdint>  // for uint8_t, uint16_t
+#include <cstring>  // for memcpy, memset
+
+#ifdef __SSE2__
+#include <emmintrin.h>  // for _mm_loadu_si128, _mm_movemask_epi8, ...
+#endif
+
+#include "CharClass.h"
+#include "String.h"  // for umlautTranslationTable
+
+using namespace std;
+
+namespace Sloppy::CharClass
+{
+  namespace
+  {
+    inline bool isDigitByte(char c) { return (c >= '0') && (c <= '9'); }
+    inline bool isAlphaByte(char c) { return ((c | 0x20) >= 'a') && ((c | 0x20) <= 'z'); }
+    inline bool isSpaceByte(char c) { return (c == ' ') || ((c >= '\t') && (c <= '\r')); }
+
+#ifdef __SSE2__
+    constexpr size_t ChunkSize = 16;
+    constexpr int FullMask = 0xffff;
+
+    inline __m128i load(const char* p)
+    {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    // all bytes in [lo, hi]; bytes >= 0x80 are negative
+    // and thus never in range for ASCII bounds
+    inline __m128i inRange(__m128i v, char lo, char hi)
+    {
+      return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+    }
+
+    inline __m128i digitMask(__m128i v) { return inRange(v, '0', '9'); }
+    inline __m128i alphaMask(__m128i v) { return inRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'); }
+    inline __m128i alnumMask(__m128i v) { return _mm_or_si128(alphaMask(v), digitMask(v)); }
+    inline __m128i spaceMask(__m128i v)
+    {
+      return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), inRange(v, '\t', '\r'));
+    }
+
+// wraps a vector predicate in a lambda
+#define SLOPPY_VEC_PRED(f) [](__m128i v) { return f(v); }
+#else
+#define SLOPPY_VEC_PRED(f) nullptr
+#endif
+
+    //----------------------------------------------------------------------------
+
+    // the predicates should be lambdas (and not function
+    // pointers) so that they can be inlined
+    template<typename VecPred, typename BytePred>
+    bool allMatch(string_view s, [[maybe_unused]] VecPred vecPred, BytePred bytePred)
+    {
+      size_t idx{0};
+#ifdef __SSE2__
+      for (; (idx + ChunkSize) <= s.size(); idx += ChunkSize)
+      {
+        if (_mm_movemask_epi8(vecPred(load(s.data() + idx))) != FullMask) return false;
+      }
+#endif
+      for (; idx < s.size(); ++idx)
+      {
+        if (!bytePred(s[idx])) return false;
+      }
+
+      return true;
+    }
+
+    //----------------------------------------------------------------------------
+
+    template<char First, char Last, int Delta>
+    void shiftAsciiRange(char* p, size_t n)
+    {
+      size_t idx{0};
+#ifdef __SSE2__
+      const __m128i delta = _mm_set1_epi8(static_cast<char>(Delta));
+      for (; (idx + ChunkSize) <= n; idx += ChunkSize)
+      {
+        __m128i v = load(p + idx);
+        v = _mm_add_epi8(v, _mm_and_si128(inRange(v, First, Last), delta));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + idx), v);
+      }
+#endif
+      for (; idx < n; ++idx)
+      {
+        if ((p[idx] >= First) && (p[idx] <= Last)) p[idx] = static_cast<char>(p[idx] + Delta);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    // Two-byte UTF-8 sequences encode the code points 0x80 ... 0x7ff,
+    // so a table with 2048 entries covers all of them
+    using CaseTable = array<uint16_t, 2048>;
+
+    struct CaseTables
+    {
+      CaseTable upper;
+      CaseTable lower;
+      vector<pair<string, string>> irregular;
+    };
+
+    bool isTwoByteSequence(const string& s)
+    {
+      if (s.size() != 2) return false;
+      const auto lead = static_cast<uint8_t>(s[0]);
+      const auto cont = static_cast<uint8_t>(s[1]);
+      return ((lead >= 0xc2) && (lead <= 0xdf) && ((cont & 0xc0) == 0x80));
+    }
+
+    uint16_t codePoint(uint8_t lead, uint8_t cont)
+    {
+      return static_cast<uint16_t>(((lead & 0x1f) << 6) | (cont & 0x3f));
+    }
+
+    const CaseTables& caseTables()
+    {
+      static const CaseTables tables = []()
+      {
+        CaseTables t;
+        for (size_t cp = 0; cp < t.upper.size(); ++cp)
+        {
+          t.upper[cp] = static_cast<uint16_t>(cp);
+          t.lower[cp] = static_cast<uint16_t>(cp);
+        }
+
+        for (const auto& [lo, up] : umlautTranslationTable)
+        {
+          if (!isTwoByteSequence(lo) || !isTwoByteSequence(up))
+          {
+            t.irregular.push_back(pair{lo, up});
+            continue;
+          }
+
+          const uint16_t cpLo = codePoint(lo[0], lo[1]);
+          const uint16_t cpUp = codePoint(up[0], up[1]);
+          t.upper[cpLo] = cpUp;
+          t.lower[cpUp] = cpLo;
+        }
+
+        return t;
+      }();
+
+      return tables;
+    }
+
+    //----------------------------------------------------------------------------
+
+    void applyTwoByteTable(char* p, size_t n, const CaseTable& table)
+    {
+      size_t idx = firstNonAscii(string_view{p, n});
+      while ((idx + 1) < n)
+      {
+        const auto lead = static_cast<uint8_t>(p[idx]);
+        const auto cont = static_cast<uint8_t>(p[idx + 1]);
+        if (((lead & 0xe0) != 0xc0) || ((cont & 0xc0) != 0x80))
+        {
+          ++idx;
+          continue;
+        }
+
+        const uint16_t cp = codePoint(lead, cont);
+        const uint16_t newCp = table[cp];
+        if (newCp != cp)
+        {
+          p[idx] = static_cast<char>(0xc0 | (newCp >> 6));
+          p[idx + 1] = static_cast<char>(0x80 | (newCp & 0x3f));
+        }
+        idx += 2;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t firstNonAscii(string_view s)
+  {
+    size_t idx{0};
+#ifdef __SSE2__
+    for (; (idx + ChunkSize) <= s.size(); idx += ChunkSize)
+    {
+      const int m = _mm_movemask_epi8(load(s.data() + idx));
+      if (m != 0) return idx + __builtin_ctz(m);
+    }
+#endif
+    while ((idx < s.size()) && (static_cast<uint8_t>(s[idx]) < 0x80)) ++idx;
+
+    return idx;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool isAllDigits(string_view s)
+  {
+    return allMatch(s, SLOPPY_VEC_PRED(digitMask), [](char c) { return isDigitByte(c); });
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool isAllAlpha(string_view s)
+  {
+    return allMatch(s, SLOPPY_VEC_PRED(alphaMask), [](char c) { return isAlphaByte(c); });
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool isAllAlnum(string_view s)
+  {
+    return allMatch(s, SLOPPY_VEC_PRED(alnumMask), [](char c) { return (isAlphaByte(c) || isDigitByte(c)); });
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t countLeadingSpaces(string_view s)
+  {
+    size_t idx{0};
+#ifdef __SSE2__
+    for (; (idx + ChunkSize) <= s.size(); idx += ChunkSize)
+    {
+      const int nonSpace = _mm_movemask_epi8(spaceMask(load(s.data() + idx))) ^ FullMask;
+      if (nonSpace != 0) return idx + __builtin_ctz(nonSpace);
+    }
+#endif
+    while ((idx < s.size()) && isSpaceByte(s[idx])) ++idx;
+
+    return idx;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t countTrailingSpaces(string_view s)
+  {
+    size_t end = s.size();  // one past the last non-space character
+#ifdef __SSE2__
+    for (; end >= ChunkSize; end -= ChunkSize)
+    {
+      const int nonSpace = _mm_movemask_epi8(spaceMask(load(s.data() + end - ChunkSize))) ^ FullMask;
+      if (nonSpace != 0)
+      {
+        const int idxHighestBit = 31 - __builtin_clz(nonSpace);
+        return s.size() - (end - ChunkSize + idxHighestBit + 1);
+      }
+    }
+#endif
+    while ((end > 0) && isSpaceByte(s[end - 1])) --end;
+
+    return s.size() - end;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void asciiToUpper(char* p, size_t n)
+  {
+    shiftAsciiRange<'a', 'z', 'A' - 'a'>(p, n);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void asciiToLower(char* p, size_t n)
+  {
+    shiftAsciiRange<'A', 'Z', 'a' - 'A'>(p, n);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void toUpper(char* p, size_t n)
+  {
+    asciiToUpper(p, n);
+    applyTwoByteTable(p, n, caseTables().upper);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void toLower(char* p, size_t n)
+  {
+    asciiToLower(p, n);
+    applyTwoByteTable(p, n, caseTables().lower);
+  }
+
+  //----------------------------------------------------------------------------
+
+  const vector<pair<string, string>>& irregularCasePairs()
+  {
+    return caseTables().irregular;
+  }
+}
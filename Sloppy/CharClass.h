@@ -0,0 +1,96 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CHARCLASS_H
+#define __LIBSLOPPY_CHARCLASS_H
+
+#include <cstddef>      // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+namespace Sloppy
+{
+  /** \brief Fast character classification and case conversion kernels
+   *
+   * All functions operate on raw byte buffers. ASCII data is processed
+   * 16 bytes at a time using SSE2 if available; non-ASCII bytes are treated as
+   * UTF-8. The results do not depend on the current locale and match the
+   * behaviour of the `<cctype>` functions in the default "C" locale.
+   */
+  namespace CharClass
+  {
+    /** \returns the index of the first byte with the highest bit set (i.e.,
+     * the first non-ASCII byte) or the length of the input if the input is pure ASCII
+     */
+    size_t firstNonAscii(std::string_view s);
+
+    /** \returns `true` if all characters are ASCII digits (`0` ... `9`); `true` for empty input
+     */
+    bool isAllDigits(std::string_view s);
+
+    /** \returns `true` if all characters are ASCII letters; `true` for empty input
+     */
+    bool isAllAlpha(std::string_view s);
+
+    /** \returns `true` if all characters are ASCII letters or digits; `true` for empty input
+     */
+    bool isAllAlnum(std::string_view s);
+
+    /** \returns the number of white space characters (as defined by `isspace()`
+     * in the "C" locale) at the start of the input
+     */
+    size_t countLeadingSpaces(std::string_view s);
+
+    /** \returns the number of white space characters (as defined by `isspace()`
+     * in the "C" locale) at the end of the input
+     */
+    size_t countTrailingSpaces(std::string_view s);
+
+    /** \brief Converts all ASCII letters to upper case; all other bytes remain untouched
+     */
+    void asciiToUpper(char* p, size_t n);
+
+    /** \brief Converts all ASCII letters to lower case; all other bytes remain untouched
+     */
+    void asciiToLower(char* p, size_t n);
+
+    /** \brief Converts a UTF-8 buffer to upper case in place
+     *
+     * ASCII letters are converted directly. Two-byte UTF-8 sequences are converted
+     * using a lookup table that is derived from `umlautTranslationTable`; all other
+     * multi-byte sequences remain untouched.
+     */
+    void toUpper(char* p, size_t n);
+
+    /** \brief Converts a UTF-8 buffer to lower case in place
+     *
+     * The counterpart of `toUpper()`.
+     */
+    void toLower(char* p, size_t n);
+
+    /** \returns the pairs from `umlautTranslationTable` that cannot be handled by
+     * the lookup table in `toUpper()` / `toLower()` because they are not
+     * two-byte UTF-8 sequences; these have to be replaced by the caller
+     */
+    const std::vector<std::pair<std::string, std::string>>& irregularCasePairs();
+  }
+}
+
+#endif
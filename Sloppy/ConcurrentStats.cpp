@@ -0,0 +1,164 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for clamp
+#include <thread>     // for hardware_concurrency
+
+#include "ConcurrentStats.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  size_t defaultShardCount()
+  {
+    static const size_t cnt = std::clamp<size_t>(thread::hardware_concurrency(), 1, 16);
+    return cnt;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t currentThreadShardHint()
+  {
+    // threads are numbered in the order in which they
+    // first touch any of the concurrent stats
+    static atomic<size_t> nextThreadNumber{0};
+    thread_local const size_t threadNumber = nextThreadNumber.fetch_add(1, memory_order_relaxed);
+
+    return threadNumber;
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  ShardedCounter::ShardedCounter(size_t shardCount)
+    :nShards{(shardCount == 0) ? 1 : shardCount}, shards{make_unique<Shard[]>(nShards)}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  uint64_t ShardedCounter::value() const
+  {
+    uint64_t result{0};
+    for (size_t i = 0; i < nShards; ++i) result += shards[i].value.load(memory_order_relaxed);
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ShardedCounter::reset()
+  {
+    for (size_t i = 0; i < nShards; ++i) shards[i].value.store(0, memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  ConcurrentHistogram::ConcurrentHistogram(size_t shardCount)
+    :nShards{(shardCount == 0) ? 1 : shardCount}, shards{make_unique<Shard[]>(nShards)}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ConcurrentHistogram::record(int64_t value_ns, uint64_t n)
+  {
+    if (n == 0) return;
+    if (value_ns < 0) value_ns = 0;
+
+    Shard& s = shards[currentThreadShardHint() % nShards];
+    s.buckets[LatencyHistogram::bucketIndex(value_ns)].fetch_add(n, memory_order_relaxed);
+    s.sum.fetch_add(static_cast<uint64_t>(value_ns) * n, memory_order_relaxed);
+
+    int64_t prev = s.minValue.load(memory_order_relaxed);
+    while ((value_ns < prev) && !s.minValue.compare_exchange_weak(prev, value_ns, memory_order_relaxed)) {}
+
+    prev = s.maxValue.load(memory_order_relaxed);
+    while ((value_ns > prev) && !s.maxValue.compare_exchange_weak(prev, value_ns, memory_order_relaxed)) {}
+  }
+
+  //----------------------------------------------------------------------------
+
+  LatencyHistogram ConcurrentHistogram::snapshot() const
+  {
+    LatencyHistogram result;
+    for (size_t i = 0; i < nShards; ++i)
+    {
+      const Shard& s = shards[i];
+
+      uint64_t cnt{0};
+      for (size_t idx = 0; idx < LatencyHistogram::BucketCount; ++idx)
+      {
+        const uint64_t n = s.buckets[idx].load(memory_order_relaxed);
+        result.buckets[idx] += n;
+        cnt += n;
+      }
+      if (cnt == 0) continue;
+
+      const int64_t minVal = s.minValue.load(memory_order_relaxed);
+      const int64_t maxVal = s.maxValue.load(memory_order_relaxed);
+      if ((result.totalCount == 0) || (minVal < result.minValue)) result.minValue = minVal;
+      if (maxVal > result.maxValue) result.maxValue = maxVal;
+      result.totalCount += cnt;
+      result.sum += static_cast<double>(s.sum.load(memory_order_relaxed));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ConcurrentHistogram::reset()
+  {
+    for (size_t i = 0; i < nShards; ++i)
+    {
+      Shard& s = shards[i];
+      for (auto& b : s.buckets) b.store(0, memory_order_relaxed);
+      s.sum.store(0, memory_order_relaxed);
+      s.minValue.store(INT64_MAX, memory_order_relaxed);
+      s.maxValue.store(0, memory_order_relaxed);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  AsyncWorkerStats ConcurrentWorkerStats::snapshot() const
+  {
+    AsyncWorkerStats result;
+    result.runtimeHistogram = runtimes.snapshot();
+
+    const LatencyHistogram& h = result.runtimeHistogram;
+    result.nCalls = h.count();
+    if (result.nCalls == 0) return result;
+
+    result.totalRuntime_ms = static_cast<unsigned long long>(h.mean() * h.count() / 1e6);
+    result.lastRuntime_ms = static_cast<int>(lastRuntime_ns.load(memory_order_relaxed) / 1000000);
+    result.minWorkerTime_ms = static_cast<int>(h.min() / 1000000);
+    result.maxWorkerTime_ms = static_cast<int>(h.max() / 1000000);
+
+    return result;
+  }
+
+}
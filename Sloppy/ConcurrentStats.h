@@ -0,0 +1,188 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CONCURRENT_STATS_H
+#define __LIBSLOPPY_CONCURRENT_STATS_H
+
+#include <array>    // for array
+#include <atomic>   // for atomic
+#include <cstdint>  // for int64_t, uint64_t
+#include <memory>   // for unique_ptr
+
+#include "Histogram.h"    // for LatencyHistogram
+#include "ThreadStats.h"  // for AsyncWorkerStats
+
+namespace Sloppy
+{
+  /** \brief The assumed size of a cache line; used for padding shards in
+   * order to avoid false sharing between threads
+   */
+  static constexpr size_t CacheLineSize = 64;
+
+  /** \returns the default number of shards for the concurrent
+   * stats classes (number of hardware threads, limited to 1...16)
+   */
+  size_t defaultShardCount();
+
+  /** \returns a small, stable per-thread number that is used
+   * for selecting a shard
+   */
+  size_t currentThreadShardHint();
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A counter that can be incremented from many threads without
+   * contention.
+   *
+   * Each writing thread is mapped to one of several cache-line-padded
+   * shards that are updated with relaxed atomics. Reading the value
+   * sums up all shards; the result is not a point-in-time snapshot
+   * across all shards but every increment is eventually included.
+   */
+  class ShardedCounter
+  {
+  public:
+    /** \brief Ctor
+     */
+    explicit ShardedCounter(
+        size_t nShards = defaultShardCount()   ///< number of independent shards (at least 1)
+        );
+
+    /** \brief Increments the counter
+     *
+     * \note This function is thread-safe and lock-free.
+     */
+    void add(uint64_t n = 1)
+    {
+      shards[currentThreadShardHint() % nShards].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /** \returns the sum of all increments
+     *
+     * \note This function is thread-safe and lock-free.
+     */
+    uint64_t value() const;
+
+    /** \brief Resets the counter to zero; increments that are
+     * performed concurrently may or may not be lost
+     */
+    void reset();
+
+  private:
+    struct alignas(CacheLineSize) Shard
+    {
+      std::atomic<uint64_t> value{0};
+    };
+
+    size_t nShards;
+    std::unique_ptr<Shard[]> shards;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A `LatencyHistogram` that can be fed from many threads without
+   * contention.
+   *
+   * Each writing thread is mapped to one of several cache-line-aligned
+   * shards whose buckets are updated with relaxed atomics. `snapshot()`
+   * aggregates all shards into a regular `LatencyHistogram` on demand.
+   */
+  class ConcurrentHistogram
+  {
+  public:
+    /** \brief Ctor
+     */
+    explicit ConcurrentHistogram(
+        size_t nShards = defaultShardCount()   ///< number of independent shards (at least 1)
+        );
+
+    /** \brief Records one or more occurrences of a value; negative values are recorded as zero
+     *
+     * \note This function is thread-safe and lock-free.
+     */
+    void record(
+        int64_t value_ns,   ///< the value to record
+        uint64_t n = 1   ///< the number of occurrences
+        );
+
+    /** \returns a histogram that contains the values of all shards
+     *
+     * \note This function is thread-safe and lock-free. Values that
+     * are recorded concurrently may or may not be included.
+     */
+    LatencyHistogram snapshot() const;
+
+    /** \brief Removes all recorded values; values that are recorded
+     * concurrently may or may not be lost
+     */
+    void reset();
+
+  private:
+    struct alignas(CacheLineSize) Shard
+    {
+      std::atomic<uint64_t> sum{0};
+      std::atomic<int64_t> minValue{INT64_MAX};
+      std::atomic<int64_t> maxValue{0};
+      std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount> buckets{};
+    };
+
+    size_t nShards;
+    std::unique_ptr<Shard[]> shards;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Lock-free replacement for a mutex-protected `AsyncWorkerStats` instance.
+   *
+   * Workers call `update__ns()` after each call of the worker function; readers
+   * obtain a regular `AsyncWorkerStats` instance via `snapshot()`. Neither
+   * side ever blocks the other.
+   */
+  class ConcurrentWorkerStats
+  {
+  public:
+    /** \brief Ctor
+     */
+    explicit ConcurrentWorkerStats(
+        size_t nShards = 1   ///< number of independent shards; one is sufficient for a single writer thread
+        )
+      :runtimes{nShards} {}
+
+    /** \brief Records the execution time of a worker call
+     *
+     * \note This function is thread-safe and lock-free.
+     */
+    void update__ns(int64_t execTime_ns)
+    {
+      runtimes.record(execTime_ns);
+      lastRuntime_ns.store(execTime_ns, std::memory_order_relaxed);
+    }
+
+    /** \returns the aggregated stats
+     *
+     * \note This function is thread-safe and lock-free.
+     */
+    AsyncWorkerStats snapshot() const;
+
+  private:
+    ConcurrentHistogram runtimes;
+    std::atomic<int64_t> lastRuntime_ns{0};
+  };
+}
+
+#endif
@@ -28,6 +28,7 @@
 
 #include "ConfigFileParser.h"
 #include "../String.h"       // for estring
+#include "../Tracing.h"      // for SLOPPY_TRACE_SPAN
 
 using namespace std;
 
@@ -417,6 +418,8 @@ namespace Sloppy
 
   void Parser::fillFromStream(istream& inStream)
   {
+    SLOPPY_TRACE_SPAN("Parser::fillFromStream");
+
     // prepare a few regex; do this only once because
     // construction of regexs is expensive
     static const regex reSection{"^\\[([^\\]]*)\\]"};
@@ -427,10 +430,11 @@ namespace Sloppy
 
     estring curSecName = defaultSectionName;
 
-    // read the data line by line
+    // read the data line by line; the line buffer is
+    // re-used in order to avoid one allocation per line
+    estring line;
     while (inStream)   // used as a condition, the stream is evaluated to 'false' if EOF or errors occur
     {
-      estring line;
       getline(inStream, line);
 
       // strip white spaces
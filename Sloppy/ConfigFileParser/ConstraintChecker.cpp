@@ -24,6 +24,7 @@
 #include <vector>              // for vector
 
 #include "ConstraintChecker.h"
+#include "../CharClass.h"      // for isAllAlnum, isAllAlpha, isAllDigits
 #include "../DateTime/date.h"  // for operator/, year, year_month, year_mont...
 #include "../DateTime/tz.h"    // for locate_zone
 #include "../String.h"         // for estring
@@ -55,11 +56,8 @@ namespace Sloppy
 
   bool checkConstraint(const estring& val, ValueConstraint c, std::string* errMsg)
   {
-    // regexs are expensive to create and thus we keep a few
-    // of them in static local variables
-    static std::regex reAlnum{"[[:alnum:]]+"};
-    static std::regex reAlpha{"[[:alpha:]]+"};
-    static std::regex reDigit{"[[:digit:]]+"};
+    // regexs are expensive to create and thus we keep
+    // them in static local variables
     static std::regex reIsoDate{"(\\d{4})-(\\d{1,2})-(\\d{1,2})"};
 
     // is the value non-empty?
@@ -76,10 +74,10 @@ namespace Sloppy
     // the checks so far where enough to satisfy KeyValueConstraint::NotEmpty
     if (c == ValueConstraint::NotEmpty) return true;
 
-    // check the AlNum constraint with a regex
+    // check the AlNum constraint
     if (c == ValueConstraint::Alnum)
     {
-      bool isOkay = regex_match(val, reAlnum);
+      bool isOkay = CharClass::isAllAlnum(val);
       if (!isOkay && (errMsg != nullptr))
       {
         *errMsg = "is not purely alphanumeric!";
@@ -88,10 +86,10 @@ namespace Sloppy
       return isOkay;
     }
 
-    // check the Alpha constraint with a regex
+    // check the Alpha constraint
     if (c == ValueConstraint::Alpha)
     {
-      bool isOkay = regex_match(val, reAlpha);
+      bool isOkay = CharClass::isAllAlpha(val);
       if (!isOkay && (errMsg != nullptr))
       {
         *errMsg = "is not purely alphabetic!";
@@ -100,10 +98,10 @@ namespace Sloppy
       return isOkay;
     }
 
-    // check the Digit constraint with a regex
+    // check the Digit constraint
     if (c == ValueConstraint::Digit)
     {
-      bool isOkay = regex_match(val, reDigit);
+      bool isOkay = CharClass::isAllDigits(val);
       if (!isOkay && (errMsg != nullptr))
       {
         *errMsg = "contains non-digit characters!";
@@ -27,6 +27,7 @@
 #include <type_traits>                                 // for __strip_refere...
 #include <vector>                                      // for vector
 
+#include "../AllocTracker.h"  // for ScopedAllocTag
 #include "../Memory.h"  // for MemView, MemArray
 
 #include "Crypto.h"
@@ -144,6 +145,7 @@ namespace Sloppy
     // Taken from https://stackoverflow.com/a/34571089
     MemArray toBase64(const MemView& src)
     {
+      ScopedAllocTag allocTag{MemTag::Crypto};
       const size_t srcLen = src.byteSize();
       if (src.empty())
       {
@@ -206,6 +208,8 @@ namespace Sloppy
     // Taken from https://stackoverflow.com/a/34571089
     MemArray fromBase64(const MemView& src)
     {
+      ScopedAllocTag allocTag{MemTag::Crypto};
+
       // calculate the length of the destination data block and
       // make sure that the padding is used correctly in the source data
       size_t dstLen = calc_base64_rawSize(src);
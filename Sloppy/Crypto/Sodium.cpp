@@ -24,7 +24,9 @@
 #include <sodium.h>
 
 #include "Sodium.h"
+#include "../AllocTracker.h"
 #include "../Net/Net.h"
+#include "../Tracing.h"
 #include "Crypto.h"
 
 using namespace std;
@@ -823,6 +825,9 @@ namespace Sloppy
 
     MemArray SodiumLib::secretbox_easy(const MemView& msg, const SecretBoxNonce& nonce, const SecretBoxKey& key)
     {
+      SLOPPY_TRACE_SPAN("SodiumLib::secretbox_easy");
+      ScopedAllocTag allocTag{MemTag::Crypto};
+
       // the message and the other parameters should be valid
       if (msg.empty())
       {
@@ -851,6 +856,9 @@ namespace Sloppy
 
     bool SodiumLib::secretbox_open_easy__internal(const MemArray& targetBuf, const MemView& cipher, const SodiumLib::SecretBoxNonce& nonce, const SodiumLib::SecretBoxKey& key)
     {
+      SLOPPY_TRACE_SPAN("SodiumLib::secretbox_open_easy");
+      ScopedAllocTag allocTag{MemTag::Crypto};
+
       // the parameters should be valid
       if (cipher.empty() || (cipher.size() <= crypto_secretbox_MACBYTES))
       {
@@ -1586,6 +1594,9 @@ namespace Sloppy
     MemArray SodiumLib::box_easy(const MemView& msg, const SodiumLib::AsymCrypto_Nonce& nonce,
                                              const SodiumLib::AsymCrypto_PublicKey& recipientKey, const SodiumLib::AsymCrypto_SecretKey& senderKey)
     {
+      SLOPPY_TRACE_SPAN("SodiumLib::box_easy");
+      ScopedAllocTag allocTag{MemTag::Crypto};
+
       // the message and the other parameters should be valid
       if (msg.empty())
       {
@@ -1616,6 +1627,9 @@ namespace Sloppy
                                                        const SodiumLib::AsymCrypto_PublicKey& senderKey, const SodiumLib::AsymCrypto_SecretKey& recipientKey,
                                                        SodiumSecureMemType clearTextProtection)
     {
+      SLOPPY_TRACE_SPAN("SodiumLib::box_open_easy");
+      ScopedAllocTag allocTag{MemTag::Crypto};
+
       // the cipher and keys should be valid
       if (cipher.empty())
       {
@@ -0,0 +1,606 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits>     // for numeric_limits
+#include <stdexcept>  // for invalid_argument, runtime_error
+#include <thread>     // for sleep_for
+#include <utility>    // for move
+
+#include "Timer.h"    // for Timer
+
+#include "CyclicJobScheduler.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  ScheduledJob::ScheduledJob(int minWorkerCycle_ms, bool isOneShot)
+    :workerCycle_ms{minWorkerCycle_ms}, oneShot{isOneShot}
+  {
+    stats.workerCycleTime_ms = workerCycle_ms;
+    stats.workerCycleTime_us = workerCycle_ms * 1000LL;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ScheduledJob::State ScheduledJob::state()
+  {
+    lock_guard<mutex> lk{jobMutex};
+    return curState;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ScheduledJob::run()
+  {
+    if (isTransitionPending) return false;
+
+    {
+      lock_guard<mutex> lk{jobMutex};
+
+      // is there anything to do at all?
+      if (curState == State::Running) return true;
+
+      // are we in a valid state for the transition?
+      if ((curState != State::Initialized) && (curState != State::Suspended)) return false;
+
+      reqState = State::Running;
+      isTransitionPending = true;
+    }
+
+    notifyScheduler();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ScheduledJob::pause()
+  {
+    if (isTransitionPending) return false;
+
+    {
+      lock_guard<mutex> lk{jobMutex};
+
+      // is there anything to do at all?
+      if (curState == State::Suspended) return true;
+
+      // are we in a valid state for the transition?
+      if (curState != State::Running) return false;
+
+      reqState = State::Suspended;
+      isTransitionPending = true;
+    }
+
+    notifyScheduler();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ScheduledJob::resume()
+  {
+    if (isTransitionPending) return false;
+
+    {
+      lock_guard<mutex> lk{jobMutex};
+
+      // is there anything to do at all?
+      if (curState == State::Running) return true;
+
+      // are we in a valid state for the transition?
+      if (curState != State::Suspended) return false;
+
+      reqState = State::Running;
+      isTransitionPending = true;
+    }
+
+    notifyScheduler();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ScheduledJob::terminate()
+  {
+    {
+      unique_lock<mutex> lk{jobMutex};
+
+      // is there anything to do at all?
+      if (curState == State::Finished) return;
+
+      reqState = State::Finished;
+      isTransitionPending = true;
+
+      // without a scheduler there is no pool thread that
+      // could complete the transition, so we do it ourselves
+      if (scheduler == nullptr)
+      {
+        doStateMachine(lk);
+        return;
+      }
+    }
+
+    notifyScheduler();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ScheduledJob::waitForStateChange()
+  {
+    while (isTransitionPending)
+    {
+      this_thread::sleep_for(chrono::milliseconds(CyclicWorkerThread::WaitForStateChangePollingTime_ms));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CyclicThreadStats ScheduledJob::workerStats()
+  {
+    lock_guard<mutex> lk{jobMutex};
+    return stats;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ScheduledJob::ExecResult ScheduledJob::execute(const chrono::steady_clock::time_point& dueTime)
+  {
+    unique_lock<mutex> lk{jobMutex};
+
+    // process pending requests first; this implies
+    // that the worker of a cyclic job is executed immediately
+    // after onFirstRun() or onResume()
+    const State prevState = curState;
+    doStateMachine(lk);
+
+    // one-shot jobs execute their worker one cycle after
+    // run(); so we only return for rescheduling here
+    const bool isStartDelayPending = oneShot && (prevState == State::Initialized) && (curState == State::Running);
+
+    if ((curState == State::Running) && !isStartDelayPending)
+    {
+      // release the lock while we're executing the worker
+      lk.unlock();
+
+      const int64_t jitter = max<int64_t>(0, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - dueTime).count());
+      Sloppy::Timer t;
+      worker();
+      const int64_t workerTime = t.getTime__ns();
+
+      lk.lock();
+      stats.update__ns(workerTime, jitter);
+
+      if (oneShot)
+      {
+        reqState = State::Finished;
+        isTransitionPending = true;
+      }
+
+      // process requests that came in while the worker was running
+      doStateMachine(lk);
+    }
+
+    switch (curState)
+    {
+    case State::Running:
+      return ExecResult::Reschedule;
+
+    case State::Finished:
+      // the scheduler will release us, so we must
+      // not contact it anymore
+      scheduler = nullptr;
+      return ExecResult::Drop;
+
+    default:
+      return ExecResult::Park;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ScheduledJob::doStateMachine(unique_lock<mutex>& lk)
+  {
+    // is there anything to do at all?
+    if (reqState == curState) return;
+
+    // Termination takes precedence, check that first
+    if (reqState == State::Finished)
+    {
+      curState = State::Terminating;
+
+      lk.unlock();
+      onTerminate();
+      lk.lock();
+
+      curState = State::Finished;
+      isTransitionPending = false;
+      return;
+    }
+
+    // Initialized --> Preparing --> Running
+    if ((curState == State::Initialized) && (reqState == State::Running))
+    {
+      curState = State::Preparing;
+
+      lk.unlock();
+      onFirstRun();
+      lk.lock();
+
+      curState = State::Running;
+      isTransitionPending = false;
+      return;
+    }
+
+    // Running --> Suspending --> Suspended
+    if ((curState == State::Running) && (reqState == State::Suspended))
+    {
+      curState = State::Suspending;
+
+      lk.unlock();
+      onSuspend();
+      lk.lock();
+
+      curState = State::Suspended;
+      isTransitionPending = false;
+      return;
+    }
+
+    // Suspended --> Resuming --> Running
+    if ((curState == State::Suspended) && (reqState == State::Running))
+    {
+      curState = State::Resuming;
+
+      lk.unlock();
+      onResume();
+      lk.lock();
+
+      curState = State::Running;
+      isTransitionPending = false;
+      return;
+    }
+
+    // we should never reach this point
+    throw std::runtime_error("ScheduledJob: state machine inconsistency or missing state transition!");
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ScheduledJob::notifyScheduler()
+  {
+    CyclicJobScheduler* s{nullptr};
+    {
+      lock_guard<mutex> lk{jobMutex};
+      s = scheduler;
+    }
+
+    if (s != nullptr) s->requestExecution(this);
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  CyclicJobScheduler::CyclicJobScheduler(int nThreads, int tickDuration_ms, const ThreadConfig& thCfg)
+    :startTime{chrono::steady_clock::now()}, tickDuration{tickDuration_ms}
+  {
+    if ((nThreads < 1) || (tickDuration_ms < 1))
+    {
+      throw std::invalid_argument("CyclicJobScheduler: invalid number of threads or invalid tick duration");
+    }
+
+    try
+    {
+      for (int i = 0; i < nThreads; ++i)
+      {
+        poolThreads.emplace_back(thCfg, [this]{ poolLoop(); });
+      }
+    }
+    catch (...)
+    {
+      // stop the threads that have already been started
+      {
+        lock_guard<mutex> lk{schedMutex};
+        isShuttingDown = true;
+        cv.notify_all();
+      }
+      for (auto& t : poolThreads) t.join();
+      throw;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CyclicJobScheduler::~CyclicJobScheduler()
+  {
+    terminateAllAndJoin();
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool CyclicJobScheduler::addJob(const shared_ptr<ScheduledJob>& job)
+  {
+    if (job == nullptr) return false;
+
+    bool hasPendingRequest{false};
+    {
+      lock_guard<mutex> lkJob{job->jobMutex};
+      if ((job->scheduler != nullptr) || (job->curState == ScheduledJob::State::Finished)) return false;
+
+      lock_guard<mutex> lk{schedMutex};
+      if (isShuttingDown) return false;
+
+      jobs.emplace(job.get(), job);
+      job->scheduler = this;
+      hasPendingRequest = job->isTransitionPending;
+    }
+
+    // if `run()` has been called before `addJob()`,
+    // we have to process the request now
+    if (hasPendingRequest) requestExecution(job.get());
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t CyclicJobScheduler::jobCount()
+  {
+    lock_guard<mutex> lk{schedMutex};
+    return jobs.size();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicJobScheduler::terminateAllAndJoin()
+  {
+    vector<shared_ptr<ScheduledJob>> allJobs;
+    {
+      lock_guard<mutex> lk{schedMutex};
+      if (poolThreads.empty()) return;
+
+      isShuttingDown = true;
+      for (const auto& [ptr, job] : jobs) allJobs.push_back(job);
+    }
+
+    // request termination; the onTerminate()-hooks
+    // are executed by the pool threads
+    for (auto& job : allJobs) job->terminate();
+
+    {
+      lock_guard<mutex> lk{schedMutex};
+      cv.notify_all();
+    }
+
+    for (auto& t : poolThreads) t.join();
+    poolThreads.clear();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicJobScheduler::poolLoop()
+  {
+    unique_lock<mutex> lk{schedMutex};
+
+    while (!(isShuttingDown && jobs.empty()))
+    {
+      advanceTo(nowTick());
+
+      if (readyQueue.empty())
+      {
+        // sleep until the next timer expires, until a
+        // cascade is necessary or until we receive a request
+        if (nWheelEntries == 0)
+        {
+          cv.wait(lk);
+        } else {
+          cv.wait_until(lk, startTime + tickDuration * nextWakeupTick());
+        }
+        continue;
+      }
+
+      TimerEntry e = std::move(readyQueue.front());
+      readyQueue.pop_front();
+
+      // skip outdated entries
+      ScheduledJob* job = e.job.get();
+      if ((e.generation != job->generation) || job->isExecuting) continue;
+
+      job->isExecuting = true;
+      job->isRescheduleRequested = false;
+      const uint64_t startTick = nowTick();
+
+      lk.unlock();
+      const auto result = job->execute(startTime + tickDuration * e.expiryTick);
+      lk.lock();
+
+      job->isExecuting = false;
+      ++job->generation;
+
+      if (result == ScheduledJob::ExecResult::Drop)
+      {
+        jobs.erase(job);
+        if (isShuttingDown && jobs.empty()) cv.notify_all();
+        continue;
+      }
+
+      // state change requests that arrived during the execution
+      // are processed immediately
+      if (job->isRescheduleRequested)
+      {
+        readyQueue.push_back(TimerEntry{std::move(e.job), job->generation, curTick});
+        continue;
+      }
+
+      if (result == ScheduledJob::ExecResult::Reschedule)
+      {
+        const auto tickCnt = tickDuration.count();
+        const uint64_t cycleTicks = max<int64_t>(1, (job->workerCycle_ms + tickCnt - 1) / tickCnt);
+        insert(TimerEntry{std::move(e.job), job->generation, startTick + cycleTicks});
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicJobScheduler::insert(TimerEntry&& e)
+  {
+    if (e.expiryTick <= curTick)
+    {
+      readyQueue.push_back(std::move(e));
+      cv.notify_one();
+      return;
+    }
+
+    // entries beyond the wheel's range are parked in the
+    // highest level and re-inserted during the cascade
+    static constexpr uint64_t MaxDelta = uint64_t{1} << (SlotBits * nLevels);
+    const uint64_t delta = e.expiryTick - curTick;
+    const uint64_t placementTick = (delta >= MaxDelta) ? (curTick + MaxDelta - 1) : e.expiryTick;
+    const uint64_t placementDelta = placementTick - curTick;
+
+    int level = 0;
+    while (placementDelta >= (uint64_t{1} << (SlotBits * (level + 1)))) ++level;
+
+    const size_t slotIdx = (placementTick >> (SlotBits * level)) & (SlotsPerLevel - 1);
+    wheel[level][slotIdx].push_back(std::move(e));
+    ++nWheelEntries;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicJobScheduler::advanceTo(uint64_t tick)
+  {
+    // shortcut for an empty wheel
+    if (nWheelEntries == 0)
+    {
+      if (tick > curTick) curTick = tick;
+      return;
+    }
+
+    while (curTick < tick)
+    {
+      // skip all ticks without due entries or cascades
+      const uint64_t next = nextEventTick();
+      if (next > tick)
+      {
+        curTick = tick;
+        return;
+      }
+      curTick = next;
+
+      // cascade entries from the higher levels down
+      // whenever a lower level wraps around
+      for (int level = 1; level < nLevels; ++level)
+      {
+        if ((curTick & ((uint64_t{1} << (SlotBits * level)) - 1)) != 0) break;
+        cascade(level);
+      }
+
+      Slot& s = wheel[0][curTick & (SlotsPerLevel - 1)];
+      if (s.empty()) continue;
+
+      Slot due;
+      due.swap(s);
+      nWheelEntries -= due.size();
+      for (TimerEntry& e : due) insert(std::move(e));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicJobScheduler::cascade(int level)
+  {
+    const size_t slotIdx = (curTick >> (SlotBits * level)) & (SlotsPerLevel - 1);
+    Slot& s = wheel[level][slotIdx];
+    if (s.empty()) return;
+
+    Slot tmp;
+    tmp.swap(s);
+    nWheelEntries -= tmp.size();
+    for (TimerEntry& e : tmp) insert(std::move(e));
+  }
+
+  //----------------------------------------------------------------------------
+
+  uint64_t CyclicJobScheduler::nextEventTick() const
+  {
+    uint64_t result = std::numeric_limits<uint64_t>::max();
+
+    // a slot of level `n` is processed at multiples of
+    // 2^(SlotBits * n) ticks and every slot is visited once
+    // per revolution of its level; so the earliest event
+    // is within the next revolution of each level
+    for (int level = 0; level < nLevels; ++level)
+    {
+      const int shift = SlotBits * level;
+      const uint64_t granule = curTick >> shift;
+      for (uint64_t k = 1; k <= SlotsPerLevel; ++k)
+      {
+        const uint64_t t = (granule + k) << shift;
+        if (t >= result) break;
+        if (!wheel[level][(granule + k) & (SlotsPerLevel - 1)].empty())
+        {
+          result = t;
+          break;
+        }
+      }
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  uint64_t CyclicJobScheduler::nextWakeupTick() const
+  {
+    if (!readyQueue.empty()) return curTick;
+
+    return nextEventTick();
+  }
+
+  //----------------------------------------------------------------------------
+
+  uint64_t CyclicJobScheduler::nowTick() const
+  {
+    return (chrono::steady_clock::now() - startTime) / tickDuration;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicJobScheduler::requestExecution(ScheduledJob* job)
+  {
+    lock_guard<mutex> lk{schedMutex};
+
+    auto it = jobs.find(job);
+    if (it == jobs.end()) return;
+
+    if (job->isExecuting)
+    {
+      job->isRescheduleRequested = true;
+      return;
+    }
+
+    // invalidate the job's current entry in the
+    // wheel and execute it as soon as possible
+    ++job->generation;
+    readyQueue.push_back(TimerEntry{it->second, job->generation, curTick});
+    cv.notify_one();
+  }
+
+}
@@ -0,0 +1,336 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_CYCLIC_JOB_SCHEDULER_H
+#define __LIBSLOPPY_CYCLIC_JOB_SCHEDULER_H
+
+#include <array>               // for array
+#include <atomic>              // for atomic
+#include <chrono>              // for steady_clock
+#include <condition_variable>  // for condition_variable
+#include <cstdint>             // for uint64_t
+#include <deque>               // for deque
+#include <memory>              // for shared_ptr
+#include <mutex>               // for mutex
+#include <unordered_map>       // for unordered_map
+#include <vector>              // for vector
+
+#include "CyclicWorkerThread.h"  // for CyclicWorkerThread::CyclicWorkerThreadState
+#include "ThreadConfig.h"        // for ThreadConfig, ConfiguredThread
+#include "ThreadStats.h"         // for CyclicThreadStats
+
+namespace Sloppy
+{
+  class CyclicJobScheduler;
+
+  /** \brief Base class for a cyclic or one-shot job that is executed
+   * by a `CyclicJobScheduler` instead of a dedicated thread.
+   *
+   * The job offers the same life cycle, the same hooks and the same
+   * controller interface as `CyclicWorkerThread`. The only differences are:
+   *   * the job has to be handed over to a scheduler via `CyclicJobScheduler::addJob()`
+   *     before any of the hooks or the worker is executed; and
+   *   * the hooks and the worker are executed by one of the scheduler's pool
+   *     threads. Thus, they should not block for too long because they'd delay
+   *     other jobs on the same pool thread.
+   *
+   * A job is never executed by more than one pool thread at a time.
+   *
+   * One-shot jobs execute the worker exactly once and terminate afterwards. The
+   * worker is executed `minWorkerCycle_ms` after `run()` (rounded up to the scheduler's
+   * tick duration) whereas `onFirstRun()` is executed immediately.
+   */
+  class ScheduledJob
+  {
+  public:
+    using State = CyclicWorkerThread::CyclicWorkerThreadState;
+
+    /** \brief Ctor that sets up the cyclic behaviour of the job
+     */
+    explicit ScheduledJob(
+        int minWorkerCycle_ms,   ///< minimum time in millisecs between two calls of the worker function; for one-shot jobs: delay between `run()` and the execution of the worker
+        bool isOneShot = false   ///< if `true`, the worker is only executed once and the job terminates afterwards
+        );
+
+    virtual ~ScheduledJob() = default;
+
+    ScheduledJob(const ScheduledJob&) = delete;
+    ScheduledJob& operator=(const ScheduledJob&) = delete;
+
+    /** \returns the current state of the job
+     *
+     * \note This function is for execution in the CONTROLLER THREAD CONTEXT only!
+     */
+    State state();
+
+    /** \brief (Re-)enables the cyclic execution of the worker; same
+     * semantics as `CyclicWorkerThread::run()`.
+     *
+     * \note This function is for execution in the CONTROLLER THREAD CONTEXT only!
+     *
+     * \returns `true` if the state change request was valid, `false` otherwise
+     */
+    bool run();
+
+    /** \brief Suspends the cyclic execution of the worker; same
+     * semantics as `CyclicWorkerThread::pause()`.
+     *
+     * \note This function is for execution in the CONTROLLER THREAD CONTEXT only!
+     *
+     * \returns `true` if the state change request was valid or the job is already paused, `false` otherwise
+     */
+    bool pause();
+
+    /** \brief Resumes the cyclic execution of the worker; same
+     * semantics as `CyclicWorkerThread::resume()`.
+     *
+     * \note This function is for execution in the CONTROLLER THREAD CONTEXT only!
+     *
+     * \returns `true` if the state change request was valid or if the job is already `Running`, `false` otherwise
+     */
+    bool resume();
+
+    /** \brief Ultimately stops the execution of the worker; same
+     * semantics as `CyclicWorkerThread::terminate()`.
+     *
+     * Once the job has reached `Finished` state, the scheduler releases
+     * its reference to the job.
+     *
+     * If the job has not been added to a scheduler, the transition
+     * (including `onTerminate()`) is completed in the calling thread
+     * before this function returns.
+     *
+     * \note This function is for execution in the CONTROLLER THREAD CONTEXT only!
+     */
+    void terminate();
+
+    /** \brief Blocks until pending state transitions are completed
+     *
+     * \note This function is for execution in the CONTROLLER THREAD CONTEXT only!
+     */
+    void waitForStateChange();
+
+    /** \returns Some basic stats about the worker
+     */
+    CyclicThreadStats workerStats();
+
+    /** \returns `true` if this is a one-shot job
+     */
+    bool isOneShot() const { return oneShot; }
+
+  protected:
+    /** \brief Overloadable hook that is called before the first execution of the worker
+     *
+     * \note This function is for execution in the WORKER THREAD CONTEXT only!
+     */
+    virtual void onFirstRun() {}
+
+    /** \brief Overloadable hook that is called before we enter the "Suspended" state
+     *
+     * \note This function is for execution in the WORKER THREAD CONTEXT only!
+     */
+    virtual void onSuspend() {}
+
+    /** \brief Overloadable hook that is called before we resume the worker
+     *
+     * \note This function is for execution in the WORKER THREAD CONTEXT only!
+     */
+    virtual void onResume() {}
+
+    /** \brief Overloadable hook that is called
+     * after the worker has been executed for the last time
+     *
+     * \note This function is for execution in the WORKER THREAD CONTEXT only!
+     */
+    virtual void onTerminate() {}
+
+    /** \brief The actual worker that has to be implemented by a derived class
+     *
+     * \note This function is for execution in the WORKER THREAD CONTEXT only!
+     */
+    virtual void worker() {}
+
+  private:
+    friend class CyclicJobScheduler;
+
+    // the result of a single execution slot
+    enum class ExecResult
+    {
+      Reschedule,   // the job is running and wants to be called again after one cycle
+      Park,   // the job is initialized or suspended and waits for a state change request
+      Drop   // the job is finished and can be released by the scheduler
+    };
+
+    // processes pending state transitions and executes the worker
+    // if the job is in state "Running"; the delay between dueTime
+    // and the start of the worker is recorded as jitter in the stats
+    //
+    // NOTE: This function is for execution in the WORKER THREAD CONTEXT only!
+    ExecResult execute(const std::chrono::steady_clock::time_point& dueTime);
+
+    // processes state transitions and calls hooks;
+    // lk is locked when calling and is locked again after returning
+    //
+    // NOTE: This function is for execution in the WORKER THREAD CONTEXT only!
+    void doStateMachine(std::unique_lock<std::mutex>& lk);
+
+    // informs the scheduler (if any) that we have a pending state transition
+    void notifyScheduler();
+
+    std::mutex jobMutex;
+    State curState{State::Initialized};
+    State reqState{State::Initialized};
+    const int workerCycle_ms;
+    const bool oneShot;
+    std::atomic<bool> isTransitionPending{false};
+    CyclicThreadStats stats;
+
+    CyclicJobScheduler* scheduler{nullptr};   // protected by jobMutex
+
+    // the following members are owned by the scheduler
+    // and protected by the scheduler's mutex
+    uint64_t generation{0};   // invalidates outdated entries in the timer wheel
+    bool isExecuting{false};
+    bool isRescheduleRequested{false};
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A scheduler that executes many `ScheduledJob`s on a small pool of
+   * shared threads.
+   *
+   * Due times are managed in a hierarchical timer wheel with four levels of
+   * 64 slots each. Inserting and removing a timer is O(1); the pool threads only
+   * wake up if a level-0 slot contains due timers or if a higher-level slot
+   * has to be cascaded into the lower levels. Thus, hundreds of mostly idle
+   * housekeeping jobs cost virtually nothing.
+   *
+   * The wheel covers 64^4 ticks; due times beyond that are parked in the last
+   * slot of the highest level and re-inserted when that slot is cascaded.
+   *
+   * The timing resolution of the jobs is limited by the tick duration.
+   */
+  class CyclicJobScheduler
+  {
+  public:
+    static constexpr int SlotBits = 6;
+    static constexpr int SlotsPerLevel = 1 << SlotBits;
+    static constexpr int nLevels = 4;
+
+    /** \brief Ctor; creates and starts the pool threads
+     *
+     * \throws std::invalid_argument if the number of threads or the tick duration
+     * is less than one or if the thread config is invalid
+     */
+    explicit CyclicJobScheduler(
+        int nThreads = 1,   ///< number of pool threads that execute the jobs
+        int tickDuration_ms = 1,   ///< resolution of the timer wheel
+        const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the pool threads
+        );
+
+    /** \brief Dtor; calls `terminateAllAndJoin()`
+     */
+    ~CyclicJobScheduler();
+
+    CyclicJobScheduler(const CyclicJobScheduler&) = delete;
+    CyclicJobScheduler& operator=(const CyclicJobScheduler&) = delete;
+
+    /** \brief Hands a job over to the scheduler.
+     *
+     * If `run()` has already been called on the job, `onFirstRun()` and the
+     * worker are executed as soon as possible. Otherwise the job remains
+     * in state `Initialized` until `run()` is called.
+     *
+     * \returns `true` if the job has been accepted, `false` if the job is empty, already
+     * assigned to a scheduler, already finished or if the scheduler is shutting down.
+     */
+    bool addJob(
+        const std::shared_ptr<ScheduledJob>& job   ///< the job that shall be executed by this scheduler
+        );
+
+    /** \returns the number of jobs that have not yet reached `Finished` state
+     */
+    size_t jobCount();
+
+    /** \brief Terminates all jobs, waits for their `onTerminate()` hooks
+     * to complete and joins all pool threads.
+     *
+     * No new jobs are accepted afterwards.
+     */
+    void terminateAllAndJoin();
+
+  private:
+    friend class ScheduledJob;
+
+    // an entry in the timer wheel
+    struct TimerEntry
+    {
+      std::shared_ptr<ScheduledJob> job;
+      uint64_t generation;
+      uint64_t expiryTick;
+    };
+
+    using Slot = std::vector<TimerEntry>;
+
+    // the main loop of each pool thread
+    void poolLoop();
+
+    // places an entry in the wheel or the ready-queue;
+    // schedMutex must be locked by the caller
+    void insert(TimerEntry&& e);
+
+    // advances the wheel up to the provided tick and moves all
+    // due entries to the ready-queue; schedMutex must be locked by the caller
+    void advanceTo(uint64_t tick);
+
+    // moves all entries of a higher-level slot down
+    void cascade(int level);
+
+    // returns the next tick at which a level-0 slot becomes due
+    // or a non-empty higher-level slot has to be cascaded;
+    // schedMutex must be locked by the caller
+    uint64_t nextEventTick() const;
+
+    // returns the next tick at which the wheel has to be
+    // processed; schedMutex must be locked by the caller
+    uint64_t nextWakeupTick() const;
+
+    // the current tick number relative to the scheduler's start time
+    uint64_t nowTick() const;
+
+    // called by a job when a state transition is pending
+    void requestExecution(ScheduledJob* job);
+
+    const std::chrono::steady_clock::time_point startTime;
+    const std::chrono::milliseconds tickDuration;
+
+    std::mutex schedMutex;
+    std::condition_variable cv;
+
+    std::array<std::array<Slot, SlotsPerLevel>, nLevels> wheel;
+    size_t nWheelEntries{0};
+    uint64_t curTick{0};
+    std::deque<TimerEntry> readyQueue;
+    std::unordered_map<ScheduledJob*, std::shared_ptr<ScheduledJob>> jobs;
+    bool isShuttingDown{false};
+
+    std::vector<ConfiguredThread> poolThreads;
+  };
+}
+
+#endif
@@ -18,9 +18,7 @@
 
 #include <chrono>     // for milliseconds, steady_clock
 #include <iosfwd>     // for std
-#include <stdexcept>  // for runtime_error
-
-#include "Timer.h"    // for Timer
+#include <stdexcept>  // for runtime_error, invalid_argument
 
 #include "CyclicWorkerThread.h"
 
@@ -29,11 +27,27 @@ using namespace std;
 namespace Sloppy
 {
 
-  CyclicWorkerThread::CyclicWorkerThread(int minWorkerCycle_ms)
-    :workerCycle_ms{minWorkerCycle_ms}
+  CyclicWorkerThread::CyclicWorkerThread(int minWorkerCycle_ms, const ThreadConfig& thCfg)
+    :workerCycle{chrono::milliseconds{minWorkerCycle_ms}}, overrunPolicy{OverrunPolicy::Relative}
   {
-    stats.workerCycleTime_ms = workerCycle_ms;
-    workerThread = thread([&]{mainLoop();});
+    stats.workerCycleTime_ms = minWorkerCycle_ms;
+    stats.workerCycleTime_us = workerCycle.count();
+    workerThread = ConfiguredThread{thCfg, [this]{mainLoop();}};
+  }
+
+  //----------------------------------------------------------------------------
+
+  CyclicWorkerThread::CyclicWorkerThread(chrono::microseconds cycleTime, OverrunPolicy policy, const ThreadConfig& thCfg)
+    :workerCycle{cycleTime}, overrunPolicy{policy}
+  {
+    if (workerCycle.count() <= 0)
+    {
+      throw std::invalid_argument("CyclicWorkerThread: the cycle time must be positive");
+    }
+
+    stats.workerCycleTime_ms = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(workerCycle).count());
+    stats.workerCycleTime_us = workerCycle.count();
+    workerThread = ConfiguredThread{thCfg, [this]{mainLoop();}};
   }
 
   //----------------------------------------------------------------------------
@@ -42,7 +56,11 @@ namespace Sloppy
   {
     if (workerThread.joinable())
     {
-      forceQuitThreadFromDtor = true;
+      {
+        lock_guard<InternalMutex> lk{stateMutex};
+        forceQuitThreadFromDtor = true;
+        cvState.notify_one();
+      }
       workerThread.join();
     }
   }
@@ -53,7 +71,7 @@ namespace Sloppy
   {
     if (isTransitionPending) return false;
 
-    lock_guard<mutex> lk{stateMutex};
+    lock_guard<InternalMutex> lk{stateMutex};
 
     // is there anything to do at all?
     if (curState == CyclicWorkerThreadState::Running)
@@ -79,7 +97,7 @@ namespace Sloppy
   {
     if (isTransitionPending) return false;
 
-    lock_guard<mutex> lk{stateMutex};
+    lock_guard<InternalMutex> lk{stateMutex};
 
     // is there anything to do at all?
     if (curState == CyclicWorkerThreadState::Suspended)
@@ -105,7 +123,7 @@ namespace Sloppy
   {
     if (isTransitionPending) return false;
 
-    lock_guard<mutex> lk{stateMutex};
+    lock_guard<InternalMutex> lk{stateMutex};
 
     // is there anything to do at all?
     if (curState == CyclicWorkerThreadState::Running)
@@ -129,7 +147,7 @@ namespace Sloppy
 
   void CyclicWorkerThread::terminate()
   {
-    lock_guard<mutex> lk{stateMutex};
+    lock_guard<InternalMutex> lk{stateMutex};
 
     // is there anything to do at all?
     if (curState == CyclicWorkerThreadState::Finished)
@@ -167,12 +185,29 @@ namespace Sloppy
 
   CyclicThreadStats CyclicWorkerThread::workerStats()
   {
-    lock_guard<mutex> lk{stateMutex};
+    lock_guard<InternalMutex> lk{stateMutex};
     return stats;
   }
 
   //----------------------------------------------------------------------------
 
+  void CyclicWorkerThread::registerMetrics(const string& instanceName, MetricsRegistry& reg)
+  {
+    metricHandles.clear();
+
+    const MetricLabels lbl{{"worker", instanceName}};
+    metricHandles.push_back(reg.addHistogram("sloppy_cyclic_worker_runtime_seconds", "Execution time of the worker function", lbl,
+                                             [this]() { lock_guard<InternalMutex> lk{stateMutex}; return stats.runtimeHistogram; }));
+    metricHandles.push_back(reg.addHistogram("sloppy_cyclic_worker_jitter_seconds", "Delay between deadline and actual start of the worker function", lbl,
+                                             [this]() { lock_guard<InternalMutex> lk{stateMutex}; return stats.jitterHistogram; }));
+    metricHandles.push_back(reg.addCounter("sloppy_cyclic_worker_overruns_total", "Number of worker calls that exceeded the cycle time", lbl,
+                                           [this]() { lock_guard<InternalMutex> lk{stateMutex}; return uint64_t{stats.nOverruns}; }));
+    metricHandles.push_back(reg.addCounter("sloppy_cyclic_worker_skipped_cycles_total", "Number of cycles that have been skipped due to overruns", lbl,
+                                           [this]() { lock_guard<InternalMutex> lk{stateMutex}; return uint64_t{stats.nSkippedCycles}; }));
+  }
+
+  //----------------------------------------------------------------------------
+
   void CyclicWorkerThread::mainLoop()
   {
     // short-cut
@@ -180,55 +215,83 @@ namespace Sloppy
 
     // initially lock the mutex because that's a pre-condition
     // when starting the while loop
-    unique_lock<mutex> lk{stateMutex};  // implicitly calls `lock()`
+    unique_lock<InternalMutex> lk{stateMutex};  // implicitly calls `lock()`
 
-    Sloppy::Timer t;
-    bool isNewWorkerCycle{true};
+    Clock::time_point nextDeadline = Clock::now();
 
     while (!forceQuitThreadFromDtor && (curState != CyclicWorkerThreadState::Finished))
     {
-      if (isNewWorkerCycle) t.restart();
+      // process pending state machine events
+      // at least once in every cycle
+      const bool wasRunning = (curState == CyclicWorkerThreadState::Running);
+      doStateMachine(lk);
+      if (forceQuitThreadFromDtor || (curState == CyclicWorkerThreadState::Finished)) return;
 
-      if ((reqState == CyclicWorkerThreadState::Running) && isNewWorkerCycle)
+      // wait for the next state machine event
+      // if the worker is inactive
+      if ((curState != CyclicWorkerThreadState::Running) || (reqState != CyclicWorkerThreadState::Running))
       {
-        // release the lock while we're executing the worker
-        lk.unlock();
-
-        // execute the worker and measure its runtime
-        worker();
-        int workerTime = t.getTime__ms();
-
-        // re-lock after the worker
-        lk.lock();
-
-        // now that we own the lock, we can update
-        // the internal stats
-        stats.update(workerTime);
+        if (reqState == curState)
+        {
+          cvState.wait(lk, [this]{ return forceQuitThreadFromDtor || (reqState != curState); });
+        }
+        continue;
+      }
 
-        // check after every (potentially long) operation
-        if (forceQuitThreadFromDtor || (curState == CyclicWorkerThreadState::Finished)) return;
+      // call the worker immediately after `onFirstRun()` or `onResume()`
+      if (!wasRunning) nextDeadline = Clock::now();
 
-        // at this point, lk is always locked
+      // wait for the next deadline or for any state
+      // machine event triggered by the controlling thread
+      Clock::time_point now = Clock::now();
+      if (now < nextDeadline)
+      {
+        cvState.wait_until(lk, nextDeadline);
+        continue;
       }
 
-      // at this point, lk is always locked
+      // release the lock while we're executing the worker
+      lk.unlock();
 
-      // process pending state machine events
-      // at least once in every cycle, regardless
-      // of how much time is left after executing the worker
-      doStateMachine(lk);
+      // execute the worker and measure its runtime
+      const Clock::time_point startTime = Clock::now();
+      worker();
+      const Clock::time_point endTime = Clock::now();
+
+      // re-lock after the worker
+      lk.lock();
 
-      cv_status eventStatus{cv_status::timeout};
-      int remainTime = workerCycle_ms - t.getTime__ms();
-      if (remainTime > 0)
+      // determine the next deadline
+      const Clock::time_point prevDeadline = nextDeadline;
+      switch (overrunPolicy)
       {
-        // wait for any state machine event triggered
-        // by the controlling thread
-        eventStatus = cvState.wait_for(lk, chrono::milliseconds(remainTime));
-        if (eventStatus != cv_status::timeout) doStateMachine(lk);
+      case OverrunPolicy::Relative:
+        nextDeadline = startTime + workerCycle;
+        if (endTime > nextDeadline) ++stats.nOverruns;
+        break;
+
+      case OverrunPolicy::CatchUp:
+        nextDeadline += workerCycle;
+        if (endTime > nextDeadline) ++stats.nOverruns;
+        break;
+
+      case OverrunPolicy::SkipMissed:
+        nextDeadline += workerCycle;
+        if (endTime > nextDeadline)
+        {
+          ++stats.nOverruns;
+          const auto nMissed = (endTime - nextDeadline) / workerCycle + 1;
+          nextDeadline += nMissed * workerCycle;
+          stats.nSkippedCycles += nMissed;
+        }
       }
 
-      isNewWorkerCycle = ((remainTime < 0) || (eventStatus == cv_status::timeout));
+      // now that we own the lock, we can update
+      // the internal stats
+      stats.update__ns(
+            chrono::duration_cast<chrono::nanoseconds>(endTime - startTime).count(),
+            chrono::duration_cast<chrono::nanoseconds>(startTime - prevDeadline).count()
+            );
 
       // lk is ALWAYS locked at this point
     }
@@ -236,7 +299,7 @@ namespace Sloppy
 
   //----------------------------------------------------------------------------
 
-  void CyclicWorkerThread::doStateMachine(unique_lock<mutex>& lk)
+  void CyclicWorkerThread::doStateMachine(unique_lock<InternalMutex>& lk)
   {
     // PRECONDITION:
     // lk is locked by the caller! In our case this is guaranteed
@@ -20,10 +20,16 @@
 #define __LIBSLOPPY_CYCLIC_WORKER_THREAD_H
 
 #include <atomic>              // for atomic
+#include <chrono>              // for microseconds, steady_clock
 #include <condition_variable>  // for condition_variable
 #include <mutex>               // for mutex, lock_guard, unique_lock
+#include <string>              // for string
 #include <thread>              // for thread
 
+#include "Metrics.h"           // for MetricsRegistry, MetricHandleList
+#include "ProfiledMutex.h"     // for InternalMutex, InternalCondVar
+
+#include "ThreadConfig.h"      // for ThreadConfig, ConfiguredThread
 #include "ThreadStats.h"       // for CyclicThreadStats
 
 namespace Sloppy
@@ -61,11 +67,40 @@ namespace Sloppy
       Finished   ///< terminal state and dead end; no exit from here
     };
 
+    /** \brief Defines how the next worker call is scheduled, in particular if
+     * a worker call took longer than one cycle
+     */
+    enum class OverrunPolicy
+    {
+      Relative,   ///< the next call is due one cycle after the actual start of the previous call (legacy behaviour; delays accumulate)
+      CatchUp,   ///< calls are due on a fixed grid of absolute deadlines; missed deadlines are executed back-to-back until we're in sync again
+      SkipMissed   ///< calls are due on a fixed grid of absolute deadlines; missed deadlines are skipped and we continue with the next deadline in the future
+    };
+
     /** \brief Ctor that sets up the cyclic behaviour of the thread
+     *
+     * \throws std::invalid_argument if the provided thread config is invalid
      */
     CyclicWorkerThread(
-        int minWorkerCycle_ms ///< minimum time in millisecs between two calls of the worker function
+        int minWorkerCycle_ms, ///< minimum time in millisecs between two calls of the worker function
         //int minIdleCycle_ms = -1 ///< minimum time in millisecs between checks for a status change if the worker is not currently running (-1 = use the worker cycle)
+        const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker thread
+        );
+
+    /** \brief Ctor for cycle times with microsecond resolution.
+     *
+     * Worker calls are scheduled against absolute deadlines on the
+     * steady clock and thus don't drift (unless `OverrunPolicy::Relative` is used).
+     * The deviation between the deadline and the actual start of each
+     * worker call is recorded in the worker stats.
+     *
+     * \throws std::invalid_argument if the cycle time is not positive
+     * or if the provided thread config is invalid
+     */
+    CyclicWorkerThread(
+        std::chrono::microseconds workerCycle,   ///< time between two (scheduled) calls of the worker function
+        OverrunPolicy policy = OverrunPolicy::SkipMissed,   ///< what to do if a worker call took longer than one cycle
+        const ThreadConfig& thCfg = ThreadConfig{}   ///< optional placement / scheduling parameters for the worker thread
         );
 
     /** \brief Dtor, calls `join()` on the underlying thread for proper clean-up*/
@@ -77,7 +112,7 @@ namespace Sloppy
      */
     CyclicWorkerThreadState state()
     {
-      std::lock_guard<std::mutex> lk{stateMutex};
+      std::lock_guard<InternalMutex> lk{stateMutex};
 
       CyclicWorkerThreadState tmp = curState;
       return tmp;
@@ -180,6 +215,17 @@ namespace Sloppy
      */
     CyclicThreadStats workerStats();
 
+    /** \brief Publishes the worker stats (runtime and jitter histograms,
+     * overruns, skipped cycles) in a metrics registry.
+     *
+     * Any previous registration is removed. The registration is
+     * removed automatically when the thread object is destroyed.
+     */
+    void registerMetrics(
+        const std::string& instanceName,   ///< the value of the `worker` label
+        MetricsRegistry& reg = MetricsRegistry::global()   ///< the registry to publish the metrics in
+        );
+
   protected:
 
     /** \brief Overloadable hook that is called before the first execution of the worker
@@ -226,20 +272,22 @@ namespace Sloppy
     //
     // Returns `true` if the worker should be forcefully executing afterwards,
     // regardless of any timer values
-    void doStateMachine(std::unique_lock<std::mutex>& lk);
+    void doStateMachine(std::unique_lock<InternalMutex>& lk);
 
-    std::mutex stateMutex;
-    std::condition_variable cvState;
+    InternalMutex stateMutex{SLOPPY_LOCK_NAME("CyclicWorkerThread::stateMutex")};
+    InternalCondVar cvState;
 
     CyclicWorkerThreadState curState{CyclicWorkerThreadState::Initialized};   ///< our current state
     CyclicWorkerThreadState reqState{CyclicWorkerThreadState::Initialized};   ///< the next state requested by the owner
-    std::thread workerThread;
-    int workerCycle_ms;
+    ConfiguredThread workerThread;
+    const std::chrono::microseconds workerCycle;
+    const OverrunPolicy overrunPolicy;
 
     std::atomic<bool> isTransitionPending{false};  ///< not strictly necessary, but makes sync easier
     bool forceQuitThreadFromDtor{false}; // may only be set by the dtor!
 
     CyclicThreadStats stats;
+    MetricHandleList metricHandles;
   };
 }
 
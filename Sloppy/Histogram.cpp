@@ -0,0 +1,207 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for min, max
+#include <cmath>      // for ceil
+#include <stdexcept>  // for invalid_argument
+
+#include "Histogram.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  void LatencyHistogram::record(int64_t value_ns, uint64_t n)
+  {
+    if (n == 0) return;
+    if (value_ns < 0) value_ns = 0;
+
+    buckets[bucketIndex(value_ns)] += n;
+
+    if ((totalCount == 0) || (value_ns < minValue)) minValue = value_ns;
+    if (value_ns > maxValue) maxValue = value_ns;
+    totalCount += n;
+    sum += static_cast<double>(value_ns) * n;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void LatencyHistogram::merge(const LatencyHistogram& other)
+  {
+    if (other.totalCount == 0) return;
+
+    for (size_t idx = 0; idx < BucketCount; ++idx) buckets[idx] += other.buckets[idx];
+
+    if ((totalCount == 0) || (other.minValue < minValue)) minValue = other.minValue;
+    if (other.maxValue > maxValue) maxValue = other.maxValue;
+    totalCount += other.totalCount;
+    sum += other.sum;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void LatencyHistogram::reset()
+  {
+    buckets.fill(0);
+    totalCount = 0;
+    minValue = 0;
+    maxValue = 0;
+    sum = 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  double LatencyHistogram::mean() const
+  {
+    return (totalCount == 0) ? 0 : (sum / totalCount);
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t LatencyHistogram::percentile(double p) const
+  {
+    if (totalCount == 0) return 0;
+
+    p = std::clamp(p, 0.0, 100.0);
+    uint64_t rank = static_cast<uint64_t>(ceil(p / 100.0 * totalCount));
+    if (rank == 0) rank = 1;
+
+    uint64_t cnt{0};
+    for (size_t idx = 0; idx < BucketCount; ++idx)
+    {
+      cnt += buckets[idx];
+      if (cnt >= rank)
+      {
+        return std::clamp(bucketUpperBound(idx), minValue, maxValue);
+      }
+    }
+
+    return maxValue;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t LatencyHistogram::bucketIndex(int64_t value_ns)
+  {
+    if (value_ns < SubBucketCount) return (value_ns < 0) ? 0 : static_cast<size_t>(value_ns);
+
+    const uint64_t v = static_cast<uint64_t>(value_ns);
+    const int msb = 63 - __builtin_clzll(v);
+    if (msb >= MaxValueBits) return BucketCount - 1;
+
+    const int shift = msb - SubBucketBits;
+    const size_t group = shift + 1;
+    const size_t sub = (v >> shift) - SubBucketCount;
+
+    return group * SubBucketCount + sub;
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t LatencyHistogram::bucketLowerBound(size_t idx)
+  {
+    const size_t group = idx / SubBucketCount;
+    const int64_t sub = idx % SubBucketCount;
+    if (group == 0) return sub;
+
+    return (SubBucketCount + sub) << (group - 1);
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t LatencyHistogram::bucketUpperBound(size_t idx)
+  {
+    const size_t group = idx / SubBucketCount;
+    if (group == 0) return bucketLowerBound(idx);
+
+    return bucketLowerBound(idx) + (int64_t{1} << (group - 1)) - 1;
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  WindowedLatencyHistogram::WindowedLatencyHistogram(int nSlices, chrono::nanoseconds sliceDur)
+    :sliceDuration{sliceDur}, startTime{Clock::now()}
+  {
+    if ((nSlices < 1) || (sliceDur.count() <= 0))
+    {
+      throw std::invalid_argument("WindowedLatencyHistogram: invalid number of slices or invalid slice duration");
+    }
+
+    slices.resize(nSlices);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void WindowedLatencyHistogram::record(int64_t value_ns, Clock::time_point now, uint64_t n)
+  {
+    const int64_t nSlices = static_cast<int64_t>(slices.size());
+    const int64_t sliceNumber = (now - startTime) / sliceDuration;
+    if (now < startTime) return;
+
+    advance(now);
+
+    // values that are older than the window are ignored
+    if (sliceNumber <= (curSliceNumber - nSlices)) return;
+
+    slices[sliceNumber % nSlices].record(value_ns, n);
+  }
+
+  //----------------------------------------------------------------------------
+
+  LatencyHistogram WindowedLatencyHistogram::snapshot(Clock::time_point now)
+  {
+    advance(now);
+
+    LatencyHistogram result;
+    for (const LatencyHistogram& h : slices) result.merge(h);
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void WindowedLatencyHistogram::reset()
+  {
+    for (LatencyHistogram& h : slices) h.reset();
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t WindowedLatencyHistogram::advance(Clock::time_point now)
+  {
+    const int64_t nSlices = static_cast<int64_t>(slices.size());
+    const int64_t sliceNumber = (now - startTime) / sliceDuration;
+
+    if (sliceNumber > curSliceNumber)
+    {
+      // drop all slices that have left the window
+      const int64_t nExpired = std::min(sliceNumber - curSliceNumber, nSlices);
+      for (int64_t i = 1; i <= nExpired; ++i)
+      {
+        slices[(curSliceNumber + i) % nSlices].reset();
+      }
+      curSliceNumber = sliceNumber;
+    }
+
+    return curSliceNumber % nSlices;
+  }
+
+}
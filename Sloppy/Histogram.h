@@ -0,0 +1,180 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_HISTOGRAM_H
+#define __LIBSLOPPY_HISTOGRAM_H
+
+#include <array>    // for array
+#include <chrono>   // for steady_clock, nanoseconds
+#include <cstdint>  // for int64_t, uint64_t
+#include <vector>   // for vector
+
+namespace Sloppy
+{
+  class ConcurrentHistogram;
+
+  /** \brief A log-bucketed histogram for latencies in nanoseconds, similar to
+   * an HDR histogram with a fixed precision.
+   *
+   * Each power-of-two range of values is split into `SubBucketCount` linear
+   * sub-buckets, so the relative error of a recorded value is at most
+   * 1 / `SubBucketCount` (6.25 %). Values between 0 and `SubBucketCount` are
+   * recorded exactly; values of 2^`MaxValueBits` ns (approx. 18 minutes) or more
+   * are recorded in the highest bucket.
+   *
+   * Recording is O(1) and never allocates; histograms of the same type can
+   * be merged by adding their bucket counts.
+   *
+   * \warning If an instance is accessed from different threads, proper
+   * locking (e.g., through a mutex) has to be guaranteed by the caller!
+   */
+  class LatencyHistogram
+  {
+  public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBucketCount = 1 << SubBucketBits;
+    static constexpr int MaxValueBits = 40;
+    static constexpr size_t BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+    /** \brief Records one or more occurrences of a value; negative values are recorded as zero
+     */
+    void record(
+        int64_t value_ns,   ///< the value to record
+        uint64_t n = 1   ///< the number of occurrences
+        );
+
+    /** \brief Adds all values of another histogram to this histogram
+     */
+    void merge(const LatencyHistogram& other);
+
+    /** \brief Removes all recorded values
+     */
+    void reset();
+
+    /** \returns the number of recorded values
+     */
+    uint64_t count() const { return totalCount; }
+
+    /** \returns the smallest recorded value (0 if the histogram is empty)
+     */
+    int64_t min() const { return (totalCount == 0) ? 0 : minValue; }
+
+    /** \returns the largest recorded value (0 if the histogram is empty)
+     */
+    int64_t max() const { return maxValue; }
+
+    /** \returns the average of all recorded values (0 if the histogram is empty)
+     */
+    double mean() const;
+
+    /** \returns the value below or at which the provided percentage of
+     * all recorded values lies (0 if the histogram is empty). The
+     * result is the upper bound of the matching bucket, limited to `max()`.
+     */
+    int64_t percentile(
+        double p   ///< the percentile, between 0 and 100 (e.g., 99.9)
+        ) const;
+
+    int64_t p50() const { return percentile(50); }
+    int64_t p99() const { return percentile(99); }
+    int64_t p999() const { return percentile(99.9); }
+
+    /** \returns the index of the bucket that covers the provided value
+     */
+    static size_t bucketIndex(int64_t value_ns);
+
+    /** \returns the smallest value that is covered by a bucket
+     */
+    static int64_t bucketLowerBound(size_t idx);
+
+    /** \returns the largest value that is covered by a bucket
+     */
+    static int64_t bucketUpperBound(size_t idx);
+
+    /** \returns the number of values in a bucket
+     */
+    uint64_t bucketCount(size_t idx) const { return buckets[idx]; }
+
+  private:
+    friend class ConcurrentHistogram;
+
+    std::array<uint64_t, BucketCount> buckets{};
+    uint64_t totalCount{0};
+    int64_t minValue{0};
+    int64_t maxValue{0};
+    double sum{0};
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A histogram that only covers the most recent values
+   * within a sliding time window.
+   *
+   * The window is split into a fixed number of slices, each backed by
+   * a `LatencyHistogram`. Values are recorded in the current slice; when
+   * a slice is older than the window, it's dropped and reused. Thus, old
+   * values decay in steps of one slice duration.
+   *
+   * \warning If an instance is accessed from different threads, proper
+   * locking (e.g., through a mutex) has to be guaranteed by the caller!
+   */
+  class WindowedLatencyHistogram
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** \brief Ctor
+     *
+     * \throws std::invalid_argument if the number of slices or the slice duration is not positive
+     */
+    WindowedLatencyHistogram(
+        int nSlices,   ///< number of slices in the window
+        std::chrono::nanoseconds sliceDuration   ///< time covered by each slice
+        );
+
+    /** \brief Records one or more occurrences of a value in the current slice
+     */
+    void record(
+        int64_t value_ns,   ///< the value to record
+        Clock::time_point now = Clock::now(),   ///< the point in time at which the value has been observed
+        uint64_t n = 1   ///< the number of occurrences
+        );
+
+    /** \returns a merged histogram of all values within the window
+     */
+    LatencyHistogram snapshot(
+        Clock::time_point now = Clock::now()   ///< the end of the window
+        );
+
+    /** \brief Removes all recorded values
+     */
+    void reset();
+
+  private:
+    // drops all slices that have left the window
+    // and returns the index of the slice for `now`
+    size_t advance(Clock::time_point now);
+
+    const std::chrono::nanoseconds sliceDuration;
+    const Clock::time_point startTime;
+    std::vector<LatencyHistogram> slices;
+    int64_t curSliceNumber{0};
+  };
+}
+
+#endif
@@ -16,11 +16,15 @@
  *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>                                            // for array
+#include <atomic>                                           // for atomic
 #include <iostream>                                         // for basic_ost...
+#include <string_view>                                      // for string_view
 
 #include "Logger.h"
+#include "../AllocTracker.h"                                  // for ScopedAllocTag
 #include "../DateTime/DateAndTime.h"                        // for WallClock...
-#include "../String.h"                                      // for estring
+#include "../String.h"                                      // for estring, FormatString
 #include "../DateTime/tz.h"  // for locate_zone
 
 using namespace std;
@@ -29,6 +33,20 @@ namespace Sloppy
 {
   namespace Logger
   {
+    namespace
+    {
+      // the number of printed messages per severity level; the
+      // index is the severity level's value divided by 10
+      std::array<std::atomic<uint64_t>, 5> msgCounters{};
+
+      std::atomic<uint64_t>& counterForLevel(SeverityLevel lvl)
+      {
+        return msgCounters[static_cast<int>(lvl) / 10];
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
     Logger::Logger()
     {
     }
@@ -46,46 +64,39 @@ namespace Sloppy
     void Logger::log(SeverityLevel lvl, const string& msg)
     {
       if (lvl < minLvl) return;
+      counterForLevel(lvl).fetch_add(1, memory_order_relaxed);
+      ScopedAllocTag allocTag{MemTag::Logger};
+
+      static const FormatString lineFormat{"%1%2%3: "};
 
-      estring outText{"%1%2%3: "};
+      string tsPrefix;
       if (useTimestamps)
       {
         DateTime::WallClockTimepoint_secs now{tzPtr};
-        if (tzPtr != nullptr)
-        {
-          outText.arg(now.timestampString() + " ");
-        } else {
-          outText.arg(now.timestampString() + "UTC ");
-        }
-      } else {
-        outText.arg("");
+        tsPrefix = now.timestampString() + ((tzPtr != nullptr) ? " " : "UTC ");
       }
 
-      if (sender.empty())
-      {
-        outText.arg("");
-      } else {
-        outText.arg(sender + " ");
-      }
+      const string senderPrefix = sender.empty() ? string{} : sender + " ";
 
+      string_view lvlName;
       switch (lvl) {
       case SeverityLevel::trace:
-        outText.arg("Info");
+        lvlName = "Info";
         break;
       case SeverityLevel::normal:
-        outText.arg("");
         break;
       case SeverityLevel::warning:
-        outText.arg("WARN");
+        lvlName = "WARN";
         break;
       case SeverityLevel::error:
-        outText.arg("ERROR");
+        lvlName = "ERROR";
         break;
       case SeverityLevel::critical:
-        outText.arg("CRITICAL");
+        lvlName = "CRITICAL";
         break;
       }
 
+      const estring outText = lineFormat.apply(tsPrefix, senderPrefix, lvlName);
       cerr << outText << msg << endl;
 
     }
@@ -99,6 +110,35 @@ namespace Sloppy
 
     //----------------------------------------------------------------------------
 
+    uint64_t Logger::messageCount(SeverityLevel lvl)
+    {
+      return counterForLevel(lvl).load(memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    MetricHandleList Logger::registerMetrics(MetricsRegistry& reg)
+    {
+      static const std::pair<SeverityLevel, const char*> levels[] = {
+        {SeverityLevel::trace, "trace"},
+        {SeverityLevel::normal, "normal"},
+        {SeverityLevel::warning, "warning"},
+        {SeverityLevel::error, "error"},
+        {SeverityLevel::critical, "critical"},
+      };
+
+      MetricHandleList result;
+      for (const auto& [lvl, lvlName] : levels)
+      {
+        result.push_back(reg.addCounter("sloppy_log_messages_total", "Number of printed log messages", {{"level", lvlName}},
+                                        [lvl = lvl]() { return messageCount(lvl); }));
+      }
+
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+
     bool Logger::setTimezone(const string& tzName)
     {
       try {
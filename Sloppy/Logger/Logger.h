@@ -18,8 +18,11 @@
 
 #pragma once
 
+#include <cstdint>  // for uint64_t
 #include <string>  // for string
 
+#include "../Metrics.h"  // for MetricsRegistry, MetricHandleList
+
 namespace date { class time_zone; }
 
 namespace Sloppy
@@ -146,6 +149,21 @@ namespace Sloppy
        */
       bool setTimezone(const std::string& tzName);
 
+      /** \returns the number of messages of a given severity level that have
+       * been printed by all `Logger` instances so far
+       */
+      static uint64_t messageCount(SeverityLevel lvl);
+
+      /** \brief Publishes the per-level message counters of all `Logger` instances
+       * in a metrics registry.
+       *
+       * \returns the handles for the registered metrics; the metrics
+       * are unregistered when the handles are destroyed
+       */
+      [[nodiscard]] static MetricHandleList registerMetrics(
+          MetricsRegistry& reg = MetricsRegistry::global()   ///< the registry to publish the metrics in
+          );
+
     protected:
       bool useTimestamps{true};
       std::string sender{};
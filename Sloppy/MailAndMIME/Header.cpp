@@ -19,6 +19,7 @@
 #include <algorithm>                                   // for find_if, any_of
 #include <cstddef>                                     // for size_t, std
 #include <functional>                                  // for function
+#include <string_view>                                 // for string_view
 
 #include "Header.h"
 #include "../String.h"  // for estring, Strin...
@@ -44,31 +45,9 @@ namespace Sloppy
         throw MalformedHeader();
       }
 
-      // split the headers up at CRLF positions
-      vector<estring> hdrLines = rawHeaderData.split(sCRLF, true, false);
-
-      // unfold header lines
-      auto it = hdrLines.begin();
-      while (it != hdrLines.end())
-      {
-        char startChar = (*it)[0];
-        if ((startChar == 0x20) || (startChar == 0x09))
-        {
-          // merge this line with the previous one
-          if (it == hdrLines.begin())
-          {
-            throw MalformedHeader();
-          }
-          auto prevLine = it - 1;
-          *prevLine = *prevLine + *it;
-          hdrLines.erase(it);
-        } else {
-          ++it;
-        }
-      }
-
-      // split header lines in field-name and field-body
-      for (const estring& f : hdrLines)
+      // a helper that splits a complete, unfolded header line
+      // in field-name and field-body
+      auto addField = [this](const estring& f)
       {
         size_t colonPos = f.find(':');
         if (colonPos == string::npos)
@@ -80,7 +59,32 @@ namespace Sloppy
         estring fieldBody = f.slice(colonPos + 1);
 
         fields.push_back(HeaderField{fieldName, fieldBody});
+      };
+
+      // iterate over the header lines (separated by CRLF) and
+      // unfold them on the fly by merging continuation lines
+      // into the current field
+      estring curField;
+      bool isFirstLine{true};
+      for (const string_view& line : rawHeaderData.splitRange(sCRLF, true, false))
+      {
+        const char startChar = line.empty() ? 0 : line[0];
+        if ((startChar == 0x20) || (startChar == 0x09))
+        {
+          // merge this line with the previous one
+          if (isFirstLine)
+          {
+            throw MalformedHeader();
+          }
+          curField.append(line);
+          continue;
+        }
+
+        if (!isFirstLine) addField(curField);
+        curField.assign(line);
+        isFirstLine = false;
       }
+      if (!isFirstLine) addField(curField);
     }
 
     //----------------------------------------------------------------------------
@@ -19,12 +19,13 @@
 #include <poll.h>        // for pollfd, poll, POLLERR, POLLHUP, POLLIN, POLL...
 #include <sys/select.h>  // for select, FD_SET, FD_ZERO, fd_set
 #include <sys/time.h>    // for timeval
-#include <unistd.h>      // for close, read, write
+#include <unistd.h>      // for close, read, write, fdatasync
 #include <iostream>      // for operator<<, basic_ostream, endl, basic_ostre...
 #include <iterator>      // for advance
 #include <stdexcept>     // for runtime_error, out_of_range
 
 #include "Timer.h"       // for Timer
+#include "Tracing.h"     // for SLOPPY_TRACE_SPAN
 
 #include "ManagedFileDescriptor.h"
 
@@ -46,7 +47,7 @@ namespace Sloppy
   ManagedFileDescriptor::~ManagedFileDescriptor()
   {
     // wait for the fd to become available
-    lock_guard<mutex> lockFd{fdMutex};
+    lock_guard<InternalMutex> lockFd{fdMutex};
 
     if ((st != State::Closed) && (fd >= 0))
     {
@@ -73,7 +74,7 @@ namespace Sloppy
   bool ManagedFileDescriptor::blockingWrite(const char* ptr, const size_t len)
   {
     // wait for the fd to become available
-    lock_guard<mutex> lockFd{fdMutex};
+    lock_guard<InternalMutex> lockFd{fdMutex};
 
     // just to be sure: check the state
     if (st != State::Idle)
@@ -91,6 +92,7 @@ namespace Sloppy
     {
       throw IOError{};
     }
+    nBytesWritten.fetch_add(n, memory_order_relaxed);
     if (static_cast<size_t>(n) != len)
     {
       cerr << "FD write: only " << n << " of " << len << " bytes written!" << endl;
@@ -104,6 +106,8 @@ namespace Sloppy
 
   MemArray ManagedFileDescriptor::blockingRead(size_t minLen, const size_t maxLen, const int timeout_ms)
   {
+    SLOPPY_TRACE_SPAN("ManagedFileDescriptor::blockingRead");
+
     if (minLen == 0) minLen = 1;   // zero means: no min length which is equivalent to "at least one byte"
     if ((maxLen > 0) && (minLen > maxLen))
     {
@@ -131,7 +135,7 @@ namespace Sloppy
     if (timeout_ms > 0) readTimer.setTimeoutDuration__ms(timeout_ms);
 
     // wait for the fd to become available
-    lock_guard<mutex> lockFd{fdMutex};
+    lock_guard<InternalMutex> lockFd{fdMutex};
 
     // just to be sure: check the state
     if (st != State::Idle)
@@ -189,10 +193,57 @@ namespace Sloppy
 
   //----------------------------------------------------------------------------
 
+  size_t ManagedFileDescriptor::readSome(char* dst, size_t maxLen, int timeout_ms)
+  {
+    if (maxLen == 0) return 0;
+
+    // wait for the fd to become available
+    lock_guard<InternalMutex> lockFd{fdMutex};
+
+    // just to be sure: check the state
+    if (st != State::Idle)
+    {
+      throw std::runtime_error("ManagedFileDescriptor: unexpected, inconsistent FD state!");
+    }
+
+    // a non-owning wrapper around the caller's buffer
+    MemArray buf{dst, maxLen};
+
+    st = State::Reading;
+    size_t n{0};
+    try
+    {
+      n = readSingleShot(buf, 0, timeout_ms);
+    }
+    catch (...)
+    {
+      st = State::Idle;
+      throw;
+    }
+    st = State::Idle;
+
+    return n;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ManagedFileDescriptor::sync()
+  {
+    // wait for the fd to become available
+    lock_guard<InternalMutex> lockFd{fdMutex};
+
+    if (fdatasync(fd) != 0)
+    {
+      throw IOError{};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
   void ManagedFileDescriptor::close()
   {
     // wait for the fd to become available
-    lock_guard<mutex> lockFd{fdMutex};
+    lock_guard<InternalMutex> lockFd{fdMutex};
 
     int rc = ::close(fd);
     fd = -1;
@@ -213,7 +264,7 @@ namespace Sloppy
   int ManagedFileDescriptor::releaseDescriptor()
   {
     // wait for the fd to become available
-    lock_guard<mutex> lockFd{fdMutex};
+    lock_guard<InternalMutex> lockFd{fdMutex};
 
     // just to be sure: check the state
     if (st != State::Idle) return -1;
@@ -247,7 +298,7 @@ namespace Sloppy
     Sloppy::Timer t;
 
     // wait for the fd to become available
-    lock_guard<mutex> lockFd{fdMutex};
+    lock_guard<InternalMutex> lockFd{fdMutex};
 
     // just to be sure: check the state
     if (st != State::Idle)
@@ -318,6 +369,7 @@ namespace Sloppy
     {
       throw IOError{};
     }
+    nBytesRead.fetch_add(n, memory_order_relaxed);
 
     return n;
   }
@@ -327,8 +379,8 @@ namespace Sloppy
   ManagedFileDescriptor::ManagedFileDescriptor(ManagedFileDescriptor&& other)
   {
     // secure exclusive access to the FDs
-    lock_guard<mutex> lockFd_other{other.fdMutex};
-    lock_guard<mutex> lockFd_Self{fdMutex};
+    lock_guard<InternalMutex> lockFd_other{other.fdMutex};
+    lock_guard<InternalMutex> lockFd_Self{fdMutex};
 
     // transfer ownership
     fd = other.fd;
@@ -336,6 +388,8 @@ namespace Sloppy
     State tmp = other.st;
     st = tmp;
     other.st = State::Closed;
+    nBytesRead = other.nBytesRead.load();
+    nBytesWritten = other.nBytesWritten.load();
   }
 
   //----------------------------------------------------------------------------
@@ -343,8 +397,8 @@ namespace Sloppy
   ManagedFileDescriptor& ManagedFileDescriptor::operator=(ManagedFileDescriptor&& other)
   {
     // secure exclusive access to the FDs
-    lock_guard<mutex> lockFd_other{other.fdMutex};
-    lock_guard<mutex> lockFd_Self{fdMutex};
+    lock_guard<InternalMutex> lockFd_other{other.fdMutex};
+    lock_guard<InternalMutex> lockFd_Self{fdMutex};
 
     // close our existing FD, if any
     if (fd >= 0)
@@ -360,12 +414,27 @@ namespace Sloppy
     State tmp = other.st;
     st = tmp;
     other.st = State::Closed;
+    nBytesRead = other.nBytesRead.load();
+    nBytesWritten = other.nBytesWritten.load();
 
     return *this;
   }
 
   //----------------------------------------------------------------------------
 
+  void ManagedFileDescriptor::registerMetrics(const string& instanceName, MetricsRegistry& reg)
+  {
+    metricHandles.clear();
+
+    const MetricLabels lbl{{"fd", instanceName}};
+    metricHandles.push_back(reg.addCounter("sloppy_fd_read_bytes_total", "Number of bytes read from the file descriptor", lbl,
+                                           [this]() noexcept { return totalBytesRead(); }));
+    metricHandles.push_back(reg.addCounter("sloppy_fd_written_bytes_total", "Number of bytes written to the file descriptor", lbl,
+                                           [this]() noexcept { return totalBytesWritten(); }));
+  }
+
+  //----------------------------------------------------------------------------
+
   bool waitForReadOnDescriptor(int fd, size_t timeout_ms)
   {
     fd_set readFd;
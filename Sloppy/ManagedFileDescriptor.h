@@ -21,12 +21,15 @@
 
 #include <errno.h>   // for errno
 #include <atomic>    // for atomic
+#include <cstdint>   // for uint64_t
 #include <cstring>   // for size_t, strerror
 #include <mutex>     // for mutex
 #include <optional>  // for optional
 #include <string>    // for string, allocator
 
 #include "Memory.h"  // for MemArray, MemView
+#include "Metrics.h" // for MetricsRegistry, MetricHandleList
+#include "ProfiledMutex.h" // for InternalMutex
 
 namespace Sloppy
 {
@@ -336,6 +339,39 @@ namespace Sloppy
      */
     MemArray blockingRead_FixedSize(size_t expectedLen, size_t timeout_ms = 0);
 
+    /** \brief Executes a single `read()` call on the descriptor and stores
+     * the received data in a caller-provided buffer.
+     *
+     * When used in a multi-thread environment, this call blocks until we
+     * can acquire the access mutex for the file descriptor.
+     *
+     * In contrast to `blockingRead()` the call returns as soon as any data
+     * is available and it doesn't require a heap allocated result buffer. This makes
+     * it suitable for consuming large inputs chunk by chunk.
+     *
+     * \throws IOError if an I/O error occurred during reading
+     *
+     * \returns the number of bytes that have actually been read. Zero indicates
+     * a timeout or, if the call waited infinitely, the end of the input (e.g.,
+     * end-of-file or a closed pipe).
+     */
+    size_t readSome(
+        char* dst,   ///< the buffer for storing the data
+        size_t maxLen,   ///< the maximum number of bytes to read (usually the size of `dst`)
+        int timeout_ms = -1   ///< the timeout (0 = return immediatly, even if no data is avail; < 0 = wait infinitely)
+        );
+
+    /** \brief Flushes all data that has been written to the descriptor
+     * to the underlying storage device by calling `fdatasync()`
+     *
+     * When used in a multi-thread environment, this call blocks until we
+     * can acquire the access mutex for the file descriptor.
+     *
+     * \throws IOError if the sync failed, e.g. because the descriptor
+     * doesn't support synchronization (pipes, sockets, ...)
+     */
+    void sync();
+
     /** \brief Closes the descriptor by calling `close()`
      *
      * \throws IOError if an I/O error occurred during closing
@@ -350,6 +386,25 @@ namespace Sloppy
      */
     int releaseDescriptor();
 
+    /** \returns the total number of bytes that have been read through this object
+     */
+    uint64_t totalBytesRead() const { return nBytesRead.load(std::memory_order_relaxed); }
+
+    /** \returns the total number of bytes that have been written through this object
+     */
+    uint64_t totalBytesWritten() const { return nBytesWritten.load(std::memory_order_relaxed); }
+
+    /** \brief Publishes the read / write byte counters in a metrics registry.
+     *
+     * Any previous registration is removed. The registration is removed
+     * automatically when the object is destroyed; it is not transferred
+     * by move operations.
+     */
+    void registerMetrics(
+        const std::string& instanceName,   ///< the value of the `fd` label
+        MetricsRegistry& reg = MetricsRegistry::global()   ///< the registry to publish the metrics in
+        );
+
     /** \returns `true` if the FD has pending input data that is available
      * for reading.
      *
@@ -414,9 +469,12 @@ namespace Sloppy
 
 
     int fd{-1};
-    std::mutex fdMutex{};
+    InternalMutex fdMutex{SLOPPY_LOCK_NAME("ManagedFileDescriptor::fdMutex")};
     std::atomic<State> st{State::Closed};
     size_t defaultReadBufSize{0};
+    std::atomic<uint64_t> nBytesRead{0};
+    std::atomic<uint64_t> nBytesWritten{0};
+    MetricHandleList metricHandles;
   };
 }
 
@@ -27,6 +27,8 @@
 #include <type_traits>  // for remove_reference<>::type
 #include <utility>      // for move
 
+#include "AllocTracker.h"  // for AllocTracker, MemTag, ScopedAllocTag
+
 namespace Sloppy
 {
   /** \brief A read-only class for arrays of any type
@@ -535,7 +537,7 @@ namespace Sloppy
 
       // actually allocate the memory.
       // Do not catch any exceptions, leave that to the caller
-      ptr = allocateMem(nElem);
+      ptr = allocateTagged(nElem);
 
       if (ptr == nullptr)
       {
@@ -544,6 +546,7 @@ namespace Sloppy
 
       cnt = nElem;
       owning = true;
+      trackAllocation();
     }
 
     /** \brief Ctor from the raw pointer of a previously allocated array of which we can, optionally, take ownership
@@ -580,7 +583,7 @@ namespace Sloppy
     {
       if ((ptr != nullptr) && owning)
       {
-        releaseMem(ptr);
+        releaseOwnedMem();
         ptr = nullptr;
         cnt = 0;
       }
@@ -614,7 +617,7 @@ namespace Sloppy
     ManagedArray& operator= (const ManagedArray& other)
     {
       // free currently owned resources
-      if (owning && (ptr != nullptr)) releaseMem(ptr);
+      if (owning && (ptr != nullptr)) releaseOwnedMem();
       cnt = 0;
       ptr = nullptr;
       owning = false;
@@ -627,7 +630,7 @@ namespace Sloppy
 
       // actually allocate the memory.
       // Do not catch any exceptions, leave that to the caller
-      ptr = allocateMem(other.cnt);
+      ptr = allocateTagged(other.cnt);
       if (ptr == nullptr)
       {
         throw std::runtime_error("ManagedArray: couldn't allocate memory for array!");
@@ -635,6 +638,7 @@ namespace Sloppy
 
       cnt = other.cnt;
       owning = true;
+      trackAllocation();
 
       // copy the contents over to our own buffer
       memcpy(to_voidPtr(), other.to_voidPtr(), byteSize());
@@ -650,6 +654,8 @@ namespace Sloppy
     {
       // take over the other's state
       overwritePointer(other.ptr, other.cnt, other.owning);
+      trackedBytes = other.trackedBytes;
+      trackedTag = other.trackedTag;
 
       // clear the other's state
       other.overwritePointer(nullptr, 0, false);
@@ -660,10 +666,12 @@ namespace Sloppy
     ManagedArray<T>& operator = (ManagedArray<T>&& other)
     {
       // free currently owned resources
-      if (owning && (ptr != nullptr)) releaseMem(ptr);
+      if (owning && (ptr != nullptr)) releaseOwnedMem();
 
       // take over the other's state
       overwritePointer(other.ptr, other.cnt, other.owning);
+      trackedBytes = other.trackedBytes;
+      trackedTag = other.trackedTag;
 
       // clear the other's state
       other.overwritePointer(nullptr, 0, false);
@@ -791,7 +799,7 @@ namespace Sloppy
 
       if (ptr != nullptr)
       {
-        releaseMem(ptr);
+        releaseOwnedMem();
         ptr = nullptr;
         cnt = 0;
       }
@@ -875,7 +883,7 @@ namespace Sloppy
       }
 
       // allocate new memory
-      T* tmpPtr = allocateMem(newSize);
+      T* tmpPtr = allocateTagged(newSize);
       if (tmpPtr == nullptr)
       {
         throw std::bad_alloc();
@@ -890,10 +898,11 @@ namespace Sloppy
         memcpy(dstPtr, srcPtr, nCopyElements * sizeof(T));
 
         // release the current memory
-        releaseMem(ptr);
+        releaseOwnedMem();
       }
 
       overwritePointer(tmpPtr, newSize, true);
+      trackAllocation();
     }
 
     /** \returns `true` if we're owning the array's memory, `false` otherwise
@@ -934,6 +943,7 @@ namespace Sloppy
         ) noexcept
     {
       ptr = newPtr;
+      trackedBytes = 0;
       if (ptr == nullptr)
       {
         cnt = 0;
@@ -973,9 +983,49 @@ namespace Sloppy
     }
 
   private:
+    /** \brief Calls `allocateMem()` with the current allocation tag or, if
+     * there is none, with `MemTag::Memory`
+     */
+    T* allocateTagged(size_t nElem)
+    {
+      const MemTag curTag = AllocTracker::currentTag();
+      ScopedAllocTag tagGuard{(curTag == MemTag::Untagged) ? MemTag::Memory : curTag};
+      return allocateMem(nElem);
+    }
+
+    /** \brief Records the allocation of the current block in the AllocTracker
+     *
+     * Does nothing if tracking is disabled or if the allocation hooks are
+     * installed (because they have already seen the allocation).
+     */
+    void trackAllocation()
+    {
+      trackedBytes = 0;
+      if (!AllocTracker::isEnabled() || AllocTracker::hooksInstalled()) return;
+
+      const MemTag curTag = AllocTracker::currentTag();
+      trackedTag = (curTag == MemTag::Untagged) ? MemTag::Memory : curTag;
+      trackedBytes = cnt * sizeof(T);
+      AllocTracker::recordAlloc(trackedTag, trackedBytes);
+    }
+
+    /** \brief Releases the current block and, if it has been tracked, records the release
+     */
+    void releaseOwnedMem()
+    {
+      if (trackedBytes > 0)
+      {
+        AllocTracker::recordFree(trackedTag, trackedBytes);
+        trackedBytes = 0;
+      }
+      releaseMem(ptr);
+    }
+
     T* ptr{nullptr};
     size_t cnt{0};
     bool owning{false};
+    size_t trackedBytes{0};   ///< the number of bytes that have been recorded in the AllocTracker for the current block
+    MemTag trackedTag{MemTag::Untagged};   ///< the tag that the current block has been recorded under
   };
 
   //----------------------------------------------------------------------------
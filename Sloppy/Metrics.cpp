@@ -0,0 +1,513 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for find_if, is_permutation
+#include <charconv>   // for to_chars
+#include <cmath>      // for isnan, isinf
+#include <condition_variable>  // for condition_variable
+#include <stdexcept>  // for invalid_argument
+
+#include "json.hpp"   // for json
+
+#include "Metrics.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  struct MetricsRegistry::Impl
+  {
+    struct Instance
+    {
+      uint64_t id;
+      MetricLabels labels;
+      string renderedLabels;   // 'a="b",c="d"', without braces
+      CounterFunc cf;
+      GaugeFunc gf;
+      HistogramFunc hf;
+      int nActiveCalls{0};   // number of renderers that currently use the callbacks; protected by mtx
+    };
+
+    struct Family
+    {
+      string help;
+      Type type;
+      vector<shared_ptr<Instance>> instances;
+    };
+
+    // a copy of a family that is used for invoking the
+    // callbacks without holding the registry's mutex
+    struct FamilySnapshot
+    {
+      string name;
+      string help;
+      Type type;
+      vector<shared_ptr<Instance>> instances;
+    };
+
+    mutable mutex mtx;
+    mutable condition_variable callsDone;
+    map<string, Family> families;
+    uint64_t nextId{1};
+    size_t nInstances{0};
+  };
+
+  //----------------------------------------------------------------------------
+
+  namespace
+  {
+    // the quantiles that are exported for histograms
+    struct QuantileDef
+    {
+      double p;
+      const char* label;
+    };
+    constexpr QuantileDef ExportedQuantiles[] = {
+      {50, "quantile=\"0.5\""},
+      {90, "quantile=\"0.9\""},
+      {99, "quantile=\"0.99\""},
+      {99.9, "quantile=\"0.999\""},
+    };
+
+    bool isValidName(const string& name, bool allowColon)
+    {
+      if (name.empty()) return false;
+
+      for (size_t i = 0; i < name.size(); ++i)
+      {
+        const char c = name[i];
+        const bool isAlpha = ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_') || (allowColon && (c == ':'));
+        const bool isDigit = (c >= '0') && (c <= '9');
+        if (!isAlpha && !(isDigit && (i > 0))) return false;
+      }
+
+      return true;
+    }
+
+    void appendEscaped(string& out, const string& s, bool escapeQuotes)
+    {
+      for (char c : s)
+      {
+        switch (c)
+        {
+        case '\\':
+          out += "\\\\";
+          break;
+        case '\n':
+          out += "\\n";
+          break;
+        case '"':
+          if (escapeQuotes)
+          {
+            out += "\\\"";
+            break;
+          }
+          [[fallthrough]];
+        default:
+          out += c;
+        }
+      }
+    }
+
+    void appendUInt(string& out, uint64_t v)
+    {
+      char buf[24];
+      auto res = to_chars(buf, buf + sizeof(buf), v);
+      out.append(buf, res.ptr);
+    }
+
+    void appendDouble(string& out, double v)
+    {
+      if (std::isnan(v))
+      {
+        out += "NaN";
+        return;
+      }
+      if (std::isinf(v))
+      {
+        out += (v > 0) ? "+Inf" : "-Inf";
+        return;
+      }
+
+      char buf[32];
+      auto res = to_chars(buf, buf + sizeof(buf), v);
+      out.append(buf, res.ptr);
+    }
+
+    // appends "name{labels,extra} "
+    void appendSample(string& out, const string& name, const char* suffix, const string& labels, const char* extraLabel)
+    {
+      out += name;
+      if (suffix != nullptr) out += suffix;
+
+      const bool hasLabels = !labels.empty();
+      const bool hasExtra = (extraLabel != nullptr);
+      if (hasLabels || hasExtra)
+      {
+        out += '{';
+        out += labels;
+        if (hasLabels && hasExtra) out += ',';
+        if (hasExtra) out += extraLabel;
+        out += '}';
+      }
+      out += ' ';
+    }
+
+    constexpr double NanosecsPerSec = 1e9;
+
+    // Copies all families while holding the registry's mutex and
+    // marks their callbacks as active; the callbacks can then be
+    // invoked without the lock. The dtor releases the callbacks
+    // so that a pending `Handle::reset()` can proceed.
+    template<typename RegImpl>
+    class CallbackSnapshot
+    {
+    public:
+      explicit CallbackSnapshot(RegImpl& regImpl)
+        :impl{regImpl}
+      {
+        lock_guard<mutex> lk{impl.mtx};
+
+        families.reserve(impl.families.size());
+        for (const auto& [name, fam] : impl.families)
+        {
+          families.push_back({name, fam.help, fam.type, fam.instances});
+          for (const auto& inst : fam.instances) ++inst->nActiveCalls;
+        }
+      }
+
+      ~CallbackSnapshot()
+      {
+        lock_guard<mutex> lk{impl.mtx};
+
+        for (const auto& fam : families)
+        {
+          for (const auto& inst : fam.instances) --inst->nActiveCalls;
+        }
+        impl.callsDone.notify_all();
+      }
+
+      CallbackSnapshot(const CallbackSnapshot&) = delete;
+      CallbackSnapshot& operator=(const CallbackSnapshot&) = delete;
+
+      vector<typename RegImpl::FamilySnapshot> families;
+
+    private:
+      RegImpl& impl;
+    };
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle::Handle(const shared_ptr<Impl>& regImpl, const string& metricName, uint64_t instanceId)
+    :registry{regImpl}, name{metricName}, id{instanceId}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle::~Handle()
+  {
+    reset();
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle::Handle(Handle&& other) noexcept
+    :registry{std::move(other.registry)}, name{std::move(other.name)}, id{other.id}
+  {
+    other.registry.reset();
+    other.id = 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle& MetricsRegistry::Handle::operator=(Handle&& other) noexcept
+  {
+    if (this == &other) return *this;
+
+    reset();
+    registry = std::move(other.registry);
+    name = std::move(other.name);
+    id = other.id;
+    other.registry.reset();
+    other.id = 0;
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void MetricsRegistry::Handle::reset()
+  {
+    auto impl = registry.lock();
+    registry.reset();
+    if (impl == nullptr) return;
+
+    unique_lock<mutex> lk{impl->mtx};
+
+    auto it = impl->families.find(name);
+    if (it == impl->families.end()) return;
+
+    auto& allInst = it->second.instances;
+    auto instIt = find_if(allInst.begin(), allInst.end(), [this](const shared_ptr<Impl::Instance>& i) { return i->id == id; });
+    if (instIt == allInst.end()) return;
+
+    const shared_ptr<Impl::Instance> inst = *instIt;
+    allInst.erase(instIt);
+    --impl->nInstances;
+    if (allInst.empty()) impl->families.erase(it);
+
+    // the owner of the handle may release the data that is
+    // referenced by the callbacks once we return, so we have
+    // to wait for renderers that are currently invoking them
+    impl->callsDone.wait(lk, [&inst]() { return inst->nActiveCalls == 0; });
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool MetricsRegistry::Handle::isValid() const
+  {
+    return !registry.expired();
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::MetricsRegistry()
+    :impl{make_shared<Impl>()}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry& MetricsRegistry::global()
+  {
+    static MetricsRegistry reg;
+    return reg;
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle MetricsRegistry::addCounter(const string& name, const string& help, const MetricLabels& labels, CounterFunc f)
+  {
+    return add(name, help, labels, Type::Counter, std::move(f), nullptr, nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle MetricsRegistry::addGauge(const string& name, const string& help, const MetricLabels& labels, GaugeFunc f)
+  {
+    return add(name, help, labels, Type::Gauge, nullptr, std::move(f), nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle MetricsRegistry::addHistogram(const string& name, const string& help, const MetricLabels& labels, HistogramFunc f)
+  {
+    return add(name, help, labels, Type::Histogram, nullptr, nullptr, std::move(f));
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t MetricsRegistry::size() const
+  {
+    lock_guard<mutex> lk{impl->mtx};
+    return impl->nInstances;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void MetricsRegistry::renderPrometheus(string& out) const
+  {
+    out.clear();
+
+    CallbackSnapshot<Impl> snapshot{*impl};
+
+    for (const auto& fam : snapshot.families)
+    {
+      const string& name = fam.name;
+      out += "# HELP ";
+      out += name;
+      out += ' ';
+      out += fam.help;
+      out += "\n# TYPE ";
+      out += name;
+
+      switch (fam.type)
+      {
+      case Type::Counter:
+        out += " counter\n";
+        for (const auto& inst : fam.instances)
+        {
+          appendSample(out, name, nullptr, inst->renderedLabels, nullptr);
+          appendUInt(out, inst->cf());
+          out += '\n';
+        }
+        break;
+
+      case Type::Gauge:
+        out += " gauge\n";
+        for (const auto& inst : fam.instances)
+        {
+          appendSample(out, name, nullptr, inst->renderedLabels, nullptr);
+          appendDouble(out, inst->gf());
+          out += '\n';
+        }
+        break;
+
+      case Type::Histogram:
+        out += " summary\n";
+        for (const auto& inst : fam.instances)
+        {
+          const LatencyHistogram h = inst->hf();
+          for (const auto& q : ExportedQuantiles)
+          {
+            appendSample(out, name, nullptr, inst->renderedLabels, q.label);
+            appendDouble(out, h.percentile(q.p) / NanosecsPerSec);
+            out += '\n';
+          }
+          appendSample(out, name, "_sum", inst->renderedLabels, nullptr);
+          appendDouble(out, h.mean() * h.count() / NanosecsPerSec);
+          out += '\n';
+          appendSample(out, name, "_count", inst->renderedLabels, nullptr);
+          appendUInt(out, h.count());
+          out += '\n';
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  nlohmann::json MetricsRegistry::toJson() const
+  {
+    nlohmann::json result = nlohmann::json::object();
+
+    CallbackSnapshot<Impl> snapshot{*impl};
+
+    for (const auto& fam : snapshot.families)
+    {
+      nlohmann::json values = nlohmann::json::array();
+      for (const auto& inst : fam.instances)
+      {
+        nlohmann::json labels = nlohmann::json::object();
+        for (const auto& [lName, lValue] : inst->labels) labels[lName] = lValue;
+
+        nlohmann::json v{{"labels", labels}};
+        switch (fam.type)
+        {
+        case Type::Counter:
+          v["value"] = inst->cf();
+          break;
+
+        case Type::Gauge:
+          v["value"] = inst->gf();
+          break;
+
+        case Type::Histogram:
+        {
+          const LatencyHistogram h = inst->hf();
+          v["count"] = h.count();
+          v["sum"] = h.mean() * h.count() / NanosecsPerSec;
+          v["min"] = h.min() / NanosecsPerSec;
+          v["max"] = h.max() / NanosecsPerSec;
+          v["p50"] = h.p50() / NanosecsPerSec;
+          v["p90"] = h.percentile(90) / NanosecsPerSec;
+          v["p99"] = h.p99() / NanosecsPerSec;
+          v["p999"] = h.p999() / NanosecsPerSec;
+        }
+        }
+
+        values.push_back(std::move(v));
+      }
+
+      static const char* typeNames[] = {"counter", "gauge", "histogram"};
+      result[fam.name] = nlohmann::json{
+        {"type", typeNames[static_cast<int>(fam.type)]},
+        {"help", fam.help},
+        {"values", std::move(values)}
+      };
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  MetricsRegistry::Handle MetricsRegistry::add(const string& name, const string& help, const MetricLabels& labels, Type t, CounterFunc cf, GaugeFunc gf, HistogramFunc hf)
+  {
+    if (!isValidName(name, true))
+    {
+      throw std::invalid_argument("MetricsRegistry: invalid metric name '" + name + "'");
+    }
+
+    auto inst = make_shared<Impl::Instance>();
+    inst->labels = labels;
+    for (const auto& [lName, lValue] : labels)
+    {
+      if (!isValidName(lName, false) || (lName == "quantile"))
+      {
+        throw std::invalid_argument("MetricsRegistry: invalid label name '" + lName + "'");
+      }
+
+      if (!inst->renderedLabels.empty()) inst->renderedLabels += ',';
+      inst->renderedLabels += lName;
+      inst->renderedLabels += "=\"";
+      appendEscaped(inst->renderedLabels, lValue, true);
+      inst->renderedLabels += '"';
+    }
+    inst->cf = std::move(cf);
+    inst->gf = std::move(gf);
+    inst->hf = std::move(hf);
+
+    lock_guard<mutex> lk{impl->mtx};
+
+    auto it = impl->families.find(name);
+    if (it == impl->families.end())
+    {
+      Impl::Family fam;
+      appendEscaped(fam.help, help, false);
+      fam.type = t;
+      it = impl->families.emplace(name, std::move(fam)).first;
+    } else {
+      if (it->second.type != t)
+      {
+        throw std::invalid_argument("MetricsRegistry: metric '" + name + "' has already been registered with a different type");
+      }
+
+      // the order of the labels doesn't matter for the exported metric
+      for (const auto& other : it->second.instances)
+      {
+        if ((other->labels.size() == labels.size()) && is_permutation(labels.begin(), labels.end(), other->labels.begin()))
+        {
+          throw std::invalid_argument("MetricsRegistry: metric '" + name + "' has already been registered with the same labels");
+        }
+      }
+    }
+
+    const uint64_t id = impl->nextId++;
+    inst->id = id;
+    it->second.instances.push_back(std::move(inst));
+    ++impl->nInstances;
+
+    return Handle{impl, name, id};
+  }
+
+}
@@ -0,0 +1,190 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_METRICS_H
+#define __LIBSLOPPY_METRICS_H
+
+#include <cstdint>     // for uint64_t
+#include <functional>  // for function
+#include <map>         // for map
+#include <memory>      // for shared_ptr, weak_ptr
+#include <mutex>       // for mutex
+#include <string>      // for string
+#include <utility>     // for pair
+#include <vector>      // for vector
+
+#include "Histogram.h"     // for LatencyHistogram
+#include "json_fwd.hpp"    // for json
+
+namespace Sloppy
+{
+  /** \brief A list of label name / label value pairs
+   */
+  using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+  /** \brief A central registry for counters, gauges and histograms.
+   *
+   * Metrics are registered as callbacks that return the current value. The
+   * callbacks are only invoked when the registry is rendered, so there
+   * is no overhead on the hot path of the instrumented code.
+   *
+   * Each registration returns a `Handle`; the metric is removed from the
+   * registry when the handle is destroyed. Handles may safely outlive
+   * the registry.
+   *
+   * Metrics with the same name (but different labels) form a family that
+   * shares the same help text and type.
+   *
+   * All methods are thread-safe. The callbacks are executed without holding
+   * the registry's mutex, so they may safely acquire locks of their own even if
+   * other threads register metrics while holding those locks. Destroying
+   * a handle blocks until all currently running invocations of the
+   * handle's callback have returned; thus, a callback must not destroy
+   * its own handle.
+   */
+  class MetricsRegistry
+  {
+  public:
+    enum class Type
+    {
+      Counter,   ///< a monotonically increasing integer value
+      Gauge,   ///< an arbitrary floating point value
+      Histogram   ///< a latency distribution, exported as a summary with quantiles
+    };
+
+    using CounterFunc = std::function<uint64_t()>;
+    using GaugeFunc = std::function<double()>;
+    using HistogramFunc = std::function<LatencyHistogram()>;
+
+  private:
+    struct Impl;
+
+  public:
+    /** \brief An RAII handle that removes its metric from the
+     * registry upon destruction
+     */
+    class Handle
+    {
+    public:
+      Handle() = default;
+      ~Handle();
+
+      Handle(const Handle&) = delete;
+      Handle& operator=(const Handle&) = delete;
+      Handle(Handle&& other) noexcept;
+      Handle& operator=(Handle&& other) noexcept;
+
+      /** \brief Removes the metric from the registry (if not already done)
+       */
+      void reset();
+
+      /** \returns `true` if the handle refers to a registered metric
+       */
+      bool isValid() const;
+
+    private:
+      friend class MetricsRegistry;
+      Handle(const std::shared_ptr<Impl>& regImpl, const std::string& metricName, uint64_t instanceId);
+
+      std::weak_ptr<Impl> registry;
+      std::string name;
+      uint64_t id{0};
+    };
+
+    /** \brief Ctor for an empty registry
+     */
+    MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /** \returns a process-wide default registry
+     */
+    static MetricsRegistry& global();
+
+    /** \brief Registers a counter
+     *
+     * \throws std::invalid_argument if the name is not a valid metric name,
+     * if a metric with the same name but a different type already exists or
+     * if a metric with the same name and the same set of labels already exists
+     */
+    [[nodiscard]] Handle addCounter(
+        const std::string& name,   ///< the metric name, e.g. "sloppy_queue_put_total"
+        const std::string& help,   ///< a short description
+        const MetricLabels& labels,   ///< the labels that distinguish this instance from other instances of the same family
+        CounterFunc f   ///< returns the current value
+        );
+
+    /** \brief Registers a gauge
+     *
+     * \throws std::invalid_argument if the name is not a valid metric name,
+     * if a metric with the same name but a different type already exists or
+     * if a metric with the same name and the same set of labels already exists
+     */
+    [[nodiscard]] Handle addGauge(
+        const std::string& name,   ///< the metric name
+        const std::string& help,   ///< a short description
+        const MetricLabels& labels,   ///< the labels that distinguish this instance from other instances of the same family
+        GaugeFunc f   ///< returns the current value
+        );
+
+    /** \brief Registers a latency histogram with values in nanosecs;
+     * it is exported in seconds.
+     *
+     * \throws std::invalid_argument if the name is not a valid metric name,
+     * if a metric with the same name but a different type already exists or
+     * if a metric with the same name and the same set of labels already exists
+     */
+    [[nodiscard]] Handle addHistogram(
+        const std::string& name,   ///< the metric name, e.g. "sloppy_async_worker_runtime_seconds"
+        const std::string& help,   ///< a short description
+        const MetricLabels& labels,   ///< the labels that distinguish this instance from other instances of the same family
+        HistogramFunc f   ///< returns the current histogram
+        );
+
+    /** \returns the number of registered metrics
+     */
+    size_t size() const;
+
+    /** \brief Renders all metrics in the Prometheus text exposition format.
+     *
+     * Histograms are exported as summaries with the quantiles 0.5, 0.9, 0.99
+     * and 0.999. The output buffer is cleared but its capacity is retained, so
+     * repeated calls with the same buffer don't have to grow the buffer again.
+     */
+    void renderPrometheus(
+        std::string& out   ///< the buffer for the result
+        ) const;
+
+    /** \returns all metrics as a JSON object with one entry per family
+     */
+    nlohmann::json toJson() const;
+
+  private:
+    Handle add(const std::string& name, const std::string& help, const MetricLabels& labels,
+               Type t, CounterFunc cf, GaugeFunc gf, HistogramFunc hf);
+
+    std::shared_ptr<Impl> impl;
+  };
+
+  /** \brief A convenience type for objects that own several metric registrations
+   */
+  using MetricHandleList = std::vector<MetricsRegistry::Handle>;
+}
+
+#endif
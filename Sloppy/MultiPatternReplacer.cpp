@@ -0,0 +1,194 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <queue>      // for queue
+#include <stdexcept>  // for invalid_argument
+
+#include "MultiPatternReplacer.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  MultiPatternReplacer::MultiPatternReplacer(const vector<Substitution>& _subs)
+    :subs{_subs}
+  {
+    if (subs.empty())
+    {
+      throw std::invalid_argument("MultiPatternReplacer: empty list of substitutions");
+    }
+
+    // assign byte classes
+    for (const auto& [key, value] : subs)
+    {
+      if (key.empty())
+      {
+        throw std::invalid_argument("MultiPatternReplacer: empty search string");
+      }
+
+      for (char c : key)
+      {
+        auto& cls = byteClass[static_cast<uint8_t>(c)];
+        if (cls == 0) cls = static_cast<uint8_t>(nClasses++);
+      }
+
+      if (value.size() > key.size()) neverGrows = false;
+    }
+
+    // build the trie; zero in the transition table means "no edge" for
+    // all states but the root because no edge can lead back to the root
+    transitions.assign(nClasses, Root);
+    depth.push_back(0);
+    longestMatch.push_back(NoMatch);
+    for (size_t id = 0; id < subs.size(); ++id)
+    {
+      uint32_t state{Root};
+      for (char c : subs[id].first)
+      {
+        const size_t idx = state * nClasses + byteClass[static_cast<uint8_t>(c)];
+        if (transitions[idx] == Root)
+        {
+          transitions[idx] = static_cast<uint32_t>(depth.size());
+          transitions.resize(transitions.size() + nClasses, Root);
+          depth.push_back(depth[state] + 1);
+          longestMatch.push_back(NoMatch);
+        }
+        state = transitions[idx];
+      }
+
+      if (longestMatch[state] != NoMatch)
+      {
+        throw std::invalid_argument("MultiPatternReplacer: duplicate search string");
+      }
+      longestMatch[state] = static_cast<int32_t>(id);
+    }
+
+    // breadth-first traversal for computing the failure links and for
+    // turning the trie into a complete state machine. A state inherits
+    // the longest match of its failure state if it doesn't represent
+    // a complete search string itself.
+    vector<uint32_t> fail(depth.size(), Root);
+    queue<uint32_t> pending;
+    for (size_t cls = 0; cls < nClasses; ++cls)
+    {
+      const uint32_t child = transitions[cls];
+      if (child != Root) pending.push(child);
+    }
+    while (!pending.empty())
+    {
+      const uint32_t state = pending.front();
+      pending.pop();
+
+      if (longestMatch[state] == NoMatch) longestMatch[state] = longestMatch[fail[state]];
+
+      for (size_t cls = 0; cls < nClasses; ++cls)
+      {
+        const size_t idx = state * nClasses + cls;
+        const uint32_t failTarget = transitions[fail[state] * nClasses + cls];
+        if (transitions[idx] == Root)
+        {
+          transitions[idx] = failTarget;
+        } else {
+          fail[transitions[idx]] = failTarget;
+          pending.push(transitions[idx]);
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  estring MultiPatternReplacer::apply(string_view src) const
+  {
+    estring result;
+    appendTo(src, result);
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t MultiPatternReplacer::appendTo(string_view src, string& dst) const
+  {
+    // the output is as long as the input if no substitution
+    // is longer than its search string; otherwise we add
+    // some headroom to avoid most re-allocations
+    dst.reserve(dst.size() + src.size() + (neverGrows ? 0 : (src.size() / 8)));
+
+    size_t nReplacements{0};
+    size_t copiedUpTo{0};   // everything before this position has been copied to `dst`
+
+    // the best match found so far that has not yet been applied
+    int32_t pendingId{NoMatch};
+    size_t pendingStart{0};
+
+    auto applyPending = [&]()
+    {
+      const auto& [key, value] = subs[pendingId];
+      dst.append(src.data() + copiedUpTo, pendingStart - copiedUpTo);
+      dst.append(value);
+      copiedUpTo = pendingStart + key.size();
+      pendingId = NoMatch;
+      ++nReplacements;
+    };
+
+    uint32_t state{Root};
+    size_t idx{0};
+    while (idx < src.size())
+    {
+      state = next(state, src[idx]);
+      ++idx;
+
+      // the longest search string that ends here has the
+      // leftmost start of all matches that end here
+      const int32_t id = longestMatch[state];
+      if (id != NoMatch)
+      {
+        const size_t start = idx - subs[id].first.size();
+        if ((pendingId == NoMatch) || (start < pendingStart) ||
+            ((start == pendingStart) && (subs[id].first.size() > subs[pendingId].first.size())))
+        {
+          pendingId = id;
+          pendingStart = start;
+        }
+      }
+
+      if (pendingId == NoMatch) continue;
+
+      // any future match starts at `idx - depth[state]` or later; if that's
+      // beyond the pending match, the pending match is final.
+      // We also apply it at the end of the input.
+      if (((idx - depth[state]) > pendingStart) || (idx == src.size()))
+      {
+        applyPending();
+
+        // continue directly after the replaced text; the
+        // characters after it have to be scanned again
+        // with a fresh state
+        idx = copiedUpTo;
+        state = Root;
+      }
+    }
+
+    // copy everything after the last match
+    dst.append(src.data() + copiedUpTo, src.size() - copiedUpTo);
+
+    return nReplacements;
+  }
+
+}
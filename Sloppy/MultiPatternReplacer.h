@@ -0,0 +1,109 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_MULTI_PATTERN_REPLACER_H
+#define __LIBSLOPPY_MULTI_PATTERN_REPLACER_H
+
+#include <array>        // for array
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint8_t, uint32_t, int32_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include "String.h"     // for estring
+
+namespace Sloppy
+{
+  /** \brief Replaces several search strings with their substitutions in a single pass
+   *
+   * The search strings are compiled once into an Aho-Corasick automaton. Each call
+   * to `apply()` then scans the input only once and copies each input character only
+   * once to the output, no matter how many search strings there are.
+   *
+   * If several search strings match at overlapping positions, the leftmost match
+   * wins; if several matches start at the same position, the longest one wins.
+   * Replaced text is never searched again, so that e.g. the substitutions
+   * `\` --> `\\` and `"` --> `\"` can be applied together.
+   *
+   * After construction, the object is immutable and can be shared between threads.
+   */
+  class MultiPatternReplacer
+  {
+  public:
+    /// a search string and its substitution
+    using Substitution = std::pair<std::string, std::string>;
+
+    /** \brief Ctor that compiles the search strings
+     *
+     * \throws std::invalid_argument if the list is empty, contains an empty
+     * search string or contains the same search string twice
+     */
+    explicit MultiPatternReplacer(
+        const std::vector<Substitution>& subs   ///< the search strings and their substitutions
+        );
+
+    /** \brief Replaces all search strings in the input
+     *
+     * \returns a new string with all substitutions applied
+     */
+    estring apply(std::string_view src   ///< the input string
+                  ) const;
+
+    /** \brief Replaces all search strings in the input and appends the
+     * result to an existing string
+     *
+     * Can be used to reuse an output buffer for many inputs.
+     *
+     * \returns the number of replacements
+     */
+    size_t appendTo(
+        std::string_view src,   ///< the input string
+        std::string& dst   ///< the string that receives the result
+        ) const;
+
+    /// \returns the number of search strings
+    size_t patternCount() const { return subs.size(); }
+
+  private:
+    static constexpr uint32_t Root = 0;
+    static constexpr int32_t NoMatch = -1;
+
+    std::vector<Substitution> subs;
+
+    // bytes that don't appear in any search string
+    // share class 0; all others get their own class
+    std::array<uint8_t, 256> byteClass{};
+    size_t nClasses{1};
+
+    std::vector<uint32_t> transitions;   // nClasses entries per state; including all failure transitions
+    std::vector<uint32_t> depth;   // length of the prefix that is represented by a state
+    std::vector<int32_t> longestMatch;   // per state: the longest search string that ends here, or NoMatch
+
+    // true if no substitution is longer than its search string
+    bool neverGrows{true};
+
+    uint32_t next(uint32_t state, char c) const
+    {
+      return transitions[state * nClasses + byteClass[static_cast<uint8_t>(c)]];
+    }
+  };
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <stdexcept>                                   // for out_of_range
 #include <utility>                                     // for move
 
+#include "../AllocTracker.h"  // for ScopedAllocTag
 #include "../Memory.h"  // for MemView, MemArray
 #include "../String.h"  // for estring
 
@@ -105,6 +106,7 @@ namespace Sloppy
 
     void OutMessage::addString(const string& s)
     {
+      ScopedAllocTag allocTag{MemTag::Net};
       addUI64(s.size());
       data += ByteString{(uint8_t*)s.c_str(), s.size()};
     }
@@ -155,6 +157,8 @@ namespace Sloppy
 
     void OutMessage::addMemView(const ArrayView<uint8_t>& mv)
     {
+      ScopedAllocTag allocTag{MemTag::Net};
+
       // is sufficient space left in the data area?
       size_t bytesRemaining = data.capacity() - data.size();
       if (bytesRemaining < mv.size())
@@ -178,6 +182,7 @@ namespace Sloppy
 
     void OutMessage::addByteString(const ByteString& bs)
     {
+      ScopedAllocTag allocTag{MemTag::Net};
       addUI64(bs.size());
       data += bs;
     }
@@ -217,6 +222,8 @@ namespace Sloppy
 
     InMessage& InMessage::operator =(const InMessage& other)
     {
+      ScopedAllocTag allocTag{MemTag::Net};
+
       if (data.notEmpty()) data.releaseMemory();
 
       if (other.data.notEmpty())
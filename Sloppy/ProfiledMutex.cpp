@@ -0,0 +1,244 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for sort
+#include <chrono>     // for steady_clock
+#include <cstdio>     // for snprintf
+#include <map>        // for map
+#include <ostream>    // for ostream
+
+#include "ProfiledMutex.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace LockProfiler
+  {
+    namespace
+    {
+      atomic<bool> enabled{false};
+
+      struct Registry
+      {
+        mutex mtx;
+        map<string, shared_ptr<LockProfile>> profiles;
+      };
+
+      Registry& registry()
+      {
+        static Registry reg;
+        return reg;
+      }
+
+      vector<shared_ptr<LockProfile>> allProfiles()
+      {
+        auto& reg = registry();
+        lock_guard<mutex> lk{reg.mtx};
+
+        vector<shared_ptr<LockProfile>> result;
+        result.reserve(reg.profiles.size());
+        for (const auto& [n, p] : reg.profiles) result.push_back(p);
+
+        return result;
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    void setEnabled(bool isEnabled)
+    {
+      enabled.store(isEnabled, memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    bool isEnabled()
+    {
+      return enabled.load(memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    shared_ptr<LockProfile> profileFor(const string& name)
+    {
+      auto& reg = registry();
+      lock_guard<mutex> lk{reg.mtx};
+
+      auto& p = reg.profiles[name];
+      if (p == nullptr) p = make_shared<LockProfile>(name);
+
+      return p;
+    }
+
+    //----------------------------------------------------------------------------
+
+    vector<LockReport> report()
+    {
+      vector<LockReport> result;
+      for (const auto& p : allProfiles())   // already sorted by name
+      {
+        LockReport r;
+        r.name = p->name;
+        r.nAcquisitions = p->nAcquisitions.load(memory_order_relaxed);
+        r.nContended = p->nContended.load(memory_order_relaxed);
+        r.nFailedTryLocks = p->nFailedTryLocks.load(memory_order_relaxed);
+        r.waitTime = p->waitTime.snapshot();
+        r.holdTime = p->holdTime.snapshot();
+        result.push_back(std::move(r));
+      }
+
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+
+    void writeReport(ostream& os)
+    {
+      char buf[256];
+      snprintf(buf, sizeof(buf), "%-40s %12s %8s %10s %10s %10s %10s %10s %10s\n",
+               "Lock", "acquired", "cont. %", "wait p50", "wait p99", "wait max", "hold p50", "hold p99", "hold max");
+      os << buf;
+
+      for (const auto& r : report())
+      {
+        // all times in microseconds
+        snprintf(buf, sizeof(buf), "%-40s %12llu %8.2f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                 r.name.c_str(), static_cast<unsigned long long>(r.nAcquisitions), r.contentionPercentage(),
+                 r.waitTime.p50() / 1000.0, r.waitTime.p99() / 1000.0, r.waitTime.max() / 1000.0,
+                 r.holdTime.p50() / 1000.0, r.holdTime.p99() / 1000.0, r.holdTime.max() / 1000.0);
+        os << buf;
+      }
+      os << "(times in microseconds; wait times only for contended acquisitions)\n";
+    }
+
+    //----------------------------------------------------------------------------
+
+    void reset()
+    {
+      for (const auto& p : allProfiles())
+      {
+        p->nAcquisitions.store(0, memory_order_relaxed);
+        p->nContended.store(0, memory_order_relaxed);
+        p->nFailedTryLocks.store(0, memory_order_relaxed);
+        p->waitTime.reset();
+        p->holdTime.reset();
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    MetricHandleList registerMetrics(MetricsRegistry& reg)
+    {
+      MetricHandleList result;
+      for (const auto& p : allProfiles())
+      {
+        const MetricLabels lbl{{"lock", p->name}};
+        result.push_back(reg.addCounter("sloppy_lock_acquisitions_total", "Number of lock acquisitions", lbl,
+                                        [p]() noexcept { return p->nAcquisitions.load(memory_order_relaxed); }));
+        result.push_back(reg.addCounter("sloppy_lock_contended_total", "Number of lock acquisitions that had to wait", lbl,
+                                        [p]() noexcept { return p->nContended.load(memory_order_relaxed); }));
+        result.push_back(reg.addHistogram("sloppy_lock_wait_seconds", "Wait time of contended lock acquisitions", lbl,
+                                          [p]() { return p->waitTime.snapshot(); }));
+        result.push_back(reg.addHistogram("sloppy_lock_hold_seconds", "Time between lock acquisition and release", lbl,
+                                          [p]() { return p->holdTime.snapshot(); }));
+      }
+
+      return result;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  namespace
+  {
+    int64_t now__ns()
+    {
+      return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  ProfiledMutex::ProfiledMutex(const string& name)
+    :profile{LockProfiler::profileFor(name)}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ProfiledMutex::lock()
+  {
+    if (!LockProfiler::isEnabled())
+    {
+      mtx.lock();
+      acquiredAt_ns = -1;
+      return;
+    }
+
+    if (mtx.try_lock())
+    {
+      acquiredAt_ns = now__ns();
+      profile->nAcquisitions.fetch_add(1, memory_order_relaxed);
+      return;
+    }
+
+    const int64_t t0 = now__ns();
+    mtx.lock();
+    acquiredAt_ns = now__ns();
+
+    profile->nAcquisitions.fetch_add(1, memory_order_relaxed);
+    profile->nContended.fetch_add(1, memory_order_relaxed);
+    profile->waitTime.record(acquiredAt_ns - t0);
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ProfiledMutex::try_lock()
+  {
+    if (!mtx.try_lock())
+    {
+      if (LockProfiler::isEnabled()) profile->nFailedTryLocks.fetch_add(1, memory_order_relaxed);
+      return false;
+    }
+
+    if (LockProfiler::isEnabled())
+    {
+      acquiredAt_ns = now__ns();
+      profile->nAcquisitions.fetch_add(1, memory_order_relaxed);
+    } else {
+      acquiredAt_ns = -1;
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ProfiledMutex::unlock()
+  {
+    if (acquiredAt_ns >= 0)
+    {
+      profile->holdTime.record(now__ns() - acquiredAt_ns);
+      acquiredAt_ns = -1;
+    }
+
+    mtx.unlock();
+  }
+
+}
@@ -0,0 +1,173 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_PROFILED_MUTEX_H
+#define __LIBSLOPPY_PROFILED_MUTEX_H
+
+#include <atomic>              // for atomic
+#include <condition_variable>  // for condition_variable, condition_variable_any
+#include <cstdint>             // for uint64_t, int64_t
+#include <iosfwd>              // for ostream
+#include <memory>              // for shared_ptr
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <vector>              // for vector
+
+#include "ConcurrentStats.h"   // for ConcurrentHistogram
+#include "Histogram.h"         // for LatencyHistogram
+#include "Metrics.h"           // for MetricsRegistry, MetricHandleList
+
+namespace Sloppy
+{
+  /** \brief The counters and histograms of all locks that share the same name
+   */
+  struct LockProfile
+  {
+    explicit LockProfile(const std::string& lockName)
+      :name{lockName} {}
+
+    const std::string name;
+    std::atomic<uint64_t> nAcquisitions{0};   ///< number of successful `lock()` / `try_lock()` calls
+    std::atomic<uint64_t> nContended{0};   ///< number of `lock()` calls that had to wait
+    std::atomic<uint64_t> nFailedTryLocks{0};   ///< number of unsuccessful `try_lock()` calls
+    ConcurrentHistogram waitTime;   ///< time between `lock()` and the acquisition, for contended acquisitions only
+    ConcurrentHistogram holdTime;   ///< time between the acquisition and `unlock()`
+  };
+
+  /** \brief A snapshot of a `LockProfile`
+   */
+  struct LockReport
+  {
+    std::string name;
+    uint64_t nAcquisitions{0};
+    uint64_t nContended{0};
+    uint64_t nFailedTryLocks{0};
+    LatencyHistogram waitTime;
+    LatencyHistogram holdTime;
+
+    /** \returns the percentage of acquisitions that had to wait
+     */
+    double contentionPercentage() const
+    {
+      return (nAcquisitions == 0) ? 0.0 : (100.0 * nContended) / nAcquisitions;
+    }
+  };
+
+  /** \brief Registry and global switch for the profiling of `ProfiledMutex` instances
+   *
+   * Profiling is off by default. If disabled, a `ProfiledMutex` costs
+   * one additional relaxed atomic load per `lock()` and `unlock()`.
+   */
+  namespace LockProfiler
+  {
+    /** \brief Globally enables or disables the profiling of all `ProfiledMutex` instances
+     */
+    void setEnabled(bool isEnabled);
+
+    /** \returns `true` if locks are currently being profiled
+     */
+    bool isEnabled();
+
+    /** \returns the (shared) profile for a lock name; creates it if necessary
+     */
+    std::shared_ptr<LockProfile> profileFor(const std::string& name);
+
+    /** \returns a snapshot of all lock profiles, sorted by name
+     */
+    std::vector<LockReport> report();
+
+    /** \brief Writes a human-readable table with the acquisition counts,
+     * the contention rate and the wait / hold time percentiles of all locks
+     */
+    void writeReport(std::ostream& os);
+
+    /** \brief Resets all counters and histograms of all lock profiles
+     */
+    void reset();
+
+    /** \brief Publishes the acquisition counters and wait / hold histograms
+     * of all lock profiles that exist at the time of the call in a metrics registry
+     *
+     * \returns the handles for the published metrics; the metrics are removed
+     * from the registry when the handles are destroyed
+     */
+    MetricHandleList registerMetrics(
+        MetricsRegistry& reg = MetricsRegistry::global()   ///< the registry to publish the metrics in
+        );
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A drop-in replacement for `std::mutex` that records acquisitions,
+   * contention, wait times and hold times in a named `LockProfile`
+   *
+   * All instances with the same name share one profile, e.g. the
+   * list mutexes of all `ThreadSafeQueue` instances.
+   *
+   * The class satisfies the *Lockable* requirements and thus works with
+   * `std::lock_guard`, `std::unique_lock` and `std::condition_variable_any`.
+   */
+  class ProfiledMutex
+  {
+  public:
+    explicit ProfiledMutex(
+        const std::string& name = "unnamed"   ///< the name of the profile that this mutex reports to
+        );
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    /** \returns the name of the profile that this mutex reports to
+     */
+    const std::string& name() const { return profile->name; }
+
+  private:
+    std::mutex mtx;
+    std::shared_ptr<LockProfile> profile;
+    int64_t acquiredAt_ns{-1};   ///< only accessed by the thread holding `mtx`; -1 if the acquisition hasn't been profiled
+  };
+
+  //----------------------------------------------------------------------------
+
+  //
+  // The mutex and condition variable types that the library uses internally.
+  //
+  // If the library is built with `SLOPPY_PROFILE_LOCKS` (CMake option of the
+  // same name), the internal locks are `ProfiledMutex` instances that can
+  // be switched on at run time using `LockProfiler::setEnabled()`. Otherwise
+  // they are plain `std::mutex` instances without any overhead.
+  //
+  // Code that includes the library headers has to use the same setting
+  // as the library itself.
+  //
+#ifdef SLOPPY_PROFILE_LOCKS
+  using InternalMutex = ProfiledMutex;
+  using InternalCondVar = std::condition_variable_any;
+  #define SLOPPY_LOCK_NAME(n) n
+#else
+  using InternalMutex = std::mutex;
+  using InternalCondVar = std::condition_variable;
+  #define SLOPPY_LOCK_NAME(n)
+#endif
+}
+
+#endif
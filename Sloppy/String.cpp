@@ -16,10 +16,13 @@
  *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <algorithm>  // for all_of, find_if_not, for_each, max, count
+#include <algorithm>  // for all_of, find_if_not, for_each, max, count, sort, unique, lower_bound
 #include <cctype>     // for isdigit, isspace, tolower, toupper
+#include <charconv>   // for to_chars, from_chars, chars_format
 #include <stdexcept>  // for invalid_argument
 
+#include "CharClass.h"
+#include "MultiPatternReplacer.h"
 #include "String.h"
 
 using namespace std;
@@ -112,20 +115,12 @@ namespace Sloppy
   estring& estring::trimLeft()
   {
     // find the first non-whitespace character
-    auto it = std::find_if_not(cbegin(), cend(), [](const char& c) {
-      return isspace(static_cast<unsigned char>(c));
-    });
+    const size_t nSpaces = CharClass::countLeadingSpaces(toStringView());
+    if (nSpaces == 0) return *this;  // nothing to trim
 
-    if (it == cbegin()) return *this;  // nothing to trim
-    if (it == cend())
-    {
-      // the string consists only of white spaces
-      clear();
-      return *this;
-    }
-
-    // keep everything starting from 'it'
-    erase(begin(), it);
+    // keep everything after the white spaces; this also
+    // works if the string consists only of white spaces
+    erase(0, nSpaces);
     return *this;
   }
 
@@ -133,21 +128,11 @@ namespace Sloppy
 
   estring& estring::trimRight()
   {
-    // find the first non-whitespace character
-    auto it = std::find_if_not(crbegin(), crend(), [](const char& c) {
-      return isspace(static_cast<unsigned char>(c));
-    });
-
-    if (it == crbegin()) return *this;  // nothing to trim
-    if (it == crend())
-    {
-      // the string consists only of white spaces
-      clear();
-      return *this;
-    }
+    // find the last non-whitespace character
+    const size_t nSpaces = CharClass::countTrailingSpaces(toStringView());
+    if (nSpaces == 0) return *this;  // nothing to trim
 
-    // keep everything starting from 'it'
-    erase(it.base(), end());
+    resize(size() - nSpaces);
     return *this;
   }
 
@@ -164,27 +149,24 @@ namespace Sloppy
 
   estring estring::trimLeft_copy() const
   {
-    estring tmp{*this};
-    tmp.trimLeft();
-    return tmp;
+    const string_view sv = toStringView();
+    const size_t nSpaces = CharClass::countLeadingSpaces(sv);
+    return estring{sv.data() + nSpaces, sv.size() - nSpaces};
   }
 
   //----------------------------------------------------------------------------
 
   estring estring::trimRight_copy() const
   {
-    estring tmp{*this};
-    tmp.trimRight();
-    return tmp;
+    return estring{data(), size() - CharClass::countTrailingSpaces(toStringView())};
   }
 
   //----------------------------------------------------------------------------
 
   estring estring::trim_copy() const
   {
-    estring tmp{*this};
-    tmp.trim();
-    return tmp;
+    const string_view trimmed = trimView(toStringView());
+    return estring{trimmed.data(), trimmed.size()};
   }
 
   //----------------------------------------------------------------------------
@@ -269,6 +251,19 @@ namespace Sloppy
 
   //----------------------------------------------------------------------------
 
+  bool estring::replaceAll(const MultiPatternReplacer& replacer)
+  {
+    if (empty()) return false;
+
+    estring tmp;
+    if (replacer.appendTo(toStringView(), tmp) == 0) return false;
+
+    operator=(std::move(tmp));
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
   void estring::replaceSection(estring::size_type idxFirst, estring::size_type idxLast, const string& s)
   {
     if (idxLast < idxFirst)
@@ -295,13 +290,12 @@ namespace Sloppy
 
   void estring::toUpper()
   {
-    // normal uppercase conversion
-    for_each(begin(), end(), [](char& c) {
-      c = toupper(static_cast<unsigned char>(c));
-    });
+    // ASCII conversion plus table-based conversion
+    // of two-byte UTF-8 characters in one go
+    CharClass::toUpper(data(), size());
 
-    // additional conversions for multibyte UTF-8 characters
-    for (const pair<string, string>& umlaut : umlautTranslationTable)
+    // additional conversions for all other multibyte UTF-8 characters
+    for (const pair<string, string>& umlaut : CharClass::irregularCasePairs())
     {
       replaceAll(umlaut.first, umlaut.second);
     }
@@ -311,13 +305,12 @@ namespace Sloppy
 
   void estring::toLower()
   {
-    // normal lowercase conversion
-    for_each(begin(), end(), [](char& c) {
-      c = tolower(static_cast<unsigned char>(c));
-    });
+    // ASCII conversion plus table-based conversion
+    // of two-byte UTF-8 characters in one go
+    CharClass::toLower(data(), size());
 
-    // additional conversions for multibyte UTF-8 characters
-    for (const pair<string, string>& umlaut : umlautTranslationTable)
+    // additional conversions for all other multibyte UTF-8 characters
+    for (const pair<string, string>& umlaut : CharClass::irregularCasePairs())
     {
       replaceAll(umlaut.second, umlaut.first);
     }
@@ -443,9 +436,7 @@ namespace Sloppy
     }
 
     // make sure that all characters are numbers
-    return all_of(start, cend(), [](const char& c) {
-      return isdigit(static_cast<unsigned int>(c));
-    });
+    return CharClass::isAllDigits(toStringView().substr(start - cbegin()));
   }
 
   //----------------------------------------------------------------------------
@@ -469,13 +460,12 @@ namespace Sloppy
     if (*this == ".-") return false;
 
     // we may have exactly zero or one decimal points
-    auto nDots = count(cbegin(), cend(), '.');
-    if (nDots > 1) return false;
+    // and all other characters must be numbers
+    const string_view digits = toStringView().substr(start - cbegin());
+    const size_t dotPos = digits.find('.');
+    if (dotPos == string_view::npos) return CharClass::isAllDigits(digits);
 
-    // make sure that all characters are numbers or dot
-    return all_of(start, cend(), [](const char& c) {
-      return (isdigit(static_cast<unsigned int>(c)) || (c == '.'));
-    });
+    return (CharClass::isAllDigits(digits.substr(0, dotPos)) && CharClass::isAllDigits(digits.substr(dotPos + 1)));
   }
 
   //----------------------------------------------------------------------------
@@ -483,54 +473,26 @@ namespace Sloppy
   vector<estring> estring::split(const string& delim, bool keepEmptyParts, bool trimParts) const
   {
     vector<estring> result;
-    if (empty()) return result;
-
-    if (delim.empty())
+    for (const string_view& part : splitRange(delim, keepEmptyParts, trimParts))
     {
-      throw std::invalid_argument("estring::split: called with empty delimiter string!");
+      result.push_back(estring{part.data(), part.size()});
     }
 
-    // iterate over the string segments, delimiter by delimiter
-    size_t nextStartPos = 0;
-    while (nextStartPos < length())
-    {
-      size_t nextDelimPos = find(delim, nextStartPos);
-      if (nextDelimPos == string::npos) break;
-
-      estring s;
-      if (nextDelimPos > nextStartPos)
-      {
-        // there is content between two delimiters; extract
-        // the content
-        s = slice(nextStartPos, nextDelimPos - 1);
-        if (trimParts) s.trim();
-      }
-      // else: we have two directly subsequent delimiters (e.g., ",,")
-      // and thus we simply use an empty string
-
-      nextStartPos = nextDelimPos + delim.length();
-
-      if (s.empty() && !keepEmptyParts) continue;
+    return result;
+  }
 
-      result.push_back(s);
-    }
+  //----------------------------------------------------------------------------
 
-    // the last section between the last delimiter and the string end
-    if (nextStartPos < length())
-    {
-      estring s = substr(nextStartPos);
-      if (trimParts) s.trim();
-      if (keepEmptyParts || s.notEmpty()) result.push_back(s);
-    }
+  vector<string_view> estring::splitView(string_view delim, bool keepEmptyParts, bool trimParts) const
+  {
+    return splitRange(delim, keepEmptyParts, trimParts).toVector();
+  }
 
-    // if the string terminated with a delimiter
-    // push an empty string
-    if ((nextStartPos == length()) && keepEmptyParts)
-    {
-      result.push_back(estring{});
-    }
+  //----------------------------------------------------------------------------
 
-    return result;
+  SplitRange estring::splitRange(string_view delim, bool keepEmptyParts, bool trimParts) const
+  {
+    return SplitRange{toStringView(), delim, keepEmptyParts, trimParts};
   }
 
   //----------------------------------------------------------------------------
@@ -622,6 +584,185 @@ namespace Sloppy
 
     return std::tuple{std::move(allTags), lowestArg};
   }
+
+  //----------------------------------------------------------------------------
+
+  string_view trimView(string_view sv)
+  {
+    sv.remove_prefix(CharClass::countLeadingSpaces(sv));
+    sv.remove_suffix(CharClass::countTrailingSpaces(sv));
+
+    return sv;
+  }
+
+  //----------------------------------------------------------------------------
+
+  SplitRange::SplitRange(string_view _src, string_view _delim, bool _keepEmptyParts, bool _trimParts)
+    :src{_src}, delim{_delim}, keepEmptyParts{_keepEmptyParts}, trimParts{_trimParts}
+  {
+    // same check as in estring::split(), but only
+    // for non-empty strings
+    if (delim.empty() && !src.empty())
+    {
+      throw std::invalid_argument("SplitRange: called with empty delimiter string!");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  vector<string_view> SplitRange::toVector() const
+  {
+    vector<string_view> result;
+    for (const auto& part : *this) result.push_back(part);
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SplitRange::Iterator::advance()
+  {
+    // an empty string has no parts at all, otherwise
+    // we have one part more than delimiters
+    while ((range != nullptr) && (nextPos != string_view::npos) && !range->src.empty())
+    {
+      const size_t delimPos = range->src.find(range->delim, nextPos);
+      if (delimPos == string_view::npos)
+      {
+        cur = range->src.substr(nextPos);
+        nextPos = string_view::npos;
+      } else {
+        cur = range->src.substr(nextPos, delimPos - nextPos);
+        nextPos = delimPos + range->delim.size();
+      }
+
+      if (range->trimParts) cur = trimView(cur);
+
+      if (!cur.empty() || range->keepEmptyParts) return;
+    }
+
+    // no more parts ==> turn into an end iterator
+    range = nullptr;
+    nextPos = 0;
+    cur = string_view{};
+  }
+
+  //----------------------------------------------------------------------------
+
+  FormatArg::FormatArg(double d)
+  {
+    const auto res = to_chars(buf, buf + BufSize, d);
+    len = res.ptr - buf;
+  }
+
+  //----------------------------------------------------------------------------
+
+  FormatArg FormatArg::fixed(double d, int numDigits)
+  {
+    FormatArg result{d};
+
+    const auto res = to_chars(result.buf, result.buf + BufSize, d, chars_format::fixed, max(numDigits, 0));
+    if (res.ec == errc{})
+    {
+      result.len = res.ptr - result.buf;
+    }
+    // else: keep the shortest representation from the ctor
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  FormatString::FormatString(string_view _fmt)
+    :fmt{_fmt}
+  {
+    // the tag values are temporarily stored in
+    // `argIdx` and later on converted to indices
+    vector<int> allValues;
+
+    // each '%' can add at most one tag and one literal fragment
+    const auto nPercent = count(fmt.cbegin(), fmt.cend(), '%');
+    allValues.reserve(nPercent);
+    fragments.reserve(2 * nPercent + 1);
+
+    size_t litStart{0};
+    size_t idx{0};
+    while (idx < fmt.size())
+    {
+      if (fmt[idx] != '%')
+      {
+        ++idx;
+        continue;
+      }
+
+      // same as in findAllArgTags(): in a sequence of '%' only the last one
+      // can start a tag; the others are plain text
+      while (((idx + 1) < fmt.size()) && (fmt[idx + 1] == '%')) ++idx;
+
+      const size_t tagStart = idx;
+      size_t tagEnd = idx + 1;  // one past the last digit
+      while ((tagEnd < fmt.size()) && (fmt[tagEnd] >= '0') && (fmt[tagEnd] <= '9')) ++tagEnd;
+
+      int val{0};
+      const auto res = from_chars(fmt.data() + tagStart + 1, fmt.data() + tagEnd, val);
+      if ((tagEnd == (tagStart + 1)) || (res.ec != errc{}))
+      {
+        // no digits after the '%' or a number
+        // that's too large ==> plain text
+        idx = tagEnd;
+        continue;
+      }
+
+      if (tagStart > litStart)
+      {
+        fragments.push_back(Fragment{litStart, tagStart - litStart, -1});
+      }
+      fragments.push_back(Fragment{tagStart, tagEnd - tagStart, val});
+      allValues.push_back(val);
+
+      litStart = tagEnd;
+      idx = tagEnd;
+    }
+    if (litStart < fmt.size())
+    {
+      fragments.push_back(Fragment{litStart, fmt.size() - litStart, -1});
+    }
+
+    // convert the tag values into argument indices: the
+    // lowest value gets the first argument and so on
+    sort(allValues.begin(), allValues.end());
+    allValues.erase(unique(allValues.begin(), allValues.end()), allValues.end());
+    nPlaceholders = allValues.size();
+
+    for (auto& f : fragments)
+    {
+      if (f.argIdx < 0) continue;
+      f.argIdx = lower_bound(allValues.cbegin(), allValues.cend(), f.argIdx) - allValues.cbegin();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  estring FormatString::render(const FormatArg* args, size_t nArgs) const
+  {
+    auto fragmentText = [&](const Fragment& f)
+    {
+      if ((f.argIdx >= 0) && (static_cast<size_t>(f.argIdx) < nArgs))
+      {
+        return args[f.argIdx].view();
+      }
+
+      return string_view{fmt.data() + f.idxStart, f.len};
+    };
+
+    size_t totalSize{0};
+    for (const auto& f : fragments) totalSize += fragmentText(f).size();
+
+    estring result;
+    result.reserve(totalSize);
+    for (const auto& f : fragments) result.append(fragmentText(f));
+
+    return result;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -21,10 +21,13 @@
 
 #include <stdint.h>     // for int64_t, uint8_t
 #include <stdio.h>      // for snprintf
-#include <cstddef>      // for size_t
+#include <charconv>     // for to_chars
+#include <cstddef>      // for size_t, ptrdiff_t
+#include <iterator>     // for forward_iterator_tag
 #include <string>       // for string, basic_string<>::size_type, to_string
 #include <string_view>  // for string_view, hash
 #include <tuple>        // for tuple
+#include <type_traits>  // for enable_if_t, is_integral_v, is_same_v
 #include <utility>      // for pair, move
 #include <vector>       // for vector
 
@@ -55,6 +58,101 @@ namespace Sloppy
     {"û", "Û"},
   };
 
+  /** \brief Removes leading and trailing white spaces from a string_view without copying any data
+   *
+   * \returns a view on the trimmed part of the input
+   */
+  std::string_view trimView(std::string_view sv   ///< the view to trim
+                            );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A lazy range over the parts of a delimiter-separated string
+   *
+   * The parts are determined on demand while iterating and are returned as `string_view`s
+   * that point into the original string. Thus, no data is copied and no memory is allocated
+   * but the original string must outlive the range and all parts obtained from it.
+   *
+   * The parts are identical to those returned by `estring::split()`.
+   */
+  class SplitRange
+  {
+  public:
+    /** \brief Ctor
+     *
+     * \throws std::invalid_argument if the delimiter is empty
+     */
+    SplitRange(
+        std::string_view src,   ///< the string to split
+        std::string_view delim,   ///< the delimiter used for the splitting
+        bool keepEmptyParts,   ///< set to `true` to keep empty parts
+        bool trimParts   ///< set to `true` to remove surrounding whitespaces from the parts
+        );
+
+    /** \brief A forward iterator that yields one part after the other
+     */
+    class Iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = std::string_view;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const std::string_view*;
+      using reference = const std::string_view&;
+
+      /// creates an end iterator
+      Iterator() = default;
+
+      reference operator*() const { return cur; }
+      pointer operator->() const { return &cur; }
+
+      Iterator& operator++() { advance(); return *this; }
+      Iterator operator++(int) { Iterator tmp{*this}; advance(); return tmp; }
+
+      bool operator==(const Iterator& other) const
+      {
+        return (range == nullptr) ? (other.range == nullptr) : ((range == other.range) && (nextPos == other.nextPos));
+      }
+      bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    protected:
+      friend class SplitRange;
+
+      explicit Iterator(const SplitRange* r)
+        :range{r} { advance(); }
+
+      /** \brief Moves to the next part that matches the range's options or turns
+       * the iterator into an end iterator
+       */
+      void advance();
+
+    private:
+      const SplitRange* range{nullptr};   // nullptr for end iterators
+      size_t nextPos{0};   // start of the next part; npos after the last part
+      std::string_view cur{};
+    };
+
+    Iterator begin() const { return Iterator{this}; }
+    Iterator end() const { return Iterator{}; }
+
+    /** \brief Collects all parts in a vector
+     *
+     * \returns a vector of views into the original string
+     */
+    std::vector<std::string_view> toVector() const;
+
+  private:
+    std::string_view src;
+    std::string_view delim;
+    bool keepEmptyParts;
+    bool trimParts;
+  };
+
+  //----------------------------------------------------------------------------
+
+  class FormatString;
+  class MultiPatternReplacer;
+
   /** \brief An extend string class with some convenience functions
    *
    * This class is derived from std::string and can be used like std::string
@@ -320,6 +418,16 @@ namespace Sloppy
 
     //----------------------------------------------------------------------------
 
+    /** \brief Applies all substitutions of a `MultiPatternReplacer` in a single pass;
+     * the string is modified in place
+     *
+     * \returns `true` if an replacement occurred, `false` otherwise
+     */
+    bool replaceAll(const MultiPatternReplacer& replacer   ///< the compiled search strings and their substitutions
+                    );
+
+    //----------------------------------------------------------------------------
+
     /** \brief Replaces a section of a string with a new string; the string is modified in place
      *
      *  The new string is appended if idxFirst >= size(). If idxLast is beyond the string's end,
@@ -415,6 +523,29 @@ namespace Sloppy
 
     //----------------------------------------------------------------------------
 
+    /** \brief Creates a new string by filling all "%n" placeholders of a format string in a single pass
+     *
+     * The first argument replaces all placeholders with the lowest number, the second argument
+     * all placeholders with the second lowest number and so on. The result is thus the same
+     * as calling `arg()` once per argument, except that placeholders that are
+     * contained in the arguments themselves are not evaluated again.
+     *
+     * Placeholders without a matching argument remain untouched.
+     *
+     * Arguments can be anything that can be converted to a `FormatArg`, e.g. strings, integers and doubles.
+     *
+     * If the same format is used repeatedly, use a `FormatString` instead; this
+     * saves parsing the format string on every call.
+     *
+     * \returns the formatted string
+     */
+    template<typename... Args>
+    static estring format(std::string_view fmt,   ///< the format string containing "%1", "%2", ...
+                          const Args&... args     ///< the values for the placeholders
+                          );
+
+    //----------------------------------------------------------------------------
+
     /** \brief Very strict checking whether the string contains an int and nothing else
      *
      *  This is more strict than simply calling `stoi` and checking for exceptions!
@@ -448,6 +579,36 @@ namespace Sloppy
 
     //----------------------------------------------------------------------------
 
+    /** \brief Splits the string like `split()` but returns views into this string instead of copies
+     *
+     * \warning The views become invalid if the string is modified or destroyed!
+     *
+     * \throws std::invalid_argument if the delimiter is empty
+     *
+     * \returns an array (possibly empty) with views on the substrings
+     */
+    std::vector<std::string_view> splitView(std::string_view delim,    ///< the delimiter used for the splitting
+                                            bool keepEmptyParts,    ///< set to `true` to keep empty parts in the result list
+                                            bool trimParts          ///< set to `true` to remove surrounding whitespaces from the parts
+                                            ) const;
+
+    //----------------------------------------------------------------------------
+
+    /** \brief Splits the string lazily, part by part, while iterating over the returned range
+     *
+     * \warning The range and its parts become invalid if the string is modified or destroyed!
+     *
+     * \throws std::invalid_argument if the delimiter is empty
+     *
+     * \returns a range of views on the substrings, see `SplitRange`
+     */
+    SplitRange splitRange(std::string_view delim,    ///< the delimiter used for the splitting
+                          bool keepEmptyParts,    ///< set to `true` to keep empty parts
+                          bool trimParts          ///< set to `true` to remove surrounding whitespaces from the parts
+                          ) const;
+
+    //----------------------------------------------------------------------------
+
     /** \brief A simple inversion of empty()
      *
      * \returns `true` if the string is not empty
@@ -485,6 +646,125 @@ namespace Sloppy
 
   using StringList = std::vector<estring>;
 
+  //----------------------------------------------------------------------------
+
+  /** \brief A single argument for `FormatString` or `estring::format()`
+   *
+   * Strings are referenced without copying them, so the argument must not outlive
+   * the string it has been created from. Numbers are converted using `std::to_chars()`
+   * into an internal buffer.
+   */
+  class FormatArg
+  {
+  public:
+    FormatArg(std::string_view s)
+      :ptr{s.data()}, len{s.size()} {}
+    FormatArg(const std::string& s)
+      :ptr{s.data()}, len{s.size()} {}
+    FormatArg(const char* s)
+      :FormatArg{std::string_view{s}} {}
+    FormatArg(char c)
+      :buf{c}, len{1} {}
+
+    /// ctor for all integral types, using their numeric representation
+    template<typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>>>
+    FormatArg(T v)
+    {
+      const auto res = std::to_chars(buf, buf + BufSize, v);
+      len = res.ptr - buf;
+    }
+
+    /// ctor for doubles, using the shortest representation that reproduces the value
+    FormatArg(double d);
+
+    /** \brief Creates an argument from a double with a fixed number of digits after the decimal point
+     *
+     * If the value is too large for the fixed notation, the shortest representation is used instead.
+     */
+    static FormatArg fixed(double d,   ///< the value
+                           int numDigits   ///< the number of digits after the decimal point
+                           );
+
+    /// \returns the text for the placeholder
+    std::string_view view() const { return (ptr == nullptr) ? std::string_view{buf, len} : std::string_view{ptr, len}; }
+
+  private:
+    static constexpr size_t BufSize = 32;
+
+    const char* ptr{nullptr};   // nullptr if the text is in `buf`
+    char buf[BufSize]{};
+    size_t len{0};
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A preprocessed format string with "%n" placeholders that can be filled repeatedly
+   *
+   * The format string is parsed only once in the ctor. Each call to `apply()` then
+   * computes the size of the result, reserves the memory and fills in all
+   * placeholders in a single pass.
+   *
+   * The placeholder syntax is the same as for `estring::arg()`, see `estring::format()`
+   * for the assignment of arguments to placeholders.
+   */
+  class FormatString
+  {
+  public:
+    /** \brief Ctor that parses the format string
+     */
+    explicit FormatString(std::string_view fmt   ///< the format string containing "%1", "%2", ...
+                          );
+
+    /** \brief Fills the placeholders with the provided arguments
+     *
+     * \returns the formatted string
+     */
+    template<typename... Args>
+    estring apply(const Args&... args) const
+    {
+      if constexpr (sizeof...(Args) == 0)
+      {
+        return render(nullptr, 0);
+      } else {
+        const FormatArg allArgs[] = {FormatArg{args}...};
+        return render(allArgs, sizeof...(Args));
+      }
+    }
+
+    /// \returns the number of distinct placeholder numbers in the format string
+    size_t placeholderCount() const { return nPlaceholders; }
+
+    /// \returns the original format string
+    const std::string& formatString() const { return fmt; }
+
+  protected:
+    /** \brief Assembles the result string from the parsed fragments and an array of arguments
+     */
+    estring render(const FormatArg* args, size_t nArgs) const;
+
+  private:
+    /** \brief Either a literal part of the format string or a placeholder
+     */
+    struct Fragment
+    {
+      size_t idxStart;   // position in the format string
+      size_t len;        // length in the format string
+      int argIdx;        // index of the argument for placeholders or -1 for literal text
+    };
+
+    std::string fmt;
+    std::vector<Fragment> fragments;
+    size_t nPlaceholders{0};
+  };
+
+  //----------------------------------------------------------------------------
+
+  template<typename... Args>
+  estring estring::format(std::string_view fmt, const Args&... args)
+  {
+    return FormatString{fmt}.apply(args...);
+  }
+
 }
 
 namespace std
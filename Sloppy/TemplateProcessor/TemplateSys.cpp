@@ -24,9 +24,11 @@
 #include <vector>
 #include <fstream>
 
+#include "../AllocTracker.h"
 #include "../Utils.h"
 #include "../json.hpp"
 #include "../ConfigFileParser/ConfigFileParser.h"
+#include "../Tracing.h"
 #include "../json_fwd.hpp"
 
 #include "TemplateSys.h"
@@ -544,6 +546,8 @@ namespace Sloppy
     TemplateStore::TemplateStore(const string& rootDir, const StringList& extList)
       :langCode{}
     {
+      ScopedAllocTag allocTag{MemTag::Template};
+
       std::filesystem::path rootPath{rootDir};
       if (!(std::filesystem::exists(rootPath)))
       {
@@ -648,6 +652,9 @@ namespace Sloppy
 
     string TemplateStore::get(const string& tName, const json& dic)
     {
+      SLOPPY_TRACE_SPAN("TemplateStore::get");
+      ScopedAllocTag allocTag{MemTag::Template};
+
       StringList visited;
 
       return getTemplate_Recursive(tName, dic, visited);
@@ -0,0 +1,314 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <exception>   // for terminate
+#include <fstream>     // for ifstream
+#include <stdexcept>   // for invalid_argument, runtime_error
+#include <utility>     // for move
+
+#ifndef WIN32
+#include <limits.h>        // for PTHREAD_STACK_MIN
+#include <sched.h>         // for cpu_set_t, CPU_SET, CPU_ZERO
+#include <sys/resource.h>  // for setpriority
+#include <sys/syscall.h>   // for SYS_gettid
+#include <unistd.h>        // for syscall
+#endif
+
+#include "String.h"        // for estring
+
+#include "ThreadConfig.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+
+  bool ThreadConfig::isDefault() const
+  {
+    return (name.empty() && cpuSet.empty() && !numaNode && !niceValue && (stackSize_bytes == 0));
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ThreadConfig::isValid(string* errMsg) const
+  {
+    auto fail = [&errMsg](const string& msg)
+    {
+      if (errMsg != nullptr) *errMsg = msg;
+      return false;
+    };
+
+    if (name.size() > MaxNameLen) return fail("thread name exceeds 15 characters");
+
+    for (int cpu : cpuSet)
+    {
+      if (cpu < 0) return fail("negative CPU index");
+#ifndef WIN32
+      if (cpu >= CPU_SETSIZE) return fail("CPU index exceeds CPU_SETSIZE");
+#endif
+    }
+
+    if (numaNode && (*numaNode < 0)) return fail("negative NUMA node index");
+
+    if (niceValue && ((*niceValue < -20) || (*niceValue > 19))) return fail("nice value outside -20...19");
+
+#ifndef WIN32
+    if ((stackSize_bytes > 0) && (stackSize_bytes < static_cast<size_t>(PTHREAD_STACK_MIN))) return fail("stack size below PTHREAD_STACK_MIN");
+#endif
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  vector<int> cpusOfNumaNode(int node)
+  {
+    vector<int> result;
+    if (node < 0) return result;
+
+    // the file contains a list of ranges like "0-3,8-11"
+    ifstream f{"/sys/devices/system/node/node" + to_string(node) + "/cpulist"};
+    if (!f.is_open()) return result;
+
+    estring cpuList;
+    getline(f, cpuList);
+    cpuList.trim();
+    if (cpuList.empty()) return result;
+
+    try
+    {
+      for (const estring& range : cpuList.split(",", false, true))
+      {
+        const auto bounds = range.split("-", false, true);
+        if (bounds.empty() || (bounds.size() > 2)) return vector<int>{};
+
+        const int first = stoi(bounds[0]);
+        const int last = (bounds.size() == 2) ? stoi(bounds[1]) : first;
+        for (int cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+      }
+    }
+    catch (std::exception&)
+    {
+      return vector<int>{};
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool applyThreadConfigToCallingThread(const ThreadConfig& cfg)
+  {
+#ifdef WIN32
+    return cfg.isDefault();
+#else
+    bool isOkay{true};
+
+    if (!cfg.name.empty())
+    {
+      isOkay = (pthread_setname_np(pthread_self(), cfg.name.c_str()) == 0) && isOkay;
+    }
+
+    // CPU affinity; if both a CPU set and a NUMA node are
+    // provided, we use the intersection of both
+    if (!cfg.cpuSet.empty() || cfg.numaNode)
+    {
+      vector<int> cpus = cfg.cpuSet;
+      if (cfg.numaNode)
+      {
+        const auto nodeCpus = cpusOfNumaNode(*cfg.numaNode);
+        if (cpus.empty())
+        {
+          cpus = nodeCpus;
+        } else {
+          vector<int> tmp;
+          for (int cpu : cpus)
+          {
+            for (int nc : nodeCpus)
+            {
+              if (nc == cpu) tmp.push_back(cpu);
+            }
+          }
+          cpus = std::move(tmp);
+        }
+      }
+
+      if (cpus.empty())
+      {
+        isOkay = false;
+      } else {
+        cpu_set_t cs;
+        CPU_ZERO(&cs);
+        for (int cpu : cpus)
+        {
+          if ((cpu >= 0) && (cpu < CPU_SETSIZE)) CPU_SET(cpu, &cs);
+        }
+        isOkay = (pthread_setaffinity_np(pthread_self(), sizeof(cs), &cs) == 0) && isOkay;
+      }
+    }
+
+    // on Linux, the nice value is a per-thread attribute
+    // if we address the thread by its kernel thread ID
+    if (cfg.niceValue)
+    {
+      const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+      isOkay = (setpriority(PRIO_PROCESS, tid, *cfg.niceValue) == 0) && isOkay;
+    }
+
+    return isOkay;
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  namespace
+  {
+    // the data that is handed over to a new thread
+    struct ThreadStartData
+    {
+      ThreadConfig cfg;
+      function<void ()> func;
+      shared_ptr<atomic_bool> applyResult;
+    };
+
+#ifndef WIN32
+    extern "C" void* configuredThreadEntry(void* arg)
+    {
+      unique_ptr<ThreadStartData> sd{static_cast<ThreadStartData*>(arg)};
+
+      *(sd->applyResult) = applyThreadConfigToCallingThread(sd->cfg);
+
+      // exceptions must not leave a C start routine; like
+      // std::thread, we terminate if the thread function throws
+      try
+      {
+        sd->func();
+      }
+      catch (...)
+      {
+        std::terminate();
+      }
+
+      return nullptr;
+    }
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+
+  ConfiguredThread::ConfiguredThread(const ThreadConfig& cfg, function<void ()> func)
+  {
+    string errMsg;
+    if (!cfg.isValid(&errMsg))
+    {
+      throw std::invalid_argument("ConfiguredThread: invalid thread config (" + errMsg + ")");
+    }
+
+    applyResult = make_shared<atomic_bool>(false);
+
+#ifdef WIN32
+    thr = std::thread{std::move(func)};
+    *applyResult = cfg.isDefault();
+#else
+    auto sd = make_unique<ThreadStartData>(ThreadStartData{cfg, std::move(func), applyResult});
+
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0)
+    {
+      throw std::runtime_error("ConfiguredThread: could not initialize thread attributes");
+    }
+    if ((cfg.stackSize_bytes > 0) && (pthread_attr_setstacksize(&attr, cfg.stackSize_bytes) != 0))
+    {
+      pthread_attr_destroy(&attr);
+      throw std::invalid_argument("ConfiguredThread: invalid stack size");
+    }
+
+    const int rc = pthread_create(&tid, &attr, configuredThreadEntry, sd.get());
+    pthread_attr_destroy(&attr);
+    if (rc != 0)
+    {
+      throw std::runtime_error("ConfiguredThread: could not create thread");
+    }
+
+    // the new thread owns the start data now
+    sd.release();
+#endif
+
+    isJoinable = true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ConfiguredThread::~ConfiguredThread()
+  {
+    if (isJoinable) std::terminate();
+  }
+
+  //----------------------------------------------------------------------------
+
+  ConfiguredThread::ConfiguredThread(ConfiguredThread&& other) noexcept
+  {
+#ifdef WIN32
+    thr = std::move(other.thr);
+#else
+    tid = other.tid;
+#endif
+    isJoinable = other.isJoinable;
+    applyResult = std::move(other.applyResult);
+    other.isJoinable = false;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ConfiguredThread& ConfiguredThread::operator=(ConfiguredThread&& other) noexcept
+  {
+    if (isJoinable) std::terminate();
+
+#ifdef WIN32
+    thr = std::move(other.thr);
+#else
+    tid = other.tid;
+#endif
+    isJoinable = other.isJoinable;
+    applyResult = std::move(other.applyResult);
+    other.isJoinable = false;
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ConfiguredThread::join()
+  {
+    if (!isJoinable)
+    {
+      throw std::runtime_error("ConfiguredThread: join() called on a non-joinable thread");
+    }
+
+#ifdef WIN32
+    thr.join();
+#else
+    pthread_join(tid, nullptr);
+#endif
+
+    isJoinable = false;
+  }
+
+}
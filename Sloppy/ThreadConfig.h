@@ -0,0 +1,170 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_THREADCONFIG_H
+#define __LIBSLOPPY_THREADCONFIG_H
+
+#include <atomic>      // for atomic_bool
+#include <cstddef>     // for size_t
+#include <functional>  // for function
+#include <memory>      // for shared_ptr
+#include <optional>    // for optional
+#include <string>      // for string
+#include <vector>      // for vector
+
+#ifdef WIN32
+#include <thread>      // for thread
+#else
+#include <pthread.h>   // for pthread_t
+#endif
+
+namespace Sloppy
+{
+  /** \brief A set of placement and scheduling parameters for
+   * threads that are spawned by the library (e.g., by `AsyncWorker`
+   * or `CyclicWorkerThread`).
+   *
+   * All members are optional; a default-constructed config leaves
+   * everything at the operating system's defaults.
+   *
+   * \note Affinity, NUMA placement and thread names are only supported
+   * on Linux and are silently ignored on other platforms.
+   */
+  struct ThreadConfig
+  {
+    static constexpr size_t MaxNameLen = 15;   ///< `pthread_setname_np()` limit, excluding the zero-terminator
+
+    std::string name{};   ///< the thread name as shown by `top -H` or `ps -L`; at most 15 characters
+    std::vector<int> cpuSet{};   ///< zero-based indices of the CPUs the thread may run on; empty = no restriction
+    std::optional<int> numaNode{};   ///< restrict the thread to the CPUs of this NUMA node (combined with `cpuSet`, if provided)
+    std::optional<int> niceValue{};   ///< the nice value (-20...19) for the thread; lower values require privileges
+    size_t stackSize_bytes{0};   ///< the stack size for the new thread; 0 = system default
+
+    /** \returns `true` if the config does not request any deviation
+     * from the system defaults
+     */
+    bool isDefault() const;
+
+    /** \returns `true` if all parameters are within their valid
+     * range; optionally an error message is returned through `errMsg`
+     */
+    bool isValid(
+        std::string* errMsg = nullptr   ///< an optional pointer to a string for returning a human-readable error message
+        ) const;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \returns the zero-based indices of all CPUs that belong to a given NUMA
+   * node as reported by `/sys/devices/system/node/node<N>/cpulist`; empty
+   * if the node doesn't exist or if NUMA information is not available.
+   */
+  std::vector<int> cpusOfNumaNode(
+      int node   ///< zero-based index of the NUMA node
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Applies name, CPU affinity / NUMA placement and nice value to the
+   * CALLING thread. The stack size is ignored because it can only be set
+   * when the thread is created.
+   *
+   * \returns `true` if all requested settings could be applied, `false` if
+   * at least one of them failed (e.g., because of missing privileges for
+   * a negative nice value or because of a CPU index that isn't online).
+   */
+  bool applyThreadConfigToCallingThread(
+      const ThreadConfig& cfg   ///< the settings to apply
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A minimal replacement for `std::thread` that applies a
+   * `ThreadConfig` to the new thread.
+   *
+   * The stack size is set via thread attributes before the thread is
+   * created; all other settings are applied by the new thread itself
+   * before the thread function is executed.
+   *
+   * Just like `std::thread`, the object has to be `join()`ed before
+   * it is destroyed.
+   */
+  class ConfiguredThread
+  {
+  public:
+    /** \brief Default ctor for an empty, not-joinable thread object
+     */
+    ConfiguredThread() = default;
+
+    /** \brief Ctor that immediately starts a new thread executing `func`
+     *
+     * \throws std::invalid_argument if the provided config is not valid
+     *
+     * \throws std::runtime_error if the thread could not be created
+     */
+    ConfiguredThread(
+        const ThreadConfig& cfg,   ///< placement and scheduling parameters for the new thread
+        std::function<void ()> func   ///< the thread function
+        );
+
+    /** \brief Dtor; terminates the process (like `std::thread`) if
+     * the thread is still joinable
+     */
+    ~ConfiguredThread();
+
+    ConfiguredThread(const ConfiguredThread&) = delete;
+    ConfiguredThread& operator=(const ConfiguredThread&) = delete;
+
+    /** \brief Move ctor
+     */
+    ConfiguredThread(ConfiguredThread&& other) noexcept;
+
+    /** \brief Move assignment; terminates the process (like `std::thread`) if
+     * we're still holding a joinable thread
+     */
+    ConfiguredThread& operator=(ConfiguredThread&& other) noexcept;
+
+    /** \returns `true` if the object represents a running or finished but
+     * not yet joined thread
+     */
+    bool joinable() const { return isJoinable; }
+
+    /** \brief Blocks until the thread function has finished
+     *
+     * \throws std::runtime_error if the thread is not joinable
+     */
+    void join();
+
+    /** \returns `true` if all settings from the `ThreadConfig` have been
+     * applied successfully by the thread; `false` if the thread has not
+     * yet started or if at least one setting failed.
+     */
+    bool configApplied() const { return (applyResult != nullptr) && applyResult->load(); }
+
+  private:
+#ifdef WIN32
+    std::thread thr{};
+#else
+    pthread_t tid{};
+#endif
+    bool isJoinable{false};
+    std::shared_ptr<std::atomic_bool> applyResult{};
+  };
+}
+
+#endif
@@ -39,9 +39,12 @@
 #include <string>
 #include <chrono>
 #include <mutex>
+#include <atomic>
 #include <deque>
 #include <condition_variable>
 #include <optional>
+#include "Metrics.h"
+#include "ProfiledMutex.h"
 #include "Timer.h"
 
 // we include some special file functions for
@@ -79,8 +82,9 @@ namespace Sloppy
         const T& inData   ///< the data that shall be copy-appended to the queue
         )
     {
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       queue.push_back(inData);
+      nPut.fetch_add(1, std::memory_order_relaxed);
       notify();
     }
 
@@ -90,8 +94,9 @@ namespace Sloppy
         T&& inData   ///< the data that shall be moved to the queue
         )
     {
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       queue.push_back(std::forward<T>(inData));
+      nPut.fetch_add(1, std::memory_order_relaxed);
       notify();
     }
 
@@ -106,9 +111,10 @@ namespace Sloppy
       if (!waitForData(timeout_ms)) {
         return std::nullopt;
       }
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       const T outData = queue.front();
       queue.pop_front();
+      nGet.fetch_add(1, std::memory_order_relaxed);
       return outData;
     }
 
@@ -120,7 +126,7 @@ namespace Sloppy
      */
     bool hasData()
     {
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       return !queue.empty();
     }
 
@@ -132,7 +138,7 @@ namespace Sloppy
      */
     bool empty()
     {
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       return queue.empty();
     }
 
@@ -144,7 +150,7 @@ namespace Sloppy
      */
     int size()
     {
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       return queue.size();
     }
 
@@ -152,10 +158,40 @@ namespace Sloppy
      */
     void clear()
     {
-      std::lock_guard<std::mutex> lg{listMutex};
+      std::lock_guard<InternalMutex> lg{listMutex};
       queue.clear();
     }
 
+    /** \returns the total number of elements that have been put into the queue
+     */
+    uint64_t putCount() const { return nPut.load(std::memory_order_relaxed); }
+
+    /** \returns the total number of elements that have been taken from the queue
+     */
+    uint64_t getCount() const { return nGet.load(std::memory_order_relaxed); }
+
+    /** \brief Publishes the put / get counters and the queue length
+     * in a metrics registry.
+     *
+     * Any previous registration is removed. The registration is
+     * removed automatically when the queue is destroyed.
+     */
+    void registerMetrics(
+        const std::string& instanceName,   ///< the value of the `queue` label
+        MetricsRegistry& reg = MetricsRegistry::global()   ///< the registry to publish the metrics in
+        )
+    {
+      metricHandles.clear();
+
+      const MetricLabels lbl{{"queue", instanceName}};
+      metricHandles.push_back(reg.addCounter("sloppy_queue_put_total", "Number of elements put into the queue", lbl,
+                                             [this]() { return putCount(); }));
+      metricHandles.push_back(reg.addCounter("sloppy_queue_get_total", "Number of elements taken from the queue", lbl,
+                                             [this]() { return getCount(); }));
+      metricHandles.push_back(reg.addGauge("sloppy_queue_length", "Number of elements currently in the queue", lbl,
+                                           [this]() { return static_cast<double>(size()); }));
+    }
+
   protected:
     virtual void notify() = 0;  ///< only to be caller by the writer thread; mutex must be in place
 
@@ -173,10 +209,13 @@ namespace Sloppy
     }
 
     /** \brief Derived classes need direct access to the mutex */
-    std::mutex listMutex;
+    InternalMutex listMutex{SLOPPY_LOCK_NAME("ThreadSafeQueue::listMutex")};
 
   private:
     std::deque<T> queue;
+    std::atomic<uint64_t> nPut{0};
+    std::atomic<uint64_t> nGet{0};
+    MetricHandleList metricHandles;
   };
 
   //------------------------------------------------------------------------------------------
@@ -202,7 +241,7 @@ namespace Sloppy
       // block infinitely until data is available
       if (timeout_ms < 0) {
         // condition variables only work with unique_lock, not with lock_guard
-        std::unique_lock<std::mutex> lock{this->listMutex};
+        std::unique_lock<InternalMutex> lock{this->listMutex};
 
         // wait for a notification that new data has arrived;
         // ignores spurious wakeups and is guaranteed to not return
@@ -213,14 +252,14 @@ namespace Sloppy
 
       // quickly check if there's pending data
       if (timeout_ms == 0) {
-        std::lock_guard<std::mutex> lg{this->listMutex};
+        std::lock_guard<InternalMutex> lg{this->listMutex};
         return !(this->unprotected_empty());
       }
 
       // get exclusive access to the queue;
       //
       // condition variables only work with unique_lock, not with lock_guard
-      std::unique_lock<std::mutex> lock{this->listMutex};
+      std::unique_lock<InternalMutex> lock{this->listMutex};
       bool hasData = !(this->unprotected_empty());
 
       //
@@ -251,7 +290,7 @@ namespace Sloppy
     }
 
   private:
-    std::condition_variable cv;
+    InternalCondVar cv;
 
   };
 
@@ -306,7 +345,7 @@ namespace Sloppy
     }
 
     ~ThreadSafeQueue_PipeSynced() {
-      std::lock_guard<std::mutex> lg{this->listMutex};
+      std::lock_guard<InternalMutex> lg{this->listMutex};
       ::close(pipeReadFd);
       ::close(pipeWriteFd);
       ::close(epollContext);
@@ -37,15 +37,55 @@ namespace Sloppy
     if (execTime_ms < minWorkerTime_ms) minWorkerTime_ms = execTime_ms;
   }
 
+  //----------------------------------------------------------------------------
+
+  void AsyncWorkerStats::update__ns(int64_t execTime_ns)
+  {
+    update(static_cast<int>(execTime_ns / 1000000));
+    runtimeHistogram.record(execTime_ns);
+  }
+
   //----------------------------------------------------------------------------
   //----------------------------------------------------------------------------
   //----------------------------------------------------------------------------
 
   double CyclicThreadStats::dutyPercentage() const
   {
+    if (workerCycleTime_us > 0)
+    {
+      return (nCalls == 0) ? 0 : (double(totalRuntime_us) / nCalls / workerCycleTime_us);
+    }
+
     return avgWorkerExecTime_ms() / workerCycleTime_ms;
   }
 
+  //----------------------------------------------------------------------------
+
+  double CyclicThreadStats::avgJitter_us() const
+  {
+    return (nCalls == 0) ? 0 : (double(totalJitter_us) / nCalls);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicThreadStats::update__us(long long execTime_us, long long jitter_us)
+  {
+    update__ns(execTime_us * 1000, jitter_us * 1000);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void CyclicThreadStats::update__ns(int64_t execTime_ns, int64_t jitter_ns)
+  {
+    AsyncWorkerStats::update__ns(execTime_ns);
+    jitterHistogram.record(jitter_ns);
+
+    const long long jitter_us = jitter_ns / 1000;
+    totalRuntime_us += execTime_ns / 1000;
+    lastJitter_us = jitter_us;
+    totalJitter_us += jitter_us;
+    if (jitter_us > maxJitter_us) maxJitter_us = jitter_us;
+  }
 
 
 }
@@ -38,6 +38,9 @@
 #define __LIBSLOPPY_THREADSTATS_H
 
 #include <climits>
+#include <cstdint>
+
+#include "Histogram.h"   // for LatencyHistogram
 
 
 namespace Sloppy
@@ -52,6 +55,7 @@ namespace Sloppy
     int lastRuntime_ms{0};   ///< the number of millisecs the last worker function call lasted
     int minWorkerTime_ms{INT_MAX};
     int maxWorkerTime_ms{0};
+    LatencyHistogram runtimeHistogram;   ///< the execution times of all worker function calls in nanosecs
 
     /** \returns the average execution time across all
      * worker calls so far (0 if no calls were performed so far)
@@ -68,6 +72,15 @@ namespace Sloppy
      * locking (e.g., through a mutex) has to be guaranteed by the caller!
      */
     void update(int execTime_ms);
+
+    /** \brief Updates the stats with the execution time of the
+     * last worker call in nanosecs; in contrast to `update()`, this
+     * also records the value in the runtime histogram
+     *
+     * \warning If this struct is accessed from different threads, proper
+     * locking (e.g., through a mutex) has to be guaranteed by the caller!
+     */
+    void update__ns(int64_t execTime_ns);
   };
 
   //----------------------------------------------------------------------------
@@ -78,11 +91,48 @@ namespace Sloppy
   struct CyclicThreadStats : public AsyncWorkerStats
   {
     int workerCycleTime_ms{0};
+    long long workerCycleTime_us{0};   ///< the cycle time in microsecs (0 if unknown)
+    unsigned long long totalRuntime_us{0};   ///< the accumulated execution time of all worker calls in microsecs
+    long long lastJitter_us{0};   ///< the delay between the deadline and the actual start of the last worker call
+    long long maxJitter_us{0};   ///< the largest delay between deadline and actual start so far
+    unsigned long long totalJitter_us{0};   ///< the accumulated delays between deadlines and actual starts
+    unsigned long long nOverruns{0};   ///< the number of worker calls that exceeded the cycle time
+    unsigned long long nSkippedCycles{0};   ///< the number of deadlines that have been dropped due to overruns
+    LatencyHistogram jitterHistogram;   ///< the delays between deadlines and actual starts in nanosecs
 
     /** \returns a value between 0...1 that represents the average
      * duty percentage of the worker loop (0 if no calls were performed so far)
      */
     double dutyPercentage() const;
+
+    /** \returns the average delay between the deadline and the actual
+     * start of a worker call (0 if no calls were performed so far)
+     */
+    double avgJitter_us() const;
+
+    /** \brief Updates the stats with the timing of the last worker call
+     *
+     * \warning If this struct is accessed from different threads, proper
+     * locking (e.g., through a mutex) has to be guaranteed by the caller!
+     */
+    void update__us(
+        long long execTime_us,   ///< the execution time of the worker call
+        long long jitter_us   ///< the delay between the call's deadline and its actual start
+        );
+
+    using AsyncWorkerStats::update__ns;
+
+    /** \brief Updates the stats with the timing of the last worker call
+     * in nanosecs; in contrast to `update__us()`, this doesn't lose the
+     * sub-microsec resolution of the histograms.
+     *
+     * \warning If this struct is accessed from different threads, proper
+     * locking (e.g., through a mutex) has to be guaranteed by the caller!
+     */
+    void update__ns(
+        int64_t execTime_ns,   ///< the execution time of the worker call
+        int64_t jitter_ns   ///< the delay between the call's deadline and its actual start
+        );
   };
 }
 
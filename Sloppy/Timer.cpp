@@ -17,26 +17,128 @@
  */
 
 #include <iosfwd>  // for std
+#include <thread>  // for sleep_for
 
 #include "Timer.h"
 
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#include <cpuid.h>      // for __get_cpuid
+#include <x86intrin.h>  // for __rdtsc, _mm_lfence
+#define __LIBSLOPPY_HAS_TSC
+#endif
+
 using namespace std;
 
 namespace Sloppy
 {
+  namespace
+  {
+    // the result of the one-time TSC check and calibration
+    struct TscCalibration
+    {
+      bool isAvailable{false};
+      double nsPerTick{0};
+
+      TscCalibration()
+      {
+#ifdef __LIBSLOPPY_HAS_TSC
+        // CPUID leaf 0x80000007, EDX bit 8: invariant TSC
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0) return;
+        if (eax < 0x80000007) return;
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) return;
+        if ((edx & (1u << 8)) == 0) return;
+
+        // measure the TSC rate against the steady clock
+        static constexpr int CalibrationTime_ms = 20;
+        const auto t0 = chrono::steady_clock::now();
+        const uint64_t tsc0 = TscClock::now();
+        this_thread::sleep_for(chrono::milliseconds{CalibrationTime_ms});
+        const auto t1 = chrono::steady_clock::now();
+        const uint64_t tsc1 = TscClock::now();
+
+        const double elapsed_ns = chrono::duration<double, nano>(t1 - t0).count();
+        if ((tsc1 <= tsc0) || (elapsed_ns <= 0)) return;
+
+        nsPerTick = elapsed_ns / (tsc1 - tsc0);
+        isAvailable = true;
+#endif
+      }
+    };
+
+    const TscCalibration& tscCalibration()
+    {
+      static const TscCalibration cal;
+      return cal;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  uint64_t TscClock::now()
+  {
+#ifdef __LIBSLOPPY_HAS_TSC
+    // RDTSC isn't serializing; the LFENCE prevents it from being
+    // executed before all preceding instructions have completed.
+    // In contrast to RDTSCP this works on all x86 CPUs.
+    _mm_lfence();
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool TscClock::calibrate()
+  {
+    return tscCalibration().isAvailable;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool TscClock::isAvailable()
+  {
+    return tscCalibration().isAvailable;
+  }
+
+  //----------------------------------------------------------------------------
+
+  double TscClock::nsPerTick()
+  {
+    return tscCalibration().nsPerTick;
+  }
+
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+  //----------------------------------------------------------------------------
+
+  atomic<Timer::ClockSource> Timer::defaultSource{Timer::ClockSource::SteadyClock};
+
+  //----------------------------------------------------------------------------
+
+  Timer::ClockSource Timer::setDefaultClockSource(ClockSource src)
+  {
+    if ((src == ClockSource::TSC) && !TscClock::isAvailable()) src = ClockSource::SteadyClock;
+
+    defaultSource.store(src, memory_order_relaxed);
+    return src;
+  }
+
+  //----------------------------------------------------------------------------
 
   void Timer::stop()
   {
     if (stopTime) return;
 
-    stopTime = chrono::steady_clock::now();
+    stopTime = rawNow();
   }
 
   //----------------------------------------------------------------------------
 
   void Timer::restart()
   {
-    startTime = chrono::steady_clock::now();
+    startTime = rawNow();
     if (stopTime) stopTime.reset();
   }
 
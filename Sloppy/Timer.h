@@ -19,23 +19,115 @@
 #pragma once
 
 #include <stdint.h>  // for int64_t
+#include <atomic>    // for atomic
 #include <chrono>    // for nanoseconds, duration, microseconds, milliseconds
 #include <optional>  // for optional
 #include <ratio>     // for milli, ratio
 
 namespace Sloppy
 {
+  /** \brief A clock based on the CPU's time stamp counter (TSC).
+   *
+   * Reading the TSC takes only a few nanoseconds and doesn't involve
+   * the kernel or the vDSO. The TSC is only used if the CPU reports an
+   * invariant TSC (constant rate in all P-/C-states); the tick rate is
+   * calibrated once against `std::chrono::steady_clock`.
+   *
+   * The calibration blocks the calling thread for about 20 ms. It is
+   * performed by the first call of `calibrate()`, `isAvailable()` or
+   * `nsPerTick()`, which includes the construction of the first `Timer`
+   * that requests the TSC. Latency-sensitive applications should call
+   * `calibrate()` explicitly during startup.
+   *
+   * \note The TSC is assumed to be synchronized across all cores which is
+   * the case for invariant TSCs on all current single-socket systems.
+   */
+  class TscClock
+  {
+  public:
+    /** \brief Checks for an invariant TSC and calibrates its tick rate, if
+     * not already done; blocks for about 20 ms on the first call.
+     *
+     * \returns `true` if the CPU has an invariant TSC and the calibration succeeded
+     */
+    static bool calibrate();
+
+    /** \returns `true` if the CPU has an invariant TSC and the calibration succeeded;
+     * the result is determined once and cached afterwards
+     *
+     * \note The first call triggers the calibration, see `calibrate()`
+     */
+    static bool isAvailable();
+
+    /** \returns the current value of the TSC or 0 if the TSC is not available
+     */
+    static uint64_t now();
+
+    /** \returns the calibrated number of nanosecs per TSC tick (0 if the TSC is not available)
+     */
+    static double nsPerTick();
+
+    /** \returns a number of TSC ticks converted to nanosecs
+     */
+    static int64_t ticksToNs(int64_t ticks)
+    {
+      return static_cast<int64_t>(ticks * nsPerTick());
+    }
+  };
+
+  //----------------------------------------------------------------------------
+
   /** \brief A basic timer for measuring durations and checking timeouts
    *
-   * It uses the highest available clock for maximum precision.
+   * By default, it uses `std::chrono::steady_clock`. Optionally, the
+   * TSC can be used as a low-overhead clock source, either for an individual
+   * timer or globally via `setDefaultClockSource()`. If the TSC is
+   * requested but not available, the timer silently falls back to
+   * `std::chrono::steady_clock`.
    */
   class Timer
   {
   public:
+    /** \brief The clock that provides the time stamps for a timer
+     */
+    enum class ClockSource
+    {
+      SteadyClock,   ///< `std::chrono::steady_clock`, typically `clock_gettime(CLOCK_MONOTONIC)`
+      TSC   ///< the calibrated CPU time stamp counter, see `TscClock`
+    };
+
     /** \brief Ctor for a new timer that is started immediately and that
-     * has no timeout set.
+     * has no timeout set; uses the default clock source.
+     */
+    Timer() : Timer{defaultSource.load(std::memory_order_relaxed)} {}
+
+    /** \brief Ctor for a new timer with a specific clock source that is started
+     * immediately and that has no timeout set.
+     *
+     * \note If the TSC is requested and `TscClock::calibrate()` hasn't been
+     * called before, the ctor blocks for about 20 ms for the calibration.
+     */
+    explicit Timer(
+        ClockSource src   ///< the requested clock source
+        )
+      : useTsc{(src == ClockSource::TSC) && TscClock::isAvailable()}, startTime{rawNow()} {}
+
+    /** \returns the clock source that is actually used by this timer
+     */
+    ClockSource clockSource() const { return useTsc ? ClockSource::TSC : ClockSource::SteadyClock; }
+
+    /** \brief Sets the clock source for all timers that are created
+     * afterwards with the default ctor
+     *
+     * \note Requesting the TSC triggers its calibration, see `TscClock::calibrate()`
+     *
+     * \returns the clock source that will actually be used
+     */
+    static ClockSource setDefaultClockSource(ClockSource src);
+
+    /** \returns the clock source for new timers
      */
-    Timer() : startTime{std::chrono::steady_clock::now()} {}
+    static ClockSource defaultClockSource() { return defaultSource.load(std::memory_order_relaxed); }
 
     /** \brief Stops the timer.
      *
@@ -58,13 +150,8 @@ namespace Sloppy
     template<typename Resolution>
     Resolution getTime() const
     {
-      if (stopTime)
-      {
-        return std::chrono::duration_cast<Resolution>(*stopTime - startTime);
-      }
-
-      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-      return std::chrono::duration_cast<Resolution>(now - startTime);
+      const int64_t endTime = stopTime ? *stopTime : rawNow();
+      return std::chrono::duration_cast<Resolution>(rawToNs(endTime - startTime));
     }
 
     /** \returns the elapsed time in nanoseconds
@@ -188,8 +275,26 @@ namespace Sloppy
     }
 
   private:
-    std::chrono::steady_clock::time_point startTime;
-    std::optional<std::chrono::steady_clock::time_point> stopTime;
+    // the current time stamp of the selected clock, either in
+    // TSC ticks or in nanosecs since the steady clock's epoch
+    int64_t rawNow() const
+    {
+      if (useTsc) return static_cast<int64_t>(TscClock::now());
+      return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    // converts a difference of raw time stamps to nanosecs
+    std::chrono::nanoseconds rawToNs(int64_t delta) const
+    {
+      if (useTsc) return std::chrono::nanoseconds{TscClock::ticksToNs(delta)};
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::duration{delta});
+    }
+
+    static std::atomic<ClockSource> defaultSource;
+
+    bool useTsc;
+    int64_t startTime;
+    std::optional<int64_t> stopTime;
     std::optional<std::chrono::nanoseconds> timeoutDuration;
   };
 }
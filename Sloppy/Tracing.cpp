@@ -0,0 +1,252 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>   // for getpid
+
+#include <fstream>    // for ofstream
+#include <iomanip>    // for setprecision
+#include <memory>     // for shared_ptr, make_shared
+#include <mutex>      // for mutex, lock_guard
+#include <ostream>    // for ostream
+
+#include "Timer.h"    // for Timer
+
+#include "Tracing.h"
+
+using namespace std;
+
+namespace Sloppy
+{
+  namespace Tracing
+  {
+    namespace
+    {
+      // a single-producer / single-consumer ring buffer; the producer
+      // is the owning thread, the consumer is the thread calling `collect()`
+      struct ThreadBuffer
+      {
+        explicit ThreadBuffer(uint32_t tid) noexcept : threadId{tid} {}
+
+        const uint32_t threadId;
+        SpanRecord ring[SpansPerThreadBuffer];
+        alignas(64) atomic<uint64_t> head{0};   // next write position; written by the producer only
+        alignas(64) atomic<uint64_t> tail{0};   // next read position; written by the consumer only
+        atomic<bool> isThreadAlive{true};
+      };
+
+      struct Registry
+      {
+        mutex mtx;   // protects `buffers` and serializes consumers
+        vector<shared_ptr<ThreadBuffer>> buffers;
+        atomic<uint32_t> nextThreadId{1};
+        atomic<uint64_t> nDropped{0};
+      };
+
+      Registry& registry()
+      {
+        static Registry reg;
+        return reg;
+      }
+
+      atomic<bool> tracingEnabled{false};
+
+      // owns the thread's buffer and marks it as orphaned on thread exit
+      struct ThreadBufferHolder
+      {
+        shared_ptr<ThreadBuffer> buf;
+
+        ~ThreadBufferHolder()
+        {
+          if (buf != nullptr) buf->isThreadAlive = false;
+        }
+      };
+
+      ThreadBuffer& threadBuffer()
+      {
+        thread_local ThreadBufferHolder holder;
+        if (holder.buf == nullptr)
+        {
+          Registry& reg = registry();
+          holder.buf = make_shared<ThreadBuffer>(reg.nextThreadId++);
+
+          lock_guard<mutex> lk{reg.mtx};
+          reg.buffers.push_back(holder.buf);
+        }
+
+        return *holder.buf;
+      }
+
+      const Timer& epoch()
+      {
+        static const Timer t;
+        return t;
+      }
+
+      void writeJsonString(ostream& os, const char* s)
+      {
+        os << '"';
+        for (const char* p = s; *p != '\0'; ++p)
+        {
+          const char c = *p;
+          if ((c == '"') || (c == '\\'))
+          {
+            os << '\\' << c;
+          } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << ' ';
+          } else {
+            os << c;
+          }
+        }
+        os << '"';
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    void setEnabled(bool isEnabled)
+    {
+      // make sure the epoch is initialized before the first span
+      epoch();
+      tracingEnabled.store(isEnabled, memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    bool isEnabled()
+    {
+      return tracingEnabled.load(memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    int64_t now__ns()
+    {
+      return epoch().getTime__ns();
+    }
+
+    //----------------------------------------------------------------------------
+
+    vector<SpanRecord> collect()
+    {
+      vector<SpanRecord> result;
+
+      Registry& reg = registry();
+      lock_guard<mutex> lk{reg.mtx};
+
+      for (const auto& buf : reg.buffers)
+      {
+        const uint64_t head = buf->head.load(memory_order_acquire);
+        uint64_t tail = buf->tail.load(memory_order_relaxed);
+        for (; tail < head; ++tail) result.push_back(buf->ring[tail % SpansPerThreadBuffer]);
+        buf->tail.store(tail, memory_order_release);
+      }
+
+      // release the buffers of threads that have terminated
+      // and whose spans have all been collected
+      erase_if(reg.buffers, [](const shared_ptr<ThreadBuffer>& buf) noexcept {
+        return !buf->isThreadAlive && (buf->tail.load() == buf->head.load());
+      });
+
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+
+    uint64_t droppedSpans()
+    {
+      return registry().nDropped.load(memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------
+
+    void writeChromeTrace(ostream& os)
+    {
+      const auto spans = collect();
+      const auto pid = getpid();
+
+      const auto oldFlags = os.flags();
+      const auto oldPrecision = os.precision();
+      os << fixed << setprecision(3);
+
+      os << "{\"traceEvents\":[";
+      bool isFirst{true};
+      for (const auto& s : spans)
+      {
+        if (!isFirst) os << ",";
+        isFirst = false;
+
+        // time stamps are in microsecs; we keep the nanosec fraction
+        os << "\n{\"name\":";
+        writeJsonString(os, s.name);
+        os << ",\"cat\":";
+        writeJsonString(os, s.category);
+        os << ",\"ph\":\"X\",\"ts\":" << s.start_ns / 1000.0
+           << ",\"dur\":" << s.duration_ns / 1000.0
+           << ",\"pid\":" << pid << ",\"tid\":" << s.threadId << "}";
+      }
+      os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+      os.flags(oldFlags);
+      os.precision(oldPrecision);
+    }
+
+    //----------------------------------------------------------------------------
+
+    bool writeChromeTraceFile(const string& fName)
+    {
+      ofstream f{fName};
+      if (!f) return false;
+
+      writeChromeTrace(f);
+      f.close();
+
+      return !f.fail();
+    }
+
+    //----------------------------------------------------------------------------
+    //----------------------------------------------------------------------------
+    //----------------------------------------------------------------------------
+
+    Span::Span(const char* spanName, const char* spanCategory)
+      :name{spanName}, category{spanCategory}
+    {
+      if (tracingEnabled.load(memory_order_relaxed)) start_ns = now__ns();
+    }
+
+    //----------------------------------------------------------------------------
+
+    Span::~Span()
+    {
+      if (start_ns < 0) return;
+
+      const int64_t end_ns = now__ns();
+
+      ThreadBuffer& buf = threadBuffer();
+      const uint64_t head = buf.head.load(memory_order_relaxed);
+      if ((head - buf.tail.load(memory_order_acquire)) >= SpansPerThreadBuffer)
+      {
+        registry().nDropped.fetch_add(1, memory_order_relaxed);
+        return;
+      }
+
+      buf.ring[head % SpansPerThreadBuffer] = SpanRecord{name, category, start_ns, end_ns - start_ns, buf.threadId};
+      buf.head.store(head + 1, memory_order_release);
+    }
+
+  }
+}
@@ -0,0 +1,123 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_TRACING_H
+#define __LIBSLOPPY_TRACING_H
+
+#include <atomic>   // for atomic
+#include <cstdint>  // for int64_t, uint32_t
+#include <iosfwd>   // for ostream
+#include <string>   // for string
+#include <vector>   // for vector
+
+namespace Sloppy
+{
+  namespace Tracing
+  {
+    /** \brief A completed span as stored in the per-thread buffers
+     */
+    struct SpanRecord
+    {
+      const char* name;   ///< the span's name; must have static storage duration
+      const char* category;   ///< the span's category; must have static storage duration
+      int64_t start_ns;   ///< start time relative to the tracing epoch
+      int64_t duration_ns;   ///< the span's duration
+      uint32_t threadId;   ///< a small number that identifies the recording thread
+    };
+
+    /** \brief Maximum number of unflushed spans per thread; additional spans are dropped
+     */
+    static constexpr size_t SpansPerThreadBuffer = 4096;
+
+    /** \brief Globally enables or disables the recording of spans; the default is `off`
+     */
+    void setEnabled(bool isEnabled);
+
+    /** \returns `true` if spans are currently being recorded
+     */
+    bool isEnabled();
+
+    /** \returns the elapsed time since the tracing epoch (first use of the tracing facility) in nanosecs
+     */
+    int64_t now__ns();
+
+    /** \brief Removes and returns all recorded spans from all threads.
+     *
+     * The spans of each thread are in the order of their completion.
+     */
+    std::vector<SpanRecord> collect();
+
+    /** \returns the number of spans that have been dropped because of full buffers
+     */
+    uint64_t droppedSpans();
+
+    /** \brief Removes all recorded spans from all threads and writes them
+     * to a stream in the Chrome / Perfetto trace-event JSON format
+     * (complete events, `"ph": "X"`).
+     */
+    void writeChromeTrace(std::ostream& os);
+
+    /** \brief Removes all recorded spans from all threads and writes them
+     * to a file in the Chrome / Perfetto trace-event JSON format.
+     *
+     * \returns `true` if the file has been written successfully
+     */
+    bool writeChromeTraceFile(const std::string& fName);
+
+    /** \brief An RAII span that measures the time between its construction
+     * and its destruction.
+     *
+     * If tracing is disabled upon construction, the span does nothing. Spans
+     * can be nested; the nesting is reconstructed from the time stamps.
+     *
+     * Recording a span is lock-free: each thread writes to its own
+     * ring buffer that is drained by `collect()` or `writeChromeTrace()`.
+     */
+    class Span
+    {
+    public:
+      /** \brief Ctor; starts the span
+       */
+      explicit Span(
+          const char* spanName,   ///< the span's name; must have static storage duration (e.g., a string literal)
+          const char* spanCategory = "sloppy"   ///< the span's category; must have static storage duration
+          );
+
+      /** \brief Dtor; ends the span and stores it in the thread's buffer
+       */
+      ~Span();
+
+      Span(const Span&) = delete;
+      Span& operator=(const Span&) = delete;
+
+    private:
+      const char* name;
+      const char* category;
+      int64_t start_ns{-1};   // -1 = tracing was disabled on construction
+    };
+  }
+}
+
+#define __LIBSLOPPY_TRACE_CONCAT2(a, b) a##b
+#define __LIBSLOPPY_TRACE_CONCAT(a, b) __LIBSLOPPY_TRACE_CONCAT2(a, b)
+
+/** \brief Creates a span that lasts until the end of the current scope
+ */
+#define SLOPPY_TRACE_SPAN(name) Sloppy::Tracing::Span __LIBSLOPPY_TRACE_CONCAT(__sloppySpan, __LINE__){name}
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>      // for sort, max, min
+#include <cmath>          // for sqrt, fabs
+#include <cstdio>         // for printf
+#include <ctime>          // for time, gmtime_r, strftime
+#include <thread>         // for hardware_concurrency
+#include <unordered_map>  // for unordered_map
+
+#include "../Sloppy/AllocTracker.h"
+
+#include "BenchHarness.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace Sloppy::Bench
+{
+  uint64_t allocationCount()
+  {
+    return AllocTracker::hookedAllocationCount();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void BenchState::startTiming()
+  {
+    allocsAtStart = allocationCount();
+    tStart = chrono::steady_clock::now();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void BenchState::stopTiming()
+  {
+    const auto tEnd = chrono::steady_clock::now();
+    nAllocs += allocationCount() - allocsAtStart;
+    elapsedTime += chrono::duration_cast<chrono::nanoseconds>(tEnd - tStart);
+  }
+
+  //----------------------------------------------------------------------------
+
+  json BenchResult::toJson() const
+  {
+    json j;
+    j["suite"] = suite;
+    j["name"] = name;
+    j["iterationsPerRun"] = iterationsPerRun;
+    j["runs"] = nRuns;
+    j["outliers"] = nOutliers;
+    j["median_ns"] = median_ns;
+    j["mean_ns"] = mean_ns;
+    j["stddev_ns"] = stddev_ns;
+    j["min_ns"] = min_ns;
+    j["max_ns"] = max_ns;
+    j["bytesPerSec"] = bytesPerSec;
+    j["allocsPerOp"] = allocsPerOp;
+    return j;
+  }
+
+  //----------------------------------------------------------------------------
+
+  namespace
+  {
+    double medianOfSorted(const vector<double>& v)
+    {
+      const size_t n = v.size();
+      if (n == 0) return 0;
+      return ((n % 2) == 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  BenchResult evaluateSamples(vector<double> nsPerOp, double outlierThreshold)
+  {
+    BenchResult res;
+    res.nRuns = static_cast<int>(nsPerOp.size());
+    if (nsPerOp.empty()) return res;
+
+    sort(nsPerOp.begin(), nsPerOp.end());
+    const double med = medianOfSorted(nsPerOp);
+
+    // the median absolute deviation, scaled so that it
+    // estimates the standard deviation of normally distributed data
+    vector<double> dev;
+    dev.reserve(nsPerOp.size());
+    for (double v : nsPerOp) dev.push_back(fabs(v - med));
+    sort(dev.begin(), dev.end());
+    const double scaledMad = 1.4826 * medianOfSorted(dev);
+
+    vector<double> accepted;
+    accepted.reserve(nsPerOp.size());
+    for (double v : nsPerOp)
+    {
+      if ((outlierThreshold <= 0) || (scaledMad <= 0) || (fabs(v - med) <= outlierThreshold * scaledMad))
+      {
+        accepted.push_back(v);
+      }
+    }
+    res.nOutliers = res.nRuns - static_cast<int>(accepted.size());
+
+    double sum{0};
+    for (double v : accepted) sum += v;
+    res.mean_ns = sum / accepted.size();
+
+    double sqSum{0};
+    for (double v : accepted) sqSum += (v - res.mean_ns) * (v - res.mean_ns);
+    res.stddev_ns = (accepted.size() > 1) ? sqrt(sqSum / (accepted.size() - 1)) : 0;
+
+    res.median_ns = medianOfSorted(accepted);
+    res.min_ns = accepted.front();
+    res.max_ns = accepted.back();
+
+    return res;
+  }
+
+  //----------------------------------------------------------------------------
+
+  BenchRegistry& BenchRegistry::instance()
+  {
+    static BenchRegistry reg;
+    return reg;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool BenchRegistry::add(const string& suite, const string& name, BenchFunc f)
+  {
+    entries.push_back(Entry{suite, name, std::move(f)});
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  vector<BenchResult> BenchRegistry::runAll(const BenchConfig& cfg) const
+  {
+    vector<BenchResult> results;
+
+    printf("%-40s %14s %10s %12s %12s %9s\n", "Benchmark", "ns/op", "+/- %", "MB/s", "allocs/op", "outliers");
+    for (const auto& e : entries)
+    {
+      const string fullName = e.suite + "/" + e.name;
+      if (!cfg.filter.empty() && (fullName.find(cfg.filter) == string::npos)) continue;
+
+      const auto res = run(e.suite, e.name, e.f, cfg);
+
+      const double relDev = (res.mean_ns > 0) ? 100.0 * res.stddev_ns / res.mean_ns : 0;
+      printf("%-40s %14.2f %10.2f %12.2f %12.2f %5d/%-3d\n", fullName.c_str(), res.median_ns, relDev,
+             res.bytesPerSec / 1e6, res.allocsPerOp, res.nOutliers, res.nRuns);
+      fflush(stdout);
+
+      results.push_back(res);
+    }
+
+    return results;
+  }
+
+  //----------------------------------------------------------------------------
+
+  BenchResult BenchRegistry::run(const string& suite, const string& name, const BenchFunc& f, const BenchConfig& cfg)
+  {
+    static constexpr size_t MaxIterations = 1'000'000'000;
+
+    // find an iteration count that results in a
+    // run time of at least `minRunTime`
+    const double minRunTime_ns = chrono::duration_cast<chrono::nanoseconds>(cfg.minRunTime).count();
+    size_t nIter = 1;
+    while (nIter < MaxIterations)
+    {
+      BenchState st{nIter};
+      f(st);
+      const double elapsed = st.elapsed().count();
+      if (elapsed >= minRunTime_ns) break;
+
+      // aim 20 % above the target time, but grow
+      // by at least 2x and at most 100x per step
+      double factor = (elapsed > 0) ? 1.2 * minRunTime_ns / elapsed : 100.0;
+      factor = std::min(100.0, std::max(2.0, factor));
+      nIter = std::min(MaxIterations, static_cast<size_t>(nIter * factor));
+    }
+
+    for (int i = 0; i < cfg.warmupRuns; ++i)
+    {
+      BenchState st{nIter};
+      f(st);
+    }
+
+    vector<double> samples;
+    uint64_t totalAllocs{0};
+    uint64_t bytesPerOp{0};
+    for (int i = 0; i < cfg.repetitions; ++i)
+    {
+      BenchState st{nIter};
+      f(st);
+      samples.push_back(static_cast<double>(st.elapsed().count()) / nIter);
+      totalAllocs += st.allocations();
+      bytesPerOp = st.bytesPerOperation();
+    }
+
+    BenchResult res = evaluateSamples(std::move(samples), cfg.outlierThreshold);
+    res.suite = suite;
+    res.name = name;
+    res.iterationsPerRun = nIter;
+    if (cfg.repetitions > 0)
+    {
+      res.allocsPerOp = static_cast<double>(totalAllocs) / (static_cast<double>(nIter) * cfg.repetitions);
+    }
+    if ((bytesPerOp > 0) && (res.median_ns > 0))
+    {
+      res.bytesPerSec = bytesPerOp * 1e9 / res.median_ns;
+    }
+
+    return res;
+  }
+
+  //----------------------------------------------------------------------------
+
+  json resultsToJson(const vector<BenchResult>& results, const BenchConfig& cfg)
+  {
+    json ctx;
+
+    char buf[32];
+    time_t now = time(nullptr);
+    struct tm tmUtc;
+    gmtime_r(&now, &tmUtc);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tmUtc);
+    ctx["date"] = string{buf};
+
+#ifdef __VERSION__
+    ctx["compiler"] = string{__VERSION__};
+#endif
+#ifdef __OPTIMIZE__
+    ctx["optimized"] = true;
+#else
+    ctx["optimized"] = false;
+#endif
+    ctx["hardwareThreads"] = thread::hardware_concurrency();
+    ctx["warmupRuns"] = cfg.warmupRuns;
+    ctx["repetitions"] = cfg.repetitions;
+    ctx["minRunTime_ms"] = cfg.minRunTime.count();
+    ctx["outlierThreshold"] = cfg.outlierThreshold;
+
+    json j;
+    j["context"] = ctx;
+    j["benchmarks"] = json::array();
+    for (const auto& r : results) j["benchmarks"].push_back(r.toJson());
+
+    return j;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void printComparison(const json& baseline, const vector<BenchResult>& results)
+  {
+    unordered_map<string, double> oldMedians;
+    if (baseline.contains("benchmarks"))
+    {
+      for (const auto& b : baseline["benchmarks"])
+      {
+        oldMedians[b["suite"].get<string>() + "/" + b["name"].get<string>()] = b["median_ns"].get<double>();
+      }
+    }
+
+    printf("\n%-40s %14s %14s %10s\n", "Benchmark", "old ns/op", "new ns/op", "change %");
+    for (const auto& r : results)
+    {
+      const string fullName = r.suite + "/" + r.name;
+      auto it = oldMedians.find(fullName);
+      if ((it == oldMedians.end()) || (it->second <= 0))
+      {
+        printf("%-40s %14s %14.2f %10s\n", fullName.c_str(), "-", r.median_ns, "-");
+        continue;
+      }
+
+      const double change = 100.0 * (r.median_ns - it->second) / it->second;
+      printf("%-40s %14.2f %14.2f %+10.2f\n", fullName.c_str(), it->second, r.median_ns, change);
+    }
+  }
+
+}
@@ -0,0 +1,233 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSLOPPY_BENCH_HARNESS_H
+#define __LIBSLOPPY_BENCH_HARNESS_H
+
+#include <chrono>      // for steady_clock, nanoseconds
+#include <cstdint>     // for uint64_t
+#include <functional>  // for function
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include "../Sloppy/json.hpp"
+
+namespace Sloppy::Bench
+{
+  /** \returns the number of heap allocations (calls to `operator new`)
+   * that have been made by all threads since program start
+   *
+   * The counter is maintained by the replacement allocation functions
+   * in `Sloppy/AllocTrackerHooks.cpp` which are linked into the benchmark binary.
+   */
+  uint64_t allocationCount();
+
+  /** \brief Prevents the compiler from optimizing away the computation
+   * of a value that is otherwise unused
+   */
+  template<typename T>
+  inline void doNotOptimize(const T& value)
+  {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Settings that control how often and how long each benchmark is executed
+   */
+  struct BenchConfig
+  {
+    int warmupRuns{2};   ///< number of untimed runs before the actual measurement
+    int repetitions{15};   ///< number of timed runs per benchmark
+    std::chrono::milliseconds minRunTime{20};   ///< the iteration count is chosen so that each run takes at least this long
+    double outlierThreshold{3.5};   ///< runs deviating more than this many (scaled) median absolute deviations from the median are rejected
+    std::string filter{};   ///< only benchmarks whose "suite/name" contains this string are executed
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Handed to each benchmark body; executes and times the
+   * operation under test
+   *
+   * A benchmark body performs its (untimed) setup and then calls either
+   * `measure()` with a callable that executes ONE operation or `measureBatch()`
+   * with a callable that executes `iterations()` operations in one go.
+   * Only the time spent inside these calls is measured.
+   */
+  class BenchState
+  {
+  public:
+    explicit BenchState(size_t nIterations)
+      :nIter{nIterations} {}
+
+    /** \returns the number of operations that have to be executed in this run
+     */
+    size_t iterations() const { return nIter; }
+
+    /** \brief Sets the number of bytes processed by a single operation;
+     * used for the bytes/s figure
+     */
+    void setBytesPerOp(uint64_t n) { bytesPerOp = n; }
+
+    /** \brief Executes a callable `iterations()` times and measures the
+     * elapsed time and the number of allocations
+     */
+    template<typename Op>
+    void measure(Op&& op)
+    {
+      startTiming();
+      for (size_t i = 0; i < nIter; ++i) op();
+      stopTiming();
+    }
+
+    /** \brief Calls the provided callable once with `iterations()` as
+     * argument and measures the elapsed time and the number of allocations
+     */
+    template<typename BatchOp>
+    void measureBatch(BatchOp&& op)
+    {
+      startTiming();
+      op(nIter);
+      stopTiming();
+    }
+
+    std::chrono::nanoseconds elapsed() const { return elapsedTime; }
+    uint64_t allocations() const { return nAllocs; }
+    uint64_t bytesPerOperation() const { return bytesPerOp; }
+
+  protected:
+    void startTiming();
+    void stopTiming();
+
+  private:
+    size_t nIter;
+    uint64_t bytesPerOp{0};
+    std::chrono::steady_clock::time_point tStart{};
+    uint64_t allocsAtStart{0};
+    std::chrono::nanoseconds elapsedTime{0};
+    uint64_t nAllocs{0};
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The signature of a benchmark body
+   */
+  using BenchFunc = std::function<void(BenchState&)>;
+
+  /** \brief The aggregated result of all repetitions of one benchmark
+   */
+  struct BenchResult
+  {
+    std::string suite;
+    std::string name;
+    size_t iterationsPerRun{0};
+    int nRuns{0};   ///< number of timed runs
+    int nOutliers{0};   ///< number of rejected runs
+    double median_ns{0};   ///< median time per operation of the accepted runs
+    double mean_ns{0};   ///< mean time per operation of the accepted runs
+    double stddev_ns{0};   ///< standard deviation of the time per operation of the accepted runs
+    double min_ns{0};
+    double max_ns{0};
+    double bytesPerSec{0};   ///< based on the median; zero if the benchmark processes no bytes
+    double allocsPerOp{0};
+
+    /** \returns the result as a JSON object
+     */
+    nlohmann::json toJson() const;
+  };
+
+  /** \brief Calculates the statistics for a set of per-operation timings
+   * with median-absolute-deviation-based outlier rejection
+   *
+   * Only the timing fields of the result (`nRuns`, `nOutliers` and the `*_ns` values)
+   * are set.
+   */
+  BenchResult evaluateSamples(
+      std::vector<double> nsPerOp,   ///< the time per operation for each run
+      double outlierThreshold   ///< rejection threshold in scaled MADs; zero or negative disables rejection
+      );
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A global list of all benchmarks in the binary
+   */
+  class BenchRegistry
+  {
+  public:
+    /** \returns the global registry
+     */
+    static BenchRegistry& instance();
+
+    /** \brief Adds a benchmark to the registry
+     *
+     * \returns always `true` so that the call can be used for initializing static variables
+     */
+    bool add(
+        const std::string& suite,   ///< the group the benchmark belongs to, e.g. "CSV"
+        const std::string& name,   ///< the name of the benchmark within the suite
+        BenchFunc f   ///< the benchmark body
+        );
+
+    /** \brief Executes all benchmarks that match the filter in the
+     * configuration and prints a human-readable summary to stdout
+     *
+     * \returns the results of all executed benchmarks
+     */
+    std::vector<BenchResult> runAll(const BenchConfig& cfg) const;
+
+    /** \brief Executes a single benchmark
+     */
+    static BenchResult run(
+        const std::string& suite,
+        const std::string& name,
+        const BenchFunc& f,
+        const BenchConfig& cfg
+        );
+
+  private:
+    struct Entry
+    {
+      std::string suite;
+      std::string name;
+      BenchFunc f;
+    };
+
+    std::vector<Entry> entries;
+  };
+
+  /** \brief Creates the JSON document for a set of results, including some
+   * context information about the build and the machine
+   */
+  nlohmann::json resultsToJson(const std::vector<BenchResult>& results, const BenchConfig& cfg);
+
+  /** \brief Prints a per-benchmark comparison between a previous run (as JSON, see `resultsToJson()`)
+   * and the current results to stdout
+   */
+  void printComparison(const nlohmann::json& baseline, const std::vector<BenchResult>& results);
+}
+
+/** \brief Defines and registers a benchmark; the body has access to
+ * a `Sloppy::Bench::BenchState& state`
+ */
+#define SLOPPY_BENCHMARK(suite, name) \
+  static void sloppyBench_##suite##_##name(Sloppy::Bench::BenchState& state); \
+  [[maybe_unused]] static const bool sloppyBenchReg_##suite##_##name = \
+    Sloppy::Bench::BenchRegistry::instance().add(#suite, #name, &sloppyBench_##suite##_##name); \
+  static void sloppyBench_##suite##_##name(Sloppy::Bench::BenchState& state)
+
+#endif
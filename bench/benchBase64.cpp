@@ -0,0 +1,76 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>  // for string
+
+#include "../Sloppy/Crypto/Crypto.h"
+#include "../Sloppy/Memory.h"
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy;
+using namespace Sloppy::Bench;
+
+namespace
+{
+  constexpr size_t RawSize = 16 * 1024;
+
+  MemArray makeRawData()
+  {
+    MemArray a{RawSize};
+    for (size_t i = 0; i < RawSize; ++i) a[i] = static_cast<uint8_t>(i * 131 + 7);
+    return a;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Base64, encode)
+{
+  const MemArray raw = makeRawData();
+  state.setBytesPerOp(RawSize);
+  state.measure([&]() {
+    auto enc = Crypto::toBase64(raw.view());
+    doNotOptimize(enc);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Base64, decode)
+{
+  const MemArray raw = makeRawData();
+  const MemArray enc = Crypto::toBase64(raw.view());
+  state.setBytesPerOp(RawSize);
+  state.measure([&]() {
+    auto dec = Crypto::fromBase64(enc.view());
+    doNotOptimize(dec);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Base64, encode_string)
+{
+  const string raw(256, 'x');
+  state.setBytesPerOp(raw.size());
+  state.measure([&]() {
+    auto enc = Crypto::toBase64(raw);
+    doNotOptimize(enc);
+  });
+}
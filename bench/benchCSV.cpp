@@ -0,0 +1,418 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>  // for min
+#include <cstdio>     // for remove
+#include <fstream>    // for ofstream
+#include <sstream>    // for istringstream, ostringstream
+#include <string>     // for string, to_string
+#include <vector>     // for vector
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Columnar.h"
+#include "../Sloppy/CSV_Index.h"
+#include "../Sloppy/CSV_Lazy.h"
+#include "../Sloppy/CSV_Parallel.h"
+#include "../Sloppy/CSV_Query.h"
+#include "../Sloppy/CSV_Scanner.h"
+#include "../Sloppy/CSV_Snapshot.h"
+#include "../Sloppy/CSV_Reader.h"
+#include "../Sloppy/CSV_Writer.h"
+#include "../Sloppy/ConfigFileParser/ConstraintChecker.h"
+#include "../Sloppy/Memory.h"
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy;
+using namespace Sloppy::Bench;
+
+namespace
+{
+  constexpr int nRows = 1000;
+
+  // a table with a header row and columns of all supported data types
+  string makeTableString()
+  {
+    string s{"\"id\",\"name\",\"value\",\"ratio\",\"comment\"\n"};
+    for (int i = 0; i < nRows; ++i)
+    {
+      s += to_string(i);
+      s += ",\"name_" + to_string(i) + "\"";
+      s += "," + to_string(i * 37 - 5000);
+      s += "," + to_string(i / 7.0);
+      s += (i % 10 == 0) ? ",\n" : ",\"some text\\, with a comma\"\n";
+    }
+    return s;
+  }
+
+  // typical fields of a numeric CSV export; most of them numbers
+  const vector<string> numericFields{"42", "-1234567", "3.14159", "-0.000125", "20210315",
+                                     "98.6", "0", "some text", "-17.5", "123456789012"};
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Table_parse)
+{
+  const estring data = makeTableString();
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    CSV_Table t{data, true, CSV_StringRepresentation::QuotedAndEscaped};
+    doNotOptimize(t);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Table_parse_lazy)
+{
+  // same data as in Table_parse; strings remain
+  // views into the input buffer
+  const string data = makeTableString();
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    CSV_LazyTable t{data, true, CSV_StringRepresentation::QuotedAndEscaped};
+    doNotOptimize(t);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Table_parse_large)
+{
+  string data;
+  for (int i = 0; i < 20; ++i) data += makeTableString();
+  const estring eData{data};
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    CSV_Table t{eData, false, CSV_StringRepresentation::QuotedAndEscaped};
+    doNotOptimize(t);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Table_parse_large_parallel)
+{
+  // the same input as Table_parse_large, using all hardware threads
+  string data;
+  for (int i = 0; i < 20; ++i) data += makeTableString();
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    auto t = parseCSVTableParallel(data, false, CSV_StringRepresentation::QuotedAndEscaped);
+    doNotOptimize(t);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Reader_stream)
+{
+  // same data as in Table_parse but row by row
+  // with a bounded buffer instead of a full table
+  const string data = makeTableString();
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    istringstream is{data};
+    CSV_Reader r{is, true, CSV_StringRepresentation::QuotedAndEscaped, 64 * 1024};
+    while (r.next()) doNotOptimize(r.row());
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Index_getLastRow)
+{
+  // random access to the last row of the Table_parse
+  // data; the alternative is to parse the whole table
+  const string csvName{"/tmp/sloppyBenchIndex.csv"};
+  const string idxName{"/tmp/sloppyBenchIndex.idx"};
+  {
+    ofstream f{csvName, ios::binary | ios::trunc};
+    f << makeTableString();
+  }
+  MemFile csvFile{csvName};
+  writeCSVRowIndex(csvFile, idxName, true, CSV_StringRepresentation::QuotedAndEscaped);
+  MemFile idxFile{idxName};
+  CSV_IndexedReader r{csvFile, idxFile};
+
+  state.measure([&]() {
+    auto row = r.getRow(r.size() - 1);
+    doNotOptimize(row);
+  });
+
+  remove(csvName.c_str());
+  remove(idxName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Snapshot_load)
+{
+  // loading the Table_parse data from a binary snapshot
+  // instead of parsing the CSV text
+  const string snapName{"/tmp/sloppyBenchSnapshot.bin"};
+  writeCSVSnapshot(CSV_Table{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped}, snapName);
+  MemFile snapFile{snapName};
+  state.setBytesPerOp(snapFile.size());
+
+  state.measure([&]() {
+    CSV_SnapshotReader r{snapFile};
+    CSV_Table t = r.toTable();
+    doNotOptimize(t);
+  });
+
+  remove(snapName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Snapshot_columnScan)
+{
+  // summing up the "value" column of the Table_parse data
+  // directly in the mapped snapshot file
+  const string snapName{"/tmp/sloppyBenchSnapshot.bin"};
+  writeCSVSnapshot(CSV_Table{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped}, snapName);
+  MemFile snapFile{snapName};
+  CSV_SnapshotReader r{snapFile};
+  state.setBytesPerOp(r.size() * sizeof(int64_t));
+
+  state.measure([&]() {
+    const auto values = r.longData(2);
+    const auto validBits = r.validityBits(2);
+    int64_t sum{0};
+    for (size_t idx = 0; idx < values.size(); ++idx)
+    {
+      if ((validBits.elemAt(idx / 64) >> (idx % 64)) & 1) sum += values.elemAt(idx);
+    }
+    doNotOptimize(sum);
+  });
+
+  remove(snapName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Table_serialize)
+{
+  const estring data = makeTableString();
+  const CSV_Table t{data, true, CSV_StringRepresentation::QuotedAndEscaped};
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    auto s = t.asString(true, CSV_StringRepresentation::QuotedAndEscaped);
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Writer_stream)
+{
+  // same output as Table_serialize but with a bounded,
+  // reused output buffer instead of one big string
+  const estring data = makeTableString();
+  const CSV_Table t{data, true, CSV_StringRepresentation::QuotedAndEscaped};
+  state.setBytesPerOp(data.size());
+  ostringstream os;
+  state.measure([&]() {
+    os.str(string{});
+    CSV_Writer w{os, CSV_StringRepresentation::QuotedAndEscaped, 64 * 1024};
+    w.writeTable(t, true);
+    w.flush();
+    doNotOptimize(os);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, columnSum_rows)
+{
+  const CSV_Table t{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped};
+  state.measure([&]() {
+    double sum{0};
+    for (auto it = t.cbegin(); it != t.cend(); ++it)
+    {
+      const auto& v = it->get(2);
+      if (v.valueType() == CSV_Value::Type::Long) sum += v.get<int64_t>();
+    }
+    doNotOptimize(sum);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, columnSum_columnar)
+{
+  const CSV_ColumnarTable t{CSV_Table{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped}};
+  state.measure([&]() {
+    double sum = t.column(2).sum();
+    doNotOptimize(sum);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Query_filter_rows)
+{
+  const CSV_Table t{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped};
+  state.measure([&]() {
+    vector<size_t> sel;
+    size_t rowIdx{0};
+    for (auto it = t.cbegin(); it != t.cend(); ++it, ++rowIdx)
+    {
+      const auto& v = it->get(2);
+      if ((v.valueType() == CSV_Value::Type::Long) && (v.get<int64_t>() > 10000)) sel.push_back(rowIdx);
+    }
+    doNotOptimize(sel);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Query_filter_columnar)
+{
+  const CSV_ColumnarTable t{CSV_Table{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped}};
+  state.measure([&]() {
+    const auto sel = filterRows(t, 2, CSV_CompareOp::Greater, CSV_Value{int64_t{10000}});
+    doNotOptimize(sel);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Query_sort)
+{
+  const CSV_ColumnarTable t{CSV_Table{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped}};
+  state.measure([&]() {
+    const auto sel = sortRows(t, {{4, true}, {3, false}});
+    doNotOptimize(sel);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Query_groupBy)
+{
+  const CSV_ColumnarTable t{CSV_Table{makeTableString(), true, CSV_StringRepresentation::QuotedAndEscaped}};
+  state.measure([&]() {
+    const auto res = groupBy(t, {4}, {{CSV_AggregateFunction::Sum, 2}, {CSV_AggregateFunction::Mean, 3}});
+    doNotOptimize(res);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, Row_parse)
+{
+  const string line{"42,\"some text\\, with a comma\",-12345,3.14159,,\"plain\""};
+  state.setBytesPerOp(line.size());
+  state.measure([&]() {
+    CSV_Row r{line, CSV_StringRepresentation::QuotedAndEscaped};
+    doNotOptimize(r);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, separatorScan_bytewise)
+{
+  // the byte-by-byte state machine of the former CSV_Row::splitInputInChunks()
+  const string data = makeTableString();
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    size_t nSep{0};
+    char prevChar{0};
+    int quoteCount{0};
+    for (char c : data)
+    {
+      if ((c == '"') && (prevChar != '\\')) ++quoteCount;
+      if ((c == ',') && (quoteCount != 1) && (prevChar != '\\'))
+      {
+        ++nSep;
+        quoteCount = 0;
+      }
+      if (c == '\n') quoteCount = 0;
+      prevChar = c;
+    }
+    doNotOptimize(nSep);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, separatorScan_structural)
+{
+  const string data = makeTableString();
+  state.setBytesPerOp(data.size());
+  state.measure([&]() {
+    CSV_StructuralScanner scanner{CSV_StringRepresentation::QuotedAndEscaped};
+    size_t nSep{0};
+    for (size_t idx = 0; idx < data.size(); idx += CSV_StructuralScanner::BlockSize)
+    {
+      const auto m = scanner.scanBlock(data.data() + idx, std::min(CSV_StructuralScanner::BlockSize, data.size() - idx));
+      nSep += __builtin_popcountll(m.separators);
+    }
+    doNotOptimize(nSep);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, escape_unescape)
+{
+  const string raw{"some \"quoted\" text, with commas, a backslash \\ and\na newline"};
+  state.setBytesPerOp(raw.size());
+  state.measure([&]() {
+    auto s = unescapeStringForCSV(escapeStringForCSV(raw, false));
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, numericField_legacy)
+{
+  // the type detection of CSV_Row before parseNumericCSVField() was introduced
+  state.measure([&]() {
+    for (const auto& f : numericFields)
+    {
+      CSV_Value v;
+      const estring trimmed = estring{f}.trim_copy();
+      if (checkConstraint(trimmed, ValueConstraint::Integer))
+      {
+        v = CSV_Value{static_cast<int64_t>(stol(trimmed))};
+      } else if (checkConstraint(trimmed, ValueConstraint::Numeric)) {
+        v = CSV_Value{stod(trimmed)};
+      }
+      doNotOptimize(v);
+    }
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(CSV, numericField)
+{
+  state.measure([&]() {
+    for (const auto& f : numericFields)
+    {
+      auto v = parseNumericCSVField(trimView(f));
+      doNotOptimize(v);
+    }
+  });
+}
@@ -0,0 +1,122 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>    // for printf, fprintf
+#include <cstdlib>   // for atoi
+#include <fstream>   // for ifstream, ofstream
+#include <iostream>  // for cout
+#include <string>    // for string
+
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy::Bench;
+
+namespace
+{
+  void printUsage(const char* prog)
+  {
+    printf("Usage: %s [options]\n\n", prog);
+    printf("  --filter <str>      only run benchmarks whose \"suite/name\" contains <str>\n");
+    printf("  --reps <n>          number of timed runs per benchmark\n");
+    printf("  --warmup <n>        number of untimed warm-up runs per benchmark\n");
+    printf("  --min-time-ms <n>   minimum duration of each timed run\n");
+    printf("  --json <file>       write the results as JSON to <file> (\"-\" for stdout)\n");
+    printf("  --compare <file>    compare the results with a previous JSON result file\n");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  BenchConfig cfg;
+  string jsonOut;
+  string baselineFile;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const string arg{argv[i]};
+    if ((arg == "--help") || (arg == "-h"))
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+
+    if (i + 1 >= argc)
+    {
+      fprintf(stderr, "Missing value for argument %s\n\n", arg.c_str());
+      printUsage(argv[0]);
+      return 1;
+    }
+    const string val{argv[++i]};
+
+    if (arg == "--filter") cfg.filter = val;
+    else if (arg == "--reps") cfg.repetitions = atoi(val.c_str());
+    else if (arg == "--warmup") cfg.warmupRuns = atoi(val.c_str());
+    else if (arg == "--min-time-ms") cfg.minRunTime = chrono::milliseconds{atoi(val.c_str())};
+    else if (arg == "--json") jsonOut = val;
+    else if (arg == "--compare") baselineFile = val;
+    else
+    {
+      fprintf(stderr, "Unknown argument %s\n\n", arg.c_str());
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (cfg.repetitions < 1)
+  {
+    fprintf(stderr, "At least one repetition is required\n");
+    return 1;
+  }
+
+#ifndef __OPTIMIZE__
+  fprintf(stderr, "WARNING: this binary has been built without optimization; the results are not representative!\n\n");
+#endif
+
+  const auto results = BenchRegistry::instance().runAll(cfg);
+  const auto j = resultsToJson(results, cfg);
+
+  if (jsonOut == "-")
+  {
+    cout << j.dump(2) << endl;
+  } else if (!jsonOut.empty())
+  {
+    ofstream f{jsonOut};
+    f << j.dump(2) << endl;
+    if (!f)
+    {
+      fprintf(stderr, "Could not write results to %s\n", jsonOut.c_str());
+      return 1;
+    }
+  }
+
+  if (!baselineFile.empty())
+  {
+    ifstream f{baselineFile};
+    if (!f)
+    {
+      fprintf(stderr, "Could not open baseline file %s\n", baselineFile.c_str());
+      return 1;
+    }
+    nlohmann::json baseline;
+    f >> baseline;
+    printComparison(baseline, results);
+  }
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>  // for memset
+#include <string>   // for string
+
+#include "../Sloppy/Memory.h"
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy;
+using namespace Sloppy::Bench;
+
+namespace
+{
+  constexpr size_t BufSize = 64 * 1024;
+
+  MemArray makeBuffer()
+  {
+    MemArray a{BufSize};
+    for (size_t i = 0; i < BufSize; ++i) a[i] = static_cast<uint8_t>(i * 31);
+    return a;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Memory, ArrayView_slice)
+{
+  const MemArray a = makeBuffer();
+  const MemView v = a.view();
+  state.measure([&]() {
+    auto s = v.slice_byCount(1000, 4096);
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Memory, ArrayView_iterate)
+{
+  const MemArray a = makeBuffer();
+  const MemView v = a.view();
+  state.setBytesPerOp(BufSize);
+  state.measure([&]() {
+    uint64_t sum{0};
+    for (auto it = v.cbegin(); it != v.cend(); ++it) sum += *it;
+    doNotOptimize(sum);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Memory, MemArray_alloc)
+{
+  state.measure([&]() {
+    MemArray a{4096};
+    doNotOptimize(a);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Memory, MemArray_deepCopy)
+{
+  const MemArray a = makeBuffer();
+  state.setBytesPerOp(BufSize);
+  state.measure([&]() {
+    MemArray b{a.view()};
+    doNotOptimize(b);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(Memory, MemArray_resize)
+{
+  state.measure([&]() {
+    MemArray a{1024};
+    a.resize(8192);
+    a.resize(512);
+    doNotOptimize(a);
+  });
+}
@@ -0,0 +1,175 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>  // for string
+
+#include "../Sloppy/String.h"
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy;
+using namespace Sloppy::Bench;
+
+namespace
+{
+  // a comma-separated line with 64 numeric fields and some whitespace
+  estring makeCsvLine()
+  {
+    estring s;
+    for (int i = 0; i < 64; ++i)
+    {
+      if (i > 0) s += ", ";
+      s += to_string(i * 1000 + 7);
+    }
+    return s;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, split)
+{
+  const estring s = makeCsvLine();
+  state.setBytesPerOp(s.size());
+  state.measure([&]() {
+    auto parts = s.split(",", true, false);
+    doNotOptimize(parts);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, split_trimmed)
+{
+  const estring s = makeCsvLine();
+  state.setBytesPerOp(s.size());
+  state.measure([&]() {
+    auto parts = s.split(",", false, true);
+    doNotOptimize(parts);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, splitView_trimmed)
+{
+  const estring s = makeCsvLine();
+  state.setBytesPerOp(s.size());
+  state.measure([&]() {
+    auto parts = s.splitView(",", false, true);
+    doNotOptimize(parts);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, splitRange_trimmed)
+{
+  const estring s = makeCsvLine();
+  state.setBytesPerOp(s.size());
+  state.measure([&]() {
+    size_t totalLen{0};
+    for (const auto& part : s.splitRange(",", false, true)) totalLen += part.size();
+    doNotOptimize(totalLen);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, trim_copy)
+{
+  const estring s{"   \t  some text with leading and trailing whitespace  \t\n  "};
+  state.setBytesPerOp(s.size());
+  state.measure([&]() {
+    auto t = s.trim_copy();
+    doNotOptimize(t);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, replaceAll)
+{
+  const estring src = makeCsvLine();
+  state.setBytesPerOp(src.size());
+  state.measure([&]() {
+    estring s{src};
+    s.replaceAll(", ", ";");
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, arg)
+{
+  const estring tmpl{"Job %1 finished after %2 cycles with state %3"};
+  state.measure([&]() {
+    estring s{tmpl};
+    s.arg(42);
+    s.arg(123456);
+    s.arg("ok");
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, format)
+{
+  state.measure([&]() {
+    auto s = estring::format("Job %1 finished after %2 cycles with state %3", 42, 123456, "ok");
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, format_precompiled)
+{
+  const FormatString fmt{"Job %1 finished after %2 cycles with state %3"};
+  state.measure([&]() {
+    auto s = fmt.apply(42, 123456, "ok");
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, isInt_isDouble)
+{
+  const estring i{"-1234567890"};
+  const estring d{"-12345.6789"};
+  state.measure([&]() {
+    bool r = i.isInt() && d.isDouble();
+    doNotOptimize(r);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(estring, toLower)
+{
+  const estring src{"The Quick Brown Fox Jumps Over The Lazy Dog, AGAIN AND AGAIN"};
+  state.setBytesPerOp(src.size());
+  state.measure([&]() {
+    estring s{src};
+    s.toLower();
+    doNotOptimize(s);
+  });
+}
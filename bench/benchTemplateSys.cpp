@@ -0,0 +1,131 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <filesystem>  // for path, temp_directory_path, create_directories
+#include <fstream>     // for ofstream
+#include <string>      // for string
+
+#include <unistd.h>    // for getpid
+
+#include "../Sloppy/TemplateProcessor/TemplateSys.h"
+#include "../Sloppy/json.hpp"
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy;
+using namespace Sloppy::Bench;
+using namespace Sloppy::TemplateSystem;
+using json = nlohmann::json;
+
+namespace
+{
+  /** \brief A temporary template store on disk that is removed when the object goes out of scope
+   */
+  class TempTemplateDir
+  {
+  public:
+    TempTemplateDir()
+      :root{filesystem::temp_directory_path() / ("sloppyBench_templates_" + to_string(getpid()))}
+    {
+      filesystem::create_directories(root / "inc");
+
+      writeFile("inc/header.html", "<html><head><title>{{ title }}</title></head><body>\n");
+      writeFile("inc/footer.html", "</body></html>\n");
+      writeFile("page.html",
+                "{{ include /inc/header.html }}"
+                "<h1>{{ title }}</h1>\n"
+                "{{ if showIntro }}<p>{{ intro }}</p>\n{{ endif }}"
+                "<ul>\n"
+                "{{ for item : items }}"
+                "  <li>{{ item.name }}: {{ item.value }}</li>\n"
+                "{{ endfor }}"
+                "</ul>\n"
+                "{{ include /inc/footer.html }}");
+      writeFile("plain.html", "Hello {{ user }}, you have {{ n }} new messages.\n");
+    }
+
+    ~TempTemplateDir()
+    {
+      std::error_code ec;
+      filesystem::remove_all(root, ec);
+    }
+
+    string path() const { return root.string(); }
+
+  protected:
+    void writeFile(const string& relPath, const string& content)
+    {
+      ofstream f{root / relPath};
+      f << content;
+    }
+
+  private:
+    filesystem::path root;
+  };
+
+  json makePageDic(int nItems)
+  {
+    json dic;
+    dic["title"] = "Benchmark page";
+    dic["showIntro"] = true;
+    dic["intro"] = "A page with a list of items";
+
+    json items = json::array();
+    for (int i = 0; i < nItems; ++i)
+    {
+      json item;
+      item["name"] = "item" + to_string(i);
+      item["value"] = i * 3;
+      items.push_back(item);
+    }
+    dic["items"] = items;
+
+    return dic;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(TemplateStore, render_simple)
+{
+  TempTemplateDir dir;
+  TemplateStore ts{dir.path(), {"html"}};
+
+  json dic;
+  dic["user"] = "somebody";
+  dic["n"] = 42;
+
+  state.measure([&]() {
+    auto s = ts.get("plain.html", dic);
+    doNotOptimize(s);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(TemplateStore, render_page)
+{
+  TempTemplateDir dir;
+  TemplateStore ts{dir.path(), {"html"}};
+  const json dic = makePageDic(50);
+
+  state.measure([&]() {
+    auto s = ts.get("page.html", dic);
+    doNotOptimize(s);
+  });
+}
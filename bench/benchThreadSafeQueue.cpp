@@ -0,0 +1,94 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>  // for string
+#include <thread>  // for thread
+
+#include "../Sloppy/ThreadSafeQueue.h"
+#include "BenchHarness.h"
+
+using namespace std;
+using namespace Sloppy;
+using namespace Sloppy::Bench;
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(ThreadSafeQueue, handoff)
+{
+  ThreadSafeQueue<int> q;
+  state.measureBatch([&](size_t n) {
+    thread producer{[&q, n]() {
+      for (size_t i = 0; i < n; ++i) q.put(static_cast<int>(i));
+    }};
+
+    int64_t sum{0};
+    for (size_t i = 0; i < n; ++i) sum += q.get();
+    producer.join();
+    doNotOptimize(sum);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(ThreadSafeQueue, handoff_string)
+{
+  ThreadSafeQueue<string> q;
+  const string payload(100, 'x');
+  state.measureBatch([&](size_t n) {
+    thread producer{[&q, &payload, n]() {
+      for (size_t i = 0; i < n; ++i) q.put(payload);
+    }};
+
+    size_t total{0};
+    for (size_t i = 0; i < n; ++i) total += q.get().size();
+    producer.join();
+    doNotOptimize(total);
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(ThreadSafeQueue, pingPong)
+{
+  ThreadSafeQueue<int> ping;
+  ThreadSafeQueue<int> pong;
+  state.measureBatch([&](size_t n) {
+    thread echo{[&ping, &pong, n]() {
+      for (size_t i = 0; i < n; ++i) pong.put(ping.get());
+    }};
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      ping.put(static_cast<int>(i));
+      pong.get();
+    }
+    echo.join();
+  });
+}
+
+//----------------------------------------------------------------------------
+
+SLOPPY_BENCHMARK(ThreadSafeQueue, putGet_singleThread)
+{
+  ThreadSafeQueue<int> q;
+  state.measure([&]() {
+    q.put(42);
+    int v = q.get();
+    doNotOptimize(v);
+  });
+}
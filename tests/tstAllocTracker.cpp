@@ -0,0 +1,231 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <thread>   // for thread
+#include <vector>   // for vector
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/AllocTracker.h"
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/Memory.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  // enables tracking for the lifetime of the object and
+  // resets all counters upon construction
+  struct TrackingScope
+  {
+    TrackingScope()
+    {
+      AllocTracker::setEnabled(true);
+      AllocTracker::reset();
+    }
+
+    ~TrackingScope()
+    {
+      AllocTracker::setEnabled(false);
+    }
+  };
+
+  // allocations whose result is never used may be elided by
+  // the compiler; publishing the pointer prevents that
+  void* volatile escapedPtr{nullptr};
+
+  template<typename T>
+  T* escape(T* p)
+  {
+    escapedPtr = p;
+    return p;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, HooksInstalled)
+{
+  // the test binary links AllocTrackerHooks.cpp
+  ASSERT_TRUE(AllocTracker::hooksInstalled());
+  ASSERT_TRUE(AllocTracker::hookedAllocationCount() > 0);
+
+  ASSERT_EQ(MemTag::Untagged, AllocTracker::currentTag());
+  ASSERT_STREQ("csv", AllocTracker::tagName(MemTag::CSV));
+  ASSERT_STREQ("logger", AllocTracker::tagName(MemTag::Logger));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, TagAttribution)
+{
+  TrackingScope ts;
+
+  {
+    ScopedAllocTag outer{MemTag::CSV};
+    ASSERT_EQ(MemTag::CSV, AllocTracker::currentTag());
+
+    auto* v = escape(new vector<int>(1000));
+    auto s = AllocTracker::stats(MemTag::CSV);
+    ASSERT_EQ(2, s.nAllocs);   // the vector object and its buffer
+    ASSERT_EQ(sizeof(vector<int>) + 1000 * sizeof(int), s.bytesAllocated);
+    ASSERT_EQ(static_cast<int64_t>(s.bytesAllocated), s.currentBytes);
+
+    {
+      ScopedAllocTag inner{MemTag::Net};
+      ASSERT_EQ(MemTag::Net, AllocTracker::currentTag());
+
+      // releases are attributed to the tag of the allocation,
+      // not to the current tag
+      delete v;
+    }
+    ASSERT_EQ(MemTag::CSV, AllocTracker::currentTag());
+
+    s = AllocTracker::stats(MemTag::CSV);
+    ASSERT_EQ(2, s.nFrees);
+    ASSERT_EQ(0, s.currentBytes);
+    ASSERT_EQ(sizeof(vector<int>) + 1000 * sizeof(int), s.peakBytes);
+    ASSERT_EQ(0, AllocTracker::stats(MemTag::Net).nFrees);
+  }
+  ASSERT_EQ(MemTag::Untagged, AllocTracker::currentTag());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, ManagedArray)
+{
+  TrackingScope ts;
+
+  // untagged array allocations count as "Memory"
+  {
+    MemArray a{4096};
+    auto s = AllocTracker::stats(MemTag::Memory);
+    ASSERT_EQ(1, s.nAllocs);
+    ASSERT_EQ(4096, s.currentBytes);
+
+    a.resize(8192);
+    s = AllocTracker::stats(MemTag::Memory);
+    ASSERT_EQ(2, s.nAllocs);
+    ASSERT_EQ(1, s.nFrees);
+    ASSERT_EQ(8192, s.currentBytes);
+    ASSERT_EQ(4096 + 8192, s.peakBytes);
+  }
+  ASSERT_EQ(0, AllocTracker::stats(MemTag::Memory).currentBytes);
+
+  // within a tagged scope, arrays use the scope's tag
+  {
+    ScopedAllocTag tag{MemTag::Crypto};
+    ManagedArray<uint64_t> a{100};
+    ASSERT_EQ(800, AllocTracker::stats(MemTag::Crypto).currentBytes);
+  }
+  ASSERT_EQ(0, AllocTracker::stats(MemTag::Crypto).currentBytes);
+  ASSERT_EQ(2, AllocTracker::stats(MemTag::Memory).nAllocs);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, EnableDisableIsBalanced)
+{
+  AllocTracker::setEnabled(false);
+  AllocTracker::reset();
+
+  // allocated while disabled, released while enabled
+  auto* p = escape(new char[1000]);
+  {
+    ScopedAllocTag tag{MemTag::Template};
+    AllocTracker::setEnabled(true);
+    delete[] p;
+
+    // allocated while enabled, released while disabled
+    p = escape(new char[500]);
+    AllocTracker::setEnabled(false);
+    delete[] p;
+  }
+
+  const auto s = AllocTracker::stats(MemTag::Template);
+  ASSERT_EQ(1, s.nAllocs);
+  ASSERT_EQ(1, s.nFrees);
+  ASSERT_EQ(500, s.bytesAllocated);
+  ASSERT_EQ(500, s.bytesFreed);
+  ASSERT_EQ(0, s.currentBytes);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, PeakAndTotals)
+{
+  TrackingScope ts;
+
+  ScopedAllocTag tag{MemTag::Logger};
+  auto* p = escape(new char[1 << 20]);
+  delete[] p;
+  auto* q = escape(new char[1000]);
+
+  auto s = AllocTracker::stats(MemTag::Logger);
+  ASSERT_EQ(1 << 20, s.peakBytes);
+  ASSERT_EQ(1000, s.currentBytes);
+
+  AllocTracker::resetPeaks();
+  s = AllocTracker::stats(MemTag::Logger);
+  ASSERT_EQ(1000, s.peakBytes);
+
+  const auto total = AllocTracker::totalStats();
+  ASSERT_TRUE(total.nAllocs >= 2);
+  ASSERT_TRUE(total.bytesAllocated >= (1 << 20) + 1000);
+
+  const auto all = AllocTracker::allStats();
+  ASSERT_EQ(s.nAllocs, all[static_cast<size_t>(MemTag::Logger)].nAllocs);
+
+  delete[] q;
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, TagsArePerThread)
+{
+  TrackingScope ts;
+
+  ScopedAllocTag tag{MemTag::Net};
+  thread t{[]() {
+      // the other thread's tag does not leak into this thread
+      ASSERT_EQ(MemTag::Untagged, AllocTracker::currentTag());
+      ScopedAllocTag innerTag{MemTag::Template};
+      auto* p = escape(new int[10]);
+      delete[] p;
+    }};
+  t.join();
+
+  ASSERT_EQ(MemTag::Net, AllocTracker::currentTag());
+  ASSERT_EQ(1, AllocTracker::stats(MemTag::Template).nAllocs);
+  ASSERT_EQ(40, AllocTracker::stats(MemTag::Template).bytesFreed);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(AllocTracker, Subsystems)
+{
+  TrackingScope ts;
+
+  CSV_Table t{"1,2,3\n4,5,6\n", false, CSV_StringRepresentation::Plain};
+  ASSERT_EQ(2, t.size());
+
+  const auto s = AllocTracker::stats(MemTag::CSV);
+  ASSERT_TRUE(s.nAllocs > 0);
+  ASSERT_TRUE(s.currentBytes > 0);   // the table's rows
+}
@@ -16,8 +16,13 @@
  *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -285,6 +290,46 @@ TEST(Utils, CSV_Row_Ctor)
 
 //----------------------------------------------------------------------------
 
+TEST(Utils, CSV_NumericField)
+{
+  using Type = Sloppy::CSV_Value::Type;
+
+  // integers
+  for (const auto& [s, expected] : std::vector<std::pair<string, int64_t>>{
+         {"0", 0}, {"-0", 0}, {"42", 42}, {"-42", -42}, {"007", 7},
+         {"9223372036854775807", INT64_MAX}, {"-9223372036854775808", INT64_MIN}})
+  {
+    const auto v = Sloppy::parseNumericCSVField(s);
+    ASSERT_EQ(Type::Long, v.valueType());
+    ASSERT_EQ(expected, v.get<int64_t>());
+  }
+
+  // doubles
+  for (const auto& [s, expected] : std::vector<std::pair<string, double>>{
+         {"0.0", 0.0}, {"3.14159", 3.14159}, {"-2.5", -2.5}, {".5", 0.5}, {"-.5", -0.5}, {"5.", 5.0},
+         {"12345678901234567890.0", 12345678901234567890.0}})
+  {
+    const auto v = Sloppy::parseNumericCSVField(s);
+    ASSERT_EQ(Type::Double, v.valueType());
+    ASSERT_EQ(stod(s), v.get<double>());
+    ASSERT_EQ(expected, v.get<double>());
+  }
+
+  // not numeric
+  for (const char* s : {"", "-", ".", "-.", ".-", "--1", "1-", "1.2.3", "1e5", "inf", "nan", "+1", " 1", "1 ", "0x10", "abc"})
+  {
+    ASSERT_FALSE(Sloppy::parseNumericCSVField(s).has_value());
+  }
+
+  // out of range
+  ASSERT_THROW(Sloppy::parseNumericCSVField("9223372036854775808"), std::out_of_range);
+  ASSERT_THROW(Sloppy::parseNumericCSVField("-9223372036854775809"), std::out_of_range);
+  ASSERT_THROW(Sloppy::parseNumericCSVField(string(400, '9') + ".0"), std::out_of_range);
+  ASSERT_THROW(Sloppy::CSV_Row("1,99999999999999999999", Sloppy::CSV_StringRepresentation::Plain), std::out_of_range);
+}
+
+//----------------------------------------------------------------------------
+
 TEST(Utils, CSV_Row_Append)
 {
   using Rep = Sloppy::CSV_StringRepresentation;
@@ -459,6 +504,58 @@ TEST(Utils, CSV_Tab_Headers)
 
 //----------------------------------------------------------------------------
 
+TEST(Utils, CSV_HeaderHelpers)
+{
+  using Rep = Sloppy::CSV_StringRepresentation;
+
+  auto hdr = Sloppy::validateCSVHeaders(Sloppy::CSV_Row{"\" a \",\"b\",42", Rep::QuotedAndEscaped});
+  ASSERT_TRUE(hdr.has_value());
+  ASSERT_EQ(vector<string>({"a", "b", "42"}), *hdr);
+  ASSERT_EQ(1, *Sloppy::findCSVColumn(*hdr, "b"));
+  ASSERT_FALSE(Sloppy::findCSVColumn(*hdr, "B").has_value());
+
+  hdr = Sloppy::validateCSVHeaders(vector<string>{" x", "y "});
+  ASSERT_TRUE(hdr.has_value());
+  ASSERT_EQ(vector<string>({"x", "y"}), *hdr);
+
+  // NULL, empty, duplicate or invalid headers
+  ASSERT_FALSE(Sloppy::validateCSVHeaders(Sloppy::CSV_Row{"a,,b", Rep::Plain}).has_value());
+  ASSERT_FALSE(Sloppy::validateCSVHeaders(vector<string>{"a", "  "}).has_value());
+  ASSERT_FALSE(Sloppy::validateCSVHeaders(vector<string>{"a", "b", " a"}).has_value());
+  ASSERT_FALSE(Sloppy::validateCSVHeaders(vector<string>{"a", "b\"c"}).has_value());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Utils, CSV_Lines)
+{
+  string_view data{"a\r\n\n\r\nb\n\r\rc"};
+  string_view line;
+
+  ASSERT_TRUE(Sloppy::nextCSVLine(data, line));
+  ASSERT_EQ("a", line);
+
+  // empty lines are skipped but lines with only "\r" are not
+  ASSERT_TRUE(Sloppy::nextCSVLine(data, line));
+  ASSERT_EQ("", line);
+  ASSERT_TRUE(Sloppy::nextCSVLine(data, line));
+  ASSERT_EQ("b", line);
+
+  // only one trailing "\r" is removed
+  ASSERT_TRUE(Sloppy::nextCSVLine(data, line));
+  ASSERT_EQ("\r\rc", line);
+  ASSERT_FALSE(Sloppy::nextCSVLine(data, line));
+  ASSERT_TRUE(data.empty());
+
+  // the CSV_Table ctor uses the same rules; a line with only "\r"
+  // is an empty row which doesn't match the column count
+  ASSERT_THROW(Sloppy::CSV_Table("a,b\n\r\n1,2", false, Sloppy::CSV_StringRepresentation::Plain), std::invalid_argument);
+  Sloppy::CSV_Table t{"a,b\n\n1,2\r\n", false, Sloppy::CSV_StringRepresentation::Plain};
+  ASSERT_EQ(2, t.size());
+}
+
+//----------------------------------------------------------------------------
+
 TEST(Utils, CSV_Tab_StringExport)
 {
   using Rep = Sloppy::CSV_StringRepresentation;
@@ -0,0 +1,189 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Columnar.h"
+#include "../Sloppy/CSV_Reader.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  const string tableData{
+    "\"id\",\"name\",\"value\",\"ratio\",\"comment\"\n"
+    "1,\"a\",10,0.5,\n"
+    "2,\"b\",,1.5,\"x\"\n"
+    "3,\"a\",30,2.5,\n"
+    "4,\"c\",40,,42\n"
+  };
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Columnar, Column)
+{
+  CSV_Column c;
+  ASSERT_EQ(CSV_Column::Type::Empty, c.type());
+  ASSERT_EQ(0, c.size());
+
+  // leading NULLs don't determine the type
+  c.append(CSV_Value{});
+  c.append(CSV_Value{});
+  ASSERT_EQ(CSV_Column::Type::Empty, c.type());
+  c.append(CSV_Value{string{"abc"}});
+  c.append(CSV_Value{string{"def"}});
+  c.append(CSV_Value{string{"abc"}});
+  c.append(CSV_Value{});
+  ASSERT_EQ(CSV_Column::Type::String, c.type());
+  ASSERT_EQ(6, c.size());
+  ASSERT_EQ(3, c.nullCount());
+  ASSERT_TRUE(c.isNull(0));
+  ASSERT_FALSE(c.isNull(2));
+  ASSERT_THROW(c.isNull(6), std::out_of_range);
+
+  // dictionary encoding
+  ASSERT_EQ(2, c.dictionarySize());
+  ASSERT_EQ(c.stringCodes()[2], c.stringCodes()[4]);
+  ASSERT_EQ("def", c.dictionaryEntry(c.stringCodes()[3]));
+  ASSERT_EQ(c.stringCodes()[2], *c.findString("abc"));
+  ASSERT_FALSE(c.findString("xyz").has_value());
+  ASSERT_FALSE(c.get(1).has_value());
+  ASSERT_EQ("abc", c.get(4).get<string>());
+  ASSERT_THROW(c.sum(), std::invalid_argument);
+
+  // copies have their own, valid dictionary index
+  CSV_Column c2;
+  {
+    CSV_Column tmp = c;
+    c2 = tmp;
+  }
+  ASSERT_EQ(c.stringCodes()[3], *c2.findString("def"));
+  c2.append(CSV_Value{string{"def"}});
+  ASSERT_EQ(2, c2.dictionarySize());
+
+  // numeric columns
+  CSV_Column l;
+  l.append(CSV_Value{1});
+  l.append(CSV_Value{});
+  l.append(CSV_Value{41});
+  ASSERT_EQ(CSV_Column::Type::Long, l.type());
+  ASSERT_EQ(vector<int64_t>({1, 0, 41}), l.longData());
+  ASSERT_EQ(42.0, l.sum());
+
+  // type conflicts result in a "Mixed" column without loss of data
+  l.append(CSV_Value{0.5});
+  ASSERT_EQ(CSV_Column::Type::Mixed, l.type());
+  ASSERT_TRUE(l.longData().empty());
+  ASSERT_EQ(4, l.size());
+  ASSERT_EQ(41, l.get(2).get<int64_t>());
+  ASSERT_FALSE(l.get(1).has_value());
+  ASSERT_EQ(0.5, l.get(3).get<double>());
+  ASSERT_EQ(42.5, l.sum());
+
+  // many values, across several bitmap words
+  CSV_Column d;
+  for (int i = 0; i < 200; ++i)
+  {
+    if ((i % 3) == 0)
+    {
+      d.append(CSV_Value{});
+    } else {
+      d.append(CSV_Value{i * 1.0});
+    }
+  }
+  ASSERT_EQ(CSV_Column::Type::Double, d.type());
+  ASSERT_EQ(67, d.nullCount());
+  for (int i = 0; i < 200; ++i)
+  {
+    ASSERT_EQ((i % 3) == 0, d.isNull(i));
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Columnar, TableConversion)
+{
+  const CSV_Table t{tableData, true, Rep::Quoted};
+  const CSV_ColumnarTable ct{t};
+
+  ASSERT_EQ(5, ct.nCols());
+  ASSERT_EQ(4, ct.size());
+  ASSERT_TRUE(ct.hasHeaders());
+  ASSERT_EQ("ratio", ct.headers()[3]);
+  ASSERT_EQ(3, *ct.columnIndex("ratio"));
+
+  ASSERT_EQ(CSV_Column::Type::Long, ct.column("id").type());
+  ASSERT_EQ(CSV_Column::Type::String, ct.column("name").type());
+  ASSERT_EQ(3, ct.column("name").dictionarySize());
+  ASSERT_EQ(CSV_Column::Type::Long, ct.column("value").type());
+  ASSERT_EQ(1, ct.column("value").nullCount());
+  ASSERT_EQ(80.0, ct.column(2).sum());
+  ASSERT_EQ(CSV_Column::Type::Double, ct.column("ratio").type());
+  ASSERT_EQ(CSV_Column::Type::Mixed, ct.column("comment").type());
+  ASSERT_THROW(ct.column("xyz"), std::invalid_argument);
+  ASSERT_THROW(ct.column(5), std::out_of_range);
+
+  ASSERT_EQ("c", ct.get(3, 1).get<string>());
+  ASSERT_FALSE(ct.get(1, 2).has_value());
+  ASSERT_THROW(ct.get(4, 0), std::out_of_range);
+  ASSERT_THROW(ct.getRow(4), std::out_of_range);
+
+  // round trip
+  const CSV_Table t2 = ct.toTable();
+  ASSERT_EQ(t.asString(true, Rep::Quoted), t2.asString(true, Rep::Quoted));
+
+  // empty rows are rejected, even as the first row
+  CSV_ColumnarTable ct2;
+  ASSERT_FALSE(ct2.append(CSV_Row{}));
+  ASSERT_EQ(0, ct2.size());
+  ASSERT_EQ(0, ct2.nCols());
+
+  // consistent column count
+  ASSERT_TRUE(ct2.append(t.get(0)));
+  ASSERT_FALSE(ct2.append(CSV_Row{}));
+  CSV_Row shortRow;
+  shortRow.append(1);
+  ASSERT_FALSE(ct2.append(shortRow));
+  ASSERT_EQ(1, ct2.size());
+  ASSERT_FALSE(ct2.setHeader(vector<string>{"a", "b"}));
+  ASSERT_FALSE(ct2.setHeader(vector<string>{"a", "b", "c", "d", "d"}));
+  ASSERT_TRUE(ct2.setHeader(vector<string>{"a", "b", "c", "d", " e "}));
+  ASSERT_EQ("e", ct2.headers()[4]);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Columnar, FromReader)
+{
+  istringstream is{tableData};
+  CSV_Reader r{is, true, Rep::Quoted, 16};
+  const CSV_ColumnarTable ct{r};
+
+  const CSV_Table t{tableData, true, Rep::Quoted};
+  ASSERT_EQ(t.asString(true, Rep::Quoted), ct.toTable().asString(true, Rep::Quoted));
+}
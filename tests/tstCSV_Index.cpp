@@ -0,0 +1,277 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Index.h"
+#include "../Sloppy/Memory.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  void writeFile(const string& fname, const string& content)
+  {
+    ofstream f{fname, ios::binary | ios::trunc};
+    f << content;
+  }
+
+  string readFile(const string& fname)
+  {
+    ifstream f{fname, ios::binary};
+    return string{istreambuf_iterator<char>{f}, istreambuf_iterator<char>{}};
+  }
+
+  // overwrites a header field of an index file
+  void patchIndexField(const string& fname, const string& origContent, size_t fieldIdx, uint64_t val)
+  {
+    string content{origContent};
+    memcpy(content.data() + fieldIdx * sizeof(uint64_t), &val, sizeof(val));
+    writeFile(fname, content);
+  }
+
+  // a table with a string key column that contains escape sequences
+  // and a few empty lines and "\r\n" line breaks in between
+  string makeTestCSV(int nRows)
+  {
+    string s{"\"id\",\"key\",\"value\"\n"};
+    for (int i = 0; i < nRows; ++i)
+    {
+      s += to_string(i) + ",\"k\\," + to_string(i * 7 % nRows) + "\"," + to_string(i / 3.0);
+      s += ((i % 13) == 0) ? "\r\n\n" : "\n";
+    }
+    return s;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Index, RowAccess)
+{
+  const string csvName{"/tmp/sloppyCsvIndexTest.csv"};
+  const string idxName{"/tmp/sloppyCsvIndexTest.idx"};
+  const int nRows = 1000;
+  const string csv = makeTestCSV(nRows);
+  writeFile(csvName, csv);
+  const CSV_Table ref{csv, true, Rep::QuotedAndEscaped};
+
+  for (size_t stride : {1, 7, 256, 5000})
+  {
+    MemFile csvFile{csvName};
+    ASSERT_EQ(nRows, writeCSVRowIndex(csvFile, idxName, true, Rep::QuotedAndEscaped, stride, 1));
+
+    MemFile idxFile{idxName};
+    CSV_IndexedReader r{csvFile, idxFile};
+    ASSERT_EQ(nRows, r.size());
+    ASSERT_TRUE(r.hasHeaders());
+    ASSERT_EQ(vector<string>({"id", "key", "value"}), r.headers());
+    ASSERT_TRUE(r.hasKeyIndex());
+
+    for (size_t rowIdx : {0, 1, 12, 13, 14, 255, 256, 257, 500, 999})
+    {
+      ASSERT_EQ(ref.get(rowIdx).asString(Rep::QuotedAndEscaped), r.getRow(rowIdx).asString(Rep::QuotedAndEscaped));
+    }
+    ASSERT_EQ("13,\"k\\,91\",4.333333", r.rawRow(13).substr(0, 19));
+    ASSERT_THROW(r.getRow(nRows), std::out_of_range);
+
+    // key lookups with unescaped keys
+    for (int rowIdx : {0, 1, 42, 999})
+    {
+      const string key = "k," + to_string(rowIdx * 7 % nRows);
+      ASSERT_EQ(rowIdx, *r.findKey(key));
+      ASSERT_EQ(rowIdx, r.getRowByKey(key)->get(0).get<int64_t>());
+    }
+    ASSERT_FALSE(r.findKey("k\\,0").has_value());
+    ASSERT_FALSE(r.findKey("").has_value());
+    ASSERT_FALSE(r.getRowByKey("zzz").has_value());
+  }
+
+  remove(csvName.c_str());
+  remove(idxName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Index, NumericKeysAndNoHeaders)
+{
+  const string csvName{"/tmp/sloppyCsvIndexTest2.csv"};
+  const string idxName{"/tmp/sloppyCsvIndexTest2.idx"};
+  writeFile(csvName, "5,a\n 3 ,b\n,c\n5,d\n2.50,e");
+
+  MemFile csvFile{csvName};
+  ASSERT_EQ(5, writeCSVRowIndex(csvFile, idxName, false, Rep::Plain, 2, 0));
+  MemFile idxFile{idxName};
+  CSV_IndexedReader r{csvFile, idxFile};
+  ASSERT_FALSE(r.hasHeaders());
+
+  // numbers are stored as they appear in the file; duplicate
+  // keys return the first row; NULL values are not indexed
+  ASSERT_EQ(0, *r.findKey("5"));
+  ASSERT_EQ(1, *r.findKey("3"));
+  ASSERT_EQ(4, *r.findKey("2.50"));
+  ASSERT_FALSE(r.findKey("2.5").has_value());
+  ASSERT_FALSE(r.findKey("").has_value());
+  ASSERT_EQ("e", r.getRow(4).get(1).get<string>());
+  ASSERT_EQ("a", r.getRowByKey("5")->get(1).get<string>());
+
+  // an index without keys
+  ASSERT_EQ(5, writeCSVRowIndex(csvFile, idxName, false, Rep::Plain, 2));
+  MemFile idxFile2{idxName};
+  CSV_IndexedReader r2{csvFile, idxFile2};
+  ASSERT_FALSE(r2.hasKeyIndex());
+  ASSERT_EQ("c", r2.getRow(2).get(1).get<string>());
+  ASSERT_THROW(r2.findKey("5"), std::runtime_error);
+
+  remove(csvName.c_str());
+  remove(idxName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Index, SameLineRulesAsTable)
+{
+  const string csvName{"/tmp/sloppyCsvIndexTest4.csv"};
+  const string idxName{"/tmp/sloppyCsvIndexTest4.idx"};
+
+  // empty lines are skipped; like in CSV_Table, a line
+  // that only contains "\r" is an empty row
+  writeFile(csvName, "a,b\r\n\n1,2\r\n\r\n\n3,4\n");
+
+  MemFile csvFile{csvName};
+  ASSERT_EQ(3, writeCSVRowIndex(csvFile, idxName, true, Rep::Plain, 2));
+  {
+    MemFile idxFile{idxName};
+    CSV_IndexedReader r{csvFile, idxFile};
+    ASSERT_EQ(vector<string>({"a", "b"}), r.headers());
+    ASSERT_EQ("1,2", r.rawRow(0));
+    ASSERT_EQ("", r.rawRow(1));
+    ASSERT_THROW(r.getRow(1), std::invalid_argument);
+    ASSERT_EQ("3,4", r.rawRow(2));
+  }
+
+  // the empty row doesn't contain the key column
+  ASSERT_THROW(writeCSVRowIndex(csvFile, idxName, true, Rep::Plain, 2, 0), std::invalid_argument);
+
+  remove(csvName.c_str());
+  remove(idxName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Index, Errors)
+{
+  const string csvName{"/tmp/sloppyCsvIndexTest3.csv"};
+  const string idxName{"/tmp/sloppyCsvIndexTest3.idx"};
+  writeFile(csvName, "a,b\n1,2\n3\n");
+
+  MemFile csvFile{csvName};
+  ASSERT_THROW(writeCSVRowIndex(csvFile, idxName, true, Rep::Plain, 0), std::invalid_argument);
+  ASSERT_THROW(writeCSVRowIndex(csvFile, idxName, true, Rep::Plain, 1, 2), std::invalid_argument);
+  ASSERT_THROW(writeCSVRowIndex(csvFile, idxName, true, Rep::Plain, 1, 1), std::invalid_argument);
+  ASSERT_THROW(writeCSVRowIndex(csvFile, "/nonexisting/dir/x.idx", true, Rep::Plain), std::runtime_error);
+
+  // without key column, the rows are not validated
+  // until they are accessed
+  ASSERT_EQ(2, writeCSVRowIndex(csvFile, idxName, true, Rep::Plain));
+  {
+    MemFile idxFile{idxName};
+    CSV_IndexedReader r{csvFile, idxFile};
+    ASSERT_EQ(2, r.getRow(0).get(1).get<int64_t>());
+    ASSERT_THROW(r.getRow(1), std::invalid_argument);
+  }
+
+  // the index doesn't match a modified file
+  writeFile(csvName, "a,b\n1,2\n3,4\n");
+  MemFile modified{csvName};
+  {
+    MemFile idxFile{idxName};
+    ASSERT_THROW(CSV_IndexedReader(modified, idxFile), std::invalid_argument);
+  }
+
+  // an invalid index file
+  writeFile(idxName, "this is not an index file, but it is long enough to contain a header");
+  {
+    MemFile idxFile{idxName};
+    ASSERT_THROW(CSV_IndexedReader(modified, idxFile), std::invalid_argument);
+  }
+
+  // invalid escape sequences in the key column
+  writeFile(csvName, "a,b\n1,x\\y\n");
+  {
+    MemFile badKey{csvName};
+    ASSERT_THROW(writeCSVRowIndex(badKey, idxName, true, Rep::Escaped, 1, 1), std::invalid_argument);
+    ASSERT_EQ(1, writeCSVRowIndex(badKey, idxName, true, Rep::Escaped, 1));
+  }
+
+  remove(csvName.c_str());
+  remove(idxName.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Index, CorruptHeader)
+{
+  const string csvName{"/tmp/sloppyCsvIndexTest5.csv"};
+  const string idxName{"/tmp/sloppyCsvIndexTest5.idx"};
+  writeFile(csvName, makeTestCSV(20));
+  MemFile csvFile{csvName};
+  ASSERT_EQ(20, writeCSVRowIndex(csvFile, idxName, true, Rep::QuotedAndEscaped, 4, 1));
+  const string validIndex = readFile(idxName);
+
+  // header fields: magic, CSV size, stride, nRows, nKeys, flags, key column
+  constexpr uint64_t Huge = numeric_limits<uint64_t>::max();
+  const vector<pair<size_t, uint64_t>> corruptions{
+    {2, 0},   // zero stride
+    {3, 1000},   // too many rows for the offset table
+    {3, Huge},   // overflows when rounding up to the next stride
+    {4, 1000},   // too many keys for the key table
+    {4, Huge / 24 + 1},   // overflows when multiplied with the entry size
+    {5, 0x304},   // unknown string representation
+    {5, 0x3ff},
+  };
+  for (const auto& [fieldIdx, val] : corruptions)
+  {
+    patchIndexField(idxName, validIndex, fieldIdx, val);
+    MemFile idxFile{idxName};
+    ASSERT_THROW(CSV_IndexedReader(csvFile, idxFile), std::invalid_argument);
+  }
+
+  // the unmodified index is fine
+  writeFile(idxName, validIndex);
+  {
+    MemFile idxFile{idxName};
+    CSV_IndexedReader r{csvFile, idxFile};
+    ASSERT_EQ(20, r.size());
+  }
+
+  remove(csvName.c_str());
+  remove(idxName.c_str());
+}
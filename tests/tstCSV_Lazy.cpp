@@ -0,0 +1,213 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Lazy.h"
+#include "../Sloppy/Memory.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  // compares a lazy table with a table that
+  // has been parsed with CSV_Table
+  void assertSameContent(const CSV_LazyTable& lt, const CSV_Table& t)
+  {
+    ASSERT_EQ(t.size(), lt.size());
+    ASSERT_EQ(t.nCols(), lt.nCols());
+    for (size_t rowIdx = 0; rowIdx < t.size(); ++rowIdx)
+    {
+      ASSERT_EQ(t.get(rowIdx).asString(Rep::QuotedAndEscaped), lt.getRow(rowIdx).asString(Rep::QuotedAndEscaped));
+    }
+    ASSERT_EQ(t.asString(true, Rep::QuotedAndEscaped), lt.toTable().asString(true, Rep::QuotedAndEscaped));
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Lazy, Basics)
+{
+  const string data{"\"a\",\"b\",\"c\"\r\n1,2.2,\"x\"\n\n,\"\",\"y\\,z\"\n-5,,\"a\\\\b\\n\""};
+  const CSV_LazyTable t{data, true, Rep::QuotedAndEscaped};
+
+  ASSERT_TRUE(t.hasHeaders());
+  ASSERT_EQ(3, t.nCols());
+  ASSERT_EQ(3, t.size());
+  ASSERT_FALSE(t.empty());
+  ASSERT_EQ(vector<string>({"a", "b", "c"}), t.headers());
+  ASSERT_EQ(2, *t.columnIndex("c"));
+  ASSERT_FALSE(t.columnIndex("C").has_value());
+
+  ASSERT_EQ(1, t.get(0, 0).get<int64_t>());
+  ASSERT_EQ(2.2, t.get(0, "b").get<double>());
+  ASSERT_EQ(CSV_LazyValue::Type::String, t.get(0, 2).valueType());
+
+  // strings without escape sequences point directly into the input buffer
+  const auto& x = t.get(0, 2);
+  ASSERT_FALSE(x.needsUnescaping());
+  const string_view xv = x.get<string_view>();
+  ASSERT_EQ("x", xv);
+  ASSERT_TRUE((xv.data() > data.data()) && (xv.data() < data.data() + data.size()));
+
+  ASSERT_FALSE(t.get(1, 0).has_value());
+  ASSERT_EQ(CSV_LazyValue::Type::Null, t.get(1, 0).valueType());
+  ASSERT_THROW(t.get(1, 0).get<int64_t>(), std::bad_optional_access);
+  ASSERT_TRUE(t.get(1, 1).has_value());
+  ASSERT_EQ("", t.get(1, 1).get<string_view>());
+
+  // escaped strings are resolved on access
+  const auto& yz = t.get(1, 2);
+  ASSERT_TRUE(yz.needsUnescaping());
+  ASSERT_EQ("y\\,z", yz.rawView());
+  ASSERT_EQ("y,z", yz.get<string_view>());
+  ASSERT_EQ(yz.get<string_view>().data(), yz.get<string_view>().data());   // cached
+  ASSERT_EQ("a\\b\n", t.get(2, 2).get<string_view>());
+
+  // copies are independent of the original's cache
+  CSV_LazyValue cpy{yz};
+  ASSERT_EQ("y,z", cpy.get<string_view>());
+  ASSERT_NE(cpy.get<string_view>().data(), yz.get<string_view>().data());
+  cpy = t.get(0, 0);
+  ASSERT_EQ(1, cpy.get<int64_t>());
+
+  ASSERT_THROW(t.get(0, 0).get<double>(), std::bad_variant_access);
+  ASSERT_THROW(t.get(0, 0).rawView(), std::bad_variant_access);
+  ASSERT_THROW(t.get(3, 0), std::out_of_range);
+  ASSERT_THROW(t.get(0, 3), std::out_of_range);
+  ASSERT_THROW(t.get(0, "xyz"), std::invalid_argument);
+  ASSERT_THROW(t.getRow(3), std::out_of_range);
+
+  ASSERT_EQ("\"y,z\"", t.get(1, 2).toValue().asString(Rep::Quoted));
+  ASSERT_FALSE(t.get(1, 0).toValue().has_value());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Lazy, Errors)
+{
+  ASSERT_THROW(CSV_LazyTable(string_view{"a,a\n1,2\n"}, true, Rep::Plain), std::invalid_argument);
+  ASSERT_THROW(CSV_LazyTable(string_view{"1,2\n3\n"}, false, Rep::Plain), std::invalid_argument);
+  ASSERT_THROW(CSV_LazyTable(string_view{"a,b\n1,2,3\n"}, true, Rep::Plain), std::invalid_argument);
+  ASSERT_THROW(CSV_LazyTable(string_view{"1,abc\n"}, false, Rep::Quoted), std::invalid_argument);
+  ASSERT_THROW(CSV_LazyTable(string_view{"1,\"abc\\\"\n"}, false, Rep::QuotedAndEscaped), std::invalid_argument);
+
+  // invalid escaped content is rejected during parsing, not on access
+  for (const string& invalidData : {"1,\"a,b\"\n", "1,\"a\\x,b\"\n", "1,\"a\\x\"\n", "1,\"a\\\\,b\"\n"})
+  {
+    ASSERT_THROW(CSV_Table(invalidData, false, Rep::QuotedAndEscaped), std::invalid_argument);
+    ASSERT_THROW(CSV_LazyTable(invalidData, false, Rep::QuotedAndEscaped), std::invalid_argument);
+  }
+
+  // like in CSV_Table, a line that only contains "\r" is an empty row
+  ASSERT_THROW(CSV_LazyTable(string_view{"1,2\n\r\n3,4\n"}, false, Rep::Plain), std::invalid_argument);
+
+  const CSV_LazyTable empty{string_view{}, true, Rep::Plain};
+  ASSERT_TRUE(empty.empty());
+  ASSERT_FALSE(empty.hasHeaders());
+  ASSERT_EQ(0, empty.nCols());
+
+  // headers only
+  const CSV_LazyTable hdrOnly{string_view{"a,b\n"}, true, Rep::Plain};
+  ASSERT_TRUE(hdrOnly.empty());
+  ASSERT_EQ(2, hdrOnly.nCols());
+
+  MemFile invalid;
+  ASSERT_THROW(CSV_LazyTable(invalid, false, Rep::Plain), std::invalid_argument);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Lazy, SameAsTable)
+{
+  for (Rep rep : {Rep::Plain, Rep::Quoted, Rep::Escaped, Rep::QuotedAndEscaped})
+  {
+    const bool usesEscaping = ((rep == Rep::Escaped) || (rep == Rep::QuotedAndEscaped));
+    const bool usesQuotes = ((rep == Rep::Quoted) || (rep == Rep::QuotedAndEscaped));
+
+    CSV_Table src;
+    for (int i = 0; i < 50; ++i)
+    {
+      CSV_Row row;
+      row.append(i);
+      row.append(string{usesEscaping ? "name, \"no.\" " : "name no. "} + to_string(i));
+      row.append(i / 4.0);
+      if (usesQuotes && ((i % 5) == 0)) row.append();
+      else row.append(string{"  "});
+      ASSERT_TRUE(src.append(row));
+    }
+    ASSERT_TRUE(src.setHeader(vector<string>{"id", "name", "value", "other"}));
+
+    const string csv = src.asString(true, rep);
+    const CSV_Table ref{csv, true, rep};
+    const CSV_LazyTable lt{csv, true, rep};
+    assertSameContent(lt, ref);
+  }
+
+  // both tables agree on which escaped input is valid
+  const vector<pair<string, bool>> escapedInput{
+    {"1,\"a,b\"\n", false},
+    {"1,\"a\\x,b\"\n", false},
+    {"1,\"a\\\\,b\"\n", false},
+    {"1,\"a\\,b\"\n", true},
+    {"1,\"a\\\\b\\\"c\"\n", true},
+  };
+  for (const auto& [data, isValid] : escapedInput)
+  {
+    if (!isValid)
+    {
+      ASSERT_THROW(CSV_Table(data, false, Rep::QuotedAndEscaped), std::invalid_argument);
+      ASSERT_THROW(CSV_LazyTable(data, false, Rep::QuotedAndEscaped), std::invalid_argument);
+      continue;
+    }
+
+    const CSV_Table ref{data, false, Rep::QuotedAndEscaped};
+    const CSV_LazyTable lt{data, false, Rep::QuotedAndEscaped};
+    assertSameContent(lt, ref);
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Lazy, MemFile)
+{
+  const string fname{"../tests/date_time_zonespec.csv"};
+
+  ifstream f{fname};
+  ASSERT_TRUE(f.is_open());
+  stringstream ss;
+  ss << f.rdbuf();
+  const CSV_Table ref{ss.str(), true, Rep::Quoted};
+
+  MemFile mf{fname};
+  const CSV_LazyTable lt{mf, true, Rep::Quoted};
+  ASSERT_EQ(11, lt.nCols());
+  ASSERT_EQ("STD ABBR", lt.headers()[1]);
+  assertSameContent(lt, ref);
+}
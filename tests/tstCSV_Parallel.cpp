@@ -0,0 +1,161 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Parallel.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  // a table that is large enough to be split into several chunks
+  string makeTableString(int nRows)
+  {
+    string s{"\"id\",\"name\",\"value\"\r\n"};
+    for (int i = 0; i < nRows; ++i)
+    {
+      s += to_string(i) + ",\"name\\, no. " + to_string(i) + "\"," + to_string(i / 8.0);
+      s += ((i % 100) == 0) ? "\n\n" : "\n";
+    }
+    return s;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Parallel, Chunking)
+{
+  ASSERT_TRUE(splitCSVAtRowBoundaries("", 4).empty());
+
+  const string data = makeTableString(1000);
+  for (size_t n : {1, 2, 3, 7, 64, 100000})
+  {
+    const auto chunks = splitCSVAtRowBoundaries(data, n);
+    ASSERT_TRUE(chunks.size() <= n);
+
+    // the chunks cover the input without gaps and
+    // all but the last chunk end with a newline
+    string joined;
+    for (size_t idx = 0; idx < chunks.size(); ++idx)
+    {
+      ASSERT_FALSE(chunks[idx].empty());
+      if (idx < (chunks.size() - 1)) ASSERT_EQ('\n', chunks[idx].back());
+      joined += chunks[idx];
+    }
+    ASSERT_EQ(data, joined);
+  }
+
+  // no newline at all
+  const auto chunks = splitCSVAtRowBoundaries("1,2,3", 4);
+  ASSERT_EQ(1, chunks.size());
+  ASSERT_EQ("1,2,3", chunks[0]);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Parallel, SameResultAsSequential)
+{
+  const string data = makeTableString(50000);
+  ASSERT_TRUE(data.size() > 4 * MinParallelCSVChunkSize);
+
+  const CSV_Table ref{data, true, Rep::QuotedAndEscaped};
+  const string refString = ref.asString(true, Rep::QuotedAndEscaped);
+
+  for (size_t nThreads : {0, 1, 2, 3, 8})
+  {
+    const CSV_Table t = parseCSVTableParallel(data, true, Rep::QuotedAndEscaped, nThreads);
+    ASSERT_EQ(ref.size(), t.size());
+    ASSERT_EQ("value", t.getHeader(2));
+    ASSERT_EQ(refString, t.asString(true, Rep::QuotedAndEscaped));
+  }
+
+  // no headers
+  const CSV_Table t = parseCSVTableParallel(data, false, Rep::QuotedAndEscaped, 4);
+  ASSERT_FALSE(t.hasHeaders());
+  ASSERT_EQ(ref.size() + 1, t.size());
+
+  // empty input and header-only input
+  ASSERT_TRUE(parseCSVTableParallel("", true, Rep::Plain).empty());
+  const CSV_Table hdrOnly = parseCSVTableParallel("\n\na,b\n\n", true, Rep::Plain);
+  ASSERT_TRUE(hdrOnly.empty());
+  ASSERT_EQ(2, hdrOnly.nCols());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Parallel, Errors)
+{
+  string data = makeTableString(50000);
+
+  // invalid headers
+  ASSERT_THROW(parseCSVTableParallel("a,a\n1,2\n", true, Rep::Plain), std::invalid_argument);
+
+  // a malformed row near the end of the input
+  string badRow = data + "1,\"abc,2\n";
+  ASSERT_THROW(parseCSVTableParallel(badRow, true, Rep::QuotedAndEscaped, 4), std::invalid_argument);
+
+  // inconsistent column count in the middle of the input
+  string badCount = data;
+  badCount.insert(badCount.size() / 2, "\n1,2\n");
+  ASSERT_THROW(parseCSVTableParallel(badCount, true, Rep::QuotedAndEscaped, 4), std::invalid_argument);
+
+  // like in CSV_Table, a line that only contains "\r" is an empty row
+  string crLine = data;
+  crLine.insert(crLine.find('\n', crLine.size() / 2) + 1, "\r\n");
+  ASSERT_THROW(parseCSVTableParallel(crLine, true, Rep::QuotedAndEscaped, 4), std::invalid_argument);
+
+  // a row with a numeric overflow; this error type must
+  // be propagated from the worker threads as well
+  string overflow = data + "1,\"x\",99999999999999999999\n";
+  ASSERT_THROW(parseCSVTableParallel(overflow, true, Rep::QuotedAndEscaped, 4), std::out_of_range);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Parallel, TaskRunner)
+{
+  for (size_t nThreads : {0, 1, 3, 16})
+  {
+    vector<int> done(10, 0);
+    runParallelCSVTasks(done.size(), nThreads, ThreadConfig{}, [&](size_t idx) { ++done[idx]; });
+    ASSERT_EQ(vector<int>(10, 1), done);
+  }
+
+  // all tasks are executed and the error of
+  // the task with the lowest index is rethrown
+  atomic<int> nCalls{0};
+  auto failingTask = [&](size_t idx)
+  {
+    ++nCalls;
+    if (idx == 7) throw std::out_of_range("7");
+    if (idx == 5) throw std::invalid_argument("5");
+  };
+  ASSERT_THROW(runParallelCSVTasks(10, 4, ThreadConfig{}, failingTask), std::invalid_argument);
+  ASSERT_EQ(10, nCalls);
+}
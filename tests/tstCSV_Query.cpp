@@ -0,0 +1,402 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Columnar.h"
+#include "../Sloppy/CSV_Query.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  // columns: id (int), cat (string, some NULL), val (double, some NULL), mix (int or string)
+  CSV_ColumnarTable makeQueryTable(int nRows)
+  {
+    CSV_ColumnarTable tab;
+    EXPECT_TRUE(tab.setHeader({"id", "cat", "val", "mix"}));
+
+    for (int i = 0; i < nRows; ++i)
+    {
+      CSV_Row r;
+      r.append(int64_t{(i * 7919) % 1000});
+      if ((i % 13) == 0) r.append(); else r.append("c" + to_string(i % 10));
+      if ((i % 17) == 0) r.append(); else r.append((i % 23) / 4.0 - 2.0);
+      if ((i % 3) == 0) r.append("m" + to_string(i % 5)); else r.append(int64_t{i % 7});
+      EXPECT_TRUE(tab.append(r));
+    }
+
+    return tab;
+  }
+
+  CSV_Selection bruteForceFilter(const CSV_ColumnarTable& tab, CSV_ColumnarTable::ColumnIndexType colIdx, CSV_CompareOp op, const CSV_Value& operand)
+  {
+    CSV_Selection result;
+    for (size_t row = 0; row < tab.size(); ++row)
+    {
+      const CSV_Value v = tab.get(row, colIdx);
+      if (!v.has_value()) continue;
+
+      const int c = compareCSVValues(v, operand);
+      bool isMatch{false};
+      switch (op)
+      {
+      case CSV_CompareOp::Equal: isMatch = (c == 0); break;
+      case CSV_CompareOp::NotEqual: isMatch = (c != 0); break;
+      case CSV_CompareOp::Less: isMatch = (c < 0); break;
+      case CSV_CompareOp::LessOrEqual: isMatch = (c <= 0); break;
+      case CSV_CompareOp::Greater: isMatch = (c > 0); break;
+      case CSV_CompareOp::GreaterOrEqual: isMatch = (c >= 0); break;
+      }
+      if (isMatch) result.push_back(row);
+    }
+    return result;
+  }
+
+  bool isSameValue(const CSV_Value& a, const CSV_Value& b)
+  {
+    return (a.valueType() == b.valueType()) && (compareCSVValues(a, b) == 0);
+  }
+
+  const vector<CSV_CompareOp> allOps{
+    CSV_CompareOp::Equal, CSV_CompareOp::NotEqual, CSV_CompareOp::Less,
+    CSV_CompareOp::LessOrEqual, CSV_CompareOp::Greater, CSV_CompareOp::GreaterOrEqual
+  };
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Query, CompareValues)
+{
+  ASSERT_EQ(0, compareCSVValues(CSV_Value{}, CSV_Value{}));
+  ASSERT_TRUE(compareCSVValues(CSV_Value{}, CSV_Value{int64_t{-100}}) < 0);
+  ASSERT_TRUE(compareCSVValues(CSV_Value{int64_t{100}}, CSV_Value{"0"}) < 0);
+  ASSERT_TRUE(compareCSVValues(CSV_Value{"b"}, CSV_Value{"a"}) > 0);
+  ASSERT_EQ(0, compareCSVValues(CSV_Value{int64_t{2}}, CSV_Value{2.0}));
+  ASSERT_TRUE(compareCSVValues(CSV_Value{int64_t{2}}, CSV_Value{2.5}) < 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Query, Filter)
+{
+  const auto tab = makeQueryTable(140000);
+
+  const vector<pair<CSV_ColumnarTable::ColumnIndexType, CSV_Value>> conditions{
+    {0, CSV_Value{int64_t{500}}},
+    {0, CSV_Value{499.5}},
+    {0, CSV_Value{"abc"}},
+    {1, CSV_Value{"c4"}},
+    {1, CSV_Value{"zzz"}},
+    {1, CSV_Value{int64_t{3}}},
+    {2, CSV_Value{0.25}},
+    {2, CSV_Value{int64_t{1}}},
+    {3, CSV_Value{int64_t{3}}},
+    {3, CSV_Value{"m2"}},
+  };
+
+  for (const auto& [colIdx, operand] : conditions)
+  {
+    for (auto op : allOps)
+    {
+      const auto expected = bruteForceFilter(tab, colIdx, op, operand);
+      ASSERT_EQ(expected, filterRows(tab, colIdx, op, operand, 1));
+      ASSERT_EQ(expected, filterRows(tab, colIdx, op, operand, 4));
+    }
+  }
+
+  // refinement of an existing selection
+  const auto sel = filterRows(tab, 1, CSV_CompareOp::Equal, CSV_Value{"c4"}, 4);
+  const auto refined = filterRows(tab, sel, 2, CSV_CompareOp::Greater, CSV_Value{0.0}, 4);
+  CSV_Selection expected;
+  for (auto row : sel)
+  {
+    const CSV_Value v = tab.get(row, 2);
+    if (v.has_value() && (v.get<double>() > 0)) expected.push_back(row);
+  }
+  ASSERT_FALSE(expected.empty());
+  ASSERT_EQ(expected, refined);
+
+  // copy the selected rows
+  const auto sub = selectRows(tab, refined);
+  ASSERT_EQ(tab.headers(), sub.headers());
+  ASSERT_EQ(refined.size(), sub.size());
+  ASSERT_EQ(tab.getRow(refined.back()).asString(CSV_StringRepresentation::Plain), sub.getRow(sub.size() - 1).asString(CSV_StringRepresentation::Plain));
+
+  // invalid arguments
+  ASSERT_THROW(filterRows(tab, 1, CSV_CompareOp::Equal, CSV_Value{}), std::invalid_argument);
+  ASSERT_THROW(filterRows(tab, 4, CSV_CompareOp::Equal, CSV_Value{"x"}), std::out_of_range);
+  ASSERT_THROW(filterRows(tab, CSV_Selection{tab.size()}, 1, CSV_CompareOp::Equal, CSV_Value{"x"}), std::out_of_range);
+  ASSERT_THROW(selectRows(tab, CSV_Selection{tab.size()}), std::out_of_range);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Query, Sort)
+{
+  const auto tab = makeQueryTable(140000);
+
+  const vector<vector<CSV_SortKey>> sortOrders{
+    {{0, true}},
+    {{2, false}},
+    {{1, true}, {0, false}},
+    {{3, true}},
+    {{1, false}, {2, true}},
+  };
+
+  for (const auto& keys : sortOrders)
+  {
+    // brute force: stable sort with compareCSVValues()
+    CSV_Selection expected(tab.size());
+    for (size_t i = 0; i < expected.size(); ++i) expected[i] = i;
+    stable_sort(expected.begin(), expected.end(), [&](size_t a, size_t b)
+    {
+      for (const auto& k : keys)
+      {
+        int c = compareCSVValues(tab.get(a, k.colIdx), tab.get(b, k.colIdx));
+        if (!k.ascending)
+        {
+          // descending with NULLs last
+          c = -c;
+        }
+        if (c != 0) return c < 0;
+      }
+      return false;
+    });
+
+    ASSERT_EQ(expected, sortRows(tab, keys, 1));
+    ASSERT_EQ(expected, sortRows(tab, keys, 4));
+  }
+
+  // sort a selection
+  const auto sel = filterRows(tab, 1, CSV_CompareOp::Equal, CSV_Value{"c7"});
+  const auto sorted = sortRows(tab, sel, {{2, true}}, 4);
+  ASSERT_EQ(sel.size(), sorted.size());
+  for (size_t i = 1; i < sorted.size(); ++i)
+  {
+    ASSERT_TRUE(compareCSVValues(tab.get(sorted[i - 1], 2), tab.get(sorted[i], 2)) <= 0);
+    if (compareCSVValues(tab.get(sorted[i - 1], 2), tab.get(sorted[i], 2)) == 0)
+    {
+      ASSERT_TRUE(sorted[i - 1] < sorted[i]);
+    }
+  }
+
+  ASSERT_THROW(sortRows(tab, {}), std::invalid_argument);
+  ASSERT_THROW(sortRows(tab, {{4, true}}), std::out_of_range);
+  ASSERT_THROW(sortRows(tab, CSV_Selection{tab.size()}, {{0, true}}), std::out_of_range);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Query, GroupBy)
+{
+  const auto tab = makeQueryTable(140000);
+
+  const vector<CSV_Aggregate> aggs{
+    {CSV_AggregateFunction::Count, 2},
+    {CSV_AggregateFunction::Sum, 2},
+    {CSV_AggregateFunction::Mean, 2},
+    {CSV_AggregateFunction::Min, 2},
+    {CSV_AggregateFunction::Max, 0},
+    {CSV_AggregateFunction::Sum, 0},
+    {CSV_AggregateFunction::Sum, 3},
+    {CSV_AggregateFunction::Max, 3},
+  };
+
+  // brute force
+  struct Expected
+  {
+    int64_t cnt{0};
+    double sum{0};
+    double minVal{1e9};
+    int64_t maxId{-1};
+    int64_t idSum{0};
+    double mixSum{0};
+    string maxMix;
+  };
+  map<string, Expected> expected;
+  vector<string> order;
+  for (size_t row = 0; row < tab.size(); ++row)
+  {
+    const CSV_Value cat = tab.get(row, 1);
+    const string key = cat.has_value() ? cat.get<string>() : "<NULL>";
+    if (expected.find(key) == expected.end()) order.push_back(key);
+    auto& e = expected[key];
+
+    const CSV_Value v = tab.get(row, 2);
+    if (v.has_value())
+    {
+      ++e.cnt;
+      e.sum += v.get<double>();
+      e.minVal = std::min(e.minVal, v.get<double>());
+    }
+    e.maxId = std::max(e.maxId, tab.get(row, 0).get<int64_t>());
+    e.idSum += tab.get(row, 0).get<int64_t>();
+
+    const CSV_Value m = tab.get(row, 3);
+    if (m.valueType() == CSV_Value::Type::Long) e.mixSum += m.get<int64_t>();
+    else e.maxMix = std::max(e.maxMix, m.get<string>());
+  }
+
+  for (size_t nThreads : {1, 4})
+  {
+    const auto res = groupBy(tab, {1}, aggs, nThreads);
+    ASSERT_EQ(order.size(), res.size());
+    ASSERT_EQ(9, res.nCols());
+    ASSERT_EQ("count(val)", res.headers()[1]);
+    ASSERT_EQ("sum(val)", res.headers()[2]);
+    ASSERT_EQ("max(mix)", res.headers()[8]);
+
+    for (size_t g = 0; g < order.size(); ++g)
+    {
+      const auto& e = expected[order[g]];
+      const CSV_Value key = res.get(g, 0);
+      ASSERT_EQ(order[g], key.has_value() ? key.get<string>() : "<NULL>");
+      ASSERT_EQ(e.cnt, res.get(g, 1).get<int64_t>());
+      ASSERT_NEAR(e.sum, res.get(g, 2).get<double>(), 1e-6);
+      ASSERT_NEAR(e.sum / e.cnt, res.get(g, 3).get<double>(), 1e-9);
+      ASSERT_EQ(e.minVal, res.get(g, 4).get<double>());
+      ASSERT_EQ(e.maxId, res.get(g, 5).get<int64_t>());
+      ASSERT_EQ(e.idSum, res.get(g, 6).get<int64_t>());
+      ASSERT_NEAR(e.mixSum, res.get(g, 7).get<double>(), 1e-6);
+      ASSERT_EQ(e.maxMix, res.get(g, 8).get<string>());   // strings are larger than numbers
+    }
+  }
+
+  // multiple keys
+  const auto res = groupBy(tab, {1, 3}, {{CSV_AggregateFunction::Count, 0}}, 4);
+  int64_t total{0};
+  for (size_t g = 0; g < res.size(); ++g) total += res.get(g, 2).get<int64_t>();
+  ASSERT_EQ(static_cast<int64_t>(tab.size()), total);
+  ASSERT_EQ("count(id)", res.headers()[2]);
+
+  // only NULL values in a group
+  CSV_ColumnarTable small;
+  CSV_Row r;
+  r.append("a");
+  r.append();
+  ASSERT_TRUE(small.append(r));
+  const auto smallRes = groupBy(small, {0}, {{CSV_AggregateFunction::Count, 1}, {CSV_AggregateFunction::Sum, 1}, {CSV_AggregateFunction::Min, 1}});
+  ASSERT_FALSE(smallRes.hasHeaders());
+  ASSERT_EQ(1, smallRes.size());
+  ASSERT_EQ(0, smallRes.get(0, 1).get<int64_t>());
+  ASSERT_FALSE(smallRes.get(0, 2).has_value());
+  ASSERT_FALSE(smallRes.get(0, 3).has_value());
+
+  // integer sums that exceed the range of int64_t become double
+  CSV_ColumnarTable big;
+  for (int64_t v : {numeric_limits<int64_t>::max(), int64_t{1}, numeric_limits<int64_t>::max()})
+  {
+    r = CSV_Row{};
+    r.append("a");
+    r.append(CSV_Value{v});
+    ASSERT_TRUE(big.append(r));
+    r = CSV_Row{};
+    r.append("b");
+    r.append(CSV_Value{-v});
+    ASSERT_TRUE(big.append(r));
+  }
+  const auto bigRes = groupBy(big, {0}, {{CSV_AggregateFunction::Sum, 1}, {CSV_AggregateFunction::Mean, 1}});
+  ASSERT_EQ(CSV_Value::Type::Double, bigRes.get(0, 1).valueType());
+  ASSERT_DOUBLE_EQ(2.0 * numeric_limits<int64_t>::max() + 1, bigRes.get(0, 1).get<double>());
+  ASSERT_DOUBLE_EQ((2.0 * numeric_limits<int64_t>::max() + 1) / 3, bigRes.get(0, 2).get<double>());
+  ASSERT_DOUBLE_EQ(-2.0 * numeric_limits<int64_t>::max() - 1, bigRes.get(1, 1).get<double>());
+
+  ASSERT_THROW(groupBy(tab, {}, aggs), std::invalid_argument);
+  ASSERT_THROW(groupBy(tab, {0}, {{CSV_AggregateFunction::Sum, 1}}), std::invalid_argument);
+  ASSERT_THROW(groupBy(tab, {0}, {{CSV_AggregateFunction::Count, 1}, {CSV_AggregateFunction::Count, 1}}), std::invalid_argument);
+  ASSERT_THROW(groupBy(tab, {4}, aggs), std::out_of_range);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Query, HashJoin)
+{
+  const auto left = makeQueryTable(140000);
+
+  // right table: id (int, with duplicates), cat (string), label
+  CSV_ColumnarTable right;
+  for (int i = 0; i < 300; ++i)
+  {
+    CSV_Row r;
+    r.append(int64_t{(i % 150) * 5});
+    if ((i % 50) == 0) r.append(); else r.append("c" + to_string(i % 10));
+    r.append("label " + to_string(i));
+    ASSERT_TRUE(right.append(r));
+  }
+
+  for (const auto& [lKeys, rKeys] : vector<pair<vector<CSV_ColumnarTable::ColumnIndexType>, vector<CSV_ColumnarTable::ColumnIndexType>>>{
+         {{0}, {0}},
+         {{1}, {1}},
+         {{0, 1}, {0, 1}},
+         {{3}, {0}},
+         {{2}, {0}},   // double vs. int never matches
+       })
+  {
+    // brute force
+    CSV_JoinResult expected;
+    for (size_t l = 0; l < left.size(); ++l)
+    {
+      for (size_t r = 0; r < right.size(); ++r)
+      {
+        bool isMatch{true};
+        for (size_t k = 0; k < lKeys.size(); ++k)
+        {
+          const CSV_Value lv = left.get(l, lKeys[k]);
+          const CSV_Value rv = right.get(r, rKeys[k]);
+          if (!lv.has_value() || !rv.has_value() || !isSameValue(lv, rv))
+          {
+            isMatch = false;
+            break;
+          }
+        }
+        if (!isMatch) continue;
+        expected.leftRows.push_back(l);
+        expected.rightRows.push_back(r);
+      }
+      if (l == 5000) break;   // limit the brute-force effort
+    }
+
+    for (size_t nThreads : {1, 4})
+    {
+      auto res = hashJoin(left, lKeys, right, rKeys, nThreads);
+      ASSERT_EQ(res.leftRows.size(), res.rightRows.size());
+
+      // compare the part that has been checked by brute force
+      const auto cut = lower_bound(res.leftRows.begin(), res.leftRows.end(), 5001) - res.leftRows.begin();
+      res.leftRows.resize(cut);
+      res.rightRows.resize(cut);
+      ASSERT_EQ(expected.leftRows, res.leftRows);
+      ASSERT_EQ(expected.rightRows, res.rightRows);
+    }
+  }
+
+  ASSERT_THROW(hashJoin(left, {}, right, {}), std::invalid_argument);
+  ASSERT_THROW(hashJoin(left, {0, 1}, right, {0}), std::invalid_argument);
+  ASSERT_THROW(hashJoin(left, {5}, right, {0}), std::out_of_range);
+}
@@ -0,0 +1,243 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Reader.h"
+#include "../Sloppy/ManagedFileDescriptor.h"
+#include "../Sloppy/Memory.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  // compares all rows delivered by a reader with
+  // the rows of a table that has been parsed in one go
+  void assertSameRows(CSV_Reader& r, const CSV_Table& t)
+  {
+    for (size_t rowIdx = 0; rowIdx < t.size(); ++rowIdx)
+    {
+      ASSERT_TRUE(r.next());
+      ASSERT_EQ(t.get(rowIdx).asString(Rep::QuotedAndEscaped), r.row().asString(Rep::QuotedAndEscaped));
+    }
+    ASSERT_FALSE(r.next());
+    ASSERT_FALSE(r.next());
+    ASSERT_EQ(t.size(), r.rowCount());
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Reader, Istream)
+{
+  istringstream is{"\"a\",\"b\",\"c\"\r\n1,2.2,\"x\"\n\n,\"\",\"y\\,z\"\n-5,,"};
+  CSV_Reader r{is, true, Rep::QuotedAndEscaped};
+
+  ASSERT_TRUE(r.hasHeaders());
+  ASSERT_EQ(3, r.nCols());
+  ASSERT_EQ("b", r.getHeader(1));
+  ASSERT_EQ(vector<string>({"a", "b", "c"}), r.headers());
+  ASSERT_EQ(2, *r.columnIndex("c"));
+  ASSERT_FALSE(r.columnIndex("C").has_value());
+  ASSERT_THROW(r.getHeader(3), std::out_of_range);
+  ASSERT_EQ(0, r.rowCount());
+
+  ASSERT_TRUE(r.next());
+  ASSERT_EQ(1, r.row()[0].get<int64_t>());
+  ASSERT_EQ(2.2, r.row()[1].get<double>());
+  ASSERT_EQ("x", r.row()[2].get<string>());
+  ASSERT_EQ(2, r.lineNumber());
+
+  // the empty line is skipped
+  ASSERT_TRUE(r.next());
+  ASSERT_FALSE(r.row()[0].has_value());
+  ASSERT_EQ("", r.row()[1].get<string>());
+  ASSERT_EQ("y,z", r.row()[2].get<string>());
+  ASSERT_EQ(4, r.lineNumber());
+
+  // unterminated last line; the row buffer is reused and
+  // all columns have been overwritten
+  ASSERT_TRUE(r.next());
+  ASSERT_EQ(-5, r.row()[0].get<int64_t>());
+  ASSERT_FALSE(r.row()[1].has_value());
+  ASSERT_FALSE(r.row()[2].has_value());
+
+  ASSERT_FALSE(r.next());
+  ASSERT_EQ(3, r.rowCount());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Reader, NoHeadersAndErrors)
+{
+  istringstream is{"1,2\n3,4\n5,6,7\n"};
+  CSV_Reader r{is, false, Rep::Plain};
+  ASSERT_FALSE(r.hasHeaders());
+  ASSERT_EQ(0, r.nCols());
+
+  ASSERT_TRUE(r.next());
+  ASSERT_EQ(2, r.nCols());
+  ASSERT_TRUE(r.next());
+  ASSERT_EQ(4, r.row()[1].get<int64_t>());
+  ASSERT_THROW(r.next(), std::invalid_argument);
+  ASSERT_EQ(3, r.lineNumber());
+
+  // like in CSV_Table, a line that only contains "\r" is
+  // an empty row and not an empty line
+  istringstream crLine{"1,2\n\r\n3,4\n"};
+  CSV_Reader r5{crLine, false, Rep::Plain};
+  ASSERT_TRUE(r5.next());
+  ASSERT_THROW(r5.next(), std::invalid_argument);
+
+  // empty input
+  istringstream empty{""};
+  CSV_Reader r2{empty, true, Rep::Plain};
+  ASSERT_FALSE(r2.hasHeaders());
+  ASSERT_FALSE(r2.next());
+
+  // invalid headers
+  istringstream dupHeader{"a,a\n1,2\n"};
+  ASSERT_THROW(CSV_Reader(dupHeader, true, Rep::Plain), std::invalid_argument);
+  istringstream nullHeader{"a,,c\n1,2,3\n"};
+  ASSERT_THROW(CSV_Reader(nullHeader, true, Rep::Plain), std::invalid_argument);
+
+  // malformed row data
+  istringstream badQuotes{"1,\"abc\n"};
+  CSV_Reader r3{badQuotes, false, Rep::Quoted};
+  ASSERT_THROW(r3.next(), std::invalid_argument);
+
+  // line length limit
+  istringstream longLine{"1,2\n" + string(100, 'x') + "\n"};
+  CSV_Reader r4{longLine, false, Rep::Plain, 8, 64};
+  ASSERT_TRUE(r4.next());
+  ASSERT_THROW(r4.next(), std::invalid_argument);
+
+  // the limit also applies if the line has been read in a single chunk
+  istringstream longLine2{"1,2\n" + string(100, 'x') + "\n"};
+  CSV_Reader r6{longLine2, false, Rep::Plain, 4096, 64};
+  ASSERT_TRUE(r6.next());
+  ASSERT_THROW(r6.next(), std::invalid_argument);
+
+  // zero chunk size
+  istringstream dummy{"1"};
+  ASSERT_THROW(CSV_Reader(dummy, false, Rep::Plain, 0), std::invalid_argument);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Reader, AllRepresentationsAndChunkSizes)
+{
+  // export a table in all representations and read it back
+  // with different (tiny) chunk sizes so that rows are
+  // split across chunk boundaries
+  for (Rep rep : {Rep::Plain, Rep::Quoted, Rep::Escaped, Rep::QuotedAndEscaped})
+  {
+    // only escaped strings may contain commas
+    const bool usesEscaping = ((rep == Rep::Escaped) || (rep == Rep::QuotedAndEscaped));
+
+    CSV_Table src;
+    for (int i = 0; i < 50; ++i)
+    {
+      CSV_Row row;
+      row.append(i);
+      row.append(string{usesEscaping ? "name, no. " : "name no. "} + to_string(i));
+      row.append(i / 4.0);
+      ASSERT_TRUE(src.append(row));
+    }
+
+    const bool usesQuotes = ((rep == Rep::Quoted) || (rep == Rep::QuotedAndEscaped));
+    const string hdr = usesQuotes ? "\"id\",\"name\",\"value\"\n" : "id,name,value\n";
+    const string csv = hdr + src.asString(false, rep);
+    const CSV_Table ref{csv, true, rep};
+
+    for (size_t chunkSize : {1, 3, 17, 1000, 100000})
+    {
+      istringstream is{csv};
+      CSV_Reader r{is, true, rep, chunkSize};
+      ASSERT_EQ(3, r.nCols());
+      ASSERT_EQ("name", r.getHeader(1));
+      assertSameRows(r, ref);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Reader, FileSources)
+{
+  const string fname{"../tests/date_time_zonespec.csv"};
+
+  ifstream f{fname};
+  ASSERT_TRUE(f.is_open());
+  stringstream ss;
+  ss << f.rdbuf();
+  const CSV_Table ref{ss.str(), true, Rep::Quoted};
+  ASSERT_TRUE(ref.size() > 300);
+
+  // memory-mapped file
+  MemFile mf{fname};
+  CSV_Reader r1{mf, true, Rep::Quoted};
+  ASSERT_EQ(11, r1.nCols());
+  ASSERT_EQ("STD ABBR", r1.getHeader(1));
+  assertSameRows(r1, ref);
+
+  // input stream
+  f.clear();
+  f.seekg(0);
+  CSV_Reader r2{f, true, Rep::Quoted, 4096};
+  assertSameRows(r2, ref);
+
+  // a pipe that is fed by a separate thread
+  int fd[2];
+  ASSERT_EQ(0, pipe(fd));
+  ManagedFileDescriptor fdRead{fd[0]};
+  thread writer{[&]()
+    {
+      ManagedFileDescriptor fdWrite{fd[1]};
+      const string& data = ss.str();
+      for (size_t idx = 0; idx < data.size(); idx += 1000)
+      {
+        fdWrite.blockingWrite(data.substr(idx, 1000));
+      }
+      // the dtor closes the descriptor which signals EOF to the reader
+    }};
+
+  CSV_Reader r3{fdRead, true, Rep::Quoted, 512};
+  assertSameRows(r3, ref);
+  writer.join();
+
+  // the line length limit applies to memory-mapped files as well
+  ASSERT_THROW(CSV_Reader(mf, true, Rep::Quoted, 16), std::invalid_argument);
+
+  // an invalid MemFile
+  MemFile invalid;
+  ASSERT_THROW(CSV_Reader(invalid, false, Rep::Plain), std::invalid_argument);
+}
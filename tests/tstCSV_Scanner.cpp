@@ -0,0 +1,177 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Scanner.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  // the byte-by-byte state machine that CSV_Row used before the
+  // structural scanner was introduced; stops where the old
+  // code threw an exception (more than two quotes in a field)
+  vector<size_t> referenceSeparators(const string& s, Rep rep, size_t& validLen)
+  {
+    const bool usesEscaping = ((rep == Rep::Escaped) || (rep == Rep::QuotedAndEscaped));
+    const bool usesQuotes = ((rep == Rep::Quoted) || (rep == Rep::QuotedAndEscaped));
+
+    vector<size_t> result;
+    char prevChar{0};
+    int quoteCount{0};
+    for (size_t idx = 0; idx < s.size(); ++idx)
+    {
+      const char c = s[idx];
+      if (usesQuotes && (c == '"') && (!usesEscaping || (prevChar != '\\')))
+      {
+        ++quoteCount;
+        if (quoteCount > 2)
+        {
+          validLen = idx;
+          return result;
+        }
+      }
+
+      if ((c == ',') && (quoteCount != 1) && (!usesEscaping || (prevChar != '\\')))
+      {
+        result.push_back(idx);
+        quoteCount = 0;
+      }
+
+      prevChar = c;
+    }
+
+    validLen = s.size();
+    return result;
+  }
+
+  // feeds a string block by block into a scanner
+  vector<CSV_StructuralMasks> scanAll(const string& s, Rep rep)
+  {
+    CSV_StructuralScanner scanner{rep};
+    vector<CSV_StructuralMasks> result;
+    for (size_t idx = 0; idx < s.size(); idx += CSV_StructuralScanner::BlockSize)
+    {
+      result.push_back(scanner.scanBlock(s.data() + idx, std::min(CSV_StructuralScanner::BlockSize, s.size() - idx)));
+    }
+    return result;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Scanner, Basics)
+{
+  CSV_StructuralScanner sc{Rep::QuotedAndEscaped};
+
+  string s{R"(1,"a,b","c\"d",\,x)"};
+  s += '\n';
+  auto m = sc.scanBlock(s.data(), s.size());
+
+  // separators at 1, 7 and 14; the comma in "a,b" is
+  // quoted and the one at position 16 is escaped
+  ASSERT_EQ((1ull << 1) | (1ull << 7) | (1ull << 14), m.separators);
+  ASSERT_EQ((1ull << 2) | (1ull << 6) | (1ull << 8) | (1ull << 13), m.quotes);
+  ASSERT_EQ(1ull << 18, m.lineEnds);
+
+  // no quoting: the quotation marks have no effect
+  CSV_StructuralScanner plain{Rep::Plain};
+  m = plain.scanBlock(s.data(), s.size());
+  ASSERT_EQ(0, m.quotes);
+  ASSERT_EQ((1ull << 1) | (1ull << 4) | (1ull << 7) | (1ull << 14) | (1ull << 16), m.separators);
+
+  // empty block
+  m = sc.scanBlock(s.data(), 0);
+  ASSERT_EQ(0, m.separators);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Scanner, StateAcrossBlocks)
+{
+  // an open quotation mark and a backslash at the end of
+  // the first block affect the second block
+  string s(63, 'x');
+  s[10] = '"';
+  s += '\\';
+  s += ",abc\",def";
+
+  CSV_StructuralScanner sc{Rep::QuotedAndEscaped};
+  auto m = sc.scanBlock(s.data(), 64);
+  ASSERT_EQ(0, m.separators);
+  m = sc.scanBlock(s.data() + 64, s.size() - 64);
+  ASSERT_EQ(0, m.separators & 1);   // escaped
+  ASSERT_EQ(1ull << 4, m.quotes);   // closing quote
+  ASSERT_EQ(1ull << 5, m.separators);
+
+  // after a reset, the second block is scanned as if it was a new row
+  sc.reset();
+  m = sc.scanBlock(s.data() + 64, s.size() - 64);
+  ASSERT_EQ(1ull, m.separators);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Scanner, CompareWithReference)
+{
+  mt19937 rng{42};
+  const string alphabet{",,,\"\"\\\\ab \n"};
+  uniform_int_distribution<size_t> charDist{0, alphabet.size() - 1};
+  uniform_int_distribution<size_t> lenDist{0, 300};
+
+  for (int n = 0; n < 5000; ++n)
+  {
+    string s;
+    const size_t len = lenDist(rng);
+    for (size_t i = 0; i < len; ++i) s += alphabet[charDist(rng)];
+
+    for (Rep rep : {Rep::Plain, Rep::Quoted, Rep::Escaped, Rep::QuotedAndEscaped})
+    {
+      size_t validLen{0};
+      const auto refSep = referenceSeparators(s, rep, validLen);
+
+      vector<size_t> sep;
+      const auto masks = scanAll(s, rep);
+      for (size_t blockIdx = 0; blockIdx < masks.size(); ++blockIdx)
+      {
+        for (size_t bit = 0; bit < CSV_StructuralScanner::BlockSize; ++bit)
+        {
+          const size_t idx = blockIdx * CSV_StructuralScanner::BlockSize + bit;
+          if ((masks[blockIdx].separators >> bit) & 1)
+          {
+            ASSERT_TRUE(idx < s.size());
+            if (idx < validLen) sep.push_back(idx);
+          }
+          ASSERT_EQ((idx < s.size()) && (s[idx] == '\n'), ((masks[blockIdx].lineEnds >> bit) & 1) == 1);
+        }
+      }
+
+      ASSERT_EQ(refSep, sep) << "Input: " << s;
+    }
+  }
+}
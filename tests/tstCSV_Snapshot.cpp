@@ -0,0 +1,285 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Columnar.h"
+#include "../Sloppy/CSV_Snapshot.h"
+#include "../Sloppy/Memory.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  // columns: int with NULLs, double, string (incl. empty strings), mixed, only NULLs
+  CSV_Table makeSnapshotTable(int nRows)
+  {
+    CSV_Table tab;
+    EXPECT_TRUE(tab.setHeader(vector<string>{"id", "value", "name", "mixed", "nothing"}));
+    for (int i = 0; i < nRows; ++i)
+    {
+      CSV_Row r;
+      if ((i % 11) == 3) r.append(); else r.append(int64_t{i * 1000003LL - 500000000LL});
+      r.append(i / 7.0 - 3.5);
+      if ((i % 5) == 0) r.append(string{}); else r.append("name, \"no.\" " + to_string(i % 17));
+      switch (i % 4)
+      {
+      case 0: r.append(int64_t{i}); break;
+      case 1: r.append(i * 0.5); break;
+      case 2: r.append("m" + to_string(i % 3)); break;
+      default: r.append();
+      }
+      r.append();
+      EXPECT_TRUE(tab.append(std::move(r)));
+    }
+    return tab;
+  }
+
+  void assertSameValue(const CSV_Value& expected, const CSV_Value& actual)
+  {
+    ASSERT_EQ(expected.valueType(), actual.valueType());
+    switch (expected.valueType())
+    {
+    case CSV_Value::Type::Long: ASSERT_EQ(expected.get<int64_t>(), actual.get<int64_t>()); break;
+    case CSV_Value::Type::Double: ASSERT_EQ(expected.get<double>(), actual.get<double>()); break;
+    case CSV_Value::Type::String: ASSERT_EQ(expected.get<string>(), actual.get<string>()); break;
+    default: break;
+    }
+  }
+
+  void writeFile(const string& fname, const string& content)
+  {
+    ofstream f{fname, ios::binary | ios::trunc};
+    f << content;
+  }
+
+  string readFile(const string& fname)
+  {
+    ifstream f{fname, ios::binary};
+    return string{istreambuf_iterator<char>{f}, istreambuf_iterator<char>{}};
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Snapshot, RoundTrip)
+{
+  const string fname{"/tmp/sloppyCsvSnapshotTest.bin"};
+  const CSV_Table tab = makeSnapshotTable(1000);
+  writeCSVSnapshot(tab, fname);
+
+  {
+    MemFile mf{fname};
+    ASSERT_EQ(0, mf.size() % 8);
+
+    CSV_SnapshotReader snap{mf};
+    ASSERT_EQ(tab.size(), snap.size());
+    ASSERT_EQ(5, snap.nCols());
+    ASSERT_TRUE(snap.hasHeaders());
+    ASSERT_EQ((vector<string>{"id", "value", "name", "mixed", "nothing"}), snap.headers());
+
+    ASSERT_EQ(CSV_Column::Type::Long, snap.columnType(0));
+    ASSERT_EQ(CSV_Column::Type::Double, snap.columnType(1));
+    ASSERT_EQ(CSV_Column::Type::String, snap.columnType(2));
+    ASSERT_EQ(CSV_Column::Type::Mixed, snap.columnType(3));
+    ASSERT_EQ(CSV_Column::Type::Empty, snap.columnType(4));
+
+    // direct cell access
+    for (size_t row = 0; row < tab.size(); ++row)
+    {
+      for (CSV_Table::ColumnIndexType col = 0; col < tab.nCols(); ++col)
+      {
+        assertSameValue(tab.get(row, col), snap.get(row, col));
+        ASSERT_EQ(!tab.get(row, col).has_value(), snap.isNull(row, col));
+      }
+    }
+
+    // conversion into a table
+    const CSV_Table copy = snap.toTable();
+    ASSERT_EQ(tab.asString(true, CSV_StringRepresentation::QuotedAndEscaped), copy.asString(true, CSV_StringRepresentation::QuotedAndEscaped));
+
+    ASSERT_THROW(snap.get(tab.size(), 0), std::out_of_range);
+    ASSERT_THROW(snap.get(0, 5), std::out_of_range);
+    ASSERT_THROW(snap.columnType(5), std::out_of_range);
+  }
+
+  // writing a columnar table gives the same file
+  const string fromTable = readFile(fname);
+  writeCSVSnapshot(CSV_ColumnarTable{tab}, fname);
+  ASSERT_EQ(fromTable, readFile(fname));
+
+  remove(fname.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Snapshot, TypedColumns)
+{
+  const string fname{"/tmp/sloppyCsvSnapshotTest3.bin"};
+  const CSV_Table tab = makeSnapshotTable(1000);
+  const CSV_ColumnarTable ct{tab};
+  writeCSVSnapshot(ct, fname);
+
+  MemFile mf{fname};
+  CSV_SnapshotReader snap{mf};
+
+  // the views have the same contents as the columns of a columnar table
+  const auto longs = snap.longData(0);
+  ASSERT_EQ(ct.column(0).longData(), vector<int64_t>(longs.cbegin(), longs.cend()));
+  const auto doubles = snap.doubleData(1);
+  ASSERT_EQ(ct.column(1).doubleData(), vector<double>(doubles.cbegin(), doubles.cend()));
+  const auto codes = snap.stringCodes(2);
+  ASSERT_EQ(ct.column(2).stringCodes(), vector<CSV_Column::StringCode>(codes.cbegin(), codes.cend()));
+  for (CSV_Table::ColumnIndexType colIdx = 0; colIdx < tab.nCols(); ++colIdx)
+  {
+    const auto validBits = snap.validityBits(colIdx);
+    ASSERT_EQ(ct.column(colIdx).validityBits(), vector<uint64_t>(validBits.cbegin(), validBits.cend()));
+  }
+
+  // the dictionary strings are views into the file
+  ASSERT_EQ(ct.column(2).dictionarySize(), snap.dictionarySize(2));
+  for (size_t code = 0; code < snap.dictionarySize(2); ++code)
+  {
+    ASSERT_EQ(ct.column(2).dictionaryEntry(code), snap.dictionaryEntry(2, code));
+  }
+  ASSERT_EQ(3, snap.dictionarySize(3));
+  ASSERT_EQ(0, snap.dictionarySize(0));
+
+  // a scan over the raw data
+  int64_t sum{0};
+  for (size_t row = 0; row < snap.size(); ++row)
+  {
+    if (!snap.isNull(row, 0)) sum += longs.elemAt(row);
+  }
+  int64_t expectedSum{0};
+  for (size_t row = 0; row < tab.size(); ++row)
+  {
+    if (tab.get(row, 0).has_value()) expectedSum += tab.get(row, 0).get<int64_t>();
+  }
+  ASSERT_EQ(expectedSum, sum);
+
+  // type mismatches and invalid indices
+  ASSERT_THROW(snap.longData(1), std::invalid_argument);
+  ASSERT_THROW(snap.doubleData(0), std::invalid_argument);
+  ASSERT_THROW(snap.stringCodes(3), std::invalid_argument);
+  ASSERT_THROW(snap.longData(4), std::invalid_argument);
+  ASSERT_THROW(snap.longData(5), std::out_of_range);
+  ASSERT_THROW(snap.validityBits(5), std::out_of_range);
+  ASSERT_THROW(snap.dictionarySize(5), std::out_of_range);
+  ASSERT_THROW(snap.dictionaryEntry(5, 0), std::out_of_range);
+  ASSERT_THROW(snap.dictionaryEntry(2, snap.dictionarySize(2)), std::invalid_argument);
+
+  remove(fname.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Snapshot, SpecialTables)
+{
+  const string fname{"/tmp/sloppyCsvSnapshotTest2.bin"};
+
+  // no headers
+  CSV_Table tab;
+  CSV_Row r;
+  r.append(int64_t{42});
+  r.append("abc");
+  ASSERT_TRUE(tab.append(r));
+  writeCSVSnapshot(tab, fname);
+  {
+    MemFile mf{fname};
+    CSV_SnapshotReader snap{mf};
+    ASSERT_FALSE(snap.hasHeaders());
+    ASSERT_EQ(1, snap.size());
+    ASSERT_EQ(42, snap.get(0, 0).get<int64_t>());
+    ASSERT_EQ("abc", snap.get(0, 1).get<string>());
+  }
+
+  // headers but no rows
+  CSV_Table emptyTab;
+  ASSERT_TRUE(emptyTab.setHeader(vector<string>{"a", "b"}));
+  writeCSVSnapshot(emptyTab, fname);
+  {
+    MemFile mf{fname};
+    CSV_SnapshotReader snap{mf};
+    ASSERT_EQ(0, snap.size());
+    ASSERT_EQ(2, snap.nCols());
+    ASSERT_EQ((vector<string>{"a", "b"}), snap.headers());
+    ASSERT_TRUE(snap.toTable().empty());
+    ASSERT_TRUE(snap.validityBits(0).empty());
+  }
+
+  // completely empty
+  writeCSVSnapshot(CSV_Table{}, fname);
+  {
+    MemFile mf{fname};
+    CSV_SnapshotReader snap{mf};
+    ASSERT_EQ(0, snap.size());
+    ASSERT_EQ(0, snap.nCols());
+  }
+
+  remove(fname.c_str());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Snapshot, InvalidFiles)
+{
+  const string fname{"/tmp/sloppyCsvSnapshotTest3.bin"};
+  const string badName{"/tmp/sloppyCsvSnapshotTest3.bad"};
+  writeCSVSnapshot(makeSnapshotTable(100), fname);
+  const string content = readFile(fname);
+
+  // not a snapshot file at all
+  writeFile(badName, "\"id\",\"name\"\n1,\"abc\"\n");
+  {
+    MemFile mf{badName};
+    ASSERT_THROW(CSV_SnapshotReader{mf}, std::invalid_argument);
+  }
+
+  // truncated files
+  for (size_t len : {size_t{8}, size_t{64}, content.size() / 2, content.size() - 8})
+  {
+    writeFile(badName, content.substr(0, len));
+    MemFile mf{badName};
+    ASSERT_THROW(CSV_SnapshotReader{mf}, std::invalid_argument);
+  }
+
+  // a truncated file with a patched size field; the
+  // layout check must detect the missing blocks
+  string patched = content.substr(0, content.size() - 64);
+  const uint64_t newSize = patched.size();
+  for (int i = 0; i < 8; ++i) patched[8 + i] = static_cast<char>((newSize >> (8 * i)) & 0xff);
+  writeFile(badName, patched);
+  {
+    MemFile mf{badName};
+    ASSERT_THROW(CSV_SnapshotReader{mf}, std::invalid_argument);
+  }
+
+  ASSERT_THROW(writeCSVSnapshot(CSV_Table{}, "/this/path/does/not/exist.bin"), std::runtime_error);
+
+  remove(fname.c_str());
+  remove(badName.c_str());
+}
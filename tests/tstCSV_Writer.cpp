@@ -0,0 +1,221 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/CSV_Reader.h"
+#include "../Sloppy/CSV_Writer.h"
+#include "../Sloppy/ManagedFileDescriptor.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  using Rep = CSV_StringRepresentation;
+
+  CSV_Table makeTestTable(bool withCommas, bool withNull = true)
+  {
+    CSV_Table t;
+    for (int i = 0; i < 100; ++i)
+    {
+      CSV_Row row;
+      row.append(i - 50);
+      row.append(string{withCommas ? "name, \"no.\" " : "name no. "} + to_string(i));
+      row.append(i / 8.0);
+      if (!withNull) row.append(42);
+      else if ((i % 7) == 0) row.append();
+      else row.append(string{});
+      t.append(row);
+    }
+    return t;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Writer, SameOutputAsTable)
+{
+  for (Rep rep : {Rep::Plain, Rep::Quoted, Rep::Escaped, Rep::QuotedAndEscaped})
+  {
+    const bool usesEscaping = ((rep == Rep::Escaped) || (rep == Rep::QuotedAndEscaped));
+    const bool usesQuotes = ((rep == Rep::Quoted) || (rep == Rep::QuotedAndEscaped));
+
+    // NULL values can't be represented without quotes
+    CSV_Table t = makeTestTable(usesEscaping, usesQuotes);
+    ASSERT_TRUE(t.setHeader(vector<string>{"a", "b", "c", "d"}));
+
+    // a tiny flush threshold enforces many partial writes
+    for (size_t threshold : {1, 100, 1000000})
+    {
+      ostringstream os;
+      {
+        CSV_Writer w{os, rep, threshold};
+        w.writeTable(t, true);
+        ASSERT_EQ(t.size(), w.rowCount());
+      }
+      ASSERT_EQ(t.asString(true, rep), os.str());
+
+      // read the data back
+      const CSV_Table t2{os.str(), true, rep};
+      ASSERT_EQ(t.size(), t2.size());
+      ASSERT_EQ("c", t2.getHeader(2));
+      ASSERT_EQ(t.asString(true, rep), t2.asString(true, rep));
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Writer, RowsAndErrors)
+{
+  ostringstream os;
+  CSV_Writer w{os, Rep::Plain, 1000};
+
+  w.writeHeader({"x", "y"});
+  ASSERT_EQ(0, w.rowCount());
+
+  CSV_Row r;
+  r.append(1);
+  r.append(string{"abc"});
+  w.writeRow(r);
+  ASSERT_EQ(1, w.rowCount());
+
+  // nothing has been flushed yet
+  ASSERT_TRUE(os.str().empty());
+  ASSERT_EQ(0, w.bytesWritten());
+
+  // wrong column count
+  CSV_Row wrong;
+  wrong.append(1);
+  ASSERT_THROW(w.writeRow(wrong), std::invalid_argument);
+  ASSERT_THROW(w.writeHeader({"a"}), std::invalid_argument);
+
+  // NULL without quotes; the buffer content remains unchanged
+  CSV_Row withNull;
+  withNull.append(2);
+  withNull.append();
+  ASSERT_THROW(w.writeRow(withNull), std::bad_optional_access);
+  ASSERT_EQ(1, w.rowCount());
+
+  CSV_Row r2;
+  r2.append(numeric_limits<int64_t>::min());
+  r2.append(-1.5);
+  w.writeRow(r2);
+
+  w.flush();
+  const string expected{"x,y\n1,abc\n-9223372036854775808,-1.500000\n"};
+  ASSERT_EQ(expected, os.str());
+  ASSERT_EQ(expected.size(), w.bytesWritten());
+  ASSERT_EQ(2, w.rowCount());
+
+  // a failed stream
+  ostringstream failed;
+  failed.setstate(ios::badbit);
+  CSV_Writer w2{failed, Rep::Plain, 0};
+  ASSERT_THROW(w2.writeRow(r), std::runtime_error);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Writer, QuotedHeaders)
+{
+  // headers are written like strings and can thus
+  // be parsed back in quoted mode
+  CSV_Table t;
+  CSV_Row r;
+  r.append(1);
+  r.append(string{"x"});
+  t.append(r);
+  ASSERT_TRUE(t.setHeader(vector<string>{"id", "the name"}));
+
+  const string csv = t.asString(true, Rep::QuotedAndEscaped);
+  ASSERT_EQ("\"id\",\"the name\"\n1,\"x\"\n", csv);
+  const CSV_Table t2{csv, true, Rep::QuotedAndEscaped};
+  ASSERT_EQ("the name", t2.getHeader(1));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CSV_Writer, FileDescriptors)
+{
+  const CSV_Table src = makeTestTable(true);
+
+  // a pipe, read back by a CSV_Reader
+  int fd[2];
+  ASSERT_EQ(0, pipe(fd));
+  ManagedFileDescriptor fdRead{fd[0]};
+  thread writer{[&]()
+    {
+      ManagedFileDescriptor fdWrite{fd[1]};
+      CSV_Writer w{fdWrite, Rep::QuotedAndEscaped, 256};
+      w.writeHeader({"a", "b", "c", "d"});
+      w.writeTable(src, false);
+      w.flush();
+      // the dtor of fdWrite closes the descriptor which signals EOF to the reader
+    }};
+
+  CSV_Reader r{fdRead, true, Rep::QuotedAndEscaped, 100};
+  for (auto it = src.cbegin(); it != src.cend(); ++it)
+  {
+    ASSERT_TRUE(r.next());
+    ASSERT_EQ(it->asString(Rep::QuotedAndEscaped), r.row().asString(Rep::QuotedAndEscaped));
+  }
+  ASSERT_FALSE(r.next());
+  writer.join();
+
+  // a regular file with periodic syncs
+  char fname[] = "/tmp/sloppyCsvWriterXXXXXX";
+  int fileFd = mkstemp(fname);
+  ASSERT_TRUE(fileFd >= 0);
+  {
+    ManagedFileDescriptor mfd{fileFd};
+    CSV_Writer w{mfd, Rep::QuotedAndEscaped, 1000000, 10};
+    w.writeTable(src, false);
+
+    // the last sync happened after 100 rows,
+    // so everything has been written
+    ASSERT_EQ(src.asString(false, Rep::QuotedAndEscaped).size(), w.bytesWritten());
+  }
+  ifstream f{fname};
+  stringstream ss;
+  ss << f.rdbuf();
+  ASSERT_EQ(src.asString(false, Rep::QuotedAndEscaped), ss.str());
+  remove(fname);
+
+  // syncing a pipe fails
+  int fd2[2];
+  ASSERT_EQ(0, pipe(fd2));
+  ManagedFileDescriptor p0{fd2[0]};
+  ManagedFileDescriptor p1{fd2[1]};
+  CSV_Writer w{p1, Rep::Plain};
+  ASSERT_THROW(w.sync(), IOError);
+}
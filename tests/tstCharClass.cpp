@@ -0,0 +1,157 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cctype>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CharClass.h"
+#include "../Sloppy/String.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  // creates strings of all lengths between 0 and 40 so that
+  // both the vectorized and the scalar code paths are covered
+  // and inserts a given character at all possible positions
+  template<typename Check>
+  void forAllLengthsAndPositions(char filler, char probe, Check check)
+  {
+    for (size_t len = 0; len <= 40; ++len)
+    {
+      const string base(len, filler);
+      check(base);
+      for (size_t pos = 0; pos < len; ++pos)
+      {
+        string s{base};
+        s[pos] = probe;
+        check(s);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CharClass, Classification)
+{
+  // compare with the <cctype> functions in the "C" locale for all bytes
+  for (int b = 0; b < 256; ++b)
+  {
+    const char c = static_cast<char>(b);
+    const auto uc = static_cast<unsigned char>(c);
+
+    forAllLengthsAndPositions('7', c, [&](const string& s) {
+      const bool expected = all_of(s.begin(), s.end(), [](char x) { return isdigit(static_cast<unsigned char>(x)); });
+      ASSERT_EQ(expected, CharClass::isAllDigits(s));
+    });
+    forAllLengthsAndPositions('q', c, [&](const string& s) {
+      const bool expected = all_of(s.begin(), s.end(), [](char x) { return isalpha(static_cast<unsigned char>(x)); });
+      ASSERT_EQ(expected, CharClass::isAllAlpha(s));
+    });
+    forAllLengthsAndPositions('Z', c, [&](const string& s) {
+      const bool expected = all_of(s.begin(), s.end(), [](char x) { return isalnum(static_cast<unsigned char>(x)); });
+      ASSERT_EQ(expected, CharClass::isAllAlnum(s));
+    });
+
+    ASSERT_EQ(isspace(uc) != 0, CharClass::countLeadingSpaces(string(1, c)) == 1);
+  }
+
+  ASSERT_TRUE(CharClass::isAllDigits(""));
+  ASSERT_FALSE(CharClass::isAllAlpha("abcdefghijklmnopqrstuvwxyz0"));
+  ASSERT_TRUE(CharClass::isAllAlnum("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CharClass, Spaces)
+{
+  for (char sp : {' ', '\t', '\n', '\v', '\f', '\r'})
+  {
+    for (size_t nLeft = 0; nLeft <= 35; ++nLeft)
+    {
+      for (size_t nRight = 0; nRight <= 35; nRight += 7)
+      {
+        for (size_t nMid : {0, 1, 20})
+        {
+          const string s = string(nLeft, sp) + string(nMid, 'x') + string(nRight, sp);
+          if (nMid == 0)
+          {
+            ASSERT_EQ(s.size(), CharClass::countLeadingSpaces(s));
+            ASSERT_EQ(s.size(), CharClass::countTrailingSpaces(s));
+          } else {
+            ASSERT_EQ(nLeft, CharClass::countLeadingSpaces(s));
+            ASSERT_EQ(nRight, CharClass::countTrailingSpaces(s));
+          }
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CharClass, FirstNonAscii)
+{
+  ASSERT_EQ(0, CharClass::firstNonAscii(""));
+  forAllLengthsAndPositions('a', static_cast<char>(0x80), [](const string& s) {
+    const auto pos = s.find(static_cast<char>(0x80));
+    ASSERT_EQ((pos == string::npos) ? s.size() : pos, CharClass::firstNonAscii(s));
+  });
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CharClass, CaseConversion)
+{
+  // ASCII; compare with the <cctype> functions for all bytes
+  string all;
+  for (int b = 0; b < 256; ++b) all += static_cast<char>(b);
+  for (size_t len = 0; len <= all.size(); ++len)
+  {
+    string s = all.substr(all.size() - len);
+    string expected{s};
+    for (char& c : expected) if (static_cast<unsigned char>(c) < 0x80) c = toupper(static_cast<unsigned char>(c));
+    CharClass::asciiToUpper(s.data(), s.size());
+    ASSERT_EQ(expected, s);
+
+    for (char& c : expected) if (static_cast<unsigned char>(c) < 0x80) c = tolower(static_cast<unsigned char>(c));
+    CharClass::asciiToLower(s.data(), s.size());
+    ASSERT_EQ(expected, s);
+  }
+
+  // UTF-8, including all pairs from the translation table
+  for (const auto& [lo, up] : umlautTranslationTable)
+  {
+    string s = "x" + lo + "abcdefghijklmnopqrstuvwxyz" + lo;
+    CharClass::toUpper(s.data(), s.size());
+    ASSERT_EQ("X" + up + "ABCDEFGHIJKLMNOPQRSTUVWXYZ" + up, s);
+    CharClass::toLower(s.data(), s.size());
+    ASSERT_EQ("x" + lo + "abcdefghijklmnopqrstuvwxyz" + lo, s);
+  }
+  ASSERT_TRUE(CharClass::irregularCasePairs().empty());
+
+  // characters without a mapping, three-byte sequences and
+  // truncated / invalid sequences remain untouched
+  string s{"ß€\xc3\xc3\xa4\xa4\xc3"};
+  CharClass::toUpper(s.data(), s.size());
+  ASSERT_EQ("ß€\xc3\xc3\x84\xa4\xc3", s);
+}
@@ -0,0 +1,117 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/ConcurrentStats.h"
+
+using namespace std;
+using namespace Sloppy;
+
+static constexpr int nThreads = 8;
+static constexpr int nIterations = 20000;
+
+TEST(ConcurrentStats, Counter)
+{
+  ShardedCounter cnt{4};
+  ASSERT_EQ(0, cnt.value());
+
+  vector<thread> threads;
+  for (int i = 0; i < nThreads; ++i)
+  {
+    threads.emplace_back([&cnt]{
+      for (int j = 0; j < nIterations; ++j) cnt.add();
+      cnt.add(10);
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  ASSERT_EQ(nThreads * (nIterations + 10), cnt.value());
+
+  cnt.reset();
+  ASSERT_EQ(0, cnt.value());
+
+  // zero shards is treated as one shard
+  ShardedCounter c0{0};
+  c0.add(3);
+  ASSERT_EQ(3, c0.value());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ConcurrentStats, Histogram)
+{
+  ConcurrentHistogram ch;
+  LatencyHistogram expected;
+  for (int i = 0; i < nThreads; ++i)
+  {
+    for (int j = 0; j < nIterations; ++j) expected.record(i * 1000 + j);
+  }
+
+  vector<thread> threads;
+  for (int i = 0; i < nThreads; ++i)
+  {
+    threads.emplace_back([&ch, i]{
+      for (int j = 0; j < nIterations; ++j) ch.record(i * 1000 + j);
+    });
+  }
+
+  // concurrent reads are okay
+  for (int i = 0; i < 10; ++i)
+  {
+    auto snap = ch.snapshot();
+    ASSERT_TRUE(snap.count() <= nThreads * nIterations);
+  }
+
+  for (auto& t : threads) t.join();
+
+  auto snap = ch.snapshot();
+  ASSERT_EQ(expected.count(), snap.count());
+  ASSERT_EQ(expected.min(), snap.min());
+  ASSERT_EQ(expected.max(), snap.max());
+  ASSERT_DOUBLE_EQ(expected.mean(), snap.mean());
+  ASSERT_EQ(expected.p50(), snap.p50());
+  ASSERT_EQ(expected.p999(), snap.p999());
+
+  ch.reset();
+  ASSERT_EQ(0, ch.snapshot().count());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ConcurrentStats, WorkerStats)
+{
+  ConcurrentWorkerStats ws;
+  ASSERT_EQ(0, ws.snapshot().nCalls);
+
+  ws.update__ns(500000);
+  ws.update__ns(3000000);
+  ws.update__ns(1200000);
+
+  auto st = ws.snapshot();
+  ASSERT_EQ(3, st.nCalls);
+  ASSERT_EQ(4, st.totalRuntime_ms);
+  ASSERT_EQ(1, st.lastRuntime_ms);
+  ASSERT_EQ(0, st.minWorkerTime_ms);
+  ASSERT_EQ(3, st.maxWorkerTime_ms);
+  ASSERT_EQ(3, st.runtimeHistogram.count());
+  ASSERT_EQ(500000, st.runtimeHistogram.min());
+}
@@ -0,0 +1,215 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CyclicJobScheduler.h"
+
+using namespace std;
+
+class CountingJob : public Sloppy::ScheduledJob
+{
+public:
+  CountingJob(int cycle_ms, bool isOneShot = false)
+    :Sloppy::ScheduledJob{cycle_ms, isOneShot} {}
+
+  atomic<int> onFirstRunCnt{0};
+  atomic<int> onSuspendCnt{0};
+  atomic<int> onResumeCnt{0};
+  atomic<int> onTermCnt{0};
+  atomic<int> workerCnt{0};
+
+protected:
+  void onFirstRun() override { ++onFirstRunCnt; }
+  void onSuspend() override { ++onSuspendCnt; }
+  void onResume() override { ++onResumeCnt; }
+  void onTerminate() override { ++onTermCnt; }
+  void worker() override { ++workerCnt; }
+};
+
+//----------------------------------------------------------------------------
+
+TEST(CyclicJobScheduler, Lifecycle)
+{
+  using State = Sloppy::ScheduledJob::State;
+
+  Sloppy::CyclicJobScheduler sched{1, 1};
+  auto job = make_shared<CountingJob>(10);
+  ASSERT_EQ(State::Initialized, job->state());
+
+  ASSERT_TRUE(sched.addJob(job));
+  ASSERT_FALSE(sched.addJob(job));   // no double registration
+  ASSERT_FALSE(sched.addJob(nullptr));
+  ASSERT_EQ(1, sched.jobCount());
+
+  // nothing happens before run()
+  this_thread::sleep_for(chrono::milliseconds(30));
+  ASSERT_EQ(0, job->workerCnt);
+
+  ASSERT_TRUE(job->run());
+  job->waitForStateChange();
+  ASSERT_EQ(State::Running, job->state());
+  ASSERT_EQ(1, job->onFirstRunCnt);
+
+  this_thread::sleep_for(chrono::milliseconds(105));
+  int cnt = job->workerCnt;
+  ASSERT_TRUE((cnt >= 5) && (cnt <= 12));
+
+  ASSERT_TRUE(job->pause());
+  job->waitForStateChange();
+  ASSERT_EQ(State::Suspended, job->state());
+  ASSERT_EQ(1, job->onSuspendCnt);
+  cnt = job->workerCnt;
+  this_thread::sleep_for(chrono::milliseconds(50));
+  ASSERT_EQ(cnt, job->workerCnt);
+
+  ASSERT_TRUE(job->resume());
+  job->waitForStateChange();
+  ASSERT_EQ(State::Running, job->state());
+  ASSERT_EQ(1, job->onResumeCnt);
+  ASSERT_TRUE(job->workerCnt > cnt);
+
+  job->terminate();
+  job->waitForStateChange();
+  ASSERT_EQ(State::Finished, job->state());
+  ASSERT_EQ(1, job->onTermCnt);
+  ASSERT_EQ(0, sched.jobCount());
+
+  // finished jobs can't be re-added
+  ASSERT_FALSE(sched.addJob(job));
+
+  auto st = job->workerStats();
+  ASSERT_EQ(10, st.workerCycleTime_ms);
+  ASSERT_EQ(10000, st.workerCycleTime_us);
+  ASSERT_EQ(job->workerCnt, st.nCalls);
+  ASSERT_EQ(st.nCalls, st.runtimeHistogram.count());
+  ASSERT_EQ(st.nCalls, st.jitterHistogram.count());
+  ASSERT_GE(st.maxJitter_us, st.lastJitter_us);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CyclicJobScheduler, ManyJobsOnOneThread)
+{
+  static constexpr int nJobs = 200;
+
+  Sloppy::CyclicJobScheduler sched{1, 1};
+  vector<shared_ptr<CountingJob>> allJobs;
+  for (int i = 0; i < nJobs; ++i)
+  {
+    // use a mix of short and long cycles so that
+    // the higher wheel levels are involved as well
+    auto job = make_shared<CountingJob>((i % 2) ? 20 : 100);
+    job->run();   // run() before addJob() is valid
+    ASSERT_TRUE(sched.addJob(job));
+    allJobs.push_back(job);
+  }
+
+  this_thread::sleep_for(chrono::milliseconds(250));
+
+  for (int i = 0; i < nJobs; ++i)
+  {
+    const auto& job = allJobs[i];
+    ASSERT_EQ(Sloppy::ScheduledJob::State::Running, job->state());
+    ASSERT_EQ(1, job->onFirstRunCnt);
+    if (i % 2)
+    {
+      ASSERT_TRUE(job->workerCnt >= 8);
+    } else {
+      ASSERT_TRUE((job->workerCnt >= 2) && (job->workerCnt <= 4));
+    }
+  }
+
+  sched.terminateAllAndJoin();
+  ASSERT_EQ(0, sched.jobCount());
+  for (const auto& job : allJobs)
+  {
+    ASSERT_EQ(Sloppy::ScheduledJob::State::Finished, job->state());
+    ASSERT_EQ(1, job->onTermCnt);
+  }
+
+  // no new jobs after shutdown
+  ASSERT_FALSE(sched.addJob(make_shared<CountingJob>(10)));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CyclicJobScheduler, OneShot)
+{
+  Sloppy::CyclicJobScheduler sched{2, 1};
+  auto job = make_shared<CountingJob>(100, true);
+  ASSERT_TRUE(job->isOneShot());
+  ASSERT_TRUE(sched.addJob(job));
+  ASSERT_TRUE(job->run());
+
+  // onFirstRun() is called immediately ...
+  job->waitForStateChange();
+  ASSERT_EQ(Sloppy::ScheduledJob::State::Running, job->state());
+  ASSERT_EQ(1, job->onFirstRunCnt);
+
+  // ... but the worker is delayed
+  this_thread::sleep_for(chrono::milliseconds(50));
+  ASSERT_EQ(0, job->workerCnt);
+  ASSERT_EQ(Sloppy::ScheduledJob::State::Running, job->state());
+
+  this_thread::sleep_for(chrono::milliseconds(100));
+  ASSERT_EQ(Sloppy::ScheduledJob::State::Finished, job->state());
+  ASSERT_EQ(1, job->onFirstRunCnt);
+  ASSERT_EQ(1, job->workerCnt);
+  ASSERT_EQ(1, job->onTermCnt);
+  ASSERT_EQ(0, sched.jobCount());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CyclicJobScheduler, TerminateUnstartedJobs)
+{
+  auto job = make_shared<CountingJob>(10);
+  {
+    Sloppy::CyclicJobScheduler sched{1, 5};
+    ASSERT_TRUE(sched.addJob(job));
+  }
+
+  // the dtor has terminated the job
+  ASSERT_EQ(Sloppy::ScheduledJob::State::Finished, job->state());
+  ASSERT_EQ(0, job->onFirstRunCnt);
+  ASSERT_EQ(0, job->workerCnt);
+  ASSERT_EQ(1, job->onTermCnt);
+
+  // a job that has never been added to a scheduler
+  // completes the transition immediately
+  auto orphan = make_shared<CountingJob>(10);
+  ASSERT_TRUE(orphan->run());
+  orphan->terminate();
+  orphan->waitForStateChange();
+  ASSERT_EQ(Sloppy::ScheduledJob::State::Finished, orphan->state());
+  ASSERT_EQ(0, orphan->onFirstRunCnt);
+  ASSERT_EQ(1, orphan->onTermCnt);
+  orphan->terminate();
+  ASSERT_EQ(1, orphan->onTermCnt);
+  Sloppy::CyclicJobScheduler sched{1, 5};
+  ASSERT_FALSE(sched.addJob(orphan));
+
+  ASSERT_THROW(Sloppy::CyclicJobScheduler(0, 1), std::invalid_argument);
+  ASSERT_THROW(Sloppy::CyclicJobScheduler(1, 0), std::invalid_argument);
+}
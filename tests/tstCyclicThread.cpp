@@ -272,3 +272,82 @@ TEST(CyclicThread, InvalidTransitions)
   tw.terminateAndJoin();
 
 }
+
+//----------------------------------------------------------------------------
+
+class MicroWorker : public Sloppy::CyclicWorkerThread
+{
+public:
+  MicroWorker(chrono::microseconds cycle, OverrunPolicy p)
+    : Sloppy::CyclicWorkerThread{cycle, p} {}
+
+  atomic<int> workerCnt{0};
+  atomic<int> overrunAtCall{-1};   // the worker call that shall block for 10 cycles
+  chrono::microseconds cycle{500};
+
+protected:
+  void worker() override
+  {
+    int cnt = ++workerCnt;
+    if (cnt == overrunAtCall) this_thread::sleep_for(10 * cycle);
+  }
+};
+
+//----------------------------------------------------------------------------
+
+TEST(CyclicThread, MicrosecCycles)
+{
+  using OP = Sloppy::CyclicWorkerThread::OverrunPolicy;
+
+  ASSERT_THROW(MicroWorker(chrono::microseconds{0}, OP::SkipMissed), std::invalid_argument);
+
+  // no drift: the number of calls is determined by the
+  // elapsed time, not by the sum of individual delays
+  MicroWorker mw{chrono::microseconds{500}, OP::CatchUp};
+  Sloppy::Timer t;
+  ASSERT_TRUE(mw.run());
+  this_thread::sleep_for(chrono::milliseconds(200));
+  mw.terminateAndJoin();
+  int expected = t.getTime__us() / 500;
+  auto st = mw.workerStats();
+  ASSERT_TRUE(abs(int(st.nCalls) - expected) < 0.05 * expected);
+  ASSERT_EQ(500, st.workerCycleTime_us);
+  ASSERT_EQ(0, st.workerCycleTime_ms);
+  ASSERT_TRUE(st.maxJitter_us >= st.lastJitter_us);
+  ASSERT_TRUE(st.avgJitter_us() >= 0);
+  cout << "Avg. / max jitter in us: " << st.avgJitter_us() << " / " << st.maxJitter_us << endl;
+}
+
+//----------------------------------------------------------------------------
+
+TEST(CyclicThread, OverrunPolicies)
+{
+  using OP = Sloppy::CyclicWorkerThread::OverrunPolicy;
+
+  // catch-up: missed calls are made up for
+  MicroWorker cu{chrono::microseconds{500}, OP::CatchUp};
+  cu.overrunAtCall = 20;
+  Sloppy::Timer t;
+  ASSERT_TRUE(cu.run());
+  this_thread::sleep_for(chrono::milliseconds(100));
+  cu.terminateAndJoin();
+  int expected = t.getTime__us() / 500;
+  auto st = cu.workerStats();
+  ASSERT_TRUE(abs(int(st.nCalls) - expected) < 0.05 * expected);
+  ASSERT_TRUE(st.nOverruns >= 1);
+  ASSERT_EQ(0, st.nSkippedCycles);
+  ASSERT_TRUE(st.maxJitter_us >= 4000);   // the delayed calls are late
+
+  // skip: missed calls are dropped
+  MicroWorker sk{chrono::microseconds{500}, OP::SkipMissed};
+  sk.overrunAtCall = 20;
+  t.restart();
+  ASSERT_TRUE(sk.run());
+  this_thread::sleep_for(chrono::milliseconds(100));
+  sk.terminateAndJoin();
+  st = sk.workerStats();
+  expected = t.getTime__us() / 500 - st.nSkippedCycles;
+  ASSERT_TRUE(abs(int(st.nCalls) - expected) < 0.05 * expected);
+  ASSERT_TRUE(st.nOverruns >= 1);
+  ASSERT_TRUE(st.nSkippedCycles >= 9);
+}
@@ -0,0 +1,181 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/Histogram.h"
+#include "../Sloppy/ThreadStats.h"
+
+using namespace std;
+using namespace Sloppy;
+
+TEST(Histogram, BucketLayout)
+{
+  // small values are exact
+  for (int64_t v = 0; v < LatencyHistogram::SubBucketCount; ++v)
+  {
+    auto idx = LatencyHistogram::bucketIndex(v);
+    ASSERT_EQ(v, LatencyHistogram::bucketLowerBound(idx));
+    ASSERT_EQ(v, LatencyHistogram::bucketUpperBound(idx));
+  }
+
+  // buckets are contiguous and cover all values
+  for (size_t idx = 1; idx < LatencyHistogram::BucketCount; ++idx)
+  {
+    ASSERT_EQ(LatencyHistogram::bucketUpperBound(idx - 1) + 1, LatencyHistogram::bucketLowerBound(idx));
+    ASSERT_EQ(idx, LatencyHistogram::bucketIndex(LatencyHistogram::bucketLowerBound(idx)));
+    ASSERT_EQ(idx, LatencyHistogram::bucketIndex(LatencyHistogram::bucketUpperBound(idx)));
+  }
+
+  // relative error is bounded
+  for (int64_t v : {17L, 999L, 123456L, 987654321L})
+  {
+    auto idx = LatencyHistogram::bucketIndex(v);
+    double err = double(LatencyHistogram::bucketUpperBound(idx) - LatencyHistogram::bucketLowerBound(idx)) / v;
+    ASSERT_TRUE(err <= 1.0 / LatencyHistogram::SubBucketCount);
+  }
+
+  // clamping
+  ASSERT_EQ(0, LatencyHistogram::bucketIndex(-5));
+  ASSERT_EQ(LatencyHistogram::BucketCount - 1, LatencyHistogram::bucketIndex(int64_t{1} << 50));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Histogram, Percentiles)
+{
+  LatencyHistogram h;
+  ASSERT_EQ(0, h.count());
+  ASSERT_EQ(0, h.p50());
+  ASSERT_EQ(0, h.mean());
+
+  // 1...10000 ns
+  for (int64_t v = 1; v <= 10000; ++v) h.record(v);
+  ASSERT_EQ(10000, h.count());
+  ASSERT_EQ(1, h.min());
+  ASSERT_EQ(10000, h.max());
+  ASSERT_NEAR(5000.5, h.mean(), 0.01);
+
+  auto checkPercentile = [&](double p, int64_t expected) {
+    int64_t v = h.percentile(p);
+    ASSERT_TRUE(v >= expected);
+    ASSERT_TRUE(v <= expected * (1.0 + 1.0 / LatencyHistogram::SubBucketCount));
+  };
+  checkPercentile(50, 5000);
+  checkPercentile(99, 9900);
+  checkPercentile(99.9, 9990);
+  ASSERT_EQ(10000, h.percentile(100));
+  ASSERT_EQ(1, h.percentile(0));
+
+  h.reset();
+  ASSERT_EQ(0, h.count());
+  ASSERT_EQ(0, h.max());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Histogram, Merge)
+{
+  LatencyHistogram h1;
+  LatencyHistogram h2;
+  LatencyHistogram all;
+
+  mt19937 rng{42};
+  uniform_int_distribution<int64_t> dist{0, 5000000};
+  for (int i = 0; i < 10000; ++i)
+  {
+    int64_t v = dist(rng);
+    ((i % 3) ? h1 : h2).record(v);
+    all.record(v);
+  }
+
+  LatencyHistogram merged;
+  merged.merge(h1);
+  merged.merge(h2);
+  ASSERT_EQ(all.count(), merged.count());
+  ASSERT_EQ(all.min(), merged.min());
+  ASSERT_EQ(all.max(), merged.max());
+  ASSERT_EQ(all.p50(), merged.p50());
+  ASSERT_EQ(all.p999(), merged.p999());
+  for (size_t idx = 0; idx < LatencyHistogram::BucketCount; ++idx)
+  {
+    ASSERT_EQ(all.bucketCount(idx), merged.bucketCount(idx));
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Histogram, Windowed)
+{
+  using Clock = WindowedLatencyHistogram::Clock;
+  using namespace std::chrono_literals;
+
+  ASSERT_THROW(WindowedLatencyHistogram(0, 1s), std::invalid_argument);
+  ASSERT_THROW(WindowedLatencyHistogram(1, 0s), std::invalid_argument);
+
+  // 4 slices of 1 second each
+  WindowedLatencyHistogram w{4, 1s};
+  const auto t0 = Clock::now();
+
+  w.record(100, t0);
+  w.record(200, t0 + 1s);
+  w.record(300, t0 + 2s, 2);
+  ASSERT_EQ(4, w.snapshot(t0 + 2s).count());
+  ASSERT_EQ(300, w.snapshot(t0 + 2s).max());
+
+  // the first slice leaves the window
+  auto snap = w.snapshot(t0 + 4s);
+  ASSERT_EQ(3, snap.count());
+  ASSERT_EQ(200, snap.min());
+
+  // values older than the window are ignored
+  w.record(999, t0);
+  ASSERT_EQ(3, w.snapshot(t0 + 4s).count());
+
+  // everything decays after a long pause
+  ASSERT_EQ(0, w.snapshot(t0 + 100s).count());
+
+  w.record(5, t0 + 100s);
+  ASSERT_EQ(1, w.snapshot(t0 + 100s).count());
+  w.reset();
+  ASSERT_EQ(0, w.snapshot(t0 + 100s).count());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Histogram, WorkerStats)
+{
+  AsyncWorkerStats st;
+  st.update__ns(1500);
+  st.update__ns(2500000);
+  ASSERT_EQ(2, st.nCalls);
+  ASSERT_EQ(0, st.minWorkerTime_ms);
+  ASSERT_EQ(2, st.maxWorkerTime_ms);
+  ASSERT_EQ(2, st.runtimeHistogram.count());
+  ASSERT_EQ(1500, st.runtimeHistogram.min());
+  ASSERT_EQ(2500000, st.runtimeHistogram.max());
+
+  CyclicThreadStats cst;
+  cst.update__us(10, 3);
+  ASSERT_EQ(1, cst.runtimeHistogram.count());
+  ASSERT_EQ(10000, cst.runtimeHistogram.max());
+  ASSERT_EQ(3000, cst.jitterHistogram.max());
+}
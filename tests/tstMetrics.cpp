@@ -0,0 +1,243 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/Metrics.h"
+#include "../Sloppy/json.hpp"
+#include "../Sloppy/ThreadSafeQueue.h"
+#include "../Sloppy/ManagedFileDescriptor.h"
+#include "../Sloppy/Logger/Logger.h"
+
+using namespace std;
+using namespace Sloppy;
+
+TEST(Metrics, Prometheus)
+{
+  MetricsRegistry reg;
+  ASSERT_EQ(0, reg.size());
+
+  uint64_t cnt{42};
+  auto h1 = reg.addCounter("test_requests_total", "Number of requests", {{"path", "/a\"b"}}, [&]() { return cnt; });
+  auto h2 = reg.addCounter("test_requests_total", "ignored", {{"path", "/c"}}, []() { return uint64_t{7}; });
+  auto h3 = reg.addGauge("test_temperature", "Line1\nLine2", {}, []() { return 21.5; });
+
+  LatencyHistogram lh;
+  for (int i = 1; i <= 1000; ++i) lh.record(i * 1000);
+  auto h4 = reg.addHistogram("test_latency_seconds", "Latency", {{"op", "x"}}, [&]() { return lh; });
+  ASSERT_EQ(4, reg.size());
+
+  string out;
+  reg.renderPrometheus(out);
+  const string expected =
+      "# HELP test_latency_seconds Latency\n"
+      "# TYPE test_latency_seconds summary\n"
+      "test_latency_seconds{op=\"x\",quantile=\"0.5\"} ";
+  ASSERT_EQ(0, out.find(expected));
+  ASSERT_NE(string::npos, out.find("test_latency_seconds_count{op=\"x\"} 1000\n"));
+  ASSERT_NE(string::npos, out.find("test_latency_seconds_sum{op=\"x\"} 0.5005\n"));
+  ASSERT_NE(string::npos, out.find("# HELP test_requests_total Number of requests\n# TYPE test_requests_total counter\n"));
+  ASSERT_NE(string::npos, out.find("test_requests_total{path=\"/a\\\"b\"} 42\n"));
+  ASSERT_NE(string::npos, out.find("test_requests_total{path=\"/c\"} 7\n"));
+  ASSERT_NE(string::npos, out.find("# HELP test_temperature Line1\\nLine2\n"));
+  ASSERT_NE(string::npos, out.find("test_temperature 21.5\n"));
+
+  // values are read at render time; the buffer is reused
+  cnt = 43;
+  const auto cap = out.capacity();
+  reg.renderPrometheus(out);
+  ASSERT_NE(string::npos, out.find("test_requests_total{path=\"/a\\\"b\"} 43\n"));
+  ASSERT_EQ(cap, out.capacity());
+
+  // unregistering
+  h1.reset();
+  h2 = MetricsRegistry::Handle{};
+  ASSERT_FALSE(h1.isValid());
+  ASSERT_EQ(2, reg.size());
+  reg.renderPrometheus(out);
+  ASSERT_EQ(string::npos, out.find("test_requests_total"));
+
+  // moving handles
+  MetricsRegistry::Handle moved{std::move(h3)};
+  ASSERT_FALSE(h3.isValid());
+  ASSERT_TRUE(moved.isValid());
+  ASSERT_EQ(2, reg.size());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Metrics, Errors)
+{
+  MetricsRegistry reg;
+  auto f = []() { return uint64_t{0}; };
+  ASSERT_THROW(auto h = reg.addCounter("", "", {}, f), std::invalid_argument);
+  ASSERT_THROW(auto h = reg.addCounter("1abc", "", {}, f), std::invalid_argument);
+  ASSERT_THROW(auto h = reg.addCounter("a-b", "", {}, f), std::invalid_argument);
+  ASSERT_THROW(auto h = reg.addCounter("abc", "", {{"a:b", "x"}}, f), std::invalid_argument);
+  ASSERT_THROW(auto h = reg.addCounter("abc", "", {{"quantile", "x"}}, f), std::invalid_argument);
+
+  auto h = reg.addCounter("a:b_c", "", {}, f);
+  ASSERT_THROW(auto h2 = reg.addGauge("a:b_c", "", {}, []() { return 1.0; }), std::invalid_argument);
+  ASSERT_EQ(1, reg.size());
+
+  // the same name and label set can't be registered twice,
+  // regardless of the order of the labels
+  ASSERT_THROW(auto h2 = reg.addCounter("a:b_c", "", {}, f), std::invalid_argument);
+  auto hLbl = reg.addCounter("a:b_c", "", {{"x", "1"}, {"y", "2"}}, f);
+  ASSERT_THROW(auto h2 = reg.addCounter("a:b_c", "", {{"y", "2"}, {"x", "1"}}, f), std::invalid_argument);
+  auto hLbl2 = reg.addCounter("a:b_c", "", {{"x", "1"}, {"y", "3"}}, f);
+  ASSERT_EQ(3, reg.size());
+
+  // after releasing the handle, the label set is available again
+  hLbl.reset();
+  hLbl = reg.addCounter("a:b_c", "", {{"y", "2"}, {"x", "1"}}, f);
+  ASSERT_EQ(3, reg.size());
+
+  // handles may outlive the registry
+  MetricsRegistry::Handle h3;
+  {
+    MetricsRegistry tmp;
+    h3 = tmp.addCounter("abc", "", {}, f);
+    ASSERT_TRUE(h3.isValid());
+  }
+  ASSERT_FALSE(h3.isValid());
+  h3.reset();
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Metrics, Json)
+{
+  MetricsRegistry reg;
+  auto h1 = reg.addCounter("c", "a counter", {{"x", "1"}}, []() { return uint64_t{5}; });
+  auto h2 = reg.addGauge("g", "a gauge", {}, []() { return 0.25; });
+  auto h3 = reg.addHistogram("h", "a histogram", {}, []() { LatencyHistogram lh; lh.record(2000000000); return lh; });
+
+  auto j = reg.toJson();
+  ASSERT_EQ("counter", j["c"]["type"]);
+  ASSERT_EQ("a counter", j["c"]["help"]);
+  ASSERT_EQ(5, j["c"]["values"][0]["value"]);
+  ASSERT_EQ("1", j["c"]["values"][0]["labels"]["x"]);
+  ASSERT_EQ(0.25, j["g"]["values"][0]["value"]);
+  ASSERT_EQ(1, j["h"]["values"][0]["count"]);
+  ASSERT_EQ(2.0, j["h"]["values"][0]["max"]);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Metrics, CallbacksWithoutLock)
+{
+  MetricsRegistry reg;
+
+  // the callbacks are invoked without holding the registry's
+  // mutex, so they may use the registry themselves
+  MetricsRegistry::Handle hInner;
+  auto h = reg.addGauge("g", "", {}, [&]() {
+    if (!hInner.isValid()) hInner = reg.addCounter("c", "", {}, []() { return uint64_t{1}; });
+    return static_cast<double>(reg.size());
+  });
+
+  string out;
+  reg.renderPrometheus(out);
+  ASSERT_EQ("# HELP g \n# TYPE g gauge\ng 2\n", out);
+  ASSERT_EQ(2, reg.size());
+
+  // the new metric shows up in the next rendering
+  auto j = reg.toJson();
+  ASSERT_EQ(1, j["c"]["values"][0]["value"]);
+  ASSERT_EQ(2.0, j["g"]["values"][0]["value"]);
+
+  // releasing a handle blocks until a running callback has returned
+  atomic<bool> isInCallback{false};
+  atomic<bool> isCallbackDone{false};
+  auto hSlow = reg.addGauge("slow", "", {}, [&]() {
+    isInCallback = true;
+    this_thread::sleep_for(chrono::milliseconds(50));
+    isCallbackDone = true;
+    return 0.0;
+  });
+  thread renderer{[&]() { string tmp; reg.renderPrometheus(tmp); }};
+  while (!isInCallback) this_thread::yield();
+  hSlow.reset();
+  ASSERT_TRUE(isCallbackDone);
+  renderer.join();
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Metrics, Hooks)
+{
+  MetricsRegistry reg;
+  string out;
+
+  // queue
+  {
+    ThreadSafeQueue<int> q;
+    q.registerMetrics("q1", reg);
+    q.put(1);
+    q.put(2);
+    q.get();
+
+    reg.renderPrometheus(out);
+    ASSERT_NE(string::npos, out.find("sloppy_queue_put_total{queue=\"q1\"} 2\n"));
+    ASSERT_NE(string::npos, out.find("sloppy_queue_get_total{queue=\"q1\"} 1\n"));
+    ASSERT_NE(string::npos, out.find("sloppy_queue_length{queue=\"q1\"} 1\n"));
+  }
+  ASSERT_EQ(0, reg.size());   // unregistered by the dtor
+
+  // file descriptors
+  {
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    ManagedFileDescriptor rd{fds[0]};
+    ManagedFileDescriptor wr{fds[1]};
+    rd.registerMetrics("rd", reg);
+    wr.registerMetrics("wr", reg);
+    ASSERT_TRUE(wr.blockingWrite("Hello"));
+    auto data = rd.blockingRead(5, 5, 100);
+    ASSERT_EQ(5, wr.totalBytesWritten());
+    ASSERT_EQ(5, rd.totalBytesRead());
+
+    reg.renderPrometheus(out);
+    ASSERT_NE(string::npos, out.find("sloppy_fd_written_bytes_total{fd=\"wr\"} 5\n"));
+    ASSERT_NE(string::npos, out.find("sloppy_fd_read_bytes_total{fd=\"rd\"} 5\n"));
+  }
+  ASSERT_EQ(0, reg.size());
+
+  // logger
+  {
+    auto handles = Logger::Logger::registerMetrics(reg);
+    ASSERT_EQ(5, reg.size());
+    const auto before = Logger::Logger::messageCount(Logger::SeverityLevel::warning);
+    Logger::Logger log{"tst"};
+    log.warn("metrics test");
+    log.trace("suppressed");
+    ASSERT_EQ(before + 1, Logger::Logger::messageCount(Logger::SeverityLevel::warning));
+
+    reg.renderPrometheus(out);
+    ASSERT_NE(string::npos, out.find("sloppy_log_messages_total{level=\"warning\"} " + to_string(before + 1) + "\n"));
+  }
+  ASSERT_EQ(0, reg.size());
+}
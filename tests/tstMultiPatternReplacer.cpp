@@ -0,0 +1,178 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/MultiPatternReplacer.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  // a straightforward reference implementation with
+  // leftmost-longest semantics
+  string naiveReplace(const string& src, const vector<MultiPatternReplacer::Substitution>& subs)
+  {
+    string result;
+    size_t idx{0};
+    while (idx < src.size())
+    {
+      const MultiPatternReplacer::Substitution* best{nullptr};
+      for (const auto& s : subs)
+      {
+        if ((src.compare(idx, s.first.size(), s.first) == 0) && ((best == nullptr) || (s.first.size() > best->first.size())))
+        {
+          best = &s;
+        }
+      }
+
+      if (best == nullptr)
+      {
+        result += src[idx];
+        ++idx;
+      } else {
+        result += best->second;
+        idx += best->first.size();
+      }
+    }
+
+    return result;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(MultiPatternReplacer, Basics)
+{
+  const MultiPatternReplacer r{{{"he", "1"}, {"she", "2"}, {"his", "3"}, {"hers", "4"}}};
+  ASSERT_EQ(4, r.patternCount());
+
+  ASSERT_EQ("u2rs", r.apply("ushers"));  // leftmost wins
+  ASSERT_EQ("4", r.apply("hers"));  // longest wins
+  ASSERT_EQ("t3", r.apply("this"));
+  ASSERT_EQ("1 1", r.apply("he he"));
+  ASSERT_EQ("", r.apply(""));
+  ASSERT_EQ("xyz", r.apply("xyz"));
+
+  string buf{"prefix:"};
+  ASSERT_EQ(2, r.appendTo("she his", buf));
+  ASSERT_EQ("prefix:2 3", buf);
+  ASSERT_EQ(0, r.appendTo("-", buf));
+  ASSERT_EQ("prefix:2 3-", buf);
+
+  // replaced text is not searched again
+  const MultiPatternReplacer swap{{{"a", "b"}, {"b", "a"}}};
+  ASSERT_EQ("baab", swap.apply("abba"));
+
+  // a longer match that starts earlier but ends later
+  const MultiPatternReplacer nested{{{"bc", "X"}, {"abcd", "Y"}, {"cde", "Z"}}};
+  ASSERT_EQ("Ye", nested.apply("abcde"));
+  ASSERT_EQ("aXx", nested.apply("abcx"));
+  ASSERT_EQ("Xde", nested.apply("bcde"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(MultiPatternReplacer, InvalidInput)
+{
+  ASSERT_THROW(MultiPatternReplacer{{}}, std::invalid_argument);
+  ASSERT_THROW((MultiPatternReplacer{{{"a", "b"}, {"", "c"}}}), std::invalid_argument);
+  ASSERT_THROW((MultiPatternReplacer{{{"a", "b"}, {"a", "c"}}}), std::invalid_argument);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(MultiPatternReplacer, CompareWithReference)
+{
+  mt19937 rng{42};
+  uniform_int_distribution<int> charDist{0, 3};   // small alphabet ==> many overlaps
+  uniform_int_distribution<int> lenDist{1, 4};
+
+  for (int round = 0; round < 200; ++round)
+  {
+    vector<MultiPatternReplacer::Substitution> subs;
+    const int nSubs = 1 + round % 6;
+    while (static_cast<int>(subs.size()) < nSubs)
+    {
+      string key;
+      for (int i = lenDist(rng); i > 0; --i) key += static_cast<char>('a' + charDist(rng));
+      bool isDuplicate{false};
+      for (const auto& s : subs) isDuplicate = isDuplicate || (s.first == key);
+      if (!isDuplicate) subs.push_back({key, "<" + to_string(subs.size()) + ">"});
+    }
+
+    const MultiPatternReplacer r{subs};
+    for (int i = 0; i < 10; ++i)
+    {
+      string src;
+      for (int j = round % 50; j > 0; --j) src += static_cast<char>('a' + charDist(rng));
+      ASSERT_EQ(naiveReplace(src, subs), r.apply(src));
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(MultiPatternReplacer, SharedBetweenThreads)
+{
+  const MultiPatternReplacer r{{{"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}}};
+  const string src{"<a href=\"x&y\">"};
+  const string expected{"&lt;a href=\"x&amp;y\"&gt;"};
+
+  vector<thread> workers;
+  vector<int> nErrors(4, 0);
+  for (int t = 0; t < 4; ++t)
+  {
+    workers.emplace_back([&, t]() {
+      for (int i = 0; i < 1000; ++i)
+      {
+        if (r.apply(src) != expected) ++nErrors[t];
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+  for (int n : nErrors) ASSERT_EQ(0, n);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(MultiPatternReplacer, EstringAndCSV)
+{
+  const MultiPatternReplacer r{{{"ä", "ae"}, {"ö", "oe"}, {"ü", "ue"}}};
+  estring e{"Jäger über Köln"};
+  ASSERT_TRUE(e.replaceAll(r));
+  ASSERT_EQ("Jaeger ueber Koeln", e);
+  ASSERT_FALSE(e.replaceAll(r));
+  e.clear();
+  ASSERT_FALSE(e.replaceAll(r));
+
+  // escaping for CSV and back
+  const string raw{"a\\b\"c,d\ne\\n\\,"};
+  const string escaped = escapeStringForCSV(raw, false);
+  ASSERT_EQ("a\\\\b\\\"c\\,d\\ne\\\\n\\\\\\,", escaped);
+  ASSERT_EQ("\"" + escaped + "\"", escapeStringForCSV(raw, true));
+  ASSERT_EQ(raw, unescapeStringForCSV(escaped));
+}
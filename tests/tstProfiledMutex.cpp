@@ -0,0 +1,198 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>              // for milliseconds
+#include <condition_variable>  // for condition_variable_any
+#include <mutex>               // for lock_guard, unique_lock
+#include <sstream>             // for ostringstream
+#include <thread>              // for thread, sleep_for
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/ProfiledMutex.h"
+#include "../Sloppy/ThreadSafeQueue.h"
+
+using namespace std;
+using namespace Sloppy;
+
+namespace
+{
+  LockReport reportFor(const string& name)
+  {
+    for (const auto& r : LockProfiler::report())
+    {
+      if (r.name == name) return r;
+    }
+    return LockReport{};
+  }
+
+  // enables profiling for the lifetime of the object and
+  // resets all profiles upon construction
+  struct ProfilingScope
+  {
+    ProfilingScope()
+    {
+      LockProfiler::setEnabled(true);
+      LockProfiler::reset();
+    }
+
+    ~ProfilingScope()
+    {
+      LockProfiler::setEnabled(false);
+    }
+  };
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ProfiledMutex, DisabledByDefault)
+{
+  ASSERT_FALSE(LockProfiler::isEnabled());
+
+  ProfiledMutex m{"tst::disabled"};
+  ASSERT_EQ("tst::disabled", m.name());
+  {
+    lock_guard<ProfiledMutex> lk{m};
+  }
+  ASSERT_TRUE(m.try_lock());
+  m.unlock();
+
+  const auto r = reportFor("tst::disabled");
+  ASSERT_EQ("tst::disabled", r.name);
+  ASSERT_EQ(0, r.nAcquisitions);
+  ASSERT_EQ(0, r.holdTime.count());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ProfiledMutex, UncontendedAndTryLock)
+{
+  ProfilingScope ps;
+
+  ProfiledMutex m{"tst::uncontended"};
+  for (int i = 0; i < 10; ++i)
+  {
+    lock_guard<ProfiledMutex> lk{m};
+  }
+
+  ASSERT_TRUE(m.try_lock());
+  thread t{[&m]() { ASSERT_FALSE(m.try_lock()); }};
+  t.join();
+  m.unlock();
+
+  const auto r = reportFor("tst::uncontended");
+  ASSERT_EQ(11, r.nAcquisitions);
+  ASSERT_EQ(0, r.nContended);
+  ASSERT_EQ(1, r.nFailedTryLocks);
+  ASSERT_EQ(11, r.holdTime.count());
+  ASSERT_EQ(0, r.waitTime.count());
+  ASSERT_EQ(0.0, r.contentionPercentage());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ProfiledMutex, ContentionAndSharedProfiles)
+{
+  ProfilingScope ps;
+
+  // two instances with the same name share one profile
+  ProfiledMutex m1{"tst::contended"};
+  ProfiledMutex m2{"tst::contended"};
+
+  m1.lock();
+  thread t{[&m1]() {
+      lock_guard<ProfiledMutex> lk{m1};   // has to wait
+    }};
+  this_thread::sleep_for(chrono::milliseconds{20});
+  m1.unlock();
+  t.join();
+
+  {
+    lock_guard<ProfiledMutex> lk{m2};
+  }
+
+  const auto r = reportFor("tst::contended");
+  ASSERT_EQ(3, r.nAcquisitions);
+  ASSERT_EQ(1, r.nContended);
+  ASSERT_EQ(1, r.waitTime.count());
+  ASSERT_TRUE(r.waitTime.max() >= 10'000'000);   // at least 10 ms
+  ASSERT_EQ(3, r.holdTime.count());
+  ASSERT_TRUE(r.holdTime.max() >= 10'000'000);
+  ASSERT_NEAR(100.0 / 3, r.contentionPercentage(), 0.01);
+
+  ostringstream os;
+  LockProfiler::writeReport(os);
+  ASSERT_NE(string::npos, os.str().find("tst::contended"));
+
+  MetricsRegistry reg;
+  {
+    auto handles = LockProfiler::registerMetrics(reg);
+    ASSERT_TRUE(reg.size() >= 4);
+    string txt;
+    reg.renderPrometheus(txt);
+    ASSERT_NE(string::npos, txt.find("sloppy_lock_acquisitions_total{lock=\"tst::contended\"} 3"));
+  }
+  ASSERT_EQ(0, reg.size());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ProfiledMutex, ConditionVariable)
+{
+  ProfilingScope ps;
+
+  ProfiledMutex m{"tst::condvar"};
+  condition_variable_any cv;
+  bool ready{false};
+
+  thread t{[&]() {
+      this_thread::sleep_for(chrono::milliseconds{5});
+      lock_guard<ProfiledMutex> lk{m};
+      ready = true;
+      cv.notify_one();
+    }};
+
+  {
+    unique_lock<ProfiledMutex> lk{m};
+    cv.wait(lk, [&ready]() { return ready; });
+  }
+  t.join();
+
+  const auto r = reportFor("tst::condvar");
+  ASSERT_TRUE(r.nAcquisitions >= 3);   // initial lock, the writer, re-lock after the wait
+  ASSERT_EQ(r.nAcquisitions, r.holdTime.count());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ProfiledMutex, InternalLocks)
+{
+  ProfilingScope ps;
+
+  ThreadSafeQueue<int> q;
+  q.put(1);
+  ASSERT_EQ(1, q.get());
+
+  const auto r = reportFor("ThreadSafeQueue::listMutex");
+#ifdef SLOPPY_PROFILE_LOCKS
+  ASSERT_TRUE(r.nAcquisitions >= 2);
+#else
+  // the library's internal locks are plain mutexes
+  ASSERT_EQ(0, r.nAcquisitions);
+#endif
+}
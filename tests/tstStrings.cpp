@@ -19,6 +19,7 @@
 #include <iostream>
 #include <thread>
 #include <limits>
+#include <iterator>
 
 #include <gtest/gtest.h>
 
@@ -490,6 +491,60 @@ TEST(Strings, ArgDouble)
 
 //----------------------------------------------------------------------------
 
+TEST(Strings, Format)
+{
+  // same semantic as a sequence of arg() calls
+  ASSERT_EQ("abc % def X %a %% Y", estring::format("abc % def %1 %a %% %2", "X", "Y"));
+  ASSERT_EQ("abc % def -42 %a %% %2", estring::format("abc % def %1 %a %% %2", -42));
+  ASSERT_EQ("a b 1 2 a", estring::format("%2 %7 %3 %0010 %2", "a", 1, "b", 2));
+  ASSERT_EQ(to_string(SIZE_MAX), estring::format("%1", SIZE_MAX));
+  ASSERT_EQ("%%%1", estring::format("%%%1", "%1"));  // replacement strings are not evaluated again
+  ASSERT_EQ("255 x", estring::format("%1 %2", uint8_t{255}, 'x'));
+
+  // missing and surplus arguments
+  ASSERT_EQ("X %2", estring::format("%1 %2", "X"));
+  ASSERT_EQ("X", estring::format("%1", "X", "Y"));
+  ASSERT_EQ("%1", estring::format("%1"));
+
+  // corner cases
+  ASSERT_EQ("", estring::format("", "X"));
+  ASSERT_EQ("", estring::format("%1%1", ""));
+  ASSERT_EQ("%", estring::format("%", "X"));
+  ASSERT_EQ("% %99999999999999999999", estring::format("% %99999999999999999999", "X"));
+
+  // strings of all kinds
+  const estring e{"e"};
+  const string s{"s"};
+  const string_view sv{"sv"};
+  ASSERT_EQ("e s sv", estring::format("%1 %2 %3", e, s, sv));
+
+  // doubles
+  ASSERT_EQ("3.14159 0.5", estring::format("%1 %2", 3.14159, 0.5));
+  ASSERT_EQ("3.14 3 3.14159000", estring::format("%1 %2 %3", FormatArg::fixed(3.14159, 2),
+                                                  FormatArg::fixed(3.14159, 0), FormatArg::fixed(3.14159, 8)));
+  ASSERT_EQ("1e+300", estring::format("%1", FormatArg::fixed(1e300, 2)));  // too large for the fixed notation
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Strings, FormatString)
+{
+  const FormatString fmt{"[%1] %3 (%2%%) %1"};
+  ASSERT_EQ(3, fmt.placeholderCount());
+  ASSERT_EQ("[%1] %3 (%2%%) %1", fmt.formatString());
+
+  ASSERT_EQ("[a] c (b%%) a", fmt.apply("a", "b", "c"));
+  ASSERT_EQ("[1] 3 (2%%) 1", fmt.apply(1, 2, 3));
+  ASSERT_EQ("[1] %3 (%2%%) 1", fmt.apply(1));
+  ASSERT_EQ("[%1] %3 (%2%%) %1", fmt.apply());
+
+  const FormatString noTags{"no tags here"};
+  ASSERT_EQ(0, noTags.placeholderCount());
+  ASSERT_EQ("no tags here", noTags.apply("X"));
+}
+
+//----------------------------------------------------------------------------
+
 TEST(Strings, IsInt)
 {
   ASSERT_TRUE(estring{"1"}.isInt());
@@ -597,3 +652,88 @@ TEST(Strings, Split)
 
 //----------------------------------------------------------------------------
 
+TEST(Strings, SplitView)
+{
+  estring e{"a -- b --  -- c  --"};
+  vector<string_view> v = e.splitView("--", true, true);
+  ASSERT_EQ(5, v.size());
+  ASSERT_EQ("a", v[0]);
+  ASSERT_EQ("b", v[1]);
+  ASSERT_EQ("", v[2]);
+  ASSERT_EQ("c", v[3]);
+  ASSERT_EQ("", v[4]);
+
+  // the parts point into the original string
+  ASSERT_EQ(e.data(), v[0].data());
+  ASSERT_EQ(e.data() + 5, v[1].data());
+
+  v = e.splitView("--", false, false);
+  ASSERT_EQ(4, v.size());
+  ASSERT_EQ("a ", v[0]);
+  ASSERT_EQ("  ", v[2]);
+  ASSERT_EQ(" c  ", v[3]);
+
+  v = e.splitView("--", false, true);
+  ASSERT_EQ(3, v.size());
+
+  // same results as split() for the corner cases
+  for (const char* s : {"1, 2, 3", "1,,2", ",", "1,", "", "abc", " , ,"})
+  {
+    for (int opt = 0; opt < 4; ++opt)
+    {
+      const bool keepEmpty = ((opt & 1) != 0);
+      const bool trim = ((opt & 2) != 0);
+      const estring src{s};
+      const auto copies = src.split(",", keepEmpty, trim);
+      const auto views = src.splitView(",", keepEmpty, trim);
+      ASSERT_EQ(copies.size(), views.size());
+      for (size_t i = 0; i < copies.size(); ++i) ASSERT_EQ(copies[i], views[i]);
+    }
+  }
+
+  ASSERT_THROW(e.splitView("", true, true), std::invalid_argument);
+  ASSERT_TRUE(estring{}.splitView("", true, true).empty());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Strings, SplitRange)
+{
+  const estring e{"x\r\n\r\n y \r\nz"};
+
+  vector<string_view> parts;
+  for (string_view p : e.splitRange("\r\n", false, true)) parts.push_back(p);
+  ASSERT_EQ(3, parts.size());
+  ASSERT_EQ("x", parts[0]);
+  ASSERT_EQ("y", parts[1]);
+  ASSERT_EQ("z", parts[2]);
+
+  // iterator basics
+  const auto range = e.splitRange("\r\n", true, false);
+  auto it = range.begin();
+  ASSERT_TRUE(it != range.end());
+  ASSERT_EQ("x", *it);
+  ASSERT_EQ(1, it->size());
+  auto prev = it++;
+  ASSERT_EQ("x", *prev);
+  ASSERT_EQ("", *it);
+  ++it;
+  ASSERT_EQ(" y ", *it);
+  ++it;
+  ASSERT_EQ("z", *it);
+  ++it;
+  ASSERT_TRUE(it == range.end());
+  ASSERT_EQ(4, std::distance(range.begin(), range.end()));
+  ASSERT_EQ(4, range.toVector().size());
+
+  // a free standing range on a string_view
+  SplitRange sr{"  ", ",", false, true};
+  ASSERT_TRUE(sr.begin() == sr.end());
+
+  ASSERT_EQ("a b", trimView(" \t a b\n"));
+  ASSERT_EQ("", trimView("   "));
+  ASSERT_EQ("", trimView(""));
+}
+
+//----------------------------------------------------------------------------
+
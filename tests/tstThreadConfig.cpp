@@ -0,0 +1,149 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/ThreadConfig.h"
+#include "../Sloppy/CyclicWorkerThread.h"
+
+using namespace std;
+
+TEST(ThreadConfig, Validation)
+{
+  Sloppy::ThreadConfig cfg;
+  ASSERT_TRUE(cfg.isDefault());
+  ASSERT_TRUE(cfg.isValid());
+
+  cfg.name = "0123456789abcdef";  // 16 chars
+  string err;
+  ASSERT_FALSE(cfg.isValid(&err));
+  ASSERT_FALSE(err.empty());
+  cfg.name = "0123456789abcde";  // 15 chars
+  ASSERT_TRUE(cfg.isValid());
+  ASSERT_FALSE(cfg.isDefault());
+
+  cfg.cpuSet = {-1};
+  ASSERT_FALSE(cfg.isValid());
+  cfg.cpuSet = {0};
+  ASSERT_TRUE(cfg.isValid());
+
+  cfg.niceValue = 20;
+  ASSERT_FALSE(cfg.isValid());
+  cfg.niceValue = 19;
+  ASSERT_TRUE(cfg.isValid());
+
+  cfg.stackSize_bytes = 1;
+  ASSERT_FALSE(cfg.isValid());
+
+  ASSERT_THROW(Sloppy::ConfiguredThread(cfg, []{}), std::invalid_argument);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ThreadConfig, ConfiguredThread)
+{
+  Sloppy::ThreadConfig cfg;
+  cfg.name = "SloppyTest";
+  cfg.cpuSet = {0};
+  cfg.niceValue = 5;
+  cfg.stackSize_bytes = 1024 * 1024;
+
+  string actualName;
+  int actualCpu{-1};
+  int actualNice{-100};
+  Sloppy::ConfiguredThread t{cfg, [&]
+  {
+    char buf[32];
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    actualName = buf;
+    actualCpu = sched_getcpu();
+    actualNice = getpriority(PRIO_PROCESS, 0);
+  }};
+  ASSERT_TRUE(t.joinable());
+  t.join();
+  ASSERT_FALSE(t.joinable());
+
+  ASSERT_TRUE(t.configApplied());
+  ASSERT_EQ("SloppyTest", actualName);
+  ASSERT_EQ(0, actualCpu);
+
+  // move semantics
+  atomic_bool hasRun{false};
+  Sloppy::ConfiguredThread t1{Sloppy::ThreadConfig{}, [&]{ hasRun = true; }};
+  Sloppy::ConfiguredThread t2{std::move(t1)};
+  ASSERT_FALSE(t1.joinable());
+  ASSERT_TRUE(t2.joinable());
+  t2.join();
+  ASSERT_TRUE(hasRun);
+  ASSERT_THROW(t2.join(), std::runtime_error);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(ThreadConfig, NumaNode)
+{
+  // node 0 exists on every Linux system with sysfs
+  // NUMA support; on other systems the list is empty
+  const auto cpus = Sloppy::cpusOfNumaNode(0);
+  if (!cpus.empty())
+  {
+    ASSERT_GE(cpus[0], 0);
+  }
+  ASSERT_TRUE(Sloppy::cpusOfNumaNode(-1).empty());
+  ASSERT_TRUE(Sloppy::cpusOfNumaNode(100000).empty());
+}
+
+//----------------------------------------------------------------------------
+
+class NamedCyclicWorker : public Sloppy::CyclicWorkerThread
+{
+public:
+  NamedCyclicWorker(const Sloppy::ThreadConfig& cfg)
+    : Sloppy::CyclicWorkerThread{10, cfg} {}
+
+  string workerName;
+
+protected:
+  void worker() override
+  {
+    char buf[32];
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    workerName = buf;
+  }
+};
+
+TEST(ThreadConfig, CyclicWorkerThread)
+{
+  Sloppy::ThreadConfig cfg;
+  cfg.name = "CyclicTest";
+
+  NamedCyclicWorker w{cfg};
+  w.run();
+  this_thread::sleep_for(chrono::milliseconds(50));
+  w.terminateAndJoin();
+
+  ASSERT_EQ("CyclicTest", w.workerName);
+}
@@ -77,3 +77,57 @@ TEST(Timer, RemainingTime)
   ASSERT_EQ(0, t.getRemainingTime__ms());
 }
 
+
+//----------------------------------------------------------------------------
+
+TEST(Timer, ClockSources)
+{
+  using CS = Sloppy::Timer::ClockSource;
+
+  ASSERT_EQ(CS::SteadyClock, Sloppy::Timer::defaultClockSource());
+  ASSERT_EQ(CS::SteadyClock, Sloppy::Timer{}.clockSource());
+
+  // explicit calibration; later calls return the cached result
+  const bool hasTsc = Sloppy::TscClock::calibrate();
+  ASSERT_EQ(hasTsc, Sloppy::TscClock::calibrate());
+  ASSERT_EQ(hasTsc, Sloppy::TscClock::isAvailable());
+
+  Sloppy::Timer t{CS::TSC};
+  if (!hasTsc)
+  {
+    // fallback
+    ASSERT_EQ(CS::SteadyClock, t.clockSource());
+    ASSERT_EQ(CS::SteadyClock, Sloppy::Timer::setDefaultClockSource(CS::TSC));
+    return;
+  }
+
+  ASSERT_EQ(CS::TSC, t.clockSource());
+  ASSERT_TRUE(Sloppy::TscClock::nsPerTick() > 0);
+
+  // compare against the steady clock
+  Sloppy::Timer ref{CS::SteadyClock};
+  t.restart();
+  this_thread::sleep_for(chrono::milliseconds(50));
+  t.stop();
+  ref.stop();
+  // only a sanity check: both clocks must roughly agree (10 %)
+  ASSERT_TRUE(abs(ref.getTime__us() - t.getTime__us()) < 5000);
+
+  // stopped timers don't advance
+  const auto stoppedTime = t.getTime__ns();
+  this_thread::sleep_for(chrono::milliseconds(5));
+  ASSERT_EQ(stoppedTime, t.getTime__ns());
+
+  // timeouts work as well
+  t.restart();
+  t.setTimeoutDuration__ms(30);
+  ASSERT_FALSE(t.isElapsed());
+  this_thread::sleep_for(chrono::milliseconds(40));
+  ASSERT_TRUE(t.isElapsed());
+
+  // global default
+  ASSERT_EQ(CS::TSC, Sloppy::Timer::setDefaultClockSource(CS::TSC));
+  ASSERT_EQ(CS::TSC, Sloppy::Timer{}.clockSource());
+  Sloppy::Timer::setDefaultClockSource(CS::SteadyClock);
+  ASSERT_EQ(CS::SteadyClock, Sloppy::Timer{}.clockSource());
+}
@@ -0,0 +1,132 @@
+/*
+ *    This is libSloppy, a library of sloppily implemented helper functions.
+ *    Copyright (C) 2016 - 2021  Volker Knollmann
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "../Sloppy/Tracing.h"
+#include "../Sloppy/CSV.h"
+#include "../Sloppy/json.hpp"
+
+using namespace std;
+using namespace Sloppy;
+
+TEST(Tracing, DisabledByDefault)
+{
+  ASSERT_FALSE(Tracing::isEnabled());
+  Tracing::collect();   // discard leftovers
+
+  {
+    SLOPPY_TRACE_SPAN("noop");
+  }
+  ASSERT_TRUE(Tracing::collect().empty());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Tracing, NestedSpans)
+{
+  Tracing::collect();
+  Tracing::setEnabled(true);
+
+  {
+    SLOPPY_TRACE_SPAN("outer");
+    {
+      Tracing::Span inner{"inner", "test"};
+      this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    thread t{[]() {
+        SLOPPY_TRACE_SPAN("otherThread");
+      }};
+    t.join();
+  }
+
+  Tracing::setEnabled(false);
+  auto spans = Tracing::collect();
+  ASSERT_EQ(3, spans.size());
+
+  auto find = [&](const string& n) {
+    return *std::find_if(spans.begin(), spans.end(), [&](const Tracing::SpanRecord& r) { return n == r.name; });
+  };
+  const auto outer = find("outer");
+  const auto inner = find("inner");
+  const auto other = find("otherThread");
+
+  ASSERT_STREQ("sloppy", outer.category);
+  ASSERT_STREQ("test", inner.category);
+  ASSERT_TRUE(inner.duration_ns >= 2000000);
+  ASSERT_TRUE(inner.start_ns >= outer.start_ns);
+  ASSERT_TRUE((inner.start_ns + inner.duration_ns) <= (outer.start_ns + outer.duration_ns));
+  ASSERT_EQ(outer.threadId, inner.threadId);
+  ASSERT_NE(outer.threadId, other.threadId);
+
+  // everything has been collected
+  ASSERT_TRUE(Tracing::collect().empty());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Tracing, ChromeExport)
+{
+  Tracing::collect();
+  Tracing::setEnabled(true);
+  {
+    SLOPPY_TRACE_SPAN("quote\"d");
+    CSV_Table tab{"a,b\n1,2", true, CSV_StringRepresentation::Plain};
+  }
+  Tracing::setEnabled(false);
+
+  ostringstream os;
+  Tracing::writeChromeTrace(os);
+
+  auto j = nlohmann::json::parse(os.str());
+  const auto& ev = j["traceEvents"];
+  ASSERT_EQ(2, ev.size());
+  ASSERT_EQ("CSV_Table::ctor", ev[0]["name"]);
+  ASSERT_EQ("quote\"d", ev[1]["name"]);
+  ASSERT_EQ("X", ev[1]["ph"]);
+  ASSERT_TRUE(ev[1]["dur"].get<double>() >= ev[0]["dur"].get<double>());
+  ASSERT_TRUE(ev[1]["ts"].get<double>() <= ev[0]["ts"].get<double>());
+
+  // the export drains the buffers
+  ostringstream os2;
+  Tracing::writeChromeTrace(os2);
+  ASSERT_EQ(0, nlohmann::json::parse(os2.str())["traceEvents"].size());
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Tracing, Overflow)
+{
+  Tracing::collect();
+  const auto droppedBefore = Tracing::droppedSpans();
+
+  Tracing::setEnabled(true);
+  for (size_t i = 0; i < Tracing::SpansPerThreadBuffer + 10; ++i)
+  {
+    SLOPPY_TRACE_SPAN("s");
+  }
+  Tracing::setEnabled(false);
+
+  ASSERT_EQ(droppedBefore + 10, Tracing::droppedSpans());
+  ASSERT_EQ(Tracing::SpansPerThreadBuffer, Tracing::collect().size());
+}